@@ -2,9 +2,13 @@
 
 #include <cctype>
 #include <stdexcept>
+#include <thread>
 #include "Bundle.hpp"
 #include "Cache.hpp"
 #include "Loader.hpp"
+#include "Loading.hpp"
+#include "../audio/VorbisClip.hpp"
+#include "../core/Engine.hpp"
 #include "../formats/Json.hpp"
 
 namespace ouzel::assets
@@ -23,8 +27,13 @@ namespace ouzel::assets
     void Bundle::loadAsset(Loader::Type loaderType, const std::string& name,
                            const std::string& filename, bool mipmaps)
     {
-        const auto data = fileSystem.readFile(filename);
+        loadAsset(loaderType, name, filename, fileSystem.readFile(filename), mipmaps);
+    }
 
+    void Bundle::loadAsset(Loader::Type loaderType, const std::string& name,
+                           const std::string& filename, const std::vector<std::byte>& data,
+                           bool mipmaps)
+    {
         const auto& loaders = cache.getLoaders();
 
         for (auto i = loaders.rbegin(); i != loaders.rend(); ++i)
@@ -40,21 +49,37 @@ namespace ouzel::assets
 
     void Bundle::loadAssets(const std::string& filename)
     {
-        const auto data = json::parse(fileSystem.readFile(filename));
+        const auto data = json::parse(fileSystem.mapFile(filename));
+
+        std::vector<Asset> assets;
 
         for (const auto& asset : data["assets"])
         {
             const auto file = asset["filename"].as<std::string>();
             const auto name = asset.hasMember("name") ? asset["name"].as<std::string>() : file;
             const auto mipmaps = asset.hasMember("mipmaps") ? asset["mipmaps"].as<bool>() : true;
-            loadAsset(static_cast<Loader::Type>(asset["type"].as<std::uint32_t>()), name, file, mipmaps);
+            assets.emplace_back(static_cast<Loader::Type>(asset["type"].as<std::uint32_t>()), name, file, mipmaps);
         }
+
+        loadAssets(assets);
     }
 
     void Bundle::loadAssets(const std::vector<Asset>& assets)
     {
-        for (const Asset& asset : assets)
-            loadAsset(asset.type, asset.name, asset.filename, asset.mipmaps);
+        // starting the threads costs more than reading and decoding a few assets on this thread
+        constexpr std::size_t minParallelAssets = 4;
+
+        if (assets.size() < minParallelAssets)
+            Loading(*this, assets, 0).wait();
+        else
+            loadAssetsAsync(assets)->wait();
+    }
+
+    std::unique_ptr<Loading> Bundle::loadAssetsAsync(const std::vector<Asset>& assets)
+    {
+        // one of the cores is left for the thread of the bundle
+        const auto cpuCount = std::thread::hardware_concurrency();
+        return std::make_unique<Loading>(*this, assets, cpuCount > 1 ? cpuCount - 1 : 1);
     }
 
     std::shared_ptr<graphics::Texture> Bundle::getTexture(const std::string& name) const
@@ -288,6 +313,14 @@ namespace ouzel::assets
         sounds.clear();
     }
 
+    void Bundle::loadStreamedSound(const std::string& name, const std::string& filename, float readAhead)
+    {
+        auto sound = std::make_unique<audio::StreamingVorbisClip>(*engine->getAudio(),
+                                                                  fileSystem.getFileRange(filename),
+                                                                  readAhead);
+        setSound(name, std::move(sound));
+    }
+
     const graphics::Material* Bundle::getMaterial(const std::string& name) const
     {
         const auto i = materials.find(name);
@@ -24,6 +24,7 @@
 namespace ouzel::assets
 {
     class Cache;
+    class Loading;
 
     class Asset final
     {
@@ -48,6 +49,7 @@ namespace ouzel::assets
     class Bundle final
     {
         friend Cache;
+        friend Loading;
     public:
         Bundle(Cache& initCache, storage::FileSystem& initFileSystem);
         ~Bundle();
@@ -62,6 +64,8 @@ namespace ouzel::assets
                        const std::string& filename, bool mipmaps = true);
         void loadAssets(const std::string& filename);
         void loadAssets(const std::vector<Asset>& assets);
+        // the returned loading has to be updated or waited for on the thread of the bundle
+        std::unique_ptr<Loading> loadAssetsAsync(const std::vector<Asset>& assets);
 
         std::shared_ptr<graphics::Texture> getTexture(const std::string& name) const;
         void setTexture(const std::string& name, const std::shared_ptr<graphics::Texture>& texture);
@@ -102,6 +106,9 @@ namespace ouzel::assets
         void setSound(const std::string& name, std::unique_ptr<audio::Sound> sound);
         void releaseSounds();
 
+        // the sound is decoded from the file while it plays, readAhead is the buffered duration in seconds
+        void loadStreamedSound(const std::string& name, const std::string& filename, float readAhead = 1.0F);
+
         const graphics::Material* getMaterial(const std::string& name) const;
         void setMaterial(const std::string& name, std::unique_ptr<graphics::Material> material);
         void releaseMaterials();
@@ -115,6 +122,10 @@ namespace ouzel::assets
         void releaseStaticMeshData();
 
     private:
+        void loadAsset(Loader::Type loaderType, const std::string& name,
+                       const std::string& filename, const std::vector<std::byte>& data,
+                       bool mipmaps);
+
         Cache& cache;
         storage::FileSystem& fileSystem;
 
@@ -44,10 +44,10 @@ namespace ouzel::assets
                     sourceDefinition.oscillatorType = audio::Oscillator::Type::triangle;
 
                 if (value.hasMember("frequency"))
-                    sourceDefinition.length = value["frequency"].as<float>();
+                    sourceDefinition.frequency = value["frequency"].as<float>();
 
                 if (value.hasMember("amplitude"))
-                    sourceDefinition.length = value["amplitude"].as<float>();
+                    sourceDefinition.amplitude = value["amplitude"].as<float>();
 
                 if (value.hasMember("length"))
                     sourceDefinition.length = value["length"].as<float>();
@@ -69,6 +69,10 @@ namespace ouzel::assets
             else
                 throw std::runtime_error("Invalid source type " + valueType);
 
+            // the chance of the source to be picked by a random parent
+            if (value.hasMember("weight"))
+                sourceDefinition.weight = value["weight"].as<float>();
+
             if (value.hasMember("effects"))
                 for (const json::Value& effectValue : value["effects"])
                 {
@@ -98,6 +102,15 @@ namespace ouzel::assets
                     if (effectValue.hasMember("scale")) effectDefinition.scale = effectValue["scale"].as<float>();
                     if (effectValue.hasMember("shift")) effectDefinition.shift = effectValue["shift"].as<float>();
                     if (effectValue.hasMember("decay")) effectDefinition.decay = effectValue["decay"].as<float>();
+                    if (effectValue.hasMember("cutoff")) effectDefinition.cutoff = effectValue["cutoff"].as<float>();
+                    if (effectValue.hasMember("q")) effectDefinition.q = effectValue["q"].as<float>();
+
+                    if (effectValue.hasMember("delayRandom"))
+                        effectDefinition.delayRandom = {effectValue["delayRandom"][0].as<float>(),
+                                                        effectValue["delayRandom"][1].as<float>()};
+                    if (effectValue.hasMember("gainRandom"))
+                        effectDefinition.gainRandom = {effectValue["gainRandom"][0].as<float>(),
+                                                       effectValue["gainRandom"][1].as<float>()};
 
                     sourceDefinition.effectDefinitions.push_back(effectDefinition);
                 }
@@ -1,12 +1,325 @@
 // Copyright 2015-2020 Elviss Strazdins. All rights reserved.
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
 #include "GltfLoader.hpp"
 #include "Bundle.hpp"
+#include "Cache.hpp"
+#include "../core/Engine.hpp"
 #include "../scene/SkinnedMeshRenderer.hpp"
 #include "../formats/Json.hpp"
+#include "../utils/Utils.hpp"
 
 namespace ouzel::assets
 {
+    namespace
+    {
+        constexpr std::uint32_t glbMagic = 0x46546C67; // "glTF"
+        constexpr std::uint32_t glbChunkJson = 0x4E4F534A; // "JSON"
+        constexpr std::uint32_t glbChunkBinary = 0x004E4942; // "BIN\0"
+
+        enum ComponentType: std::uint32_t
+        {
+            byteType = 5120,
+            unsignedByteType = 5121,
+            shortType = 5122,
+            unsignedShortType = 5123,
+            unsignedIntType = 5125,
+            floatType = 5126
+        };
+
+        constexpr std::uint32_t trianglesMode = 4;
+
+        struct BufferView final
+        {
+            const std::byte* data = nullptr;
+            std::size_t size = 0;
+        };
+
+        struct Accessor final
+        {
+            const std::byte* data = nullptr;
+            std::size_t count = 0;
+            std::size_t components = 0;
+            std::size_t componentSize = 0;
+            std::size_t stride = 0;
+            std::uint32_t componentType = floatType;
+            bool normalized = false;
+
+            bool isTightlyPacked() const noexcept
+            {
+                return stride == components * componentSize;
+            }
+
+            float getFloat(std::size_t index, std::size_t component) const
+            {
+                const std::byte* element = data + index * stride + component * componentSize;
+
+                switch (componentType)
+                {
+                    case floatType:
+                        return bitCast<float>(decodeLittleEndian<std::uint32_t>(element));
+                    case unsignedByteType:
+                    {
+                        const auto value = static_cast<float>(static_cast<std::uint8_t>(*element));
+                        return normalized ? value / 255.0F : value;
+                    }
+                    case byteType:
+                    {
+                        const auto value = static_cast<float>(static_cast<std::int8_t>(*element));
+                        return normalized ? std::max(value / 127.0F, -1.0F) : value;
+                    }
+                    case unsignedShortType:
+                    {
+                        const auto value = static_cast<float>(decodeLittleEndian<std::uint16_t>(element));
+                        return normalized ? value / 65535.0F : value;
+                    }
+                    case shortType:
+                    {
+                        const auto value = static_cast<float>(static_cast<std::int16_t>(decodeLittleEndian<std::uint16_t>(element)));
+                        return normalized ? std::max(value / 32767.0F, -1.0F) : value;
+                    }
+                    default:
+                        throw std::runtime_error("Unsupported component type");
+                }
+            }
+
+            std::uint32_t getUInt(std::size_t index, std::size_t component) const
+            {
+                const std::byte* element = data + index * stride + component * componentSize;
+
+                switch (componentType)
+                {
+                    case unsignedByteType: return static_cast<std::uint8_t>(*element);
+                    case unsignedShortType: return decodeLittleEndian<std::uint16_t>(element);
+                    case unsignedIntType: return decodeLittleEndian<std::uint32_t>(element);
+                    default:
+                        throw std::runtime_error("Unsupported component type");
+                }
+            }
+        };
+
+        std::size_t getComponentSize(std::uint32_t componentType)
+        {
+            switch (componentType)
+            {
+                case byteType:
+                case unsignedByteType:
+                    return 1;
+                case shortType:
+                case unsignedShortType:
+                    return 2;
+                case unsignedIntType:
+                case floatType:
+                    return 4;
+                default:
+                    throw std::runtime_error("Invalid component type");
+            }
+        }
+
+        std::size_t getComponentCount(const std::string& type)
+        {
+            if (type == "SCALAR") return 1;
+            else if (type == "VEC2") return 2;
+            else if (type == "VEC3") return 3;
+            else if (type == "VEC4") return 4;
+            else if (type == "MAT2") return 4;
+            else if (type == "MAT3") return 9;
+            else if (type == "MAT4") return 16;
+            else throw std::runtime_error("Invalid accessor type " + type);
+        }
+
+        std::vector<std::byte> decodeBase64(const std::string& str, std::size_t offset)
+        {
+            const auto decode = [](char c) -> std::uint32_t {
+                if (c >= 'A' && c <= 'Z') return static_cast<std::uint32_t>(c - 'A');
+                else if (c >= 'a' && c <= 'z') return static_cast<std::uint32_t>(c - 'a' + 26);
+                else if (c >= '0' && c <= '9') return static_cast<std::uint32_t>(c - '0' + 52);
+                else if (c == '+') return 62;
+                else if (c == '/') return 63;
+                else throw std::runtime_error("Invalid base64 character");
+            };
+
+            std::vector<std::byte> result;
+            result.reserve((str.size() - offset) * 3 / 4);
+
+            std::uint32_t bits = 0;
+            std::uint32_t bitCount = 0;
+
+            for (std::size_t i = offset; i < str.size() && str[i] != '='; ++i)
+            {
+                bits = (bits << 6) | decode(str[i]);
+                bitCount += 6;
+
+                if (bitCount >= 8)
+                {
+                    bitCount -= 8;
+                    result.push_back(static_cast<std::byte>((bits >> bitCount) & 0xFF));
+                }
+            }
+
+            return result;
+        }
+
+        Accessor getAccessor(const json::Value& d,
+                             const std::vector<BufferView>& buffers,
+                             std::size_t index)
+        {
+            const auto& accessorValue = d["accessors"][index];
+
+            Accessor accessor;
+            accessor.componentType = accessorValue["componentType"].as<std::uint32_t>();
+            accessor.componentSize = getComponentSize(accessor.componentType);
+            accessor.components = getComponentCount(accessorValue["type"].as<std::string>());
+            accessor.count = accessorValue["count"].as<std::size_t>();
+            accessor.normalized = accessorValue.hasMember("normalized") && accessorValue["normalized"].as<bool>();
+            accessor.stride = accessor.components * accessor.componentSize;
+
+            if (!accessorValue.hasMember("bufferView"))
+                throw std::runtime_error("Sparse accessors are not supported");
+
+            const auto& bufferViewValue = d["bufferViews"][accessorValue["bufferView"].as<std::size_t>()];
+            const auto& buffer = buffers[bufferViewValue["buffer"].as<std::size_t>()];
+
+            const auto viewOffset = bufferViewValue.hasMember("byteOffset") ? bufferViewValue["byteOffset"].as<std::size_t>() : 0;
+            const auto viewLength = bufferViewValue["byteLength"].as<std::size_t>();
+            const auto accessorOffset = accessorValue.hasMember("byteOffset") ? accessorValue["byteOffset"].as<std::size_t>() : 0;
+
+            if (bufferViewValue.hasMember("byteStride"))
+                accessor.stride = bufferViewValue["byteStride"].as<std::size_t>();
+
+            if (viewOffset + viewLength > buffer.size ||
+                (accessor.count && accessorOffset + (accessor.count - 1) * accessor.stride + accessor.components * accessor.componentSize > viewLength))
+                throw std::runtime_error("Accessor out of bounds");
+
+            accessor.data = buffer.data + viewOffset + accessorOffset;
+
+            return accessor;
+        }
+
+        Matrix4F getNodeTransform(const json::Value& node)
+        {
+            Matrix4F result = Matrix4F::identity();
+
+            if (node.hasMember("matrix"))
+            {
+                const auto& matrixValue = node["matrix"];
+                for (std::size_t i = 0; i < 16; ++i)
+                    result.m[i] = matrixValue[i].as<float>(); // glTF matrices are column-major like Matrix4F
+            }
+            else
+            {
+                if (node.hasMember("translation"))
+                {
+                    const auto& t = node["translation"];
+                    result.setTranslation(Vector3F(t[0].as<float>(), t[1].as<float>(), t[2].as<float>()));
+                }
+
+                if (node.hasMember("rotation"))
+                {
+                    const auto& r = node["rotation"];
+                    Matrix4F rotationMatrix;
+                    rotationMatrix.setRotation(QuaternionF(r[0].as<float>(), r[1].as<float>(), r[2].as<float>(), r[3].as<float>()));
+                    result = result * rotationMatrix;
+                }
+
+                if (node.hasMember("scale"))
+                {
+                    const auto& s = node["scale"];
+                    Matrix4F scaleMatrix;
+                    scaleMatrix.setScale(Vector3F(s[0].as<float>(), s[1].as<float>(), s[2].as<float>()));
+                    result = result * scaleMatrix;
+                }
+            }
+
+            return result;
+        }
+
+        void setBoneTransform(const json::Value& node, scene::SkinnedMeshData::Bone& bone)
+        {
+            if (node.hasMember("matrix"))
+            {
+                const auto m = getNodeTransform(node);
+
+                bone.position = Vector3F(m.m[12], m.m[13], m.m[14]);
+
+                const Vector3F x(m.m[0], m.m[1], m.m[2]);
+                const Vector3F y(m.m[4], m.m[5], m.m[6]);
+                const Vector3F z(m.m[8], m.m[9], m.m[10]);
+                bone.scale = Vector3F(x.length(), y.length(), z.length());
+
+                // rotation from the orthonormal basis
+                const float m00 = m.m[0] / bone.scale.v[0], m01 = m.m[4] / bone.scale.v[1], m02 = m.m[8] / bone.scale.v[2];
+                const float m10 = m.m[1] / bone.scale.v[0], m11 = m.m[5] / bone.scale.v[1], m12 = m.m[9] / bone.scale.v[2];
+                const float m20 = m.m[2] / bone.scale.v[0], m21 = m.m[6] / bone.scale.v[1], m22 = m.m[10] / bone.scale.v[2];
+
+                const float trace = m00 + m11 + m22;
+                if (trace > 0.0F)
+                {
+                    const float s = 0.5F / std::sqrt(trace + 1.0F);
+                    bone.rotation = QuaternionF((m21 - m12) * s, (m02 - m20) * s, (m10 - m01) * s, 0.25F / s);
+                }
+                else if (m00 > m11 && m00 > m22)
+                {
+                    const float s = 2.0F * std::sqrt(1.0F + m00 - m11 - m22);
+                    bone.rotation = QuaternionF(0.25F * s, (m01 + m10) / s, (m02 + m20) / s, (m21 - m12) / s);
+                }
+                else if (m11 > m22)
+                {
+                    const float s = 2.0F * std::sqrt(1.0F + m11 - m00 - m22);
+                    bone.rotation = QuaternionF((m01 + m10) / s, 0.25F * s, (m12 + m21) / s, (m02 - m20) / s);
+                }
+                else
+                {
+                    const float s = 2.0F * std::sqrt(1.0F + m22 - m00 - m11);
+                    bone.rotation = QuaternionF((m02 + m20) / s, (m12 + m21) / s, 0.25F * s, (m10 - m01) / s);
+                }
+            }
+            else
+            {
+                if (node.hasMember("translation"))
+                {
+                    const auto& t = node["translation"];
+                    bone.position = Vector3F(t[0].as<float>(), t[1].as<float>(), t[2].as<float>());
+                }
+
+                if (node.hasMember("rotation"))
+                {
+                    const auto& r = node["rotation"];
+                    bone.rotation = QuaternionF(r[0].as<float>(), r[1].as<float>(), r[2].as<float>(), r[3].as<float>());
+                }
+
+                if (node.hasMember("scale"))
+                {
+                    const auto& s = node["scale"];
+                    bone.scale = Vector3F(s[0].as<float>(), s[1].as<float>(), s[2].as<float>());
+                }
+            }
+        }
+    }
+
+    namespace
+    {
+        // everything but the material, which needs the cache, and the buffers, which need the engine
+        class DecodedMesh final: public Loader::Decoded
+        {
+        public:
+            Box3F boundingBox;
+            Color diffuseColor = Color::white();
+            bool doubleSided = false;
+            std::vector<std::uint32_t> indices;
+            std::vector<std::byte> indexData; // a copy of the indices that can be uploaded as they are
+            std::uint32_t indexCount = 0;
+            std::uint32_t indexSize = sizeof(std::uint32_t);
+            std::vector<graphics::Vertex> vertices;
+            std::vector<scene::SkinnedMeshData::Influence> influences;
+            std::vector<scene::SkinnedMeshData::Bone> bones;
+            std::vector<scene::SkinnedMeshData::Animation> animations;
+        };
+    }
+
     GltfLoader::GltfLoader(Cache& initCache):
         Loader(initCache, Type::skinnedMesh)
     {
@@ -17,16 +330,464 @@ namespace ouzel::assets
                                const std::vector<std::byte>& data,
                                bool mipmaps)
     {
-        const auto d = json::parse(data);
+        const auto decoded = decodeAsset(name, data, mipmaps);
+        return createAsset(bundle, name, *decoded, mipmaps);
+    }
+
+    std::unique_ptr<Loader::Decoded> GltfLoader::decodeAsset(const std::string&,
+                                                             const std::vector<std::byte>& data,
+                                                             bool)
+    {
+        auto mesh = std::make_unique<DecodedMesh>();
+
+        json::Value d;
+
+        // buffers point either into the binary chunk of the .glb or into the decoded data URIs
+        std::vector<BufferView> buffers;
+        std::vector<std::vector<std::byte>> decodedBuffers;
+        BufferView binaryChunk;
+
+        if (data.size() >= 12 && decodeLittleEndian<std::uint32_t>(data.begin()) == glbMagic)
+        {
+            if (decodeLittleEndian<std::uint32_t>(data.begin() + 4) != 2)
+                throw std::runtime_error("Unsupported glTF version");
+
+            std::size_t offset = 12;
+            while (offset + 8 <= data.size())
+            {
+                const auto chunkLength = decodeLittleEndian<std::uint32_t>(data.begin() + static_cast<std::ptrdiff_t>(offset));
+                const auto chunkType = decodeLittleEndian<std::uint32_t>(data.begin() + static_cast<std::ptrdiff_t>(offset + 4));
+                offset += 8;
+
+                if (offset + chunkLength > data.size())
+                    throw std::runtime_error("Invalid glTF chunk");
+
+                if (chunkType == glbChunkJson)
+                    d = json::parse(data.begin() + static_cast<std::ptrdiff_t>(offset),
+                                    data.begin() + static_cast<std::ptrdiff_t>(offset + chunkLength));
+                else if (chunkType == glbChunkBinary && !binaryChunk.data)
+                    binaryChunk = BufferView{data.data() + offset, chunkLength};
+
+                offset += (chunkLength + 3) & ~std::size_t(3);
+            }
+        }
+        else
+            d = json::parse(data);
+
+        if (d.hasMember("buffers"))
+            for (const auto& bufferValue : d["buffers"])
+            {
+                const auto byteLength = bufferValue["byteLength"].as<std::size_t>();
+
+                if (!bufferValue.hasMember("uri"))
+                {
+                    if (!binaryChunk.data || binaryChunk.size < byteLength)
+                        throw std::runtime_error("Invalid glTF binary chunk");
+
+                    buffers.push_back(binaryChunk);
+                }
+                else
+                {
+                    const auto& uri = bufferValue["uri"].as<std::string>();
+                    const auto dataOffset = uri.find(";base64,");
+
+                    if (uri.compare(0, 5, "data:") != 0 || dataOffset == std::string::npos)
+                        throw std::runtime_error("External glTF buffers are not supported");
+
+                    decodedBuffers.push_back(decodeBase64(uri, dataOffset + 8));
+                    if (decodedBuffers.back().size() < byteLength)
+                        throw std::runtime_error("Invalid glTF buffer size");
+
+                    buffers.push_back(BufferView{decodedBuffers.back().data(), byteLength});
+                }
+            }
+
+        if (!d.hasMember("nodes") || !d.hasMember("meshes"))
+            throw std::runtime_error("glTF file has no meshes");
 
         const auto& nodesValue = d["nodes"];
         const auto& meshesValue = d["meshes"];
 
-        (void)mipmaps;
-        (void)nodesValue;
-        (void)meshesValue;
+        // use the first skinned mesh node or the first mesh node if no mesh is skinned
+        std::size_t meshNode = nodesValue.getSize();
+        for (std::size_t i = 0; i < nodesValue.getSize(); ++i)
+            if (nodesValue[i].hasMember("mesh"))
+            {
+                if (meshNode == nodesValue.getSize()) meshNode = i;
+                if (nodesValue[i].hasMember("skin"))
+                {
+                    meshNode = i;
+                    break;
+                }
+            }
+
+        if (meshNode == nodesValue.getSize())
+            throw std::runtime_error("glTF file has no mesh nodes");
+
+        std::vector<std::size_t> nodeParents(nodesValue.getSize(), scene::SkinnedMeshData::noParent);
+        for (std::size_t i = 0; i < nodesValue.getSize(); ++i)
+            if (nodesValue[i].hasMember("children"))
+                for (const auto& childValue : nodesValue[i]["children"])
+                {
+                    const auto child = childValue.as<std::size_t>();
+                    if (child >= nodesValue.getSize())
+                        throw std::runtime_error("Invalid node child");
+
+                    nodeParents[child] = i;
+                }
+
+        const auto getGlobalTransform = [&nodesValue, &nodeParents](std::size_t node) {
+            Matrix4F result = Matrix4F::identity();
+            for (; node != scene::SkinnedMeshData::noParent; node = nodeParents[node])
+                result = getNodeTransform(nodesValue[node]) * result;
+            return result;
+        };
+
+        // skeleton
+        auto& bones = mesh->bones;
+        std::vector<std::size_t> nodeBones(nodesValue.getSize(), scene::SkinnedMeshData::noParent);
+        std::vector<std::uint16_t> jointBones;
+
+        if (nodesValue[meshNode].hasMember("skin"))
+        {
+            const auto& skinValue = d["skins"][nodesValue[meshNode]["skin"].as<std::size_t>()];
+            const auto& jointsValue = skinValue["joints"];
+
+            std::vector<std::size_t> joints;
+            for (const auto& jointValue : jointsValue)
+            {
+                const auto joint = jointValue.as<std::size_t>();
+                if (joint >= nodesValue.getSize())
+                    throw std::runtime_error("Invalid skin joint");
+
+                joints.push_back(joint);
+            }
+
+            std::vector<std::size_t> isJoint(nodesValue.getSize(), 0);
+            for (const auto joint : joints) isJoint[joint] = 1;
+
+            // sort the joints by depth so that parents come before their children
+            std::vector<std::size_t> depths(joints.size(), 0);
+            for (std::size_t j = 0; j < joints.size(); ++j)
+                for (auto node = nodeParents[joints[j]]; node != scene::SkinnedMeshData::noParent; node = nodeParents[node])
+                    if (isJoint[node]) ++depths[j];
+
+            std::vector<std::size_t> order(joints.size());
+            for (std::size_t j = 0; j < order.size(); ++j) order[j] = j;
+            std::stable_sort(order.begin(), order.end(), [&depths](std::size_t a, std::size_t b) noexcept {
+                return depths[a] < depths[b];
+            });
+
+            for (std::size_t b = 0; b < order.size(); ++b)
+                nodeBones[joints[order[b]]] = b;
+
+            jointBones.resize(joints.size());
+            for (std::size_t j = 0; j < joints.size(); ++j)
+                jointBones[j] = static_cast<std::uint16_t>(nodeBones[joints[j]]);
+
+            Accessor inverseBindMatrices;
+            if (skinValue.hasMember("inverseBindMatrices"))
+            {
+                inverseBindMatrices = getAccessor(d, buffers, skinValue["inverseBindMatrices"].as<std::size_t>());
+                if (inverseBindMatrices.count < joints.size() || inverseBindMatrices.components != 16)
+                    throw std::runtime_error("Invalid inverse bind matrices");
+            }
+
+            bones.resize(joints.size());
+            for (std::size_t b = 0; b < order.size(); ++b)
+            {
+                const auto joint = order[b];
+                const auto node = joints[joint];
+                auto& bone = bones[b];
+
+                setBoneTransform(nodesValue[node], bone);
+
+                // find the closest ancestor that is a bone
+                auto parentNode = nodeParents[node];
+                Matrix4F parentTransform = Matrix4F::identity();
+                while (parentNode != scene::SkinnedMeshData::noParent && !isJoint[parentNode])
+                {
+                    parentTransform = getNodeTransform(nodesValue[parentNode]) * parentTransform;
+                    parentNode = nodeParents[parentNode];
+                }
+
+                if (parentNode == scene::SkinnedMeshData::noParent)
+                    bone.parentTransform = parentTransform;
+                else
+                    bone.parent = nodeBones[parentNode];
+
+                if (inverseBindMatrices.data)
+                    for (std::size_t i = 0; i < 16; ++i)
+                        bone.inverseBindMatrix.m[i] = inverseBindMatrices.getFloat(joint, i);
+            }
+        }
+
+        // the vertices without weights follow the closest joint of the mesh node (or the root bone),
+        // so that they are not collapsed to the origin
+        scene::SkinnedMeshData::Influence defaultInfluence;
+        if (!bones.empty())
+        {
+            auto node = meshNode;
+            while (node != scene::SkinnedMeshData::noParent && nodeBones[node] == scene::SkinnedMeshData::noParent)
+                node = nodeParents[node];
+
+            if (node != scene::SkinnedMeshData::noParent)
+                defaultInfluence.bones[0] = static_cast<std::uint16_t>(nodeBones[node]);
+            defaultInfluence.weights[0] = 1.0F;
+        }
+
+        // mesh
+        const auto& meshValue = meshesValue[nodesValue[meshNode]["mesh"].as<std::size_t>()];
+        const auto& primitivesValue = meshValue["primitives"];
+
+        auto& vertices = mesh->vertices;
+        auto& influences = mesh->influences;
+        auto& indices = mesh->indices;
+        auto& boundingBox = mesh->boundingBox;
+        std::size_t materialIndex = std::numeric_limits<std::size_t>::max();
+
+        // static meshes are transformed to their node's space
+        const auto meshTransform = bones.empty() ? getGlobalTransform(meshNode) : Matrix4F::identity();
+
+        for (const auto& primitiveValue : primitivesValue)
+        {
+            if (primitiveValue.hasMember("mode") && primitiveValue["mode"].as<std::uint32_t>() != trianglesMode)
+                continue;
+
+            const auto& attributesValue = primitiveValue["attributes"];
+            if (!attributesValue.hasMember("POSITION"))
+                throw std::runtime_error("glTF primitive has no positions");
+
+            if (materialIndex == std::numeric_limits<std::size_t>::max() && primitiveValue.hasMember("material"))
+                materialIndex = primitiveValue["material"].as<std::size_t>();
+
+            const auto positions = getAccessor(d, buffers, attributesValue["POSITION"].as<std::size_t>());
+            const auto baseVertex = static_cast<std::uint32_t>(vertices.size());
+
+            vertices.resize(baseVertex + positions.count, graphics::Vertex{Vector3F(), Color::white(), Vector2F(), Vector3F()});
+            influences.resize(baseVertex + positions.count, defaultInfluence);
+
+            for (std::size_t i = 0; i < positions.count; ++i)
+            {
+                auto& position = vertices[baseVertex + i].position;
+                position = Vector3F(positions.getFloat(i, 0), positions.getFloat(i, 1), positions.getFloat(i, 2));
+                meshTransform.transformPoint(position);
+                boundingBox.insertPoint(position);
+            }
+
+            if (attributesValue.hasMember("NORMAL"))
+            {
+                const auto normals = getAccessor(d, buffers, attributesValue["NORMAL"].as<std::size_t>());
+                for (std::size_t i = 0; i < std::min(normals.count, positions.count); ++i)
+                {
+                    auto& normal = vertices[baseVertex + i].normal;
+                    normal = Vector3F(normals.getFloat(i, 0), normals.getFloat(i, 1), normals.getFloat(i, 2));
+                    meshTransform.transformVector(normal);
+                    normal.normalize();
+                }
+            }
+
+            if (attributesValue.hasMember("TEXCOORD_0"))
+            {
+                const auto texCoords = getAccessor(d, buffers, attributesValue["TEXCOORD_0"].as<std::size_t>());
+                for (std::size_t i = 0; i < std::min(texCoords.count, positions.count); ++i)
+                    vertices[baseVertex + i].texCoords[0] = Vector2F(texCoords.getFloat(i, 0), texCoords.getFloat(i, 1));
+            }
+
+            if (attributesValue.hasMember("COLOR_0"))
+            {
+                const auto colors = getAccessor(d, buffers, attributesValue["COLOR_0"].as<std::size_t>());
+                for (std::size_t i = 0; i < std::min(colors.count, positions.count); ++i)
+                    vertices[baseVertex + i].color = Color(colors.getFloat(i, 0),
+                                                           colors.getFloat(i, 1),
+                                                           colors.getFloat(i, 2),
+                                                           colors.components == 4 ? colors.getFloat(i, 3) : 1.0F);
+            }
+
+            if (!bones.empty() &&
+                attributesValue.hasMember("JOINTS_0") &&
+                attributesValue.hasMember("WEIGHTS_0"))
+            {
+                const auto joints = getAccessor(d, buffers, attributesValue["JOINTS_0"].as<std::size_t>());
+                const auto weights = getAccessor(d, buffers, attributesValue["WEIGHTS_0"].as<std::size_t>());
+
+                if (joints.components != scene::SkinnedMeshData::maxInfluences ||
+                    weights.components != scene::SkinnedMeshData::maxInfluences)
+                    throw std::runtime_error("Invalid joint or weight accessor type");
+
+                for (std::size_t i = 0; i < std::min({joints.count, weights.count, positions.count}); ++i)
+                {
+                    auto& influence = influences[baseVertex + i];
+                    float totalWeight = 0.0F;
+
+                    for (std::size_t c = 0; c < scene::SkinnedMeshData::maxInfluences; ++c)
+                    {
+                        const auto joint = joints.getUInt(i, c);
+                        if (joint >= jointBones.size())
+                            throw std::runtime_error("Invalid joint index");
+
+                        influence.bones[c] = jointBones[joint];
+                        influence.weights[c] = weights.getFloat(i, c);
+                        totalWeight += influence.weights[c];
+                    }
+
+                    if (totalWeight > 0.0F)
+                        for (auto& weight : influence.weights)
+                            weight /= totalWeight;
+                    else
+                        influence = defaultInfluence;
+                }
+            }
+
+            if (primitiveValue.hasMember("indices"))
+            {
+                const auto indexAccessor = getAccessor(d, buffers, primitiveValue["indices"].as<std::size_t>());
+
+                // a single primitive with 16 or 32 bit indices can be uploaded straight from the buffer
+                if (primitivesValue.getSize() == 1 &&
+                    (indexAccessor.componentType == unsignedShortType || indexAccessor.componentType == unsignedIntType) &&
+                    indexAccessor.isTightlyPacked())
+                {
+                    mesh->indexData.assign(indexAccessor.data,
+                                             indexAccessor.data + indexAccessor.count * indexAccessor.componentSize);
+                    mesh->indexCount = static_cast<std::uint32_t>(indexAccessor.count);
+                    mesh->indexSize = static_cast<std::uint32_t>(indexAccessor.componentSize);
+                }
+                else
+                {
+                    indices.reserve(indices.size() + indexAccessor.count);
+                    for (std::size_t i = 0; i < indexAccessor.count; ++i)
+                        indices.push_back(baseVertex + indexAccessor.getUInt(i, 0));
+                }
+            }
+            else
+                for (std::uint32_t i = 0; i < positions.count; ++i)
+                    indices.push_back(baseVertex + i);
+        }
+
+        if (mesh->indexData.empty())
+            mesh->indexCount = static_cast<std::uint32_t>(indices.size());
+
+        if (materialIndex != std::numeric_limits<std::size_t>::max())
+        {
+            const auto& materialValue = d["materials"][materialIndex];
+
+            if (materialValue.hasMember("pbrMetallicRoughness") &&
+                materialValue["pbrMetallicRoughness"].hasMember("baseColorFactor"))
+            {
+                const auto& colorValue = materialValue["pbrMetallicRoughness"]["baseColorFactor"];
+                mesh->diffuseColor = Color(colorValue[0].as<float>(),
+                                               colorValue[1].as<float>(),
+                                               colorValue[2].as<float>(),
+                                               colorValue[3].as<float>());
+            }
+
+            mesh->doubleSided = materialValue.hasMember("doubleSided") && materialValue["doubleSided"].as<bool>();
+        }
+
+        // animations
+        auto& animations = mesh->animations;
+
+        if (!bones.empty() && d.hasMember("animations"))
+            for (const auto& animationValue : d["animations"])
+            {
+                scene::SkinnedMeshData::Animation animation;
+                animation.name = animationValue.hasMember("name") ?
+                    animationValue["name"].as<std::string>() :
+                    "animation" + std::to_string(animations.size());
+
+                const auto& samplersValue = animationValue["samplers"];
+
+                for (const auto& channelValue : animationValue["channels"])
+                {
+                    const auto& targetValue = channelValue["target"];
+                    if (!targetValue.hasMember("node")) continue;
+
+                    const auto node = targetValue["node"].as<std::size_t>();
+                    if (node >= nodeBones.size())
+                        throw std::runtime_error("Invalid node index");
+
+                    const auto bone = nodeBones[node];
+                    if (bone == scene::SkinnedMeshData::noParent) continue;
+
+                    scene::SkinnedMeshData::Channel channel;
+                    channel.bone = bone;
+
+                    const auto& path = targetValue["path"].as<std::string>();
+                    if (path == "translation") channel.path = scene::SkinnedMeshData::Channel::Path::translation;
+                    else if (path == "rotation") channel.path = scene::SkinnedMeshData::Channel::Path::rotation;
+                    else if (path == "scale") channel.path = scene::SkinnedMeshData::Channel::Path::scale;
+                    else continue; // morph target weights are not supported
+
+                    const auto& samplerValue = samplersValue[channelValue["sampler"].as<std::size_t>()];
+                    const auto interpolation = samplerValue.hasMember("interpolation") ?
+                        samplerValue["interpolation"].as<std::string>() : std::string("LINEAR");
+
+                    channel.interpolation = (interpolation == "STEP") ?
+                        scene::SkinnedMeshData::Channel::Interpolation::step :
+                        scene::SkinnedMeshData::Channel::Interpolation::linear;
+
+                    const auto input = getAccessor(d, buffers, samplerValue["input"].as<std::size_t>());
+                    const auto output = getAccessor(d, buffers, samplerValue["output"].as<std::size_t>());
+
+                    const std::size_t components = (channel.path == scene::SkinnedMeshData::Channel::Path::rotation) ? 4 : 3;
+
+                    // cubic spline keys store an in-tangent, the value and an out-tangent, only the values are used
+                    const std::size_t elementsPerKey = (interpolation == "CUBICSPLINE") ? 3 : 1;
+                    const std::size_t valueElement = (interpolation == "CUBICSPLINE") ? 1 : 0;
+
+                    if (output.components != components || output.count < input.count * elementsPerKey)
+                        throw std::runtime_error("Invalid animation sampler output");
+
+                    channel.times.resize(input.count);
+                    channel.values.resize(input.count * components);
+
+                    for (std::size_t k = 0; k < input.count; ++k)
+                    {
+                        channel.times[k] = input.getFloat(k, 0);
+                        for (std::size_t c = 0; c < components; ++c)
+                            channel.values[k * components + c] = output.getFloat(k * elementsPerKey + valueElement, c);
+                    }
+
+                    if (!channel.times.empty())
+                        animation.length = std::max(animation.length, channel.times.back());
+
+                    animation.channels.push_back(std::move(channel));
+                }
+
+                animations.push_back(std::move(animation));
+            }
+
+        return mesh;
+    }
+
+    bool GltfLoader::createAsset(Bundle& bundle,
+                                 const std::string& name,
+                                 Decoded& decoded,
+                                 bool)
+    {
+        auto& mesh = static_cast<DecodedMesh&>(decoded);
+
+        std::shared_ptr<graphics::Material> material = std::make_shared<graphics::Material>();
+        material->blendState = cache.getBlendState(blendAlpha);
+        material->shader = cache.getShader(shaderTexture);
+        material->textures[0] = cache.getTexture(textureWhitePixel);
+        material->diffuseColor = mesh.diffuseColor;
+        material->cullMode = mesh.doubleSided ? graphics::CullMode::none : graphics::CullMode::back;
+
+        const void* indexData = mesh.indexData.empty() ?
+            static_cast<const void*>(mesh.indices.data()) :
+            static_cast<const void*>(mesh.indexData.data());
 
-        scene::SkinnedMeshData skinnedMeshData;
+        scene::SkinnedMeshData skinnedMeshData(mesh.boundingBox,
+                                               material,
+                                               indexData,
+                                               mesh.indexCount,
+                                               mesh.indexSize,
+                                               std::move(mesh.vertices),
+                                               std::move(mesh.influences),
+                                               std::move(mesh.bones),
+                                               std::move(mesh.animations));
         bundle.setSkinnedMeshData(name, std::move(skinnedMeshData));
 
         return true;
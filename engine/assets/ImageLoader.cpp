@@ -49,10 +49,35 @@ namespace ouzel::assets
     {
     }
 
+    namespace
+    {
+        class DecodedImage final: public Loader::Decoded
+        {
+        public:
+            DecodedImage(graphics::PixelFormat initPixelFormat, const Size2U& initSize,
+                         std::vector<std::pair<Size2U, std::vector<std::uint8_t>>> initLevels):
+                pixelFormat(initPixelFormat), size(initSize), levels(std::move(initLevels))
+            {
+            }
+
+            graphics::PixelFormat pixelFormat;
+            Size2U size;
+            std::vector<std::pair<Size2U, std::vector<std::uint8_t>>> levels;
+        };
+    }
+
     bool ImageLoader::loadAsset(Bundle& bundle,
                                 const std::string& name,
                                 const std::vector<std::byte>& data,
                                 bool mipmaps)
+    {
+        const auto decoded = decodeAsset(name, data, mipmaps);
+        return createAsset(bundle, name, *decoded, mipmaps);
+    }
+
+    std::unique_ptr<Loader::Decoded> ImageLoader::decodeAsset(const std::string&,
+                                                              const std::vector<std::byte>& data,
+                                                              bool mipmaps)
     {
         int width;
         int height;
@@ -63,8 +88,9 @@ namespace ouzel::assets
                                                   &width, &height,
                                                   &comp, STBI_default);
 
+        // the failure reason of stb_image is a global that the loader threads would race on, so it is not reported
         if (!tempData)
-            throw std::runtime_error("Failed to load texture, reason: " + std::string(stbi_failure_reason()));
+            throw std::runtime_error("Failed to load texture");
 
         graphics::PixelFormat pixelFormat;
         std::vector<std::uint8_t> imageData;
@@ -152,12 +178,26 @@ namespace ouzel::assets
                                      static_cast<std::uint32_t>(height)),
                               imageData);
 
+        // the mip levels are the most expensive part, so they are generated here instead of the texture
+        return std::make_unique<DecodedImage>(image.getPixelFormat(), image.getSize(),
+                                              graphics::Texture::createLevels(image.getData(),
+                                                                              image.getSize(),
+                                                                              mipmaps ? 0 : 1,
+                                                                              image.getPixelFormat()));
+    }
+
+    bool ImageLoader::createAsset(Bundle& bundle,
+                                  const std::string& name,
+                                  Decoded& decoded,
+                                  bool)
+    {
+        auto& image = static_cast<DecodedImage&>(decoded);
+
         auto texture = std::make_shared<graphics::Texture>(*engine->getGraphics(),
-                                                           image.getData(),
-                                                           image.getSize(),
+                                                           std::move(image.levels),
+                                                           image.size,
                                                            graphics::Flags::none,
-                                                           mipmaps ? 0 : 1,
-                                                           image.getPixelFormat());
+                                                           image.pixelFormat);
 
         bundle.setTexture(name, texture);
 
@@ -15,6 +15,14 @@ namespace ouzel::assets
                        const std::string& name,
                        const std::vector<std::byte>& data,
                        bool mipmaps = true) final;
+
+        std::unique_ptr<Decoded> decodeAsset(const std::string& name,
+                                             const std::vector<std::byte>& data,
+                                             bool mipmaps = true) final;
+        bool createAsset(Bundle& bundle,
+                         const std::string& name,
+                         Decoded& decoded,
+                         bool mipmaps = true) final;
     };
 }
 
@@ -4,6 +4,7 @@
 #define OUZEL_ASSETS_LOADER_HPP
 
 #include <cstddef>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -29,6 +30,20 @@ namespace ouzel::assets
             cue
         };
 
+        // an asset decoded on a loader thread that still has to be created on the thread of the bundle
+        class Decoded
+        {
+        public:
+            Decoded() = default;
+            virtual ~Decoded() = default;
+
+            Decoded(const Decoded&) = delete;
+            Decoded& operator=(const Decoded&) = delete;
+
+            Decoded(Decoded&&) = delete;
+            Decoded& operator=(Decoded&&) = delete;
+        };
+
         Loader(Cache& initCache, Type initType):
             cache(initCache), type(initType)
         {
@@ -49,6 +64,21 @@ namespace ouzel::assets
                                const std::vector<std::byte>& data,
                                bool mipmaps = true) = 0;
 
+        // called on the loader threads, so it must not touch the bundle, the cache or the engine,
+        // returns nullptr if the loader does all of the work in loadAsset
+        virtual std::unique_ptr<Decoded> decodeAsset(const std::string&,
+                                                     const std::vector<std::byte>&,
+                                                     bool = true)
+        {
+            return nullptr;
+        }
+
+        // creates the asset decoded by decodeAsset of the same loader
+        virtual bool createAsset(Bundle&, const std::string&, Decoded&, bool = true)
+        {
+            return false;
+        }
+
     protected:
         Cache& cache;
         Type type;
@@ -0,0 +1,223 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <stdexcept>
+#include "Loading.hpp"
+#include "Cache.hpp"
+
+namespace ouzel::assets
+{
+    namespace
+    {
+        // the assets that other assets refer to by name are created first
+        std::uint32_t getStage(Loader::Type type) noexcept
+        {
+            switch (type)
+            {
+                case Loader::Type::bank:
+                case Loader::Type::image:
+                case Loader::Type::sound:
+                    return 0;
+                case Loader::Type::font:
+                case Loader::Type::material:
+                case Loader::Type::particleSystem:
+                case Loader::Type::sprite:
+                case Loader::Type::cue:
+                    return 1;
+                case Loader::Type::staticMesh:
+                case Loader::Type::skinnedMesh:
+                    return 2;
+            }
+
+            return 0;
+        }
+    }
+
+    Loading::Loading(Bundle& initBundle, const std::vector<Asset>& assets, std::uint32_t workerCount):
+        bundle(initBundle), fileSystem(initBundle.fileSystem)
+    {
+        for (const auto& loader : bundle.cache.getLoaders())
+            loaders.push_back(loader.get());
+
+        std::vector<Asset> sortedAssets = assets;
+        std::stable_sort(sortedAssets.begin(), sortedAssets.end(),
+                         [](const Asset& a, const Asset& b) {
+                             return getStage(a.type) < getStage(b.type);
+                         });
+
+        items.reserve(sortedAssets.size());
+        for (const Asset& asset : sortedAssets)
+            items.emplace_back(asset);
+
+        if (items.empty() || !workerCount) return;
+
+        workerCount = static_cast<std::uint32_t>(std::min<std::size_t>(workerCount, items.size()));
+
+        // limits the memory taken by the files that are read but not created yet
+        maxPending = workerCount * 4;
+
+        readerThread = thread::Thread(&Loading::readerMain, this);
+
+        workerThreads.reserve(workerCount);
+        for (std::uint32_t i = 0; i < workerCount; ++i)
+            workerThreads.emplace_back(&Loading::workerMain, this);
+    }
+
+    Loading::~Loading()
+    {
+        std::unique_lock lock(mutex);
+        running = false;
+        lock.unlock();
+
+        readerCondition.notify_all();
+        workerCondition.notify_all();
+
+        if (readerThread.isJoinable()) readerThread.join();
+
+        for (auto& workerThread : workerThreads)
+            if (workerThread.isJoinable()) workerThread.join();
+    }
+
+    bool Loading::update()
+    {
+        if (workerThreads.empty())
+        {
+            for (; loadedCount < items.size(); ++loadedCount)
+            {
+                const auto& asset = items[loadedCount].asset;
+                bundle.loadAsset(asset.type, asset.name, asset.filename, asset.mipmaps);
+            }
+
+            return true;
+        }
+
+        while (loadedCount < items.size())
+        {
+            std::unique_lock lock(mutex);
+            auto& item = items[loadedCount];
+            if (item.state != State::ready) return false;
+            lock.unlock();
+
+            const auto exception = item.exception;
+            const auto decoded = std::move(item.decoded);
+            const auto data = std::move(item.data);
+            Loader* loader = item.loader;
+
+            lock.lock();
+            ++loadedCount;
+            lock.unlock();
+            readerCondition.notify_one();
+
+            if (exception) std::rethrow_exception(exception);
+
+            if (!decoded)
+                bundle.loadAsset(item.asset.type, item.asset.name, item.asset.filename, data, item.asset.mipmaps);
+            else if (!loader->createAsset(bundle, item.asset.name, *decoded, item.asset.mipmaps))
+                throw std::runtime_error("Failed to load asset " + item.asset.filename);
+        }
+
+        return true;
+    }
+
+    void Loading::wait()
+    {
+        while (!update())
+        {
+            std::unique_lock lock(mutex);
+            readyCondition.wait(lock, [this]() { return items[loadedCount].state == State::ready; });
+        }
+    }
+
+    void Loading::readerMain()
+    {
+        thread::setCurrentThreadName("Loader");
+
+        for (std::size_t i = 0; i < items.size(); ++i)
+        {
+            std::unique_lock lock(mutex);
+            readerCondition.wait(lock, [this]() { return !running || readCount - loadedCount < maxPending; });
+            if (!running) break;
+            lock.unlock();
+
+            auto& item = items[i];
+            bool failed = false;
+
+            try
+            {
+                item.data = fileSystem.readFile(item.asset.filename);
+            }
+            catch (...)
+            {
+                item.exception = std::current_exception();
+                failed = true;
+            }
+
+            lock.lock();
+            ++readCount;
+
+            if (failed)
+            {
+                item.state = State::ready;
+                lock.unlock();
+                readyCondition.notify_all();
+            }
+            else
+            {
+                item.state = State::read;
+                readQueue.push_back(i);
+                lock.unlock();
+                workerCondition.notify_one();
+            }
+        }
+
+        std::unique_lock lock(mutex);
+        reading = false;
+        lock.unlock();
+        workerCondition.notify_all();
+    }
+
+    void Loading::workerMain()
+    {
+        thread::setCurrentThreadName("Loader worker");
+
+        for (;;)
+        {
+            std::unique_lock lock(mutex);
+            workerCondition.wait(lock, [this]() { return !running || !reading || !readQueue.empty(); });
+            if (!running || readQueue.empty()) break;
+
+            auto& item = items[readQueue.front()];
+            readQueue.pop_front();
+            lock.unlock();
+
+            // only the loader that would be tried first can decode the asset, if it leaves the work to loadAsset,
+            // all of the loaders are tried on the thread of the bundle
+            const auto loader = std::find_if(loaders.rbegin(), loaders.rend(),
+                                             [&item](const Loader* l) { return l->getType() == item.asset.type; });
+
+            try
+            {
+                if (loader != loaders.rend())
+                {
+                    item.decoded = (*loader)->decodeAsset(item.asset.name, item.data, item.asset.mipmaps);
+
+                    if (item.decoded)
+                    {
+                        item.loader = *loader;
+                        item.data.clear();
+                        item.data.shrink_to_fit();
+                    }
+                }
+            }
+            catch (...)
+            {
+                item.exception = std::current_exception();
+            }
+
+            lock.lock();
+            item.state = State::ready;
+            lock.unlock();
+            readyCondition.notify_all();
+        }
+    }
+}
@@ -0,0 +1,91 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_ASSETS_LOADING_HPP
+#define OUZEL_ASSETS_LOADING_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Bundle.hpp"
+#include "Loader.hpp"
+#include "../thread/Thread.hpp"
+
+namespace ouzel::assets
+{
+    // loads a list of assets into a bundle, the files are read on a reader thread and decoded on the worker threads,
+    // the assets are created in the order of their dependencies on the thread that calls update or wait,
+    // without worker threads all of the assets are read and created by the first call to update or wait
+    class Loading final
+    {
+    public:
+        Loading(Bundle& initBundle, const std::vector<Asset>& assets, std::uint32_t workerCount);
+        ~Loading();
+
+        Loading(const Loading&) = delete;
+        Loading& operator=(const Loading&) = delete;
+
+        Loading(Loading&&) = delete;
+        Loading& operator=(Loading&&) = delete;
+
+        // creates the assets that are ready, returns true when all of them are loaded
+        bool update();
+        void wait();
+
+        auto getAssetCount() const noexcept { return items.size(); }
+        std::size_t getLoadedCount() const noexcept { return loadedCount; }
+        float getProgress() const noexcept
+        {
+            return items.empty() ? 1.0F : static_cast<float>(loadedCount) / static_cast<float>(items.size());
+        }
+
+    private:
+        void readerMain();
+        void workerMain();
+
+        enum class State
+        {
+            pending,
+            read,
+            ready
+        };
+
+        class Item final
+        {
+        public:
+            explicit Item(const Asset& initAsset): asset(initAsset) {}
+
+            Asset asset;
+            State state = State::pending;
+            std::vector<std::byte> data;
+            Loader* loader = nullptr;
+            std::unique_ptr<Loader::Decoded> decoded;
+            std::exception_ptr exception;
+        };
+
+        Bundle& bundle;
+        storage::FileSystem& fileSystem;
+        std::vector<Loader*> loaders;
+        std::vector<Item> items;
+        std::size_t maxPending = 0;
+
+        std::mutex mutex;
+        std::condition_variable readerCondition;
+        std::condition_variable workerCondition;
+        std::condition_variable readyCondition;
+        std::deque<std::size_t> readQueue;
+        std::size_t readCount = 0;
+        bool reading = true;
+        bool running = true;
+        std::atomic<std::size_t> loadedCount{0};
+
+        thread::Thread readerThread;
+        std::vector<thread::Thread> workerThreads;
+    };
+}
+
+#endif // OUZEL_ASSETS_LOADING_HPP
@@ -9,11 +9,55 @@
 #include "Bundle.hpp"
 #include "Cache.hpp"
 #include "../graphics/Material.hpp"
+#include "../graphics/MeshOptimizer.hpp"
 
 namespace ouzel::assets
 {
     namespace
     {
+        constexpr std::size_t maxLodCount = 4;
+
+        scene::StaticMeshData createStaticMeshData(const Box3F& boundingBox,
+                                                   std::vector<std::uint32_t>& indices,
+                                                   std::vector<graphics::Vertex>& vertices,
+                                                   const graphics::Material* material)
+        {
+            graphics::optimizeVertexCache(indices, vertices.size());
+            graphics::optimizeOverdraw(indices, vertices);
+
+            // all levels of detail share the vertex buffer and are stored one after another in the index buffer
+            std::vector<scene::StaticMeshData::Lod> lods{{0, static_cast<std::uint32_t>(indices.size()), 0.0F}};
+            std::vector<std::uint32_t> lodIndices = indices;
+            std::size_t previousIndexCount = indices.size();
+            float screenSize = 0.5F;
+
+            while (lods.size() < maxLodCount)
+            {
+                auto simplified = graphics::simplify(indices, vertices, previousIndexCount / 2);
+
+                // stop when the mesh can not be simplified any further
+                if (simplified.size() < 3 || simplified.size() * 4 > previousIndexCount * 3)
+                    break;
+
+                graphics::optimizeVertexCache(simplified, vertices.size());
+
+                lods.back().screenSize = screenSize;
+                screenSize /= 2.0F;
+
+                lods.push_back(scene::StaticMeshData::Lod{
+                    static_cast<std::uint32_t>(lodIndices.size()),
+                    static_cast<std::uint32_t>(simplified.size()),
+                    0.0F
+                });
+                lodIndices.insert(lodIndices.end(), simplified.begin(), simplified.end());
+                previousIndexCount = simplified.size();
+            }
+
+            graphics::optimizeVertexFetch(lodIndices, vertices);
+
+            return scene::StaticMeshData(boundingBox, lodIndices, vertices, material, lods);
+        }
+
         constexpr auto isWhitespace(std::byte c)
         {
             return static_cast<char>(c) == ' ' ||
@@ -251,7 +295,7 @@ namespace ouzel::assets
                 {
                     if (objectCount)
                     {
-                        scene::StaticMeshData meshData(boundingBox, indices, vertices, material);
+                        auto meshData = createStaticMeshData(boundingBox, indices, vertices, material);
                         bundle.setStaticMeshData(objectName, std::move(meshData));
                     }
 
@@ -414,7 +458,7 @@ namespace ouzel::assets
 
         if (objectCount)
         {
-            scene::StaticMeshData meshData(boundingBox, indices, vertices, material);
+            auto meshData = createStaticMeshData(boundingBox, indices, vertices, material);
             bundle.setStaticMeshData(objectName, std::move(meshData));
         }
 
@@ -15,12 +15,12 @@ namespace ouzel::assets
     bool TtfLoader::loadAsset(Bundle& bundle,
                               const std::string& name,
                               const std::vector<std::byte>& data,
-                              bool mipmaps)
+                              bool)
     {
         try
         {
             // TODO: move the loader here
-            auto font = std::make_unique<gui::TTFont>(data, mipmaps);
+            auto font = std::make_unique<gui::TTFont>(data);
             bundle.setFont(name, std::move(font));
         }
         catch (const std::exception&)
@@ -1,15 +1,19 @@
 // Copyright 2015-2020 Elviss Strazdins. All rights reserved.
 
+#include <algorithm>
 #include <cstring>
 #include "WaveLoader.hpp"
 #include "Bundle.hpp"
 #include "../audio/PcmClip.hpp"
+#include "../audio/mixer/Adpcm.hpp"
+#include "../audio/mixer/Dsp.hpp"
 #include "../core/Engine.hpp"
 
 namespace
 {
     constexpr std::uint16_t WAVE_FORMAT_PCM = 1;
     constexpr std::uint16_t WAVE_FORMAT_IEEE_FLOAT = 3;
+    constexpr std::uint16_t WAVE_FORMAT_IMA_ADPCM = 0x11;
 
     constexpr std::int32_t convert24bitTo232bit(std::byte data[3])
     {
@@ -26,6 +30,22 @@ namespace
 
 namespace ouzel::assets
 {
+    namespace
+    {
+        // the samples converted to the encoding of the clip, only one of the sample vectors is used
+        class DecodedSound final: public Loader::Decoded
+        {
+        public:
+            std::uint32_t channels = 0;
+            std::uint32_t sampleRate = 0;
+            std::uint32_t frames = 0;
+            std::vector<std::uint8_t> blocks;
+            std::size_t blockSize = 0;
+            std::vector<std::int16_t> shortSamples;
+            std::vector<float> floatSamples;
+        };
+    }
+
     WaveLoader::WaveLoader(Cache& initCache):
         Loader(initCache, Type::sound)
     {
@@ -34,12 +54,22 @@ namespace ouzel::assets
     bool WaveLoader::loadAsset(Bundle& bundle,
                                const std::string& name,
                                const std::vector<std::byte>& data,
-                               bool)
+                               bool mipmaps)
+    {
+        const auto decoded = decodeAsset(name, data, mipmaps);
+        return decoded && createAsset(bundle, name, *decoded, mipmaps);
+    }
+
+    // returns nullptr for the files that are not valid WAVE files, so that the other sound loaders can try them
+    std::unique_ptr<Loader::Decoded> WaveLoader::decodeAsset(const std::string&,
+                                                             const std::vector<std::byte>& data,
+                                                             bool)
     {
         try
         {
-            std::uint32_t channels = 0;
-            std::uint32_t sampleRate = 0;
+            auto sound = std::make_unique<DecodedSound>();
+            auto& channels = sound->channels;
+            auto& sampleRate = sound->sampleRate;
 
             const std::size_t formatOffset = 0;
 
@@ -72,6 +102,7 @@ namespace ouzel::assets
                 throw std::runtime_error("Failed to load sound file, not a WAVE file");
 
             std::uint16_t bitsPerSample = 0;
+            std::uint16_t blockAlign = 0;
             std::uint16_t formatTag = 0;
             std::vector<std::byte> soundData;
 
@@ -112,7 +143,9 @@ namespace ouzel::assets
                     formatTag = static_cast<std::uint16_t>(static_cast<std::uint32_t>(data[formatTagOffset + 0]) |
                                                            (static_cast<std::uint32_t>(data[formatTagOffset + 1]) << 8));
 
-                    if (formatTag != WAVE_FORMAT_PCM && formatTag != WAVE_FORMAT_IEEE_FLOAT)
+                    if (formatTag != WAVE_FORMAT_PCM &&
+                        formatTag != WAVE_FORMAT_IEEE_FLOAT &&
+                        formatTag != WAVE_FORMAT_IMA_ADPCM)
                         throw std::runtime_error("Failed to load sound file, unsupported format");
 
                     const std::size_t channelsOffset = formatTagOffset + 2;
@@ -133,24 +166,26 @@ namespace ouzel::assets
 
                     const std::size_t byteRateOffset = sampleRateOffset + 4;
                     const std::size_t blockAlignOffset = byteRateOffset + 4;
+                    blockAlign = static_cast<std::uint16_t>(static_cast<std::uint32_t>(data[blockAlignOffset + 0]) |
+                                                            (static_cast<std::uint32_t>(data[blockAlignOffset + 1]) << 8));
+
                     const std::size_t bitsPerSampleOffset = blockAlignOffset + 2;
                     bitsPerSample = static_cast<std::uint16_t>(static_cast<std::uint32_t>(data[bitsPerSampleOffset + 0]) |
                                                                (static_cast<std::uint32_t>(data[bitsPerSampleOffset + 1]) << 8));
 
-                    if (bitsPerSample != 8 && bitsPerSample != 16 &&
-                        bitsPerSample != 24 && bitsPerSample != 32)
-                        throw std::runtime_error("Failed to load sound file, unsupported bit depth");
-
-                    if (formatTag != WAVE_FORMAT_PCM && formatTag != WAVE_FORMAT_IEEE_FLOAT)
+                    if (formatTag == WAVE_FORMAT_PCM)
                     {
-                        const auto size = static_cast<std::uint32_t>(data[offset + 0]) |
-                            (static_cast<std::uint32_t>(data[offset + 1]) << 8) |
-                            (static_cast<std::uint32_t>(data[offset + 2]) << 16) |
-                            (static_cast<std::uint32_t>(data[offset + 3]) << 24);
-
-                        offset += 4;
-                        offset += size; // skip the additional data
+                        if (bitsPerSample != 8 && bitsPerSample != 16 &&
+                            bitsPerSample != 24 && bitsPerSample != 32)
+                            throw std::runtime_error("Failed to load sound file, unsupported bit depth");
+                    }
+                    else if (formatTag == WAVE_FORMAT_IEEE_FLOAT)
+                    {
+                        if (bitsPerSample != 32)
+                            throw std::runtime_error("Failed to load sound file, unsupported bit depth");
                     }
+                    else if (bitsPerSample != 4)
+                        throw std::runtime_error("Failed to load sound file, unsupported bit depth");
                 }
                 else if (static_cast<char>(chunkHeader[0]) == 'd' &&
                          static_cast<char>(chunkHeader[1]) == 'a' &&
@@ -165,49 +200,83 @@ namespace ouzel::assets
             if (!formatTag)
                 throw std::runtime_error("Failed to load sound file, failed to find a format chunk");
 
-            if (data.empty())
+            if (soundData.empty())
                 throw std::runtime_error("Failed to load sound file, failed to find a data chunk");
 
-            const auto sampleCount = static_cast<std::uint32_t>(soundData.size() / (bitsPerSample / 8));
-            const auto frames = sampleCount / channels;
-            std::vector<float> samples(sampleCount);
+            // 8 and 16-bit samples are kept as 16-bit and ADPCM as is, only the deeper ones are converted to floats
 
-            if (formatTag == WAVE_FORMAT_PCM)
+            if (formatTag == WAVE_FORMAT_IMA_ADPCM)
             {
-                switch (bitsPerSample)
+                constexpr std::size_t headerSize = audio::mixer::adpcm::headerSize;
+                if (blockAlign <= headerSize * channels || blockAlign % (headerSize * channels) != 0)
+                    throw std::runtime_error("Failed to load sound file, unsupported block size");
+
+                // the channels are interleaved in four byte chunks, the clip stores a block of every channel after another
+                const std::size_t blockSize = blockAlign / channels;
+                const std::size_t blockCount = (soundData.size() + blockAlign - 1) / blockAlign;
+                auto& blocks = sound->blocks;
+                blocks.resize(blockCount * blockAlign);
+                auto& frames = sound->frames;
+
+                for (std::size_t block = 0; block < blockCount; ++block)
                 {
-                    case 8:
-                    {
+                    const std::size_t blockOffset = block * blockAlign;
+                    const std::size_t chunks = std::min<std::size_t>(soundData.size() - blockOffset, blockAlign) /
+                        (headerSize * channels); // including the header
+                    if (!chunks) break;
+
+                    frames += static_cast<std::uint32_t>((chunks - 1) * 8 + 1);
+
+                    for (std::size_t chunk = 0; chunk < chunks; ++chunk)
                         for (std::uint32_t channel = 0; channel < channels; ++channel)
                         {
-                            auto outputChannel = &samples[channel * frames];
+                            const auto sourceData = &soundData[blockOffset + (chunk * channels + channel) * headerSize];
+                            const auto outputData = &blocks[blockOffset + channel * blockSize + chunk * headerSize];
 
-                            for (std::uint32_t frame = 0; frame < frames; ++frame)
-                            {
-                                const auto sourceData = &soundData[frame * channels + channel];
-                                const auto value = static_cast<std::uint8_t>(sourceData[0]);
-                                outputChannel[frame] = 2.0F * value / 255.0F - 1.0F;
-                            }
+                            for (std::size_t i = 0; i < headerSize; ++i)
+                                outputData[i] = static_cast<std::uint8_t>(sourceData[i]);
                         }
-                        break;
-                    }
-                    case 16:
+                }
+
+                sound->blockSize = blockSize;
+            }
+            else
+            {
+                const auto sampleCount = static_cast<std::uint32_t>(soundData.size() / (bitsPerSample / 8));
+                const auto frames = sampleCount / channels;
+
+                if (formatTag == WAVE_FORMAT_PCM && (bitsPerSample == 8 || bitsPerSample == 16))
+                {
+                    auto& samples = sound->shortSamples;
+                    samples.resize(frames * channels);
+
+                    for (std::uint32_t channel = 0; channel < channels; ++channel)
                     {
-                        for (std::uint32_t channel = 0; channel < channels; ++channel)
-                        {
-                            auto outputChannel = &samples[channel * frames];
+                        auto outputChannel = &samples[channel * frames];
 
-                            for (std::uint32_t frame = 0; frame < frames; ++frame)
+                        for (std::uint32_t frame = 0; frame < frames; ++frame)
+                        {
+                            if (bitsPerSample == 8)
+                            {
+                                const auto value = static_cast<std::uint8_t>(soundData[frame * channels + channel]);
+                                outputChannel[frame] = static_cast<std::int16_t>((value - 128) * 256);
+                            }
+                            else
                             {
                                 const auto sourceData = &soundData[(frame * channels + channel) * 2];
-                                const auto value = static_cast<std::int32_t>(sourceData[0]) |
-                                    (static_cast<std::int32_t>(sourceData[1]) << 8);
-                                outputChannel[frame] = static_cast<float>(value) / 32767.0F;
+                                outputChannel[frame] = static_cast<std::int16_t>(static_cast<std::uint32_t>(sourceData[0]) |
+                                                                                 (static_cast<std::uint32_t>(sourceData[1]) << 8));
                             }
                         }
-                        break;
                     }
-                    case 24:
+
+                }
+                else
+                {
+                    auto& samples = sound->floatSamples;
+                    samples.resize(frames * channels);
+
+                    if (formatTag == WAVE_FORMAT_PCM && bitsPerSample == 24)
                     {
                         for (std::uint32_t channel = 0; channel < channels; ++channel)
                         {
@@ -221,9 +290,8 @@ namespace ouzel::assets
                                 outputChannel[frame] = static_cast<float>(value / 8388607.0);
                             }
                         }
-                        break;
                     }
-                    case 32:
+                    else if (formatTag == WAVE_FORMAT_PCM)
                     {
                         for (std::uint32_t channel = 0; channel < channels; ++channel)
                         {
@@ -239,38 +307,45 @@ namespace ouzel::assets
                                 outputChannel[frame] = static_cast<float>(value / 2147483647.0);
                             }
                         }
-                        break;
                     }
-                    default:
-                        throw std::runtime_error("Failed to load sound file, unsupported bit depth");
-                }
-            }
-            else if (formatTag == WAVE_FORMAT_IEEE_FLOAT)
-            {
-                if (bitsPerSample == 32)
-                {
-                    for (std::uint32_t channel = 0; channel < channels; ++channel)
+                    else
                     {
-                        auto outputChannel = &samples[channel * frames];
-
-                        for (std::uint32_t frame = 0; frame < frames; ++frame)
-                        {
-                            const auto sourceData = &soundData[(frame * channels + channel) * 4];
-                            std::memcpy(&outputChannel[frame], sourceData, sizeof(float));
-                        }
+                        std::vector<float> interleavedSamples(frames * channels);
+                        std::memcpy(interleavedSamples.data(), soundData.data(), interleavedSamples.size() * sizeof(float));
+                        audio::mixer::dsp::deinterleave(interleavedSamples.data(), frames, channels, samples.data());
                     }
                 }
-                else
-                    throw std::runtime_error("Failed to load sound file, unsupported bit depth");
+
+                sound->frames = frames;
             }
 
-            auto sound = std::make_unique<audio::PcmClip>(*engine->getAudio(), channels, sampleRate, samples);
-            bundle.setSound(name, std::move(sound));
+            return sound;
         }
         catch (const std::exception&)
         {
-            return false;
+            return nullptr;
         }
+    }
+
+    bool WaveLoader::createAsset(Bundle& bundle,
+                                 const std::string& name,
+                                 Decoded& decoded,
+                                 bool)
+    {
+        auto& sound = static_cast<DecodedSound&>(decoded);
+
+        std::unique_ptr<audio::PcmClip> clip;
+        if (!sound.blocks.empty())
+            clip = std::make_unique<audio::PcmClip>(*engine->getAudio(), sound.channels, sound.sampleRate,
+                                                    sound.frames, std::move(sound.blocks), sound.blockSize);
+        else if (!sound.shortSamples.empty())
+            clip = std::make_unique<audio::PcmClip>(*engine->getAudio(), sound.channels, sound.sampleRate,
+                                                    sound.shortSamples);
+        else
+            clip = std::make_unique<audio::PcmClip>(*engine->getAudio(), sound.channels, sound.sampleRate,
+                                                    sound.floatSamples);
+
+        bundle.setSound(name, std::move(clip));
 
         return true;
     }
@@ -1,13 +1,19 @@
 // Copyright 2015-2020 Elviss Strazdins. All rights reserved.
 
 #include <algorithm>
+#include <cmath>
 #include "../core/Setup.h"
 #include "Audio.hpp"
+#include "mixer/Realtime.hpp"
 #include "AudioDevice.hpp"
+#include "Effects.hpp"
 #include "Listener.hpp"
+#include "Submix.hpp"
+#include "Voice.hpp"
 #include "alsa/ALSAAudioDevice.hpp"
 #include "coreaudio/CAAudioDevice.hpp"
 #include "empty/EmptyAudioDevice.hpp"
+#include "offline/OfflineAudioDevice.hpp"
 #include "openal/OALAudioDevice.hpp"
 #include "opensl/OSLAudioDevice.hpp"
 #include "xaudio2/XA2AudioDevice.hpp"
@@ -52,6 +58,8 @@ namespace ouzel::audio
             return Driver::alsa;
         else if (driver == "wasapi")
             return Driver::wasapi;
+        else if (driver == "offline")
+            return Driver::offline;
         else
             throw std::runtime_error("Invalid audio driver");
     }
@@ -63,6 +71,7 @@ namespace ouzel::audio
         if (availableDrivers.empty())
         {
             availableDrivers.insert(Driver::empty);
+            availableDrivers.insert(Driver::offline);
 
 #if OUZEL_COMPILE_OPENAL
             availableDrivers.insert(Driver::openAL);
@@ -125,6 +134,9 @@ namespace ouzel::audio
                     logger.log(Log::Level::info) << "Using WASAPI audio driver";
                     return std::make_unique<wasapi::AudioDevice>(settings, dataGetter);
 #endif
+                case Driver::offline:
+                    logger.log(Log::Level::info) << "Using offline audio driver";
+                    return std::make_unique<offline::AudioDevice>(settings, dataGetter);
                 default:
                     logger.log(Log::Level::info) << "Not using audio driver";
                     return std::make_unique<empty::AudioDevice>(settings, dataGetter);
@@ -136,60 +148,194 @@ namespace ouzel::audio
         device(createAudioDevice(driver,
                                  std::bind(&Audio::getSamples, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4),
                                  settings)),
-        mixer(device->getBufferSize(), device->getChannels(),
-              std::bind(&Audio::eventCallback, this, std::placeholders::_1)),
+        mixer(device->getBufferSize(), device->getChannels(), device->getSampleRate(), settings.latency,
+              std::bind(&Audio::eventCallback, this, std::placeholders::_1),
+              device->getDriver() == Driver::offline,
+              settings.mixerWorkers),
+        objectCapacity(mixer.getRootObjectId()),
+        debugAudio(settings.debugAudio),
+        resamplerQuality(settings.resamplerQuality),
+        maxVoices(settings.maxVoices),
         masterMix(*this),
         rootNode(*this) // mixer.getRootObjectId()
     {
+        mixer::realtime::setChecksEnabled(debugAudio);
+        mixer::Resampler::precomputeFilters(device->getSampleRate(), resamplerQuality);
         addCommand(std::make_unique<mixer::SetMasterBusCommand>(masterMix.getBusId()));
         device->start();
     }
 
     void Audio::update()
     {
-        // TODO: handle events from the audio device
+        std::unique_lock lock(stoppedStreamMutex);
+        std::swap(stoppedStreams, finishedStreams);
+        lock.unlock();
+
+        for (const auto& [streamId, playId] : finishedStreams)
+        {
+            // the voice could have been deleted since the stream stopped
+            const auto i = voices.find(streamId);
+            if (i != voices.end()) i->second->onStop(playId);
+        }
+
+        finishedStreams.clear();
+
+        updateVoices();
 
         mixer.submitCommandBuffer(std::move(commandBuffer));
         commandBuffer = mixer::CommandBuffer();
+
+        const auto invalidCommandCount = mixer.getInvalidCommandCount();
+        if (invalidCommandCount != reportedInvalidCommandCount)
+        {
+            logger.log(Log::Level::error) << "Mixer skipped " << invalidCommandCount - reportedInvalidCommandCount << " invalid commands";
+            reportedInvalidCommandCount = invalidCommandCount;
+        }
+
+        if (debugAudio)
+        {
+            const auto allocationCount = mixer::realtime::getAllocationCount();
+            if (allocationCount != reportedAllocationCount)
+            {
+                logger.log(Log::Level::warning) << "Audio thread allocated memory " << allocationCount - reportedAllocationCount << " times";
+                reportedAllocationCount = allocationCount;
+            }
+
+            const auto blockCount = mixer::realtime::getBlockCount();
+            if (blockCount != reportedBlockCount)
+            {
+                logger.log(Log::Level::warning) << "Audio thread waited for a lock " << blockCount - reportedBlockCount << " times";
+                reportedBlockCount = blockCount;
+            }
+
+            const auto xrunCount = device->getXrunCount();
+            if (xrunCount != reportedXrunCount)
+            {
+                logger.log(Log::Level::warning) << "Audio device ran out of samples " << xrunCount - reportedXrunCount << " times";
+                reportedXrunCount = xrunCount;
+            }
+        }
     }
 
     void Audio::deleteObject(mixer::Mixer::ObjectId objectId)
     {
+        dataObjects.erase(objectId);
+        timings.erase(objectId);
         addCommand(std::make_unique<mixer::DeleteObjectCommand>(objectId));
     }
 
+    mixer::Mixer::ObjectId Audio::initObject(std::unique_ptr<mixer::Source> source)
+    {
+        const auto objectId = allocateObjectId();
+        addCommand(std::make_unique<mixer::InitObjectCommand>(objectId, std::move(source)));
+        return objectId;
+    }
+
     mixer::Mixer::ObjectId Audio::initBus()
     {
-        const auto busId = mixer.getObjectId();
-        addCommand(std::make_unique<mixer::InitBusCommand>(busId));
+        const auto busId = allocateObjectId();
+        auto command = std::make_unique<mixer::InitBusCommand>(busId, device->getBufferSize() * device->getChannels());
+        command->bus->setTiming(timings[busId] = std::make_shared<mixer::Timing>());
+        addCommand(std::move(command));
         return busId;
     }
 
     mixer::Mixer::ObjectId Audio::initStream(mixer::Mixer::ObjectId sourceId)
     {
-        const auto streamId = mixer.getObjectId();
-        addCommand(std::make_unique<mixer::InitStreamCommand>(streamId, sourceId));
+        auto stream = createStream(sourceId);
+        stream->reserveBuffers(device->getBufferSize());
+        const auto streamId = allocateObjectId();
+        stream->setTiming(timings[streamId] = std::make_shared<mixer::Timing>());
+        addCommand(std::make_unique<mixer::InitStreamCommand>(streamId, std::move(stream)));
         return streamId;
     }
 
+    std::unique_ptr<mixer::Stream> Audio::createStream(mixer::Mixer::ObjectId sourceId)
+    {
+        const auto i = dataObjects.find(sourceId);
+        if (i == dataObjects.end())
+            throw std::runtime_error("Invalid audio data");
+
+        // the data is immutable, so the stream can be created outside the mixer
+        auto& data = *i->second;
+        auto stream = data.createStream();
+
+        // prepared even for the matching sample rates, because the Doppler shift is done by the resampler
+        auto& resampler = stream->getResampler();
+        resampler.setQuality(resamplerQuality);
+        resampler.prepare(data.getSampleRate(), device->getSampleRate(), data.getChannels(), device->getBufferSize());
+
+        return stream;
+    }
+
     mixer::Mixer::ObjectId Audio::initData(std::unique_ptr<mixer::Data> data)
     {
-        const auto dataId = mixer.getObjectId();
+        const auto dataId = allocateObjectId();
+        dataObjects[dataId] = data.get();
         addCommand(std::make_unique<mixer::InitDataCommand>(dataId, std::move(data)));
         return dataId;
     }
 
     mixer::Mixer::ObjectId Audio::initProcessor(std::unique_ptr<mixer::Processor> processor)
     {
-        const auto processorId = mixer.getObjectId();
+        const auto processorId = allocateObjectId();
+        processor->setTiming(timings[processorId] = std::make_shared<mixer::Timing>());
         addCommand(std::make_unique<mixer::InitProcessorCommand>(processorId, std::move(processor)));
         return processorId;
     }
 
-    void Audio::updateProcessor(mixer::Mixer::ObjectId processorId,
-                                const std::function<void(mixer::Processor*)>& updateFunction)
+    Audio::MemoryStatistics Audio::getMemoryStatistics() const noexcept
     {
-        addCommand(std::make_unique<mixer::UpdateProcessorCommand>(processorId, updateFunction));
+        MemoryStatistics statistics;
+        statistics.clipCount = clipCount;
+        statistics.residentSize = residentClipSize;
+        statistics.decodedSize = decodedClipSize;
+        return statistics;
+    }
+
+    Audio::DspStatistics Audio::getDspStatistics()
+    {
+        const auto mixerStatistics = mixer.takeStatistics();
+        const auto& renderTiming = mixerStatistics.renderTiming;
+
+        DspStatistics statistics;
+        statistics.blockCount = static_cast<std::size_t>(renderTiming.blockCount);
+        statistics.xrunCount = device->getXrunCount();
+
+        if (renderTiming.blockCount > 0)
+        {
+            const auto blockDuration = std::chrono::duration<double>(static_cast<double>(device->getBufferSize()) /
+                                                                     static_cast<double>(device->getSampleRate()));
+            const std::chrono::duration<double> totalTime = renderTiming.totalTime;
+            const std::chrono::duration<double> maximumTime = renderTiming.maximumTime;
+            statistics.load = static_cast<float>(totalTime / (blockDuration * static_cast<double>(renderTiming.blockCount)));
+            statistics.peakLoad = static_cast<float>(maximumTime / blockDuration);
+        }
+
+        for (std::size_t bin = 0; bin < statistics.jitterHistogram.size(); ++bin)
+            statistics.jitterHistogram[bin] = static_cast<std::size_t>(mixerStatistics.jitterHistogram[bin]);
+
+        return statistics;
+    }
+
+    mixer::Timing::Statistics Audio::getNodeStatistics(mixer::Mixer::ObjectId objectId)
+    {
+        const auto i = timings.find(objectId);
+        return (i != timings.end()) ? i->second->take() : mixer::Timing::Statistics{};
+    }
+
+    void Audio::addClip(std::size_t size, std::size_t decodedSize) noexcept
+    {
+        ++clipCount;
+        residentClipSize += size;
+        decodedClipSize += decodedSize;
+    }
+
+    void Audio::removeClip(std::size_t size, std::size_t decodedSize) noexcept
+    {
+        --clipCount;
+        residentClipSize -= size;
+        decodedClipSize -= decodedSize;
     }
 
     void Audio::getSamples(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate, std::vector<float>& samples)
@@ -197,7 +343,139 @@ namespace ouzel::audio
         mixer.getSamples(frames, channels, sampleRate, samples);
     }
 
-    void Audio::eventCallback(const mixer::Mixer::Event&)
+    void Audio::eventCallback(const mixer::Mixer::Event& event)
+    {
+        // called on the mixer thread
+        if (event.type == mixer::Mixer::Event::Type::starvation)
+            logger.log(Log::Level::warning) << "Audio mixer starved " << event.starvationCount <<
+                " times, " << event.missingFrames << " frames were replaced by silence";
+        else if (event.type == mixer::Mixer::Event::Type::streamStopped)
+        {
+            // the voices are updated on the game thread
+            std::lock_guard lock(stoppedStreamMutex);
+            stoppedStreams.emplace_back(event.objectId, event.playId);
+        }
+    }
+
+    namespace
+    {
+        // voices quieter than -60 dB are virtualized even if there are free voices
+        constexpr float minAudibility = 0.001F;
+    }
+
+    void Audio::updateVoices()
     {
+        listenerPositions.clear();
+        mixStack.clear();
+        mixStack.emplace_back(&masterMix, 1.0F);
+        const Listener* activeListener = nullptr;
+
+        for (std::size_t i = 0; i < mixStack.size(); ++i)
+        {
+            Mix* mix = mixStack[i].first;
+            for (const Listener* listener : mix->listeners)
+            {
+                if (!activeListener) activeListener = listener;
+                listenerPositions.push_back(listener->getPosition());
+            }
+            for (Submix* submix : mix->inputSubmixes)
+                mixStack.emplace_back(submix, 0.0F);
+        }
+
+        // the mixer renders the positional voices for the first listener
+        if (activeListener)
+            addCommand(std::make_unique<mixer::SetListenerCommand>(mixer::Listener{activeListener->getPosition(),
+                                                                                   activeListener->getRotation(),
+                                                                                   activeListener->getVelocity()}));
+
+        // estimate the audibility of every playing voice from its gain and the effects on the way to the master mix
+        voiceCandidates.clear();
+        mixStack.resize(1);
+
+        while (!mixStack.empty())
+        {
+            const auto [mix, parentGain] = mixStack.back();
+            mixStack.pop_back();
+
+            float mixGain = parentGain;
+            const Panner* mixPanner = nullptr;
+
+            for (const Effect* effect : mix->effects)
+            {
+                if (!effect->isEnabled()) continue;
+
+                if (const auto gain = dynamic_cast<const Gain*>(effect))
+                    mixGain *= std::pow(10.0F, gain->getGain() / 20.0F);
+                else if (const auto panner = dynamic_cast<const Panner*>(effect))
+                    mixPanner = panner; // the panner positions only the voices that are mixed directly into it
+            }
+
+            mix->realVoiceCount = 0;
+
+            for (Voice* voice : mix->inputVoices)
+                if (voice->streamId && voice->isPlaying())
+                {
+                    float voiceGain = mixGain * std::abs(voice->getGain());
+
+                    if (mixPanner && !listenerPositions.empty())
+                    {
+                        const auto voicePosition = mixPanner->getPosition() + voice->getPosition();
+                        float distance = voicePosition.distance(listenerPositions.front());
+                        for (const auto& listenerPosition : listenerPositions)
+                            distance = std::min(distance, voicePosition.distance(listenerPosition));
+
+                        voiceGain *= mixPanner->getAttenuation(distance);
+                    }
+
+                    voiceCandidates.push_back(VoiceCandidate{voice, mix, voiceGain});
+                }
+
+            for (Submix* submix : mix->inputSubmixes)
+                mixStack.emplace_back(submix, mixGain);
+        }
+
+        std::stable_sort(voiceCandidates.begin(), voiceCandidates.end(),
+                         [](const VoiceCandidate& a, const VoiceCandidate& b) noexcept {
+                             if (a.voice->getPriority() != b.voice->getPriority())
+                                 return a.voice->getPriority() > b.voice->getPriority();
+                             return a.audibility > b.audibility;
+                         });
+
+        std::size_t realVoiceCount = 0;
+
+        for (const auto& candidate : voiceCandidates)
+        {
+            Mix& mix = *candidate.mix;
+            const bool real = candidate.audibility >= minAudibility &&
+                (maxVoices == 0 || realVoiceCount < maxVoices) &&
+                (mix.maxVoices == 0 || mix.realVoiceCount < mix.maxVoices);
+
+            if (real)
+            {
+                ++realVoiceCount;
+                ++mix.realVoiceCount;
+            }
+
+            Voice& voice = *candidate.voice;
+            if (voice.virtualized == real)
+            {
+                voice.virtualized = !real;
+                addCommand(std::make_unique<mixer::SetStreamVirtualCommand>(voice.streamId, voice.virtualized));
+            }
+        }
+    }
+
+    mixer::Mixer::ObjectId Audio::allocateObjectId()
+    {
+        const auto objectId = mixer.getObjectId();
+
+        // grow the object table of the mixer before the object gets initialized
+        if (objectId > objectCapacity)
+        {
+            objectCapacity = std::max(objectId, objectCapacity * 2);
+            addCommand(std::make_unique<mixer::SetObjectStorageCommand>(objectCapacity));
+        }
+
+        return objectId;
     }
 }
@@ -3,29 +3,59 @@
 #ifndef OUZEL_AUDIO_AUDIO_HPP
 #define OUZEL_AUDIO_AUDIO_HPP
 
+#include <array>
+#include <atomic>
 #include <cstdint>
-#include <functional>
 #include <memory>
+#include <mutex>
 #include <set>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include "AudioDevice.hpp"
 #include "Driver.hpp"
 #include "Mix.hpp"
 #include "Node.hpp"
 #include "Settings.hpp"
+#include "Streamer.hpp"
 #include "mixer/Commands.hpp"
 #include "mixer/Processor.hpp"
 #include "mixer/Mixer.hpp"
+#include "mixer/Timing.hpp"
 #include "../math/Quaternion.hpp"
 #include "../math/Vector.hpp"
 
 namespace ouzel::audio
 {
     class Listener;
+    class Voice;
+
+    class PcmClip;
 
     class Audio final
     {
+        friend PcmClip;
+        friend Voice;
     public:
+        struct MemoryStatistics final
+        {
+            std::size_t clipCount = 0;
+            std::size_t residentSize = 0; // bytes of the samples stored by the clips
+            std::size_t decodedSize = 0; // bytes the same samples would take as floats
+        };
+
+        struct DspStatistics final
+        {
+            float load = 0.0F; // time spent mixing divided by the duration of the mixed frames
+            float peakLoad = 0.0F; // of the slowest block
+            std::size_t blockCount = 0;
+            std::size_t xrunCount = 0; // reported by the device since it was created
+            // deviations of the intervals between the device callbacks from the duration of their frames,
+            // the bins are bounded by mixer::Mixer::jitterBinBounds
+            std::array<std::size_t, mixer::Mixer::jitterBinCount> jitterHistogram{};
+        };
+
         Audio(Driver driver, const Settings& settings);
 
         static Driver getDriver(const std::string& driver);
@@ -33,6 +63,7 @@ namespace ouzel::audio
 
         auto getDevice() const noexcept { return device.get(); }
         mixer::Mixer& getMixer() { return mixer; }
+        Streamer& getStreamer() { return streamer; }
         Mix& getMasterMix() { return masterMix; }
 
         void update();
@@ -43,21 +74,73 @@ namespace ouzel::audio
         }
 
         void deleteObject(mixer::Mixer::ObjectId objectId);
+        mixer::Mixer::ObjectId initObject(std::unique_ptr<mixer::Source> source);
         mixer::Mixer::ObjectId initBus();
         mixer::Mixer::ObjectId initStream(mixer::Mixer::ObjectId sourceId);
+        // a stream of the data with its resampler prepared for the device, not added to the mixer
+        std::unique_ptr<mixer::Stream> createStream(mixer::Mixer::ObjectId sourceId);
         mixer::Mixer::ObjectId initData(std::unique_ptr<mixer::Data> data);
         mixer::Mixer::ObjectId initProcessor(std::unique_ptr<mixer::Processor> processor);
-        void updateProcessor(mixer::Mixer::ObjectId processorId,
-                             const std::function<void(mixer::Processor*)>& updateFunction);
+        // the function is called on the mixer thread, so it must be noexcept and must not allocate or lock
+        template <class Function>
+        void updateProcessor(mixer::Mixer::ObjectId processorId, Function&& updateFunction)
+        {
+            addCommand(std::make_unique<mixer::ProcessorUpdateCommand<std::decay_t<Function>>>(processorId,
+                                                                                               std::forward<Function>(updateFunction)));
+        }
 
         auto& getRootNode() { return rootNode; }
 
+        MemoryStatistics getMemoryStatistics() const noexcept;
+
+        // the statistics since the previous call
+        DspStatistics getDspStatistics();
+        // the time the mixer spent in a bus (with its streams and processors, but not its input buses),
+        // stream or processor since the previous call for the same object
+        mixer::Timing::Statistics getNodeStatistics(mixer::Mixer::ObjectId objectId);
+
     private:
         void getSamples(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate, std::vector<float>& samples);
         void eventCallback(const mixer::Mixer::Event& event);
+        mixer::Mixer::ObjectId allocateObjectId();
+        void updateVoices();
+
+        void addClip(std::size_t size, std::size_t decodedSize) noexcept;
+        void removeClip(std::size_t size, std::size_t decodedSize) noexcept;
+
+        struct VoiceCandidate final
+        {
+            Voice* voice;
+            Mix* mix;
+            float audibility;
+        };
 
+        // streamed sounds are destroyed together with the mixer, so the streamer has to outlive it
+        Streamer streamer;
         std::unique_ptr<AudioDevice> device;
         mixer::Mixer mixer;
+        std::size_t objectCapacity;
+        std::unordered_map<mixer::Mixer::ObjectId, mixer::Data*> dataObjects;
+        std::unordered_map<mixer::Mixer::ObjectId, std::shared_ptr<mixer::Timing>> timings;
+        std::unordered_map<mixer::Mixer::ObjectId, Voice*> voices; // by their stream ids
+        // stream ids with the play ids of the streams that reached their end, reported by the mixer thread
+        std::mutex stoppedStreamMutex;
+        std::vector<std::pair<mixer::Mixer::ObjectId, std::size_t>> stoppedStreams;
+        std::vector<std::pair<mixer::Mixer::ObjectId, std::size_t>> finishedStreams;
+        bool debugAudio = false;
+        ResamplerQuality resamplerQuality = ResamplerQuality::medium;
+        std::uint32_t maxVoices = 0;
+        std::vector<Vector3F> listenerPositions;
+        std::vector<std::pair<Mix*, float>> mixStack;
+        std::vector<VoiceCandidate> voiceCandidates;
+        std::size_t reportedAllocationCount = 0;
+        std::size_t reportedBlockCount = 0;
+        std::size_t reportedXrunCount = 0;
+        std::size_t reportedInvalidCommandCount = 0;
+        // clips can be loaded by the asset threads
+        std::atomic<std::size_t> clipCount{0};
+        std::atomic<std::size_t> residentClipSize{0};
+        std::atomic<std::size_t> decodedClipSize{0};
         mixer::CommandBuffer commandBuffer;
         Mix masterMix;
         Node rootNode;
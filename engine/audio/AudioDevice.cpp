@@ -1,6 +1,7 @@
 // Copyright 2015-2020 Elviss Strazdins. All rights reserved.
 
 #include "AudioDevice.hpp"
+#include "mixer/Dsp.hpp"
 
 namespace ouzel::audio
 {
@@ -20,38 +21,33 @@ namespace ouzel::audio
 
     void AudioDevice::getData(std::uint32_t frames, std::vector<std::uint8_t>& result)
     {
-        dataGetter(frames, channels, sampleRate, buffer);
-
         switch (sampleFormat)
         {
             case SampleFormat::signedInt16:
-            {
                 result.resize(frames * channels * sizeof(std::int16_t));
-                auto resultPtr = reinterpret_cast<std::int16_t*>(result.data());
-
-                for (std::uint32_t channel = 0; channel < channels; ++channel)
-                {
-                    const auto bufferChannel = &buffer[channel * frames];
-
-                    for (std::uint32_t frame = 0; frame < frames; ++frame)
-                        resultPtr[frame * channels + channel] = static_cast<std::int16_t>(bufferChannel[frame] * 32767.0F);
-                }
                 break;
-            }
             case SampleFormat::float32:
-            {
                 result.resize(frames * channels * sizeof(float));
-                auto resultPtr = reinterpret_cast<float*>(result.data());
+                break;
+            default:
+                throw std::runtime_error("Invalid sample format");
+        }
 
-                for (std::uint32_t channel = 0; channel < channels; ++channel)
-                {
-                    const auto bufferChannel = &buffer[channel * frames];
+        getData(frames, result.data());
+    }
 
-                    for (std::uint32_t frame = 0; frame < frames; ++frame)
-                        resultPtr[frame * channels + channel] = bufferChannel[frame];
-                }
+    void AudioDevice::getData(std::uint32_t frames, void* result)
+    {
+        dataGetter(frames, channels, sampleRate, buffer);
+
+        switch (sampleFormat)
+        {
+            case SampleFormat::signedInt16:
+                mixer::dsp::interleave(buffer.data(), frames, channels, static_cast<std::int16_t*>(result), dither);
+                break;
+            case SampleFormat::float32:
+                mixer::dsp::interleave(buffer.data(), frames, channels, static_cast<float*>(result));
                 break;
-            }
             default:
                 throw std::runtime_error("Invalid sample format");
         }
@@ -3,11 +3,13 @@
 #ifndef OUZEL_AUDIO_AUDIODEVICE_HPP
 #define OUZEL_AUDIO_AUDIODEVICE_HPP
 
+#include <atomic>
 #include <functional>
 #include <vector>
 #include "Driver.hpp"
 #include "SampleFormat.hpp"
 #include "Settings.hpp"
+#include "mixer/Dsp.hpp"
 
 namespace ouzel::audio
 {
@@ -36,6 +38,12 @@ namespace ouzel::audio
         auto getSampleRate() const noexcept { return sampleRate; }
         auto getChannels() const noexcept { return channels; }
 
+        // frames between the mixed samples and the speaker as measured by the driver, zero if it does not report it
+        auto getOutputLatency() const noexcept { return outputLatency.load(); }
+
+        // buffer underruns reported by the driver since the device was created, zero if it does not report them
+        auto getXrunCount() const noexcept { return xrunCount.load(); }
+
         virtual void start() = 0;
         virtual void stop() = 0;
 
@@ -44,6 +52,8 @@ namespace ouzel::audio
 
     protected:
         void getData(std::uint32_t frames, std::vector<std::uint8_t>& result);
+        // writes the interleaved samples straight to the memory of the device
+        void getData(std::uint32_t frames, void* result);
 
         std::uint16_t apiMajorVersion = 0;
         std::uint16_t apiMinorVersion = 0;
@@ -52,10 +62,13 @@ namespace ouzel::audio
         std::uint32_t bufferSize; // in frames
         std::uint32_t sampleRate;
         std::uint32_t channels;
+        std::atomic<std::uint32_t> outputLatency{0};
+        std::atomic<std::size_t> xrunCount{0};
 
     private:
         std::function<void(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate, std::vector<float>& samples)> dataGetter;
         std::vector<float> buffer;
+        mixer::dsp::Dither dither;
     };
 }
 
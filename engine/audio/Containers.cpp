@@ -1,7 +1,193 @@
 // Copyright 2015-2020 Elviss Strazdins. All rights reserved.
 
 #include "Containers.hpp"
+#include "mixer/Dsp.hpp"
+#include "../core/Engine.hpp"
 
 namespace ouzel::audio
 {
+    Container::Container(std::vector<std::unique_ptr<Source>> initChildren,
+                         std::uint32_t maxFrames, std::uint32_t maxChannels):
+        children(std::move(initChildren))
+    {
+        buffer.reserve(maxFrames * maxChannels);
+    }
+
+    void Container::play()
+    {
+        for (const auto& child : children)
+            child->play();
+    }
+
+    void Container::stop(bool shouldReset)
+    {
+        for (const auto& child : children)
+            child->stop(shouldReset);
+
+        if (shouldReset) reset();
+    }
+
+    Parallel::Parallel(std::vector<std::unique_ptr<Source>> initChildren,
+                       std::uint32_t maxFrames, std::uint32_t maxChannels):
+        Container(std::move(initChildren), maxFrames, maxChannels),
+        finished(children.size(), false)
+    {
+    }
+
+    std::uint32_t Parallel::getSamples(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate,
+                                       std::vector<float>& samples)
+    {
+        samples.resize(frames * channels);
+        std::fill(samples.begin(), samples.end(), 0.0F);
+
+        std::uint32_t result = 0;
+        bool playing = false;
+
+        for (std::size_t i = 0; i < children.size(); ++i)
+        {
+            if (finished[i]) continue;
+
+            // the frames after the end of a child are silent, so they can be added too
+            const auto generated = children[i]->getSamples(frames, channels, sampleRate, buffer);
+            mixer::dsp::add(samples.data(), buffer.data(), samples.size());
+
+            if (generated < frames)
+                finished[i] = true;
+            else
+                playing = true;
+
+            result = std::max(result, generated);
+        }
+
+        if (playing) return frames;
+
+        reset();
+        return result;
+    }
+
+    void Parallel::reset()
+    {
+        std::fill(finished.begin(), finished.end(), false);
+    }
+
+    Random::Random(std::vector<std::unique_ptr<Source>> initChildren, std::vector<float> initWeights,
+                   std::uint32_t maxFrames, std::uint32_t maxChannels):
+        Container(std::move(initChildren), maxFrames, maxChannels),
+        weights(std::move(initWeights)),
+        randomEngine(core::randomEngine()), // seeded on the game thread, the mixer uses its own engine
+        previous(children.size())
+    {
+        weights.resize(children.size(), 1.0F);
+        for (auto& weight : weights)
+            weight = std::max(weight, 0.0F);
+    }
+
+    std::uint32_t Random::getSamples(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate,
+                                     std::vector<float>& samples)
+    {
+        if (children.empty())
+        {
+            samples.resize(frames * channels);
+            std::fill(samples.begin(), samples.end(), 0.0F);
+            return 0;
+        }
+
+        if (!selected)
+        {
+            current = pick();
+            selected = true;
+        }
+
+        const auto generated = children[current]->getSamples(frames, channels, sampleRate, samples);
+
+        if (generated < frames)
+        {
+            previous = current;
+            selected = false;
+        }
+
+        return generated;
+    }
+
+    void Random::reset()
+    {
+        if (selected) previous = current;
+        selected = false;
+    }
+
+    std::size_t Random::pick()
+    {
+        // the previous child is left out, unless it is the only one
+        const auto excluded = (children.size() > 1) ? previous : children.size();
+
+        float total = 0.0F;
+        for (std::size_t i = 0; i < children.size(); ++i)
+            if (i != excluded) total += weights[i];
+
+        if (total > 0.0F)
+        {
+            auto value = std::uniform_real_distribution<float>{0.0F, total}(randomEngine);
+
+            std::size_t result = children.size();
+            for (std::size_t i = 0; i < children.size(); ++i)
+                if (i != excluded && weights[i] > 0.0F)
+                {
+                    result = i; // the last candidate also takes the rounding errors
+                    if (value < weights[i]) break;
+                    value -= weights[i];
+                }
+
+            return result;
+        }
+
+        // no weights, so every candidate is as likely
+        const auto candidates = (excluded < children.size()) ? children.size() - 1 : children.size();
+        auto index = std::uniform_int_distribution<std::size_t>{0, candidates - 1}(randomEngine);
+        if (index >= excluded) ++index;
+        return index;
+    }
+
+    Sequence::Sequence(std::vector<std::unique_ptr<Source>> initChildren,
+                       std::uint32_t maxFrames, std::uint32_t maxChannels):
+        Container(std::move(initChildren), maxFrames, maxChannels)
+    {
+    }
+
+    std::uint32_t Sequence::getSamples(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate,
+                                       std::vector<float>& samples)
+    {
+        samples.resize(frames * channels);
+
+        std::uint32_t offset = 0;
+
+        while (current < children.size())
+        {
+            const auto count = frames - offset;
+            const auto generated = children[current]->getSamples(count, channels, sampleRate, buffer);
+
+            for (std::uint32_t channel = 0; channel < channels; ++channel)
+                std::copy(buffer.begin() + channel * count, buffer.begin() + channel * count + generated,
+                          samples.begin() + channel * frames + offset);
+
+            offset += generated;
+
+            if (generated == count) break;
+
+            // the next child continues from the frame where this one ended
+            ++current;
+        }
+
+        for (std::uint32_t channel = 0; channel < channels; ++channel)
+            std::fill(samples.begin() + channel * frames + offset, samples.begin() + (channel + 1) * frames, 0.0F);
+
+        if (current < children.size()) return frames;
+
+        current = 0;
+        return offset;
+    }
+
+    void Sequence::reset()
+    {
+        current = 0;
+    }
 }
@@ -4,38 +4,82 @@
 #define OUZEL_AUDIO_CONTAINERS_HPP
 
 #include <algorithm>
+#include <memory>
+#include <random>
 #include <vector>
 #include "Source.hpp"
 
 namespace ouzel::audio
 {
+    // schedules its children on the mixer thread, the children start and end on exact frames of a block,
+    // the buffers are allocated for blocks of up to maxFrames frames of maxChannels channels
     class Container: public Source
     {
     public:
+        Container(std::vector<std::unique_ptr<Source>> initChildren,
+                  std::uint32_t maxFrames, std::uint32_t maxChannels);
+
+        void play() override;
+        void stop(bool shouldReset) override;
+
+    protected:
+        virtual void reset() {}
+
+        std::vector<std::unique_ptr<Source>> children;
+        std::vector<float> buffer;
     };
 
+    // plays all of the children at once and ends with the longest one
     class Parallel final: public Container
     {
     public:
-        void getSamples(std::uint32_t, std::uint32_t, std::uint32_t, std::vector<float>&) override
-        {
-        }
+        Parallel(std::vector<std::unique_ptr<Source>> initChildren,
+                 std::uint32_t maxFrames, std::uint32_t maxChannels);
+
+        std::uint32_t getSamples(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate,
+                                 std::vector<float>& samples) final;
+
+    private:
+        void reset() final;
+
+        std::vector<bool> finished;
     };
 
+    // plays one of the children picked by weight, never the same one twice in a row
     class Random final: public Container
     {
     public:
-        void getSamples(std::uint32_t, std::uint32_t, std::uint32_t, std::vector<float>&) override
-        {
-        }
+        Random(std::vector<std::unique_ptr<Source>> initChildren, std::vector<float> initWeights,
+               std::uint32_t maxFrames, std::uint32_t maxChannels);
+
+        std::uint32_t getSamples(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate,
+                                 std::vector<float>& samples) final;
+
+    private:
+        void reset() final;
+        std::size_t pick();
+
+        std::vector<float> weights;
+        std::minstd_rand randomEngine;
+        std::size_t current = 0;
+        std::size_t previous = 0;
+        bool selected = false;
     };
 
+    // plays the children one after another, the next one starts on the frame after the previous one ends
     class Sequence final: public Container
     {
     public:
-        void getSamples(std::uint32_t, std::uint32_t, std::uint32_t, std::vector<float>&) override
-        {
-        }
+        Sequence(std::vector<std::unique_ptr<Source>> initChildren,
+                 std::uint32_t maxFrames, std::uint32_t maxChannels);
+
+        std::uint32_t getSamples(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate,
+                                 std::vector<float>& samples) final;
+
+    private:
+        void reset() final;
+
+        std::size_t current = 0;
     };
 }
 
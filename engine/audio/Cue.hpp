@@ -39,6 +39,8 @@ namespace ouzel::audio
         float scale = 1.0F;
         float shift = 1.0f;
         float decay = 0.0F;
+        float cutoff = 0.0F; // Hz, zero for the default of the filter
+        float q = 0.7071F;
         std::pair<float, float> delayRandom{0.0F, 0.0F};
         std::pair<float, float> gainRandom{0.0F, 0.0F};
         std::pair<float, float> scaleRandom{0.0F, 0.0F};
@@ -66,6 +68,7 @@ namespace ouzel::audio
         float frequency = 0.0F;
         float amplitude = 0.0F;
         float length = 0.0F;
+        float weight = 1.0F; // relative to the other children of a random source
         const Sound* sound = nullptr;
     };
 
@@ -0,0 +1,17 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_DISTANCEMODEL_HPP
+#define OUZEL_AUDIO_DISTANCEMODEL_HPP
+
+namespace ouzel::audio
+{
+    // distance attenuation models, the distance is clamped between the min and max distance
+    enum class DistanceModel
+    {
+        inverse, // min / (min + rolloff * (distance - min))
+        linear, // 1 - rolloff * (distance - min) / (max - min)
+        exponential // (distance / min) ^ -rolloff
+    };
+}
+
+#endif // OUZEL_AUDIO_DISTANCEMODEL_HPP
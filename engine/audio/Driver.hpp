@@ -13,7 +13,8 @@ namespace ouzel::audio
         openSL,
         coreAudio,
         alsa,
-        wasapi
+        wasapi,
+        offline
     };
 }
 
@@ -24,7 +24,7 @@ namespace ouzel::audio
     {
         enabled = newEnabled;
 
-        audio.updateProcessor(processorId, [newEnabled](mixer::Object* node) {
+        audio.updateProcessor(processorId, [newEnabled](mixer::Object* node) noexcept {
             auto processor = static_cast<mixer::Processor*>(node);
             processor->setEnabled(newEnabled);
         });
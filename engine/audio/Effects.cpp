@@ -1,82 +1,115 @@
 // Copyright 2015-2020 Elviss Strazdins. All rights reserved.
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <random>
+#include <stdexcept>
 #include "Effects.hpp"
 #include "Audio.hpp"
+#include "PcmClip.hpp"
+#include "mixer/Biquad.hpp"
+#include "mixer/Convolver.hpp"
+#include "mixer/DelayLine.hpp"
+#include "mixer/Dsp.hpp"
+#include "mixer/PhaseVocoder.hpp"
+#include "mixer/Resampler.hpp"
+#include "mixer/Reverberator.hpp"
+#include "mixer/Spatializer.hpp"
+#include "mixer/Wsola.hpp"
+#include "../core/Engine.hpp"
 #include "../scene/Actor.hpp"
 #include "../math/MathUtils.hpp"
-#include "smbPitchShift.hpp"
 
 namespace ouzel::audio
 {
+    namespace
+    {
+        // picks a random offset from the range on the game thread, so that every instance of a cue sounds different
+        float getRandomOffset(const std::pair<float, float>& range)
+        {
+            const auto [minValue, maxValue] = std::minmax(range.first, range.second);
+            return std::uniform_real_distribution<float>{minValue, maxValue}(core::randomEngine);
+        }
+    }
+
     class DelayProcessor final: public mixer::Processor
     {
     public:
-        explicit DelayProcessor(float initDelay):
-            delay(initDelay)
+        DelayProcessor(float initDelay, mixer::DelayLine&& initDelayLine) noexcept:
+            delay(initDelay),
+            delayLine(std::move(initDelayLine))
         {
         }
 
         void process(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate,
                      std::vector<float>& samples) final
         {
-            const auto delayFrames = static_cast<std::uint32_t>(delay * sampleRate);
-            const auto bufferFrames = frames + delayFrames;
+            const auto delayFrames = static_cast<std::uint32_t>(delay * static_cast<float>(sampleRate));
 
-            buffer.resize(bufferFrames * channels);
+            // the line is normally allocated on the game thread
+            if (delayLine.getChannels() != channels || delayLine.getMaxDelay() < delayFrames)
+                delayLine = mixer::DelayLine(channels, delayFrames);
 
             for (std::uint32_t channel = 0; channel < channels; ++channel)
-            {
-                float* bufferChannel = &buffer[channel * bufferFrames];
-                float* outputChannel = &samples[channel * frames];
-
-                for (std::uint32_t frame = 0; frame < frames; ++frame)
-                    bufferChannel[frame + delayFrames] += outputChannel[frame];
-
-                for (std::uint32_t frame = 0; frame < frames; ++frame)
-                    outputChannel[frame] = bufferChannel[frame];
+                delayLine.process(channel, delayFrames, &samples[channel * frames], frames);
 
-                // erase frames from beginning
-                for (std::uint32_t frame = 0; frame < bufferFrames - frames; ++frame)
-                    bufferChannel[frame] = bufferChannel[frame + frames];
-
-                for (std::uint32_t frame = bufferFrames - frames; frame < bufferFrames; ++frame)
-                    bufferChannel[frame] = 0.0F;
-            }
+            delayLine.advance(frames);
         }
 
-        void setDelay(float newDelay)
+        // the previous line ends up in newDelayLine, which is released on the game thread
+        void setDelay(float newDelay, mixer::DelayLine& newDelayLine) noexcept
         {
             delay = newDelay;
+
+            if (newDelayLine.getMaxDelay() > delayLine.getMaxDelay())
+                std::swap(delayLine, newDelayLine);
         }
 
     private:
         float delay = 0.0F;
-        std::vector<float> buffer;
+        mixer::DelayLine delayLine;
     };
 
     Delay::Delay(Audio& initAudio, float initDelay):
         Effect(initAudio,
-               initAudio.initProcessor(std::make_unique<DelayProcessor>(initDelay))),
-        delay(initDelay)
+               initAudio.initProcessor(std::make_unique<DelayProcessor>(initDelay,
+                                                                        mixer::DelayLine(initAudio.getDevice()->getChannels(),
+                                                                                         static_cast<std::uint32_t>(initDelay * static_cast<float>(initAudio.getDevice()->getSampleRate())))))),
+        delay(initDelay),
+        maxDelayFrames(static_cast<std::uint32_t>(initDelay * static_cast<float>(initAudio.getDevice()->getSampleRate())))
     {
     }
 
     void Delay::setDelay(float newDelay)
     {
         delay = newDelay;
-
-        audio.updateProcessor(processorId, [newDelay](mixer::Object* node) {
-            auto delayProcessor = static_cast<DelayProcessor*>(node);
-            delayProcessor->setDelay(newDelay);
-        });
+        updateDelay();
     }
 
     void Delay::setDelayRandom(const std::pair<float, float>& newDelayRandom)
     {
         delayRandom = newDelayRandom;
-        // TODO: pass to processor
+        updateDelay();
+    }
+
+    void Delay::updateDelay()
+    {
+        const auto newDelay = std::max(delay + getRandomOffset(delayRandom), 0.0F);
+        const auto delayFrames = static_cast<std::uint32_t>(newDelay * static_cast<float>(audio.getDevice()->getSampleRate()));
+
+        // allocate a longer line here instead of on the mixer thread
+        auto delayLine = std::make_shared<mixer::DelayLine>();
+        if (delayFrames > maxDelayFrames)
+        {
+            *delayLine = mixer::DelayLine(audio.getDevice()->getChannels(), delayFrames);
+            maxDelayFrames = delayFrames;
+        }
+
+        audio.updateProcessor(processorId, [newDelay, delayLine](mixer::Object* node) noexcept {
+            auto delayProcessor = static_cast<DelayProcessor*>(node);
+            delayProcessor->setDelay(newDelay, *delayLine);
+        });
     }
 
     class GainProcessor final: public mixer::Processor
@@ -91,11 +124,10 @@ namespace ouzel::audio
         void process(std::uint32_t, std::uint32_t, std::uint32_t,
                      std::vector<float>& samples) final
         {
-            for (float& sample : samples)
-                sample *= gainFactor;
+            mixer::dsp::scale(samples.data(), samples.data(), gainFactor, samples.size());
         }
 
-        void setGain(float newGain)
+        void setGain(float newGain) noexcept
         {
             gain = newGain;
             gainFactor = std::pow(10.0F, gain / 20.0F);
@@ -116,61 +148,28 @@ namespace ouzel::audio
     void Gain::setGain(float newGain)
     {
         gain = newGain;
-
-        audio.updateProcessor(processorId, [newGain](mixer::Object* node) {
-            auto gainProcessor = static_cast<GainProcessor*>(node);
-            gainProcessor->setGain(newGain);
-        });
+        updateGain();
     }
 
     void Gain::setGainRandom(const std::pair<float, float>& newGainRandom)
     {
         gainRandom = newGainRandom;
-        // TODO: pass to processor
+        updateGain();
     }
 
-    class PannerProcessor final: public mixer::Processor
+    void Gain::updateGain()
     {
-    public:
-        PannerProcessor()
-        {
-        }
-
-        void process(std::uint32_t, std::uint32_t, std::uint32_t,
-                     std::vector<float>&) final
-        {
-        }
-
-        void setPosition(const Vector3F& newPosition)
-        {
-            position = newPosition;
-        }
-
-        void setRolloffFactor(float newRolloffFactor)
-        {
-            rolloffFactor = newRolloffFactor;
-        }
-
-        void setMinDistance(float newMinDistance)
-        {
-            minDistance = newMinDistance;
-        }
+        const auto newGain = gain + getRandomOffset(gainRandom);
 
-        void setMaxDistance(float newMaxDistance)
-        {
-            maxDistance = newMaxDistance;
-        }
-
-    private:
-        Vector3F position;
-        float rolloffFactor = 1.0F;
-        float minDistance = 1.0F;
-        float maxDistance = FLT_MAX;
-    };
+        audio.updateProcessor(processorId, [newGain](mixer::Object* node) noexcept {
+            auto gainProcessor = static_cast<GainProcessor*>(node);
+            gainProcessor->setGain(newGain);
+        });
+    }
 
     Panner::Panner(Audio& initAudio):
         Effect(initAudio,
-               initAudio.initProcessor(std::make_unique<PannerProcessor>()))
+               initAudio.initProcessor(std::make_unique<mixer::Spatializer>(initAudio.getDevice()->getBufferSize())))
     {
     }
 
@@ -178,9 +177,29 @@ namespace ouzel::audio
     {
         position = newPosition;
 
-        audio.updateProcessor(processorId, [newPosition](mixer::Object* node) {
-            auto pannerProcessor = static_cast<PannerProcessor*>(node);
-            pannerProcessor->setPosition(newPosition);
+        audio.updateProcessor(processorId, [newPosition](mixer::Object* node) noexcept {
+            auto spatializer = static_cast<mixer::Spatializer*>(node);
+            spatializer->setPosition(newPosition);
+        });
+    }
+
+    void Panner::setVelocity(const Vector3F& newVelocity)
+    {
+        velocity = newVelocity;
+
+        audio.updateProcessor(processorId, [newVelocity](mixer::Object* node) noexcept {
+            auto spatializer = static_cast<mixer::Spatializer*>(node);
+            spatializer->setVelocity(newVelocity);
+        });
+    }
+
+    void Panner::setDistanceModel(DistanceModel newDistanceModel)
+    {
+        distanceModel = newDistanceModel;
+
+        audio.updateProcessor(processorId, [newDistanceModel](mixer::Object* node) noexcept {
+            auto spatializer = static_cast<mixer::Spatializer*>(node);
+            spatializer->setDistanceModel(newDistanceModel);
         });
     }
 
@@ -188,9 +207,9 @@ namespace ouzel::audio
     {
         rolloffFactor = newRolloffFactor;
 
-        audio.updateProcessor(processorId, [newRolloffFactor](mixer::Object* node) {
-            auto pannerProcessor = static_cast<PannerProcessor*>(node);
-            pannerProcessor->setRolloffFactor(newRolloffFactor);
+        audio.updateProcessor(processorId, [newRolloffFactor](mixer::Object* node) noexcept {
+            auto spatializer = static_cast<mixer::Spatializer*>(node);
+            spatializer->setRolloffFactor(newRolloffFactor);
         });
     }
 
@@ -198,9 +217,9 @@ namespace ouzel::audio
     {
         minDistance = newMinDistance;
 
-        audio.updateProcessor(processorId, [newMinDistance](mixer::Object* node) {
-            auto pannerProcessor = static_cast<PannerProcessor*>(node);
-            pannerProcessor->setMinDistance(newMinDistance);
+        audio.updateProcessor(processorId, [newMinDistance](mixer::Object* node) noexcept {
+            auto spatializer = static_cast<mixer::Spatializer*>(node);
+            spatializer->setMinDistance(newMinDistance);
         });
     }
 
@@ -208,12 +227,27 @@ namespace ouzel::audio
     {
         maxDistance = newMaxDistance;
 
-        audio.updateProcessor(processorId, [newMaxDistance](mixer::Object* node) {
-            auto pannerProcessor = static_cast<PannerProcessor*>(node);
-            pannerProcessor->setMaxDistance(newMaxDistance);
+        audio.updateProcessor(processorId, [newMaxDistance](mixer::Object* node) noexcept {
+            auto spatializer = static_cast<mixer::Spatializer*>(node);
+            spatializer->setMaxDistance(newMaxDistance);
         });
     }
 
+    void Panner::setDopplerFactor(float newDopplerFactor)
+    {
+        dopplerFactor = newDopplerFactor;
+
+        audio.updateProcessor(processorId, [newDopplerFactor](mixer::Object* node) noexcept {
+            auto spatializer = static_cast<mixer::Spatializer*>(node);
+            spatializer->setDopplerFactor(newDopplerFactor);
+        });
+    }
+
+    float Panner::getAttenuation(float distance) const noexcept
+    {
+        return mixer::Spatializer::getAttenuation(distanceModel, distance, minDistance, maxDistance, rolloffFactor);
+    }
+
     void Panner::updateTransform()
     {
         setPosition(actor->getWorldPosition());
@@ -228,35 +262,36 @@ namespace ouzel::audio
     class PitchScaleProcessor final: public mixer::Processor
     {
     public:
-        explicit PitchScaleProcessor(float initScale):
+        PitchScaleProcessor(float initScale, std::uint32_t channels):
             scale(std::clamp(initScale, minPitch, maxPitch))
         {
+            phaseVocoder.prepare(channels);
         }
 
-        void process(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate,
+        void process(std::uint32_t frames, std::uint32_t channels, std::uint32_t,
                      std::vector<float>& samples) final
         {
-            pitchShift.resize(channels);
+            // the channel states are normally allocated on the game thread
+            if (!phaseVocoder.isPrepared(channels))
+                phaseVocoder.prepare(channels);
 
-            for (std::uint32_t channel = 0; channel < channels; ++channel)
-                pitchShift[channel].process(scale, frames, sampleRate,
-                                            &samples[channel * frames],
-                                            &samples[channel * frames]);
+            phaseVocoder.process(scale, frames, samples.data());
         }
 
-        void setScale(float newScale)
+        void setScale(float newScale) noexcept
         {
             scale = std::clamp(newScale, minPitch, maxPitch);
         }
 
     private:
-        float scale = 1.0f;
-        std::vector<smb::PitchShift<1024, 4>> pitchShift;
+        float scale = 1.0F;
+        mixer::PhaseVocoder phaseVocoder;
     };
 
     PitchScale::PitchScale(Audio& initAudio, float initScale):
         Effect(initAudio,
-               initAudio.initProcessor(std::make_unique<PitchScaleProcessor>(initScale))),
+               initAudio.initProcessor(std::make_unique<PitchScaleProcessor>(initScale,
+                                                                             initAudio.getDevice()->getChannels()))),
         scale(initScale)
     {
     }
@@ -265,7 +300,7 @@ namespace ouzel::audio
     {
         scale = newScale;
 
-        audio.updateProcessor(processorId, [newScale](mixer::Object* node) {
+        audio.updateProcessor(processorId, [newScale](mixer::Object* node) noexcept {
             auto pitchScaleProcessor = static_cast<PitchScaleProcessor*>(node);
             pitchScaleProcessor->setScale(newScale);
         });
@@ -280,29 +315,37 @@ namespace ouzel::audio
     class PitchShiftProcessor final: public mixer::Processor
     {
     public:
-        explicit PitchShiftProcessor(float initShift):
-            shift(initShift)
+        PitchShiftProcessor(float initShift, std::uint32_t sampleRate, std::uint32_t channels):
+            shift(std::clamp(initShift, minPitch, maxPitch))
         {
+            wsola.prepare(sampleRate, channels);
         }
 
-        void process(std::uint32_t, std::uint32_t, std::uint32_t,
-                     std::vector<float>&) final
+        void process(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate,
+                     std::vector<float>& samples) final
         {
-            // TODO: implement
+            // the buffers are normally allocated on the game thread
+            if (!wsola.isPrepared(sampleRate, channels))
+                wsola.prepare(sampleRate, channels);
+
+            wsola.process(shift, frames, samples.data());
         }
 
-        void setShift(float newShift)
+        void setShift(float newShift) noexcept
         {
-            shift = newShift;
+            shift = std::clamp(newShift, minPitch, maxPitch);
         }
 
     private:
-        float shift = 1.0f;
+        float shift = 1.0F;
+        mixer::Wsola wsola;
     };
 
     PitchShift::PitchShift(Audio& initAudio, float initShift):
         Effect(initAudio,
-               initAudio.initProcessor(std::make_unique<PitchShiftProcessor>(initShift))),
+               initAudio.initProcessor(std::make_unique<PitchShiftProcessor>(initShift,
+                                                                             initAudio.getDevice()->getSampleRate(),
+                                                                             initAudio.getDevice()->getChannels()))),
         shift(initShift)
     {
     }
@@ -311,7 +354,7 @@ namespace ouzel::audio
     {
         shift = newShift;
 
-        audio.updateProcessor(processorId, [newShift](mixer::Object* node) {
+        audio.updateProcessor(processorId, [newShift](mixer::Object* node) noexcept {
             auto pitchShiftProcessor = static_cast<PitchShiftProcessor*>(node);
             pitchShiftProcessor->setShift(newShift);
         });
@@ -326,81 +369,321 @@ namespace ouzel::audio
     class ReverbProcessor final: public mixer::Processor
     {
     public:
-        ReverbProcessor(float initDelay, float initDecay):
+        ReverbProcessor(float initDelay, float initDecay, std::uint32_t sampleRate, std::uint32_t channels):
             delay(initDelay), decay(initDecay)
         {
+            reverberator.prepare(sampleRate, channels, delay, decay);
         }
 
         void process(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate,
                      std::vector<float>& samples) final
         {
-            const auto delayFrames = static_cast<std::uint32_t>(delay * sampleRate);
-            const auto bufferFrames = frames + delayFrames;
-
-            buffers.resize(channels);
-
-            for (std::uint32_t channel = 0; channel < channels; ++channel)
-            {
-                std::vector<float>& buffer = buffers[channel];
-                buffer.resize(bufferFrames);
+            // the delay lines are normally allocated on the game thread
+            if (!reverberator.isPrepared(sampleRate, channels))
+                reverberator.prepare(sampleRate, channels, delay, decay);
 
-                float* outputChannel = &samples[channel * frames];
-
-                for (std::uint32_t frame = 0; frame < frames; ++frame)
-                    buffer[frame] += outputChannel[frame];
-
-                for (std::uint32_t frame = 0; frame < frames; ++frame)
-                    buffer[frame + delayFrames] += buffer[frame] * decay;
-
-                for (std::uint32_t frame = 0; frame < frames; ++frame)
-                    outputChannel[frame] = buffer[frame];
-
-                // erase frames from beginning
-                buffer.erase(buffer.begin(), buffer.begin() + frames);
-            }
+            reverberator.process(frames, samples.data());
         }
 
     private:
         float delay = 0.1F;
         float decay = 0.5F;
-        std::vector<std::vector<float>> buffers;
+        mixer::Reverberator reverberator;
     };
 
     Reverb::Reverb(Audio& initAudio, float initDelay, float initDecay):
         Effect(initAudio,
-               initAudio.initProcessor(std::make_unique<ReverbProcessor>(initDelay, initDecay))),
+               initAudio.initProcessor(std::make_unique<ReverbProcessor>(initDelay, initDecay,
+                                                                         initAudio.getDevice()->getSampleRate(),
+                                                                         initAudio.getDevice()->getChannels()))),
         delay(initDelay),
         decay(initDecay)
     {
     }
 
-    class LowPassProcessor final: public mixer::Processor
+    class ConvolutionReverbProcessor final: public mixer::Processor
     {
     public:
-        void process(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate,
+        ConvolutionReverbProcessor(std::unique_ptr<mixer::Convolver> initConvolver, float initGain):
+            convolver(std::move(initConvolver)),
+            gainFactor(std::pow(10.0F, initGain / 20.0F))
+        {
+        }
+
+        void process(std::uint32_t frames, std::uint32_t channels, std::uint32_t,
                      std::vector<float>& samples) final
         {
+            // the partitions are prepared for the channels of the device, the rest are left dry
+            if (channels >= convolver->getChannels())
+                convolver->process(frames, samples.data(), gainFactor);
         }
+
+        void setGain(float newGain) noexcept
+        {
+            gainFactor = std::pow(10.0F, newGain / 20.0F);
+        }
+
+    private:
+        std::unique_ptr<mixer::Convolver> convolver;
+        float gainFactor = 1.0F;
     };
 
-    LowPass::LowPass(Audio& initAudio):
+    namespace
+    {
+        std::unique_ptr<mixer::Convolver> createConvolver(Audio& audio, const Sound* impulseResponse, bool backgroundTail)
+        {
+            if (!impulseResponse || impulseResponse->getFormat() != Sound::Format::pcm)
+                throw std::runtime_error("Impulse response must be a PCM clip");
+
+            const auto clip = static_cast<const PcmClip*>(impulseResponse);
+            const auto impulseChannels = clip->getChannels();
+            const auto samples = clip->getSamples();
+            const auto sampleRate = audio.getDevice()->getSampleRate();
+
+            if (clip->getSampleRate() == sampleRate)
+                return std::make_unique<mixer::Convolver>(samples, impulseChannels,
+                                                          audio.getDevice()->getChannels(), backgroundTail);
+
+            // the partitions are computed once, so the best quality filter is used, the source is padded with
+            // the delay of the filter, which is then dropped from the start of the result
+            mixer::Resampler resampler;
+            resampler.setQuality(ResamplerQuality::high);
+            resampler.prepare(clip->getSampleRate(), sampleRate, impulseChannels);
+
+            const std::size_t sourceFrames = samples.size() / impulseChannels;
+            const auto delay = resampler.getDelay();
+            const auto frames = resampler.getFrames(static_cast<std::uint32_t>(sourceFrames + delay * 2));
+            const auto paddedFrames = resampler.getSourceFrames(frames);
+
+            std::vector<float> source(paddedFrames * impulseChannels);
+            for (std::uint32_t channel = 0; channel < impulseChannels; ++channel)
+                std::copy(samples.begin() + channel * sourceFrames,
+                          samples.begin() + channel * sourceFrames + std::min<std::size_t>(sourceFrames, paddedFrames),
+                          source.begin() + channel * paddedFrames);
+
+            std::vector<float> output(frames * impulseChannels);
+            resampler.process(paddedFrames, source.data(), frames, output.data());
+
+            const auto ratio = static_cast<double>(clip->getSampleRate()) / sampleRate;
+            const auto skippedFrames = std::min<std::size_t>(frames, static_cast<std::size_t>(std::lround(delay / ratio)));
+            const auto resampledFrames = std::min<std::size_t>(frames - skippedFrames,
+                                                               static_cast<std::size_t>(std::ceil(static_cast<double>(sourceFrames) / ratio)));
+            // more taps cover the same time at a higher rate, so they are scaled to keep the loudness
+            const auto gain = static_cast<float>(ratio);
+            std::vector<float> resampled(resampledFrames * impulseChannels);
+
+            for (std::uint32_t channel = 0; channel < impulseChannels; ++channel)
+                mixer::dsp::scale(resampled.data() + channel * resampledFrames,
+                                  output.data() + channel * frames + skippedFrames,
+                                  gain, resampledFrames);
+
+            return std::make_unique<mixer::Convolver>(resampled, impulseChannels,
+                                                      audio.getDevice()->getChannels(), backgroundTail);
+        }
+    }
+
+    ConvolutionReverb::ConvolutionReverb(Audio& initAudio, const Sound* impulseResponse, float initGain, bool backgroundTail):
         Effect(initAudio,
-               initAudio.initProcessor(std::unique_ptr<LowPassProcessor>()))
+               initAudio.initProcessor(std::make_unique<ConvolutionReverbProcessor>(createConvolver(initAudio, impulseResponse, backgroundTail),
+                                                                                    initGain))),
+        gain(initGain)
     {
     }
 
-    class HighPassProcessor final: public mixer::Processor
+    void ConvolutionReverb::setGain(float newGain)
+    {
+        gain = newGain;
+
+        audio.updateProcessor(processorId, [newGain](mixer::Object* node) noexcept {
+            auto convolutionReverbProcessor = static_cast<ConvolutionReverbProcessor*>(node);
+            convolutionReverbProcessor->setGain(newGain);
+        });
+    }
+
+    // shared by the filter effects, the bands are processed in series
+    class EqualizerProcessor final: public mixer::Processor
     {
     public:
+        using Band = Equalizer::Band;
+
+        explicit EqualizerProcessor(const std::vector<Band>& initBands)
+        {
+            setBands(initBands);
+        }
+
         void process(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate,
                      std::vector<float>& samples) final
         {
+            if (sampleRate != currentSampleRate)
+            {
+                currentSampleRate = sampleRate;
+                dirty = true;
+            }
+
+            if (dirty)
+            {
+                for (std::size_t i = 0; i < bandCount; ++i)
+                    filters[i].setCoefficients(getCoefficients(bands[i], sampleRate));
+                dirty = false;
+            }
+
+            for (std::size_t i = 0; i < bandCount; ++i)
+                filters[i].process(frames, channels, samples.data());
+        }
+
+        void setBands(const std::vector<Band>& newBands) noexcept
+        {
+            bandCount = std::min(newBands.size(), Equalizer::maxBands);
+            std::copy(newBands.begin(), newBands.begin() + static_cast<std::ptrdiff_t>(bandCount), bands.begin());
+            dirty = true;
         }
+
+        void setBand(std::size_t index, const Band& band) noexcept
+        {
+            if (index >= Equalizer::maxBands) return;
+
+            // the bands in between are flat until they are set
+            for (; bandCount <= index; ++bandCount)
+            {
+                bands[bandCount] = Band{};
+                filters[bandCount].reset();
+            }
+
+            bands[index] = band;
+            dirty = true;
+        }
+
+    private:
+        static mixer::Biquad::Coefficients getCoefficients(const Band& band, std::uint32_t sampleRate) noexcept
+        {
+            switch (band.type)
+            {
+                case Band::Type::peak: return mixer::Biquad::peak(sampleRate, band.frequency, band.q, band.gain);
+                case Band::Type::lowShelf: return mixer::Biquad::lowShelf(sampleRate, band.frequency, band.q, band.gain);
+                case Band::Type::highShelf: return mixer::Biquad::highShelf(sampleRate, band.frequency, band.q, band.gain);
+                case Band::Type::lowPass: return mixer::Biquad::lowPass(sampleRate, band.frequency, band.q);
+                case Band::Type::highPass: return mixer::Biquad::highPass(sampleRate, band.frequency, band.q);
+            }
+
+            return mixer::Biquad::Coefficients{};
+        }
+
+        std::array<Band, Equalizer::maxBands> bands;
+        std::array<mixer::Biquad, Equalizer::maxBands> filters;
+        std::size_t bandCount = 0;
+        std::uint32_t currentSampleRate = 0;
+        bool dirty = true;
     };
 
-    HighPass::HighPass(Audio& initAudio):
+    namespace
+    {
+        Equalizer::Band getFilterBand(Equalizer::Band::Type type, float cutoff, float q) noexcept
+        {
+            Equalizer::Band band;
+            band.type = type;
+            band.frequency = cutoff;
+            band.q = q;
+            return band;
+        }
+    }
+
+    LowPass::LowPass(Audio& initAudio, float initCutoff, float initQ):
+        Effect(initAudio,
+               initAudio.initProcessor(std::make_unique<EqualizerProcessor>(std::vector<Equalizer::Band>{
+                   getFilterBand(Equalizer::Band::Type::lowPass, initCutoff, initQ)
+               }))),
+        cutoff(initCutoff),
+        q(initQ)
+    {
+    }
+
+    void LowPass::setCutoff(float newCutoff)
+    {
+        cutoff = newCutoff;
+        updateFilter();
+    }
+
+    void LowPass::setQ(float newQ)
+    {
+        q = newQ;
+        updateFilter();
+    }
+
+    void LowPass::updateFilter()
+    {
+        const auto band = getFilterBand(Equalizer::Band::Type::lowPass, cutoff, q);
+
+        audio.updateProcessor(processorId, [band](mixer::Object* node) noexcept {
+            auto equalizerProcessor = static_cast<EqualizerProcessor*>(node);
+            equalizerProcessor->setBand(0, band);
+        });
+    }
+
+    HighPass::HighPass(Audio& initAudio, float initCutoff, float initQ):
         Effect(initAudio,
-               initAudio.initProcessor(std::unique_ptr<HighPassProcessor>()))
+               initAudio.initProcessor(std::make_unique<EqualizerProcessor>(std::vector<Equalizer::Band>{
+                   getFilterBand(Equalizer::Band::Type::highPass, initCutoff, initQ)
+               }))),
+        cutoff(initCutoff),
+        q(initQ)
+    {
+    }
+
+    void HighPass::setCutoff(float newCutoff)
     {
+        cutoff = newCutoff;
+        updateFilter();
+    }
+
+    void HighPass::setQ(float newQ)
+    {
+        q = newQ;
+        updateFilter();
+    }
+
+    void HighPass::updateFilter()
+    {
+        const auto band = getFilterBand(Equalizer::Band::Type::highPass, cutoff, q);
+
+        audio.updateProcessor(processorId, [band](mixer::Object* node) noexcept {
+            auto equalizerProcessor = static_cast<EqualizerProcessor*>(node);
+            equalizerProcessor->setBand(0, band);
+        });
+    }
+
+    Equalizer::Equalizer(Audio& initAudio, const std::vector<Band>& initBands):
+        Effect(initAudio,
+               initAudio.initProcessor(std::make_unique<EqualizerProcessor>(initBands))),
+        bands(initBands)
+    {
+        if (bands.size() > maxBands)
+            throw std::runtime_error("Too many equalizer bands");
+    }
+
+    void Equalizer::setBands(const std::vector<Band>& newBands)
+    {
+        if (newBands.size() > maxBands)
+            throw std::runtime_error("Too many equalizer bands");
+
+        bands = newBands;
+
+        audio.updateProcessor(processorId, [newBands](mixer::Object* node) noexcept {
+            auto equalizerProcessor = static_cast<EqualizerProcessor*>(node);
+            equalizerProcessor->setBands(newBands);
+        });
+    }
+
+    void Equalizer::setBand(std::size_t index, const Band& band)
+    {
+        if (index >= maxBands)
+            throw std::runtime_error("Invalid equalizer band");
+
+        if (index >= bands.size()) bands.resize(index + 1);
+        bands[index] = band;
+
+        audio.updateProcessor(processorId, [index, band](mixer::Object* node) noexcept {
+            auto equalizerProcessor = static_cast<EqualizerProcessor*>(node);
+            equalizerProcessor->setBand(index, band);
+        });
     }
 }
@@ -5,6 +5,8 @@
 
 #include <cfloat>
 #include <utility>
+#include <vector>
+#include "DistanceModel.hpp"
 #include "Effect.hpp"
 #include "../math/Vector.hpp"
 #include "../scene/Component.hpp"
@@ -28,8 +30,11 @@ namespace ouzel::audio
         void setDelayRandom(const std::pair<float, float>& newDelayRandom);
 
     private:
+        void updateDelay();
+
         float delay = 0.0F;
         std::pair<float, float> delayRandom{0.0F, 0.0F};
+        std::uint32_t maxDelayFrames = 0;
     };
 
     class Gain final: public Effect
@@ -49,6 +54,8 @@ namespace ouzel::audio
         void setGainRandom(const std::pair<float, float>& newGainRandom);
 
     private:
+        void updateGain();
+
         float gain = 0.0F; // dB
         std::pair<float, float> gainRandom{0.0F, 0.0F};
     };
@@ -63,9 +70,16 @@ namespace ouzel::audio
         Panner(Panner&&) = delete;
         Panner& operator=(Panner&&) = delete;
 
+        // the positions of the voices in the mix are relative to it
         auto& getPosition() const noexcept { return position; }
         void setPosition(const Vector3F& newPosition);
 
+        auto& getVelocity() const noexcept { return velocity; }
+        void setVelocity(const Vector3F& newVelocity);
+
+        auto getDistanceModel() const noexcept { return distanceModel; }
+        void setDistanceModel(DistanceModel newDistanceModel);
+
         auto getRolloffFactor() const noexcept { return rolloffFactor; }
         void setRolloffFactor(float newRolloffFactor);
 
@@ -75,13 +89,23 @@ namespace ouzel::audio
         auto getMaxDistance() const noexcept { return maxDistance; }
         void setMaxDistance(float newMaxDistance);
 
+        // scales the Doppler shift, zero disables it
+        auto getDopplerFactor() const noexcept { return dopplerFactor; }
+        void setDopplerFactor(float newDopplerFactor);
+
+        // gain of the distance model
+        float getAttenuation(float distance) const noexcept;
+
     private:
         void updateTransform() final;
 
         Vector3F position;
+        Vector3F velocity;
+        DistanceModel distanceModel = DistanceModel::inverse;
         float rolloffFactor = 1.0F;
         float minDistance = 1.0F;
         float maxDistance = FLT_MAX;
+        float dopplerFactor = 1.0F;
     };
 
     class PitchScale final: public Effect
@@ -144,26 +168,110 @@ namespace ouzel::audio
         float decay = 0.5F;
     };
 
+    class Sound;
+
+    // convolves the signal with a recorded impulse response of a room, the wet signal is added to the input
+    class ConvolutionReverb final: public Effect
+    {
+    public:
+        // the impulse response has to be a PCM clip (e.g. a WAV file from a bundle), gain is in dB,
+        // the long tail of the response is convolved on a background thread unless backgroundTail is false
+        ConvolutionReverb(Audio& initAudio, const Sound* impulseResponse, float initGain = 0.0F, bool backgroundTail = true);
+
+        ConvolutionReverb(const ConvolutionReverb&) = delete;
+        ConvolutionReverb& operator=(const ConvolutionReverb&) = delete;
+        ConvolutionReverb(ConvolutionReverb&&) = delete;
+        ConvolutionReverb& operator=(ConvolutionReverb&&) = delete;
+
+        auto getGain() const noexcept { return gain; }
+        void setGain(float newGain);
+
+    private:
+        float gain = 0.0F;
+    };
+
     class LowPass final: public Effect
     {
     public:
-        explicit LowPass(Audio& initAudio);
+        explicit LowPass(Audio& initAudio, float initCutoff = 5000.0F, float initQ = 0.7071F);
 
         LowPass(const LowPass&) = delete;
         LowPass& operator=(const LowPass&) = delete;
         LowPass(LowPass&&) = delete;
         LowPass& operator=(LowPass&&) = delete;
+
+        auto getCutoff() const noexcept { return cutoff; }
+        void setCutoff(float newCutoff);
+
+        auto getQ() const noexcept { return q; }
+        void setQ(float newQ);
+
+    private:
+        void updateFilter();
+
+        float cutoff = 5000.0F; // Hz
+        float q = 0.7071F;
     };
 
     class HighPass final: public Effect
     {
     public:
-        explicit HighPass(Audio& initAudio);
+        explicit HighPass(Audio& initAudio, float initCutoff = 200.0F, float initQ = 0.7071F);
 
         HighPass(const HighPass&) = delete;
         HighPass& operator=(const HighPass&) = delete;
         HighPass(HighPass&&) = delete;
         HighPass& operator=(HighPass&&) = delete;
+
+        auto getCutoff() const noexcept { return cutoff; }
+        void setCutoff(float newCutoff);
+
+        auto getQ() const noexcept { return q; }
+        void setQ(float newQ);
+
+    private:
+        void updateFilter();
+
+        float cutoff = 200.0F; // Hz
+        float q = 0.7071F;
+    };
+
+    // parametric equalizer with a cascade of biquad bands
+    class Equalizer final: public Effect
+    {
+    public:
+        static constexpr std::size_t maxBands = 8;
+
+        struct Band final
+        {
+            enum class Type
+            {
+                peak,
+                lowShelf,
+                highShelf,
+                lowPass,
+                highPass
+            };
+
+            Type type = Type::peak;
+            float frequency = 1000.0F; // Hz
+            float q = 0.7071F;
+            float gain = 0.0F; // dB, used by the peak and shelf bands
+        };
+
+        explicit Equalizer(Audio& initAudio, const std::vector<Band>& initBands = {});
+
+        Equalizer(const Equalizer&) = delete;
+        Equalizer& operator=(const Equalizer&) = delete;
+        Equalizer(Equalizer&&) = delete;
+        Equalizer& operator=(Equalizer&&) = delete;
+
+        auto& getBands() const noexcept { return bands; }
+        void setBands(const std::vector<Band>& newBands);
+        void setBand(std::size_t index, const Band& band);
+
+    private:
+        std::vector<Band> bands;
     };
 }
 
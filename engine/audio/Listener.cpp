@@ -28,6 +28,7 @@ namespace ouzel::audio
 
     void Listener::updateTransform()
     {
-        transformDirty = true;
+        position = actor->getWorldPosition();
+        rotation = actor->getTransform().getRotation();
     }
 }
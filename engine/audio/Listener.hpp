@@ -45,8 +45,7 @@ namespace ouzel::audio
         Mix* mix = nullptr;
         Vector3F position;
         Vector3F velocity;
-        QuaternionF rotation;
-        bool transformDirty = true;
+        QuaternionF rotation = QuaternionF::identity();
     };
 }
 
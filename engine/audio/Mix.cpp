@@ -1,5 +1,6 @@
 // Copyright 2015-2020 Elviss Strazdins. All rights reserved.
 
+#include <algorithm>
 #include "Mix.hpp"
 #include "Audio.hpp"
 #include "Effect.hpp"
@@ -40,6 +41,7 @@ namespace ouzel::audio
             if (effect->mix) effect->mix->removeEffect(effect);
             effect->mix = this;
             effects.push_back(effect);
+            reserveBus();
 
             audio.addCommand(std::make_unique<mixer::AddProcessorCommand>(busId, effect->getProcessorId()));
         }
@@ -60,7 +62,11 @@ namespace ouzel::audio
     void Mix::addInput(Submix* submix)
     {
         const auto i = std::find(inputSubmixes.begin(), inputSubmixes.end(), submix);
-        if (i == inputSubmixes.end()) inputSubmixes.push_back(submix);
+        if (i == inputSubmixes.end())
+        {
+            inputSubmixes.push_back(submix);
+            reserveBus();
+        }
     }
 
     void Mix::removeInput(Submix* submix)
@@ -72,7 +78,11 @@ namespace ouzel::audio
     void Mix::addInput(Voice* voice)
     {
         const auto i = std::find(inputVoices.begin(), inputVoices.end(), voice);
-        if (i == inputVoices.end()) inputVoices.push_back(voice);
+        if (i == inputVoices.end())
+        {
+            inputVoices.push_back(voice);
+            reserveBus();
+        }
     }
 
     void Mix::removeInput(Voice* voice)
@@ -81,6 +91,26 @@ namespace ouzel::audio
         if (i != inputVoices.end()) inputVoices.erase(i);
     }
 
+    void Mix::reserveBus()
+    {
+        const auto grow = [](std::size_t& capacity, std::size_t size) noexcept -> std::size_t {
+            if (size <= capacity) return 0;
+            capacity = std::max(size * 2, std::size_t(4));
+            return capacity;
+        };
+
+        // only the lists that are too small are sent to the mixer
+        const auto newInputBusCapacity = grow(inputBusCapacity, inputSubmixes.size());
+        const auto newInputStreamCapacity = grow(inputStreamCapacity, inputVoices.size());
+        const auto newProcessorCapacity = grow(processorCapacity, effects.size());
+
+        if (newInputBusCapacity || newInputStreamCapacity || newProcessorCapacity)
+            audio.addCommand(std::make_unique<mixer::ReserveBusCommand>(busId,
+                                                                        newInputBusCapacity,
+                                                                        newInputStreamCapacity,
+                                                                        newProcessorCapacity));
+    }
+
     void Mix::addListener(Listener* listener)
     {
         const auto i = std::find(listeners.begin(), listeners.end(), listener);
@@ -16,6 +16,7 @@ namespace ouzel::audio
 
     class Mix
     {
+        friend Audio;
         friend Listener;
         friend Submix;
         friend Voice;
@@ -33,6 +34,10 @@ namespace ouzel::audio
         void addEffect(Effect* effect);
         void removeEffect(Effect* effect);
 
+        // the number of real voices mixed directly into this mix, zero for no limit
+        auto getMaxVoices() const noexcept { return maxVoices; }
+        void setMaxVoices(std::size_t newMaxVoices) noexcept { maxVoices = newMaxVoices; }
+
     protected:
         void addInput(Submix* submix);
         void removeInput(Submix* submix);
@@ -41,12 +46,20 @@ namespace ouzel::audio
         void addListener(Listener* listener);
         void removeListener(Listener* listener);
 
+        // grows the lists of the bus before the mixer adds anything to them
+        void reserveBus();
+
         Audio& audio;
         std::size_t busId;
         std::vector<Submix*> inputSubmixes;
         std::vector<Voice*> inputVoices;
         std::vector<Effect*> effects;
         std::vector<Listener*> listeners;
+        std::size_t inputBusCapacity = 0;
+        std::size_t inputStreamCapacity = 0;
+        std::size_t processorCapacity = 0;
+        std::size_t maxVoices = 0;
+        std::size_t realVoiceCount = 0;
     };
 }
 
@@ -17,6 +17,14 @@ namespace ouzel::audio
             {
                 child.parent = this;
                 children.push_back(&child);
+
+                // the children of the mixer object only grow here, so that adding them never allocates on the mixer
+                if (children.size() > childCapacity)
+                {
+                    childCapacity = std::max(children.size() * 2, std::size_t(4));
+                    audio.addCommand(std::make_unique<mixer::ReserveChildrenCommand>(objectId, childCapacity));
+                }
+
                 audio.addCommand(std::make_unique<mixer::AddChildCommand>(objectId, child.objectId));
             }
         }
@@ -1,9 +1,11 @@
 // Copyright 2015-2020 Elviss Strazdins. All rights reserved.
 
+#include <algorithm>
 #include "Oscillator.hpp"
 #include "Audio.hpp"
 #include "mixer/Data.hpp"
 #include "mixer/Stream.hpp"
+#include "mixer/Wavetable.hpp"
 #include "../math/Constants.hpp"
 
 namespace ouzel::audio
@@ -18,23 +20,95 @@ namespace ouzel::audio
         void reset() final
         {
             position = 0;
+            phase = 0;
         }
 
+        void seek(std::uint64_t frame) final;
+        void skip(std::uint32_t frames) final;
+        std::uint64_t getRemainingFrames() const noexcept final;
+
         void generateSamples(std::uint32_t frames, std::vector<float>& samples) final;
 
     private:
         std::uint32_t position = 0;
+        std::uint32_t phase = 0;
     };
 
+    namespace
+    {
+        // amplitudes of the sine harmonics of the waveforms, all of them start at zero and rise
+        std::vector<float> getHarmonics(Oscillator::Type type)
+        {
+            std::vector<float> harmonics(mixer::Wavetable::maxHarmonics);
+
+            for (std::uint32_t i = 0; i < harmonics.size(); ++i)
+            {
+                const auto harmonic = static_cast<float>(i + 1);
+                const bool odd = (i % 2) == 0;
+
+                switch (type)
+                {
+                    case Oscillator::Type::sine:
+                        harmonics[i] = (i == 0) ? 1.0F : 0.0F;
+                        break;
+                    case Oscillator::Type::square:
+                        harmonics[i] = odd ? 4.0F / (pi<float> * harmonic) : 0.0F;
+                        break;
+                    case Oscillator::Type::sawtooth:
+                        harmonics[i] = (odd ? 2.0F : -2.0F) / (pi<float> * harmonic);
+                        break;
+                    case Oscillator::Type::triangle:
+                        harmonics[i] = odd ? (((i / 2) % 2 == 0) ? 8.0F : -8.0F) / (pi<float> * pi<float> * harmonic * harmonic) : 0.0F;
+                        break;
+                }
+            }
+
+            return harmonics;
+        }
+
+        // built on the first use and shared by all of the oscillators
+        const mixer::Wavetable& getSharedWavetable(Oscillator::Type type)
+        {
+            switch (type)
+            {
+                case Oscillator::Type::square:
+                {
+                    static const mixer::Wavetable square(getHarmonics(Oscillator::Type::square));
+                    return square;
+                }
+                case Oscillator::Type::sawtooth:
+                {
+                    static const mixer::Wavetable sawtooth(getHarmonics(Oscillator::Type::sawtooth));
+                    return sawtooth;
+                }
+                case Oscillator::Type::triangle:
+                {
+                    static const mixer::Wavetable triangle(getHarmonics(Oscillator::Type::triangle));
+                    return triangle;
+                }
+                case Oscillator::Type::sine:
+                default:
+                {
+                    static const mixer::Wavetable sine(std::vector<float>{1.0F});
+                    return sine;
+                }
+            }
+        }
+    }
+
     class OscillatorData final: public mixer::Data
     {
     public:
-        OscillatorData(float initFrequency, Oscillator::Type initType, float initAmplitude, float initLength):
-            Data(1, 44100),
+        OscillatorData(std::uint32_t initSampleRate, float initFrequency, Oscillator::Type initType,
+                       float initAmplitude, float initLength):
+            Data(1, initSampleRate),
             frequency(initFrequency),
             type(initType),
             amplitude(initAmplitude),
-            length(initLength)
+            length(initLength),
+            wavetable(getSharedWavetable(initType)),
+            increment(mixer::Wavetable::getIncrement(initFrequency, initSampleRate)),
+            frames(static_cast<std::uint32_t>(initLength * static_cast<float>(initSampleRate)))
         {
         }
 
@@ -42,6 +116,9 @@ namespace ouzel::audio
         auto getType() const noexcept { return type; }
         auto getAmplitude() const noexcept { return amplitude; }
         auto getLength() const noexcept { return length; }
+        auto& getWavetable() const noexcept { return wavetable; }
+        auto getIncrement() const noexcept { return increment; }
+        auto getFrames() const noexcept { return frames; }
 
         std::unique_ptr<mixer::Stream> createStream() final
         {
@@ -53,6 +130,9 @@ namespace ouzel::audio
         Oscillator::Type type;
         float amplitude;
         float length;
+        const mixer::Wavetable& wavetable;
+        std::uint32_t increment;
+        std::uint32_t frames; // zero for the oscillators without an end
     };
 
     OscillatorStream::OscillatorStream(OscillatorData& oscillatorData):
@@ -60,99 +140,70 @@ namespace ouzel::audio
     {
     }
 
-    namespace
+    void OscillatorStream::seek(std::uint64_t frame)
     {
-        void generateWave(Oscillator::Type type, std::uint32_t frames, std::uint32_t offset,
-                          float frameLength, float amplitude, float* samples)
-        {
-            for (std::uint32_t i = 0; i < frames; ++i)
-            {
-                auto t = static_cast<float>(offset) * frameLength;
+        const auto& oscillatorData = static_cast<OscillatorData&>(data);
+        const auto frames = oscillatorData.getFrames();
 
-                switch (type)
-                {
-                    case Oscillator::Type::sine:
-                        samples[i] = std::sin(t * tau<float>);
-                        break;
-                    case Oscillator::Type::square:
-                        samples[i] = std::fmod(std::round(t * 2.0F + 0.5F), 2.0F) * 2.0F - 1.0F;
-                        break;
-                    case Oscillator::Type::sawtooth:
-                        samples[i] = std::fmod(t + 0.5F, 1.0F) * 2.0F - 1.0F;
-                        break;
-                    case Oscillator::Type::triangle:
-                        samples[i] = std::fabs(std::fmod(t + 0.75F, 1.0F) * 2.0F - 1.0F) * 2.0F - 1.0F;
-                        break;
-                }
+        position = static_cast<std::uint32_t>((frames > 0) ? std::min<std::uint64_t>(frame, frames) : frame);
+        // the phase wraps around every 2^32, so only the low bits of the product matter
+        phase = static_cast<std::uint32_t>(frame * oscillatorData.getIncrement());
+    }
 
-                samples[i] *= amplitude;
+    void OscillatorStream::skip(std::uint32_t frames)
+    {
+        const auto& oscillatorData = static_cast<OscillatorData&>(data);
+        const auto sourceFrames = oscillatorData.getFrames();
 
-                ++offset;
-            }
+        if (sourceFrames > 0 && frames >= sourceFrames - position)
+        {
+            playing = false; // reported by the mixer
+            reset();
+        }
+        else
+        {
+            position += frames;
+            phase += frames * oscillatorData.getIncrement();
         }
     }
 
+    std::uint64_t OscillatorStream::getRemainingFrames() const noexcept
+    {
+        const auto frames = static_cast<const OscillatorData&>(data).getFrames();
+        if (frames > 0)
+            return frames - position;
+        else
+            return Stream::getRemainingFrames();
+    }
+
     void OscillatorStream::generateSamples(std::uint32_t frames, std::vector<float>& samples)
     {
-        auto& oscillatorData = static_cast<OscillatorData&>(data);
+        const auto& oscillatorData = static_cast<OscillatorData&>(data);
+        const auto sourceFrames = oscillatorData.getFrames();
 
         samples.resize(frames);
 
-        const auto sampleRate = data.getSampleRate();
-        const auto length = static_cast<OscillatorData&>(data).getLength();
-
-        if (length > 0.0F)
-        {
-            const auto frameCount = static_cast<std::uint32_t>(length * sampleRate);
-            auto neededSize = frames;
-            std::uint32_t totalSize = 0;
+        const auto count = (sourceFrames > 0) ? std::min(frames, sourceFrames - position) : frames;
 
-            if (neededSize > 0)
-            {
-                if (frameCount - position < neededSize)
-                {
-                    generateWave(oscillatorData.getType(), frameCount - position, position,
-                                 oscillatorData.getFrequency() / static_cast<float>(sampleRate),
-                                 oscillatorData.getAmplitude(), samples.data() + totalSize);
+        oscillatorData.getWavetable().generate(count, phase, oscillatorData.getIncrement(),
+                                               oscillatorData.getAmplitude(), samples.data());
+        std::fill(samples.begin() + count, samples.end(), 0.0F);
 
-                    totalSize += frameCount - position;
-                    neededSize -= frameCount - position;
-                    position = frameCount;
-                }
-                else
-                {
-                    generateWave(oscillatorData.getType(), neededSize, position,
-                                 oscillatorData.getFrequency() / static_cast<float>(sampleRate),
-                                 oscillatorData.getAmplitude(), samples.data() + totalSize);
+        position += count;
 
-                    totalSize += neededSize;
-                    position += neededSize;
-                    neededSize = 0;
-                }
-            }
-
-            if ((frameCount - position) == 0)
-            {
-                playing = false; // TODO: fire event
-                reset();
-            }
-
-            std::fill(samples.begin() + totalSize, samples.end(), 0.0F); // TODO: remove
-        }
-        else
+        if (sourceFrames > 0 && position == sourceFrames)
         {
-            generateWave(oscillatorData.getType(), frames, position,
-                         oscillatorData.getFrequency() / static_cast<float>(sampleRate),
-                         oscillatorData.getAmplitude(), samples.data());
-
-            position += frames;
+            playing = false; // reported by the mixer
+            reset();
         }
     }
 
     Oscillator::Oscillator(Audio& initAudio, float initFrequency,
                            Type initType, float initAmplitude, float initLength):
         Sound(initAudio,
-              initAudio.initData(std::unique_ptr<mixer::Data>(data = new OscillatorData(initFrequency, initType, initAmplitude, initLength))),
+              initAudio.initData(std::unique_ptr<mixer::Data>(data = new OscillatorData(initAudio.getDevice()->getSampleRate(),
+                                                                                        initFrequency, initType,
+                                                                                        initAmplitude, initLength))),
               Sound::Format::pcm),
         type(initType),
         frequency(initFrequency),
@@ -1,10 +1,15 @@
 // Copyright 2015-2020 Elviss Strazdins. All rights reserved.
 
+#include <algorithm>
+#include <cmath>
 #include <iterator>
+#include <limits>
 #include <stdexcept>
 #include "PcmClip.hpp"
 #include "Audio.hpp"
+#include "mixer/Adpcm.hpp"
 #include "mixer/Data.hpp"
+#include "mixer/Dsp.hpp"
 #include "mixer/Stream.hpp"
 
 namespace ouzel::audio
@@ -21,23 +26,68 @@ namespace ouzel::audio
             position = 0;
         }
 
+        void seek(std::uint64_t frame) final;
+        void skip(std::uint32_t frames) final;
+        std::uint64_t getRemainingFrames() const noexcept final;
+
         void generateSamples(std::uint32_t frames, std::vector<float>& samples) final;
 
     private:
+        void decode(std::uint32_t frames, float* samples, std::uint32_t stride);
+
         std::uint32_t position = 0;
+
+        // the last decoded ADPCM block of every channel
+        std::vector<std::int16_t> decodedSamples;
+        std::size_t decodedBlock = std::numeric_limits<std::size_t>::max();
     };
 
     class PcmData final: public mixer::Data
     {
     public:
         PcmData(std::uint32_t initChannels, std::uint32_t initSampleRate,
-                const std::vector<float>& initData):
+                std::vector<float> initSamples):
+            Data(initChannels, initSampleRate),
+            encoding(PcmClip::Encoding::float32),
+            frames(static_cast<std::uint32_t>(initSamples.size() / initChannels)),
+            floatSamples(std::move(initSamples))
+        {
+        }
+
+        PcmData(std::uint32_t initChannels, std::uint32_t initSampleRate,
+                std::vector<std::int16_t> initSamples):
+            Data(initChannels, initSampleRate),
+            encoding(PcmClip::Encoding::signedInt16),
+            frames(static_cast<std::uint32_t>(initSamples.size() / initChannels)),
+            int16Samples(std::move(initSamples))
+        {
+        }
+
+        PcmData(std::uint32_t initChannels, std::uint32_t initSampleRate, std::uint32_t initFrames,
+                std::vector<std::uint8_t> initBlocks, std::size_t initBlockSize):
             Data(initChannels, initSampleRate),
-            data(initData)
+            encoding(PcmClip::Encoding::imaAdpcm),
+            frames(initFrames),
+            blocks(std::move(initBlocks)),
+            blockSize(initBlockSize),
+            blockFrames(mixer::adpcm::getBlockFrames(initBlockSize))
         {
         }
 
-        auto& getData() const noexcept { return data; }
+        auto getEncoding() const noexcept { return encoding; }
+        auto getFrames() const noexcept { return frames; }
+        auto& getFloatSamples() const noexcept { return floatSamples; }
+        auto& getInt16Samples() const noexcept { return int16Samples; }
+        auto& getBlocks() const noexcept { return blocks; }
+        auto getBlockSize() const noexcept { return blockSize; }
+        auto getBlockFrames() const noexcept { return blockFrames; }
+
+        std::size_t getSize() const noexcept
+        {
+            return floatSamples.size() * sizeof(float) +
+                int16Samples.size() * sizeof(std::int16_t) +
+                blocks.size();
+        }
 
         std::unique_ptr<mixer::Stream> createStream() final
         {
@@ -45,12 +95,46 @@ namespace ouzel::audio
         }
 
     private:
-        std::vector<float> data;
+        PcmClip::Encoding encoding;
+        std::uint32_t frames = 0;
+        std::vector<float> floatSamples;
+        std::vector<std::int16_t> int16Samples;
+        std::vector<std::uint8_t> blocks;
+        std::size_t blockSize = 0;
+        std::uint32_t blockFrames = 0;
     };
 
     PcmStream::PcmStream(PcmData& pcmData):
         Stream(pcmData)
     {
+        // streams are created outside the mixer, so the block cache does not allocate while rendering
+        if (pcmData.getEncoding() == PcmClip::Encoding::imaAdpcm)
+            decodedSamples.resize(pcmData.getChannels() * pcmData.getBlockFrames());
+    }
+
+    void PcmStream::seek(std::uint64_t frame)
+    {
+        const auto& pcmData = static_cast<PcmData&>(data);
+        position = static_cast<std::uint32_t>(std::min<std::uint64_t>(frame, pcmData.getFrames()));
+    }
+
+    void PcmStream::skip(std::uint32_t frames)
+    {
+        const auto& pcmData = static_cast<PcmData&>(data);
+        const auto sourceFrames = pcmData.getFrames();
+
+        if (frames >= sourceFrames - position)
+        {
+            playing = false; // reported by the mixer
+            reset();
+        }
+        else
+            position += frames;
+    }
+
+    std::uint64_t PcmStream::getRemainingFrames() const noexcept
+    {
+        return static_cast<const PcmData&>(data).getFrames() - position;
     }
 
     void PcmStream::generateSamples(std::uint32_t frames, std::vector<float>& samples)
@@ -59,42 +143,202 @@ namespace ouzel::audio
         samples.resize(neededSize);
 
         const auto& pcmData = static_cast<PcmData&>(data);
-        const std::vector<float>& dataSamples = pcmData.getData();
-
-        const auto sourceFrames = static_cast<std::uint32_t>(dataSamples.size() / pcmData.getChannels());
+        const auto sourceFrames = pcmData.getFrames();
         const std::uint32_t copyFrames = (frames > sourceFrames - position) ? sourceFrames - position : frames;
 
+        decode(copyFrames, samples.data(), frames);
+
+        position += copyFrames;
+
         for (std::uint32_t channel = 0; channel < pcmData.getChannels(); ++channel)
         {
-            const float* sourceChannel = &dataSamples[channel * sourceFrames];
             float* outputChannel = &samples[channel * frames];
+            std::fill(outputChannel + copyFrames, outputChannel + frames, 0.0F);
+        }
 
-            for (std::uint32_t frame = 0; frame < copyFrames; ++frame)
-                outputChannel[frame] = sourceChannel[frame + position];
+        if ((sourceFrames - position) == 0)
+        {
+            playing = false; // reported by the mixer
+            reset();
         }
+    }
 
-        position += copyFrames;
+    void PcmStream::decode(std::uint32_t frames, float* samples, std::uint32_t stride)
+    {
+        const auto& pcmData = static_cast<PcmData&>(data);
+        const auto channels = pcmData.getChannels();
+        const auto sourceFrames = pcmData.getFrames();
 
-        for (std::uint32_t channel = 0; channel < pcmData.getChannels(); ++channel)
+        switch (pcmData.getEncoding())
         {
-            float* outputChannel = &samples[channel * frames];
+            case PcmClip::Encoding::float32:
+            {
+                const auto& floatSamples = pcmData.getFloatSamples();
+                for (std::uint32_t channel = 0; channel < channels; ++channel)
+                {
+                    const float* sourceChannel = &floatSamples[channel * sourceFrames + position];
+                    std::copy(sourceChannel, sourceChannel + frames, samples + channel * stride);
+                }
+                break;
+            }
+            case PcmClip::Encoding::signedInt16:
+            {
+                const auto& int16Samples = pcmData.getInt16Samples();
+                for (std::uint32_t channel = 0; channel < channels; ++channel)
+                    mixer::dsp::convert(&int16Samples[channel * sourceFrames + position],
+                                        samples + channel * stride, frames);
+                break;
+            }
+            case PcmClip::Encoding::imaAdpcm:
+            {
+                const auto& blocks = pcmData.getBlocks();
+                const auto blockSize = pcmData.getBlockSize();
+                const auto blockFrames = pcmData.getBlockFrames();
+
+                // every block is decoded once to 16-bit samples and then converted in one pass
+                for (std::uint32_t done = 0; done < frames;)
+                {
+                    const auto frame = position + done;
+                    const std::size_t block = frame / blockFrames;
+                    const auto offset = frame % blockFrames;
+                    const auto count = std::min(blockFrames - offset, frames - done);
+
+                    if (block != decodedBlock)
+                    {
+                        for (std::uint32_t channel = 0; channel < channels; ++channel)
+                            mixer::adpcm::decode(&blocks[(block * channels + channel) * blockSize], blockSize,
+                                                 &decodedSamples[channel * blockFrames]);
+                        decodedBlock = block;
+                    }
+
+                    for (std::uint32_t channel = 0; channel < channels; ++channel)
+                        mixer::dsp::convert(&decodedSamples[channel * blockFrames + offset],
+                                            samples + channel * stride + done, count);
 
-            for (std::uint32_t frame = copyFrames; frame < frames; ++frame)
-                outputChannel[frame] = 0.0F;
+                    done += count;
+                }
+                break;
+            }
         }
+    }
 
-        if ((sourceFrames - position) == 0)
+    namespace
+    {
+        std::vector<std::int16_t> quantize(const std::vector<float>& samples)
         {
-            playing = false; // TODO: fire event
-            reset();
+            std::vector<std::int16_t> result(samples.size());
+            std::transform(samples.begin(), samples.end(), result.begin(), [](float sample) noexcept {
+                return static_cast<std::int16_t>(std::lround(std::clamp(sample, -1.0F, 1.0F) * 32767.0F));
+            });
+            return result;
+        }
+
+        std::vector<float> convert(const std::vector<std::int16_t>& samples)
+        {
+            std::vector<float> result(samples.size());
+            mixer::dsp::convert(samples.data(), result.data(), samples.size());
+            return result;
+        }
+
+        PcmData* createData(std::uint32_t channels, std::uint32_t sampleRate,
+                            const std::vector<std::int16_t>& samples, PcmClip::Encoding encoding)
+        {
+            switch (encoding)
+            {
+                case PcmClip::Encoding::float32:
+                    return new PcmData(channels, sampleRate, convert(samples));
+                case PcmClip::Encoding::signedInt16:
+                    return new PcmData(channels, sampleRate, samples);
+                case PcmClip::Encoding::imaAdpcm:
+                {
+                    constexpr auto blockSize = mixer::adpcm::defaultBlockSize;
+                    const auto frames = static_cast<std::uint32_t>(samples.size() / channels);
+                    const auto blockFrames = mixer::adpcm::getBlockFrames(blockSize);
+                    const auto blockCount = (frames + blockFrames - 1) / blockFrames;
+                    std::vector<std::uint8_t> blocks(blockCount * channels * blockSize);
+
+                    for (std::uint32_t channel = 0; channel < channels; ++channel)
+                        mixer::adpcm::encode(&samples[channel * frames], frames,
+                                             blocks.data() + channel * blockSize, blockSize, channels * blockSize);
+
+                    return new PcmData(channels, sampleRate, frames, std::move(blocks), blockSize);
+                }
+            }
+
+            throw std::runtime_error("Invalid encoding");
         }
     }
 
     PcmClip::PcmClip(Audio& initAudio, std::uint32_t channels, std::uint32_t sampleRate,
-                      const std::vector<float>& samples):
+                     const std::vector<float>& samples, Encoding encoding):
+        Sound(initAudio,
+              initAudio.initData(std::unique_ptr<mixer::Data>(data = (encoding == Encoding::float32) ?
+                                                               new PcmData(channels, sampleRate, samples) :
+                                                               createData(channels, sampleRate, quantize(samples), encoding))),
+              Sound::Format::pcm)
+    {
+        audio.addClip(getSize(), samples.size() * sizeof(float));
+    }
+
+    PcmClip::PcmClip(Audio& initAudio, std::uint32_t channels, std::uint32_t sampleRate,
+                     const std::vector<std::int16_t>& samples, Encoding encoding):
+        Sound(initAudio,
+              initAudio.initData(std::unique_ptr<mixer::Data>(data = createData(channels, sampleRate, samples, encoding))),
+              Sound::Format::pcm)
+    {
+        audio.addClip(getSize(), samples.size() * sizeof(float));
+    }
+
+    PcmClip::PcmClip(Audio& initAudio, std::uint32_t channels, std::uint32_t sampleRate, std::uint32_t frames,
+                     std::vector<std::uint8_t> blocks, std::size_t blockSize):
         Sound(initAudio,
-              initAudio.initData(std::unique_ptr<mixer::Data>(data = new PcmData(channels, sampleRate, samples))),
+              initAudio.initData(std::unique_ptr<mixer::Data>(data = new PcmData(channels, sampleRate, frames,
+                                                                                std::move(blocks), blockSize))),
               Sound::Format::pcm)
     {
+        if (blockSize <= mixer::adpcm::headerSize ||
+            data->getBlocks().size() < (frames + data->getBlockFrames() - 1) / data->getBlockFrames() * channels * blockSize)
+            throw std::runtime_error("Invalid ADPCM data");
+
+        audio.addClip(getSize(), static_cast<std::size_t>(frames) * channels * sizeof(float));
+    }
+
+    PcmClip::~PcmClip()
+    {
+        audio.removeClip(getSize(), static_cast<std::size_t>(getFrames()) * getChannels() * sizeof(float));
+    }
+
+    std::uint32_t PcmClip::getChannels() const noexcept
+    {
+        return data->getChannels();
+    }
+
+    std::uint32_t PcmClip::getSampleRate() const noexcept
+    {
+        return data->getSampleRate();
+    }
+
+    std::uint32_t PcmClip::getFrames() const noexcept
+    {
+        return data->getFrames();
+    }
+
+    PcmClip::Encoding PcmClip::getEncoding() const noexcept
+    {
+        return data->getEncoding();
+    }
+
+    std::size_t PcmClip::getSize() const noexcept
+    {
+        return data->getSize();
+    }
+
+    std::vector<float> PcmClip::getSamples() const
+    {
+        // a stream of its own, so that the decoding does not touch the ones in the mixer
+        PcmStream stream(*data);
+        std::vector<float> samples;
+        stream.generateSamples(data->getFrames(), samples);
+        return samples;
     }
 }
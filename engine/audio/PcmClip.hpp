@@ -14,8 +14,32 @@ namespace ouzel::audio
     class PcmClip final: public Sound
     {
     public:
+        enum class Encoding
+        {
+            float32,
+            signedInt16,
+            imaAdpcm
+        };
+
+        // planar samples, converted to the encoding the clip keeps in memory
+        PcmClip(Audio& initAudio, std::uint32_t channels, std::uint32_t sampleRate,
+                const std::vector<float>& samples, Encoding encoding = Encoding::float32);
         PcmClip(Audio& initAudio, std::uint32_t channels, std::uint32_t sampleRate,
-                const std::vector<float>& samples);
+                const std::vector<std::int16_t>& samples, Encoding encoding = Encoding::signedInt16);
+        // IMA ADPCM blocks of blockSize bytes (see mixer/Adpcm.hpp), a block of every channel after another
+        PcmClip(Audio& initAudio, std::uint32_t channels, std::uint32_t sampleRate, std::uint32_t frames,
+                std::vector<std::uint8_t> blocks, std::size_t blockSize);
+        ~PcmClip() override;
+
+        std::uint32_t getChannels() const noexcept;
+        std::uint32_t getSampleRate() const noexcept;
+        std::uint32_t getFrames() const noexcept;
+        Encoding getEncoding() const noexcept;
+        // bytes taken by the stored samples
+        std::size_t getSize() const noexcept;
+
+        // decoded planar samples, the stored ones do not change after the clip is created, so they can be read outside the mixer
+        std::vector<float> getSamples() const;
 
     private:
         PcmData* data;
@@ -0,0 +1,16 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_RESAMPLERQUALITY_HPP
+#define OUZEL_AUDIO_RESAMPLERQUALITY_HPP
+
+namespace ouzel::audio
+{
+    enum class ResamplerQuality
+    {
+        low,
+        medium,
+        high
+    };
+}
+
+#endif // OUZEL_AUDIO_RESAMPLERQUALITY_HPP
@@ -4,6 +4,8 @@
 #define OUZEL_AUDIO_SETTINGS_HPP
 
 #include <cstdint>
+#include <string>
+#include "ResamplerQuality.hpp"
 #include "SampleFormat.hpp"
 
 namespace ouzel::audio
@@ -12,10 +14,18 @@ namespace ouzel::audio
     {
         bool debugAudio = false;
         std::uint32_t bufferSize = 512;
+        std::uint32_t periods = 4; // buffers of bufferSize frames queued in the device, used by ALSA
+        bool mmapAccess = true; // let the drivers that support it mix straight into the device memory
         std::uint32_t sampleRate = 44100;
         std::uint32_t channels = 0;
+        std::uint32_t latency = 0; // frames mixed ahead of the device, zero for twice the buffer size
+        std::uint32_t maxVoices = 64; // voices mixed at the same time, zero for no limit
+        std::uint32_t mixerWorkers = 1; // threads that help the mixer to generate independent buses
         SampleFormat sampleFormat = SampleFormat::float32;
+        ResamplerQuality resamplerQuality = ResamplerQuality::medium;
         std::string audioDevice;
+        std::string renderFile; // WAV file written by the offline driver, empty to discard the output
+        std::uint64_t renderLength = 0; // frames rendered by the offline driver, zero to render until stopped
     };
 }
 
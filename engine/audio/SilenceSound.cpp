@@ -19,6 +19,8 @@ namespace ouzel::audio
             position = 0;
         }
 
+        std::uint64_t getRemainingFrames() const noexcept final;
+
         void generateSamples(std::uint32_t frames, std::vector<float>& samples) final;
 
     private:
@@ -50,6 +52,15 @@ namespace ouzel::audio
     {
     }
 
+    std::uint64_t SilenceStream::getRemainingFrames() const noexcept
+    {
+        const auto length = static_cast<const SilenceData&>(data).getLength();
+        if (length > 0.0F)
+            return static_cast<std::uint32_t>(length * static_cast<float>(data.getSampleRate())) - position;
+        else
+            return Stream::getRemainingFrames();
+    }
+
     void SilenceStream::generateSamples(std::uint32_t frames, std::vector<float>& samples)
     {
         auto& silenceData = static_cast<SilenceData&>(data);
@@ -80,7 +91,7 @@ namespace ouzel::audio
 
             if ((frameCount - position) == 0)
             {
-                playing = false; // TODO: fire event
+                playing = false; // reported by the mixer
                 reset();
             }
         }
@@ -34,10 +34,15 @@ namespace ouzel::audio
         auto getSourceId() const noexcept { return sourceId; }
         auto getFormat() const noexcept { return format; }
 
+        // voices of sounds with higher priority are virtualized last
+        auto getPriority() const noexcept { return priority; }
+        void setPriority(std::int32_t newPriority) noexcept { priority = newPriority; }
+
     protected:
         Audio& audio;
         std::size_t sourceId = 0;
         Format format;
+        std::int32_t priority = 0;
     };
 }
 
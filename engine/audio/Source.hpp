@@ -15,7 +15,11 @@ namespace ouzel::audio
 
         virtual void play() {}
         virtual void stop(bool shouldReset) { (void)shouldReset; }
-        virtual void getSamples(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate, std::vector<float>& samples) = 0;
+
+        // called on the mixer thread, writes frames planar frames and returns how many of them were generated
+        // before the source ended (the rest are silent), a source that ended starts over on the next call
+        virtual std::uint32_t getSamples(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate,
+                                         std::vector<float>& samples) = 0;
 
         auto& getEffects() const noexcept { return effects; }
 
@@ -0,0 +1,65 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "Streamer.hpp"
+
+namespace ouzel::audio
+{
+    Streamer::Streamer():
+        thread(&Streamer::streamerMain, this)
+    {
+    }
+
+    Streamer::~Streamer()
+    {
+        std::unique_lock lock(mutex);
+        running = false;
+        lock.unlock();
+        condition.notify_all();
+
+        if (thread.isJoinable()) thread.join();
+    }
+
+    void Streamer::addSource(Source& source)
+    {
+        std::unique_lock lock(mutex);
+        sources.push_back(&source);
+        lock.unlock();
+        condition.notify_all();
+    }
+
+    void Streamer::removeSource(Source& source)
+    {
+        std::lock_guard lock(mutex);
+
+        const auto i = std::find(sources.begin(), sources.end(), &source);
+        if (i != sources.end()) sources.erase(i);
+    }
+
+    void Streamer::streamerMain()
+    {
+        thread::setCurrentThreadName("Streamer");
+
+        std::unique_lock lock(mutex);
+
+        while (running)
+        {
+            bool filled = false;
+            for (Source* source : sources)
+                filled = source->fill() || filled;
+
+            // keep filling until every source is full, then poll in case a wake up was missed
+            if (filled)
+            {
+                // let sources be added and removed between the passes
+                lock.unlock();
+                std::this_thread::yield();
+                lock.lock();
+            }
+            else
+                condition.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+}
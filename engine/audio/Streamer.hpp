@@ -0,0 +1,53 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_STREAMER_HPP
+#define OUZEL_AUDIO_STREAMER_HPP
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include "../thread/Thread.hpp"
+
+namespace ouzel::audio
+{
+    // reads and decodes streamed sounds ahead of the mixer on an I/O thread
+    class Streamer final
+    {
+    public:
+        class Source
+        {
+        public:
+            virtual ~Source() = default;
+
+            // called on the I/O thread, returns false if there was nothing to do
+            virtual bool fill() = 0;
+        };
+
+        Streamer();
+        ~Streamer();
+
+        Streamer(const Streamer&) = delete;
+        Streamer& operator=(const Streamer&) = delete;
+
+        Streamer(Streamer&&) = delete;
+        Streamer& operator=(Streamer&&) = delete;
+
+        // waits for the source to finish filling if it is being filled
+        void addSource(Source& source);
+        void removeSource(Source& source);
+
+        // does not lock, so it can be called from the mixer thread
+        void wake() noexcept { condition.notify_one(); }
+
+    private:
+        void streamerMain();
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::vector<Source*> sources;
+        bool running = true;
+        thread::Thread thread;
+    };
+}
+
+#endif // OUZEL_AUDIO_STREAMER_HPP
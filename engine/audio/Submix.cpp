@@ -19,7 +19,7 @@ namespace ouzel::audio
     {
         if (output) output->removeInput(this);
         output = newOutput;
-        output->addInput(this);
+        if (output) output->addInput(this);
 
         audio.addCommand(std::make_unique<mixer::SetBusOutputCommand>(busId, output ? output->getBusId() : 0));
     }
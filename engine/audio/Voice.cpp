@@ -1,41 +1,170 @@
 // Copyright 2015-2020 Elviss Strazdins. All rights reserved.
 
+#include <algorithm>
+#include <stdexcept>
 #include "Voice.hpp"
 #include "Audio.hpp"
 #include "AudioDevice.hpp"
+#include "Containers.hpp"
 #include "Effects.hpp"
 #include "Oscillator.hpp"
 #include "SilenceSound.hpp"
 #include "Sound.hpp"
 #include "Source.hpp"
 #include "WavePlayer.hpp"
+#include "mixer/Data.hpp"
+#include "mixer/Stream.hpp"
 #include "../core/Engine.hpp"
 
 namespace ouzel::audio
 {
-    class VoiceSource: public mixer::Source
+    namespace
     {
-    public:
-        void play() override
+        class CueData;
+
+        // renders the source tree of a cue, the tree is only touched by the mixer thread after the stream is created
+        class CueStream final: public mixer::Stream
         {
-            if (source)
-                source->play();
-        }
+        public:
+            CueStream(CueData& cueData, std::unique_ptr<Source> initRoot, std::uint32_t maxFrames);
+
+            void reset() final
+            {
+                root->stop(true);
+            }
+
+            void seek(std::uint64_t frame) final
+            {
+                reset();
+
+                while (frame > 0)
+                {
+                    const auto frames = static_cast<std::uint32_t>(std::min<std::uint64_t>(frame, maxFrames));
+                    skip(frames);
+                    frame -= frames;
+                }
+            }
+
+            void skip(std::uint32_t frames) final
+            {
+                // containers can only advance by rendering
+                generateSamples(frames, scratch);
+            }
+
+            void generateSamples(std::uint32_t frames, std::vector<float>& samples) final
+            {
+                if (root->getSamples(frames, data.getChannels(), data.getSampleRate(), samples) < frames)
+                    playing = false; // reported by the mixer
+            }
+
+        private:
+            std::unique_ptr<Source> root;
+            std::uint32_t maxFrames;
+            std::vector<float> scratch;
+        };
 
-        void stop(bool shouldReset) override
+        class CueData final: public mixer::Data
         {
-            if (source)
-                source->stop(shouldReset);
+        public:
+            CueData(std::uint32_t initChannels, std::uint32_t initSampleRate,
+                    std::unique_ptr<Source> initRoot, std::uint32_t initMaxFrames):
+                Data(initChannels, initSampleRate),
+                root(std::move(initRoot)),
+                maxFrames(initMaxFrames)
+            {
+            }
+
+            // the source tree has state, so every cue voice has data of its own with a single stream
+            std::unique_ptr<mixer::Stream> createStream() final
+            {
+                if (!root)
+                    throw std::runtime_error("Cue stream already created");
+
+                return std::make_unique<CueStream>(*this, std::move(root), maxFrames);
+            }
+
+        private:
+            std::unique_ptr<Source> root;
+            std::uint32_t maxFrames;
+        };
+
+        CueStream::CueStream(CueData& cueData, std::unique_ptr<Source> initRoot, std::uint32_t initMaxFrames):
+            Stream(cueData),
+            root(std::move(initRoot)),
+            maxFrames(initMaxFrames)
+        {
+            scratch.reserve(maxFrames * cueData.getChannels());
         }
 
-        void getSamples(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate, std::vector<float>& samples) override
+        // the streams of the leaves are created first, so that the containers know the channel count of the cue
+        void createStreams(Audio& audio, const SourceDefinition& sourceDefinition,
+                           std::vector<std::unique_ptr<Sound>>& sounds,
+                           std::vector<std::unique_ptr<mixer::Stream>>& streams)
         {
-            if (source)
-                source->getSamples(frames, channels, sampleRate, samples);
+            switch (sourceDefinition.type)
+            {
+                case SourceDefinition::Type::empty:
+                    break;
+                case SourceDefinition::Type::parallel:
+                case SourceDefinition::Type::random:
+                case SourceDefinition::Type::sequence:
+                    for (const auto& childDefinition : sourceDefinition.sourceDefinitions)
+                        createStreams(audio, childDefinition, sounds, streams);
+                    break;
+                case SourceDefinition::Type::oscillator:
+                    sounds.push_back(std::make_unique<Oscillator>(audio,
+                                                                  sourceDefinition.frequency,
+                                                                  sourceDefinition.oscillatorType,
+                                                                  sourceDefinition.amplitude,
+                                                                  sourceDefinition.length));
+                    streams.push_back(audio.createStream(sounds.back()->getSourceId()));
+                    break;
+                case SourceDefinition::Type::silence:
+                    sounds.push_back(std::make_unique<SilenceSound>(audio, sourceDefinition.length));
+                    streams.push_back(audio.createStream(sounds.back()->getSourceId()));
+                    break;
+                case SourceDefinition::Type::wavePlayer:
+                    if (!sourceDefinition.sound)
+                        throw std::runtime_error("Wave player without a sound");
+                    streams.push_back(audio.createStream(sourceDefinition.sound->getSourceId()));
+                    break;
+            }
         }
 
-        std::unique_ptr<audio::Source> source;
-    };
+        std::unique_ptr<Source> createSource(const SourceDefinition& sourceDefinition,
+                                             std::vector<std::unique_ptr<mixer::Stream>>::iterator& stream,
+                                             std::uint32_t maxFrames, std::uint32_t maxChannels)
+        {
+            std::vector<std::unique_ptr<Source>> children;
+            if (sourceDefinition.type == SourceDefinition::Type::parallel ||
+                sourceDefinition.type == SourceDefinition::Type::random ||
+                sourceDefinition.type == SourceDefinition::Type::sequence)
+                for (const auto& childDefinition : sourceDefinition.sourceDefinitions)
+                    children.push_back(createSource(childDefinition, stream, maxFrames, maxChannels));
+
+            switch (sourceDefinition.type)
+            {
+                case SourceDefinition::Type::parallel:
+                    return std::make_unique<Parallel>(std::move(children), maxFrames, maxChannels);
+                case SourceDefinition::Type::random:
+                {
+                    std::vector<float> weights;
+                    for (const auto& childDefinition : sourceDefinition.sourceDefinitions)
+                        weights.push_back(childDefinition.weight);
+
+                    return std::make_unique<Random>(std::move(children), std::move(weights), maxFrames, maxChannels);
+                }
+                case SourceDefinition::Type::oscillator:
+                case SourceDefinition::Type::silence:
+                case SourceDefinition::Type::wavePlayer:
+                    return std::make_unique<WavePlayer>(std::move(*stream++), maxFrames, maxChannels);
+                case SourceDefinition::Type::empty:
+                case SourceDefinition::Type::sequence:
+                default:
+                    return std::make_unique<Sequence>(std::move(children), maxFrames, maxChannels);
+            }
+        }
+    }
 
     Voice::Voice(Audio& initAudio):
         Node(initAudio),
@@ -49,45 +178,18 @@ namespace ouzel::audio
     {
         const auto& sourceDefinition = cue.getSourceDefinition();
 
-        switch (sourceDefinition.type)
-        {
-            case SourceDefinition::Type::empty:
-            {
-                break;
-            }
-            case SourceDefinition::Type::parallel:
-            {
-                break;
-            }
-            case SourceDefinition::Type::random:
-            {
-                break;
-            }
-            case SourceDefinition::Type::sequence:
-            {
-                break;
-            }
-            case SourceDefinition::Type::oscillator:
-            {
-                std::unique_ptr<Oscillator> oscillator = std::make_unique<Oscillator>(initAudio,
-                                                                                      sourceDefinition.frequency,
-                                                                                      sourceDefinition.oscillatorType,
-                                                                                      sourceDefinition.amplitude,
-                                                                                      sourceDefinition.length);
-                break;
-            }
-            case SourceDefinition::Type::silence:
-            {
-                std::unique_ptr<SilenceSound> silence = std::make_unique<SilenceSound>(initAudio,
-                                                                                       sourceDefinition.length);
-                break;
-            }
-            case SourceDefinition::Type::wavePlayer:
-            {
-                std::unique_ptr<WavePlayer> silence = std::make_unique<WavePlayer>(sourceDefinition.sound);
-                break;
-            }
-        }
+        // the decoders of the leaves are primed here, so the first block of the cue does not wait for them
+        std::vector<std::unique_ptr<mixer::Stream>> streams;
+        createStreams(audio, sourceDefinition, cueSounds, streams);
+
+        std::uint32_t channels = 1;
+        for (const auto& stream : streams)
+            channels = std::max(channels, stream->getData().getChannels());
+
+        const auto device = audio.getDevice();
+        const auto maxFrames = device->getBufferSize();
+        auto stream = streams.begin();
+        auto root = createSource(sourceDefinition, stream, maxFrames, channels);
 
         std::vector<std::unique_ptr<Effect>> effects;
 
@@ -96,11 +198,19 @@ namespace ouzel::audio
             switch (effectDefinition.type)
             {
                 case EffectDefinition::Type::delay:
-                    effects.push_back(std::make_unique<Delay>(initAudio, effectDefinition.delay));
+                {
+                    auto delayEffect = std::make_unique<Delay>(initAudio, effectDefinition.delay);
+                    delayEffect->setDelayRandom(effectDefinition.delayRandom);
+                    effects.push_back(std::move(delayEffect));
                     break;
+                }
                 case EffectDefinition::Type::gain:
-                    effects.push_back(std::make_unique<Gain>(initAudio, effectDefinition.gain));
+                {
+                    auto gainEffect = std::make_unique<Gain>(initAudio, effectDefinition.gain);
+                    gainEffect->setGainRandom(effectDefinition.gainRandom);
+                    effects.push_back(std::move(gainEffect));
                     break;
+                }
                 case EffectDefinition::Type::pitchScale:
                     effects.push_back(std::make_unique<PitchScale>(initAudio, effectDefinition.scale));
                     break;
@@ -111,37 +221,76 @@ namespace ouzel::audio
                     effects.push_back(std::make_unique<Reverb>(initAudio, effectDefinition.delay, effectDefinition.decay));
                     break;
                 case EffectDefinition::Type::lowPass:
-                    effects.push_back(std::make_unique<LowPass>(initAudio));
+                    if (effectDefinition.cutoff > 0.0F)
+                        effects.push_back(std::make_unique<LowPass>(initAudio, effectDefinition.cutoff, effectDefinition.q));
+                    else
+                        effects.push_back(std::make_unique<LowPass>(initAudio));
                     break;
                 case EffectDefinition::Type::highPass:
-                    effects.push_back(std::make_unique<HighPass>(initAudio));
+                    if (effectDefinition.cutoff > 0.0F)
+                        effects.push_back(std::make_unique<HighPass>(initAudio, effectDefinition.cutoff, effectDefinition.q));
+                    else
+                        effects.push_back(std::make_unique<HighPass>(initAudio));
                     break;
             }
         }
 
-        std::unique_ptr<mixer::Source> source = std::make_unique<VoiceSource>();
-
-        audio.addCommand(std::make_unique<mixer::InitObjectCommand>(audio.getMixer().getObjectId(),
-                                                                    std::move(source)));
+        cueDataId = audio.initData(std::make_unique<CueData>(channels, device->getSampleRate(),
+                                                             std::move(root), maxFrames));
+        streamId = audio.initStream(cueDataId);
+        audio.voices[streamId] = this;
     }
 
     Voice::Voice(Audio& initAudio, const Sound* initSound):
         Node(initAudio),
         audio(initAudio),
-        streamId(audio.initStream(initSound->getSourceId()))
+        streamId(audio.initStream(initSound->getSourceId())),
+        sound(initSound),
+        priority(initSound->getPriority())
     {
-        sound = initSound;
+        audio.voices[streamId] = this;
     }
 
     Voice::~Voice()
     {
         if (streamId)
+        {
+            audio.voices.erase(streamId);
             audio.deleteObject(streamId);
+        }
+
+        // the sounds of the cue are deleted after the stream that plays them
+        if (cueDataId)
+            audio.deleteObject(cueDataId);
+    }
+
+    void Voice::setPosition(const Vector3F& newPosition)
+    {
+        position = newPosition;
+
+        if (streamId)
+            audio.addCommand(std::make_unique<mixer::SetStreamPositionCommand>(streamId, position, velocity));
+    }
+
+    void Voice::setVelocity(const Vector3F& newVelocity)
+    {
+        velocity = newVelocity;
+
+        if (streamId)
+            audio.addCommand(std::make_unique<mixer::SetStreamPositionCommand>(streamId, position, velocity));
+    }
+
+    void Voice::setGain(float newGain)
+    {
+        gain = newGain;
+
+        if (streamId)
+            audio.addCommand(std::make_unique<mixer::SetStreamGainCommand>(streamId, gain));
     }
 
     void Voice::play()
     {
-        audio.addCommand(std::make_unique<mixer::PlayStreamCommand>(streamId));
+        audio.addCommand(std::make_unique<mixer::PlayStreamCommand>(streamId, ++playCount));
 
         playing = true;
 
@@ -171,6 +320,11 @@ namespace ouzel::audio
         // TODO: send StopCommand
     }
 
+    void Voice::seek(std::uint64_t frame)
+    {
+        audio.addCommand(std::make_unique<mixer::SeekStreamCommand>(streamId, frame));
+    }
+
     // executed on audio thread
     /*void Voice::onReset()
     {
@@ -178,18 +332,20 @@ namespace ouzel::audio
         event->type = Event::Type::soundReset;
         event->voice = this;
         engine->getEventDispatcher().postEvent(std::move(event));
-    }
+    }*/
 
-    // executed on audio thread
-    void Voice::onStop()
+    void Voice::onStop(std::size_t playId)
     {
+        // the voice was paused, stopped or played again after the stream had reached its end
+        if (!playing || playId != playCount) return;
+
         playing = false;
 
         auto event = std::make_unique<SoundEvent>();
         event->type = Event::Type::soundFinish;
         event->voice = this;
         engine->getEventDispatcher().postEvent(std::move(event));
-    }*/
+    }
 
     void Voice::setOutput(Mix* newOutput)
     {
@@ -4,6 +4,7 @@
 #define OUZEL_AUDIO_VOICE_HPP
 
 #include <memory>
+#include <vector>
 #include "Cue.hpp"
 #include "Node.hpp"
 #include "../math/Vector.hpp"
@@ -16,6 +17,7 @@ namespace ouzel::audio
 
     class Voice final: public Node
     {
+        friend Audio;
         friend Mix;
     public:
         explicit Voice(Audio& initAudio);
@@ -39,29 +41,53 @@ namespace ouzel::audio
         }
 
         auto& getSound() const noexcept { return sound; }
+        auto getStreamId() const noexcept { return streamId; }
 
+        // relative to the panner of the output mix
         auto& getPosition() const noexcept { return position; }
-        void setPosition(const Vector3F& newPosition) { position = newPosition; }
+        void setPosition(const Vector3F& newPosition);
 
         auto& getVelocity() const noexcept { return velocity; }
-        void setVelocity(const Vector3F& newVelocity) { velocity = newVelocity; }
+        void setVelocity(const Vector3F& newVelocity);
+
+        auto getGain() const noexcept { return gain; }
+        void setGain(float newGain);
+
+        // initialized from the priority of the sound
+        auto getPriority() const noexcept { return priority; }
+        void setPriority(std::int32_t newPriority) noexcept { priority = newPriority; }
+
+        // virtual voices keep their play position but are not mixed
+        auto isVirtual() const noexcept { return virtualized; }
 
         void play();
         void pause();
         void stop();
 
+        // moves the play position to the given frame of the sound
+        void seek(std::uint64_t frame);
+
         auto isPlaying() const noexcept { return playing; }
 
         void setOutput(Mix* newOutput);
 
     private:
+        // the stream reached its end after the play call with the given id
+        void onStop(std::size_t playId);
+
         Audio& audio;
-        std::size_t streamId;
+        std::size_t streamId = 0;
+        std::size_t cueDataId = 0;
+        std::vector<std::unique_ptr<Sound>> cueSounds;
 
         const Sound* sound = nullptr;
         Vector3F position;
         Vector3F velocity;
+        float gain = 1.0F;
+        std::int32_t priority = 0;
+        std::size_t playCount = 0;
         bool playing = false;
+        bool virtualized = false;
 
         Mix* output = nullptr;
     };
@@ -1,9 +1,14 @@
 // Copyright 2015-2020 Elviss Strazdins. All rights reserved.
 
+#include <array>
+#include <atomic>
+#include <cstdio>
 #include <stdexcept>
 #include "VorbisClip.hpp"
 #include "Audio.hpp"
+#include "Streamer.hpp"
 #include "mixer/Data.hpp"
+#include "mixer/RingBuffer.hpp"
 #include "mixer/Stream.hpp"
 #include "../utils/Utils.hpp"
 
@@ -43,6 +48,26 @@
 
 namespace ouzel::audio
 {
+    namespace
+    {
+        constexpr std::uint32_t maxChannels = 6;
+
+        // Vorbis orders the channels of 5.1 as L, C, R, SL, SR, LFE
+        std::array<float*, maxChannels> getChannelPointers(std::uint32_t channels, float* samples, std::size_t stride)
+        {
+            constexpr std::uint32_t surroundOrder[maxChannels] = {0, 2, 1, 4, 5, 3};
+
+            if (channels != 1 && channels != 2 && channels != 4 && channels != 6)
+                throw std::runtime_error("Unsupported channel count");
+
+            std::array<float*, maxChannels> result{};
+            for (std::uint32_t channel = 0; channel < channels; ++channel)
+                result[channel] = samples + (channels == 6 ? surroundOrder[channel] : channel) * stride;
+
+            return result;
+        }
+    }
+
     class VorbisData;
 
     class VorbisStream final: public mixer::Stream
@@ -59,12 +84,26 @@ namespace ouzel::audio
         void reset() final
         {
             stb_vorbis_seek_start(vorbisStream);
+            position = 0;
+            skipped = false;
+        }
+
+        void seek(std::uint64_t frame) final
+        {
+            stb_vorbis_seek(vorbisStream, static_cast<unsigned int>(frame));
+            position = frame;
+            skipped = false;
         }
 
+        void skip(std::uint32_t frames) final;
+        std::uint64_t getRemainingFrames() const noexcept final;
+
         void generateSamples(std::uint32_t frames, std::vector<float>& samples) final;
 
     private:
         stb_vorbis* vorbisStream = nullptr;
+        std::uint64_t position = 0;
+        bool skipped = false; // the decoder is moved only once the stream is audible again
     };
 
     class VorbisData final: public mixer::Data
@@ -84,11 +123,13 @@ namespace ouzel::audio
 
             channels = static_cast<std::uint32_t>(info.channels);
             sampleRate = info.sample_rate;
+            frames = stb_vorbis_stream_length_in_samples(vorbisStream);
 
             stb_vorbis_close(vorbisStream);
         }
 
         auto& getData() const noexcept { return data; }
+        auto getFrames() const noexcept { return frames; }
 
         std::unique_ptr<mixer::Stream> createStream() final
         {
@@ -97,6 +138,7 @@ namespace ouzel::audio
 
     private:
         std::vector<std::byte> data;
+        std::uint32_t frames = 0;
     };
 
     VorbisStream::VorbisStream(VorbisData& vorbisData):
@@ -107,8 +149,30 @@ namespace ouzel::audio
                                               nullptr, nullptr);
     }
 
+    void VorbisStream::skip(std::uint32_t frames)
+    {
+        position += frames;
+
+        if (position >= static_cast<VorbisData&>(data).getFrames())
+        {
+            playing = false; // reported by the mixer
+            reset();
+        }
+        else
+            skipped = true;
+    }
+
+    std::uint64_t VorbisStream::getRemainingFrames() const noexcept
+    {
+        const std::uint64_t frames = static_cast<const VorbisData&>(data).getFrames();
+        return (position < frames) ? frames - position : 0;
+    }
+
     void VorbisStream::generateSamples(std::uint32_t frames, std::vector<float>& samples)
     {
+        if (skipped)
+            seek(position);
+
         std::uint32_t neededSize = frames * data.getChannels();
         samples.resize(neededSize);
 
@@ -119,44 +183,18 @@ namespace ouzel::audio
             if (vorbisStream->eof)
                 reset();
 
-            std::vector<float*> channelData(data.getChannels());
-
-            switch (data.getChannels())
-            {
-                case 1:
-                    channelData[0] = &samples[0];
-                    break;
-                case 2:
-                    channelData[0] = &samples[0 * frames];
-                    channelData[1] = &samples[1 * frames];
-                    break;
-                case 4:
-                    channelData[0] = &samples[0 * frames];
-                    channelData[1] = &samples[1 * frames];
-                    channelData[2] = &samples[2 * frames];
-                    channelData[3] = &samples[3 * frames];
-                    break;
-                case 6:
-                    channelData[0] = &samples[0 * frames];
-                    channelData[1] = &samples[2 * frames];
-                    channelData[2] = &samples[1 * frames];
-                    channelData[3] = &samples[4 * frames];
-                    channelData[4] = &samples[5 * frames];
-                    channelData[5] = &samples[3 * frames];
-                    break;
-                default:
-                    throw std::runtime_error("Unsupported channel count");
-            }
+            auto channelData = getChannelPointers(data.getChannels(), samples.data(), frames);
 
             resultFrames = stb_vorbis_get_samples_float(vorbisStream,
                                                         static_cast<int>(data.getChannels()),
                                                         channelData.data(),
                                                         static_cast<int>(frames));
+            position += static_cast<std::uint64_t>(resultFrames);
         }
 
         if (vorbisStream->eof)
         {
-            playing = false; // TODO: fire event
+            playing = false; // reported by the mixer
             reset();
         }
 
@@ -171,4 +209,219 @@ namespace ouzel::audio
               Sound::Format::vorbis)
     {
     }
+
+    namespace
+    {
+        // decode at most this many frames at a time on the streamer thread
+        constexpr std::uint32_t chunkFrames = 4096;
+
+        stb_vorbis* openVorbisFile(const storage::FileRange& fileRange)
+        {
+#if defined(_WIN32)
+            std::FILE* file = _wfopen(fileRange.path.getNative().c_str(), L"rb");
+#else
+            std::FILE* file = std::fopen(fileRange.path.getNative().c_str(), "rb");
+#endif
+            if (!file)
+                throw std::runtime_error("Failed to open file " + std::string(fileRange.path));
+
+            if (std::fseek(file, static_cast<long>(fileRange.offset), SEEK_SET) != 0)
+            {
+                std::fclose(file);
+                throw std::runtime_error("Failed to seek file " + std::string(fileRange.path));
+            }
+
+            // the file is closed together with the decoder, also if opening fails
+            stb_vorbis* vorbisStream = stb_vorbis_open_file_section(file, 1, nullptr, nullptr,
+                                                                    static_cast<unsigned int>(fileRange.size));
+            if (!vorbisStream)
+                throw std::runtime_error("Failed to load Vorbis stream");
+
+            return vorbisStream;
+        }
+    }
+
+    class StreamingVorbisStream final: public mixer::Stream, public Streamer::Source
+    {
+    public:
+        explicit StreamingVorbisStream(StreamingVorbisData& vorbisData);
+        ~StreamingVorbisStream() override;
+
+        void reset() final
+        {
+            seek(0);
+        }
+
+        // executed on the mixer thread, the streamer thread moves the decoder and drops the buffered frames
+        void seek(std::uint64_t frame) final
+        {
+            position = frame;
+            skipped = false;
+            seekFrame.store(frame, std::memory_order_relaxed);
+            seekRequest.fetch_add(1, std::memory_order_release);
+            streamer.wake();
+        }
+
+        void skip(std::uint32_t frames) final;
+        std::uint64_t getRemainingFrames() const noexcept final;
+
+        void generateSamples(std::uint32_t frames, std::vector<float>& samples) final;
+
+        bool fill() final;
+
+    private:
+        Streamer& streamer;
+        stb_vorbis* vorbisStream = nullptr;
+        mixer::RingBuffer buffer;
+        std::vector<float> decodeBuffer;
+        std::uint64_t position = 0; // accessed only on the mixer thread
+        bool skipped = false;
+
+        std::atomic<std::uint64_t> seekFrame{0};
+        std::atomic<std::uint32_t> seekRequest{0};
+        std::atomic<std::uint32_t> seekCompleted{0};
+        std::atomic<bool> endOfStream{false};
+    };
+
+    class StreamingVorbisData final: public mixer::Data
+    {
+    public:
+        StreamingVorbisData(Streamer& initStreamer, const storage::FileRange& initFileRange, float readAhead):
+            streamer(initStreamer),
+            fileRange(initFileRange)
+        {
+            stb_vorbis* vorbisStream = openVorbisFile(fileRange);
+            stb_vorbis_info info = stb_vorbis_get_info(vorbisStream);
+            frames = stb_vorbis_stream_length_in_samples(vorbisStream);
+            stb_vorbis_close(vorbisStream);
+
+            channels = static_cast<std::uint32_t>(info.channels);
+            sampleRate = info.sample_rate;
+
+            if (channels > maxChannels)
+                throw std::runtime_error("Unsupported channel count");
+
+            bufferFrames = std::max(chunkFrames * 2, static_cast<std::uint32_t>(readAhead * static_cast<float>(sampleRate)));
+        }
+
+        auto& getStreamer() const noexcept { return streamer; }
+        auto& getFileRange() const noexcept { return fileRange; }
+        auto getBufferFrames() const noexcept { return bufferFrames; }
+        auto getFrames() const noexcept { return frames; }
+
+        std::unique_ptr<mixer::Stream> createStream() final
+        {
+            return std::make_unique<StreamingVorbisStream>(*this);
+        }
+
+    private:
+        Streamer& streamer;
+        storage::FileRange fileRange;
+        std::uint32_t bufferFrames = 0;
+        std::uint32_t frames = 0;
+    };
+
+    StreamingVorbisStream::StreamingVorbisStream(StreamingVorbisData& vorbisData):
+        Stream(vorbisData),
+        streamer(vorbisData.getStreamer()),
+        vorbisStream(openVorbisFile(vorbisData.getFileRange())),
+        buffer(vorbisData.getBufferFrames(), vorbisData.getChannels()),
+        decodeBuffer(chunkFrames * vorbisData.getChannels())
+    {
+        streamer.addSource(*this);
+    }
+
+    StreamingVorbisStream::~StreamingVorbisStream()
+    {
+        streamer.removeSource(*this);
+        stb_vorbis_close(vorbisStream);
+    }
+
+    void StreamingVorbisStream::skip(std::uint32_t frames)
+    {
+        position += frames;
+
+        if (position >= static_cast<StreamingVorbisData&>(data).getFrames())
+        {
+            playing = false; // reported by the mixer
+            reset();
+        }
+        else
+            skipped = true;
+    }
+
+    std::uint64_t StreamingVorbisStream::getRemainingFrames() const noexcept
+    {
+        const std::uint64_t frames = static_cast<const StreamingVorbisData&>(data).getFrames();
+        return (position < frames) ? frames - position : 0;
+    }
+
+    void StreamingVorbisStream::generateSamples(std::uint32_t frames, std::vector<float>& samples)
+    {
+        if (skipped)
+            seek(position);
+
+        samples.resize(frames * data.getChannels());
+
+        // the frames buffered before a seek must not be played
+        const bool seeking = seekCompleted.load(std::memory_order_acquire) != seekRequest.load(std::memory_order_relaxed);
+        const auto readFrames = seeking ? 0 : static_cast<std::uint32_t>(buffer.read(samples.data(), frames, frames));
+        position += readFrames;
+
+        for (std::uint32_t channel = 0; channel < data.getChannels(); ++channel)
+            std::fill(samples.begin() + channel * frames + readFrames,
+                      samples.begin() + (channel + 1) * frames, 0.0F);
+
+        // a short read without the end of the stream means that the streamer fell behind
+        if (!seeking && readFrames < frames &&
+            endOfStream.load(std::memory_order_acquire) && buffer.getFrames() == 0)
+        {
+            playing = false; // reported by the mixer
+            reset();
+        }
+        else
+            streamer.wake();
+    }
+
+    bool StreamingVorbisStream::fill()
+    {
+        const auto request = seekRequest.load(std::memory_order_acquire);
+
+        if (request != seekCompleted.load(std::memory_order_relaxed))
+        {
+            stb_vorbis_seek(vorbisStream, static_cast<unsigned int>(seekFrame.load(std::memory_order_relaxed)));
+            buffer.clear();
+            endOfStream.store(false, std::memory_order_relaxed);
+            seekCompleted.store(request, std::memory_order_release);
+        }
+
+        if (endOfStream.load(std::memory_order_relaxed))
+            return false;
+
+        const auto frames = static_cast<std::uint32_t>(std::min<std::size_t>(buffer.getFreeFrames(), chunkFrames));
+        if (frames == 0)
+            return false;
+
+        auto channelData = getChannelPointers(data.getChannels(), decodeBuffer.data(), frames);
+
+        const auto decodedFrames = stb_vorbis_get_samples_float(vorbisStream,
+                                                                static_cast<int>(data.getChannels()),
+                                                                channelData.data(),
+                                                                static_cast<int>(frames));
+
+        if (decodedFrames > 0)
+            buffer.write(decodeBuffer.data(), static_cast<std::size_t>(decodedFrames), frames);
+
+        if (decodedFrames < static_cast<int>(frames))
+            endOfStream.store(true, std::memory_order_release);
+
+        return true;
+    }
+
+    StreamingVorbisClip::StreamingVorbisClip(Audio& initAudio, const storage::FileRange& fileRange, float readAhead):
+        Sound(initAudio,
+              initAudio.initData(std::unique_ptr<mixer::Data>(data = new StreamingVorbisData(initAudio.getStreamer(), fileRange, readAhead))),
+              Sound::Format::vorbis)
+    {
+    }
 }
@@ -6,10 +6,12 @@
 #include <cstdint>
 #include <vector>
 #include "Sound.hpp"
+#include "../storage/Archive.hpp"
 
 namespace ouzel::audio
 {
     class VorbisData;
+    class StreamingVorbisData;
 
     class VorbisClip final: public Sound
     {
@@ -19,6 +21,17 @@ namespace ouzel::audio
     private:
         VorbisData* data;
     };
+
+    // decodes the file in chunks on the streamer thread while it plays instead of keeping it in memory
+    class StreamingVorbisClip final: public Sound
+    {
+    public:
+        // readAhead is the decoded duration (in seconds) buffered for each voice
+        StreamingVorbisClip(Audio& initAudio, const storage::FileRange& fileRange, float readAhead = 1.0F);
+
+    private:
+        StreamingVorbisData* data;
+    };
 }
 
 #endif // OUZEL_AUDIO_VORBISCLIP_HPP
@@ -0,0 +1,110 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include "WavePlayer.hpp"
+#include "mixer/Data.hpp"
+#include "mixer/Dsp.hpp"
+
+namespace ouzel::audio
+{
+    WavePlayer::WavePlayer(std::unique_ptr<mixer::Stream> initStream, std::uint32_t maxFrames,
+                           std::uint32_t maxChannels):
+        stream(std::move(initStream))
+    {
+        const auto channels = stream->getData().getChannels();
+
+        // the source buffer holds the resampler input and then the samples converted to the channels of the container
+        sourceBuffer.reserve(std::max(stream->getResampler().getMaxSourceFrames(maxFrames) * channels,
+                                      maxFrames * maxChannels));
+        buffer.reserve(maxFrames * channels);
+    }
+
+    void WavePlayer::play()
+    {
+        stream->play();
+    }
+
+    void WavePlayer::stop(bool shouldReset)
+    {
+        stream->stop(shouldReset);
+        if (shouldReset) ended = false;
+    }
+
+    std::uint32_t WavePlayer::getSamples(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate,
+                                         std::vector<float>& samples)
+    {
+        samples.resize(frames * channels);
+
+        // the stream ended exactly at the end of the previous block
+        if (ended)
+        {
+            ended = false;
+            std::fill(samples.begin(), samples.end(), 0.0F);
+            return 0;
+        }
+
+        const auto& data = stream->getData();
+        const auto sourceSampleRate = data.getSampleRate();
+        const auto sourceChannels = data.getChannels();
+        const auto remaining = stream->getRemainingFrames();
+        auto& resampler = stream->getResampler();
+
+        std::uint32_t generated = frames;
+        std::uint64_t consumed = 0;
+
+        if (sourceSampleRate != sampleRate)
+        {
+            if (!resampler.isPrepared(sourceSampleRate, sampleRate, sourceChannels))
+                resampler.prepare(sourceSampleRate, sampleRate, sourceChannels);
+
+            // only the frames that can be produced from what is left of the stream
+            if (remaining <= resampler.getSourceFrames(frames))
+                generated = std::min(frames, resampler.getFrames(static_cast<std::uint32_t>(remaining)));
+
+            const auto sourceFrames = resampler.getSourceFrames(generated);
+            stream->generateSamples(sourceFrames, sourceBuffer);
+            buffer.resize(generated * sourceChannels);
+            resampler.process(sourceFrames, sourceBuffer.data(), generated, buffer.data());
+            consumed = sourceFrames;
+        }
+        else
+        {
+            generated = static_cast<std::uint32_t>(std::min<std::uint64_t>(frames, remaining));
+            stream->generateSamples(generated, buffer);
+            consumed = generated;
+        }
+
+        const float* source = buffer.data();
+
+        if (sourceChannels != channels)
+        {
+            sourceBuffer.resize(generated * channels);
+
+            if (const auto matrix = mixer::dsp::getConversionMatrix(sourceChannels, channels))
+                mixer::dsp::mix(generated, sourceChannels, buffer.data(), channels, sourceBuffer.data(), matrix);
+            else
+                std::fill(sourceBuffer.begin(), sourceBuffer.end(), 0.0F);
+
+            source = sourceBuffer.data();
+        }
+
+        for (std::uint32_t channel = 0; channel < channels; ++channel)
+        {
+            const auto sourceChannel = source + channel * generated;
+            const auto outputChannel = samples.begin() + channel * frames;
+            std::copy(sourceChannel, sourceChannel + generated, outputChannel);
+            std::fill(outputChannel + generated, outputChannel + frames, 0.0F);
+        }
+
+        if (consumed >= remaining || generated < frames)
+        {
+            // the frames left after the last whole output frame are dropped
+            stream->reset();
+            resampler.reset();
+
+            if (generated == frames) ended = true;
+        }
+
+        return generated;
+    }
+}
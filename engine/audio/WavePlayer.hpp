@@ -3,25 +3,31 @@
 #ifndef OUZEL_AUDIO_WAVEPLAYER_HPP
 #define OUZEL_AUDIO_WAVEPLAYER_HPP
 
+#include <memory>
 #include "Source.hpp"
-#include "Sound.hpp"
+#include "mixer/Stream.hpp"
 
 namespace ouzel::audio
 {
-    class VorbisData;
-
+    // plays a stream of a sound inside a container, converted to the sample rate and the channels of the container,
+    // the stream is created and its resampler prepared on the game thread
     class WavePlayer final: public Source
     {
     public:
-        explicit WavePlayer(const Sound*)
-        {
-        }
+        // the resampler of the stream must be prepared, maxChannels is the channel count of the container
+        WavePlayer(std::unique_ptr<mixer::Stream> initStream, std::uint32_t maxFrames, std::uint32_t maxChannels);
+
+        void play() final;
+        void stop(bool shouldReset) final;
 
-        void getSamples(std::uint32_t, std::uint32_t, std::uint32_t, std::vector<float>&) override
-        {
-        }
+        std::uint32_t getSamples(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate,
+                                 std::vector<float>& samples) final;
 
     private:
+        std::unique_ptr<mixer::Stream> stream;
+        std::vector<float> sourceBuffer;
+        std::vector<float> buffer;
+        bool ended = false;
     };
 }
 
@@ -4,6 +4,8 @@
 
 #if OUZEL_COMPILE_ALSA
 
+#include <algorithm>
+#include <cerrno>
 #include <system_error>
 #include "ALSAAudioDevice.hpp"
 #include "../../core/Engine.hpp"
@@ -11,6 +13,14 @@
 
 namespace ouzel::audio::alsa
 {
+    namespace
+    {
+        constexpr snd_pcm_uframes_t minPeriodSize = 32;
+
+        // the device wakes the thread every period, so the timeout only matters if it stalls
+        constexpr int pollTimeout = 100;
+    }
+
     AudioDevice::AudioDevice(const Settings& settings,
                              const std::function<void(std::uint32_t frames,
                                                       std::uint32_t channels,
@@ -31,7 +41,12 @@ namespace ouzel::audio::alsa
         if (const auto result = snd_pcm_hw_params_any(playbackHandle, hwParams); result < 0)
             throw std::system_error(-result, std::system_category(), "Failed to initialize hardware parameters");
 
-        if (const auto result = snd_pcm_hw_params_set_access(playbackHandle, hwParams, SND_PCM_ACCESS_RW_INTERLEAVED); result < 0)
+        // the mmap access lets the mixer write straight to the ring buffer of the device instead of copying it there
+        mmapAccess = settings.mmapAccess &&
+            snd_pcm_hw_params_test_access(playbackHandle, hwParams, SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0;
+
+        if (const auto result = snd_pcm_hw_params_set_access(playbackHandle, hwParams,
+                                                             mmapAccess ? SND_PCM_ACCESS_MMAP_INTERLEAVED : SND_PCM_ACCESS_RW_INTERLEAVED); result < 0)
             throw std::system_error(-result, std::system_category(), "Failed to set access type");
 
         if (snd_pcm_hw_params_test_format(playbackHandle, hwParams, SND_PCM_FORMAT_FLOAT_LE) == 0)
@@ -57,15 +72,15 @@ namespace ouzel::audio::alsa
         if (const auto result = snd_pcm_hw_params_set_channels(playbackHandle, hwParams, channels); result < 0)
             throw std::system_error(-result, std::system_category(), "Failed to set channel count");
 
-        unsigned int periodLength = periodSize * 1000000 / sampleRate; // period length in microseconds
-        unsigned int bufferLength = periodLength * periods; // buffer length in microseconds
-        int dir;
+        periodSize = std::max(static_cast<snd_pcm_uframes_t>(bufferSize), minPeriodSize);
+        periods = std::max(settings.periods, 2U);
+        int dir = 0;
 
-        if (const auto result = snd_pcm_hw_params_set_buffer_time_near(playbackHandle, hwParams, &bufferLength, &dir); result < 0)
-            throw std::system_error(-result, std::system_category(), "Failed to set buffer time");
+        if (const auto result = snd_pcm_hw_params_set_period_size_near(playbackHandle, hwParams, &periodSize, &dir); result < 0)
+            throw std::system_error(-result, std::system_category(), "Failed to set period size");
 
-        if (const auto result = snd_pcm_hw_params_set_period_time_near(playbackHandle, hwParams, &periodLength, &dir); result < 0)
-            throw std::system_error(-result, std::system_category(), "Failed to set period time");
+        if (const auto result = snd_pcm_hw_params_set_periods_near(playbackHandle, hwParams, &periods, &dir); result < 0)
+            throw std::system_error(-result, std::system_category(), "Failed to set period count");
 
         if (const auto result = snd_pcm_hw_params_get_period_size(hwParams, &periodSize, &dir); result < 0)
             throw std::system_error(-result, std::system_category(), "Failed to get period size");
@@ -79,16 +94,19 @@ namespace ouzel::audio::alsa
         snd_pcm_hw_params_free(hwParams);
         hwParams = nullptr;
 
+        // the mixer renders a period at a time
+        bufferSize = static_cast<std::uint32_t>(periodSize);
+
         if (const auto result = snd_pcm_sw_params_malloc(&swParams); result < 0)
             throw std::system_error(-result, std::system_category(), "Failed to allocate memory for software parameters");
 
         if (const auto result = snd_pcm_sw_params_current(playbackHandle, swParams); result < 0)
             throw std::system_error(-result, std::system_category(), "Failed to initialize software parameters");
 
-        if (const auto result = snd_pcm_sw_params_set_avail_min(playbackHandle, swParams, 4096); result < 0)
+        if (const auto result = snd_pcm_sw_params_set_avail_min(playbackHandle, swParams, periodSize); result < 0)
             throw std::system_error(-result, std::system_category(), "Failed to set minimum available count");
 
-        if (const auto result = snd_pcm_sw_params_set_start_threshold(playbackHandle, swParams, 0); result < 0)
+        if (const auto result = snd_pcm_sw_params_set_start_threshold(playbackHandle, swParams, periodSize); result < 0)
             throw std::system_error(-result, std::system_category(), "Failed to set start threshold");
 
         if (const auto result = snd_pcm_sw_params(playbackHandle, swParams); result < 0)
@@ -99,6 +117,19 @@ namespace ouzel::audio::alsa
 
         snd_pcm_sw_params_free(swParams);
         swParams = nullptr;
+
+        const auto pollDescriptorCount = snd_pcm_poll_descriptors_count(playbackHandle);
+        if (pollDescriptorCount <= 0)
+            throw std::runtime_error("Failed to get poll descriptor count");
+
+        pollDescriptors.resize(static_cast<std::size_t>(pollDescriptorCount));
+
+        if (const auto result = snd_pcm_poll_descriptors(playbackHandle, pollDescriptors.data(), static_cast<unsigned int>(pollDescriptorCount)); result < 0)
+            throw std::system_error(-result, std::system_category(), "Failed to get poll descriptors");
+
+        logger.log(Log::Level::info) << "ALSA " << (mmapAccess ? "mmap" : "read/write") << " access, " <<
+            periods << " periods of " << periodSize << " frames (" <<
+            periods * periodSize * 1000 / sampleRate << " ms buffer)";
     }
 
     AudioDevice::~AudioDevice()
@@ -131,21 +162,32 @@ namespace ouzel::audio::alsa
         {
             try
             {
+                // sleep until the device has room for another period
+                if (poll(pollDescriptors.data(), static_cast<nfds_t>(pollDescriptors.size()), pollTimeout) < 0)
+                {
+                    if (errno == EINTR) continue;
+                    throw std::system_error(errno, std::system_category(), "Failed to poll audio interface");
+                }
+
+                unsigned short events = 0;
+                if (const auto result = snd_pcm_poll_descriptors_revents(playbackHandle, pollDescriptors.data(),
+                                                                         static_cast<unsigned int>(pollDescriptors.size()), &events); result < 0)
+                    throw std::system_error(-result, std::system_category(), "Failed to get poll events");
+
+                if (!(events & (POLLOUT | POLLERR)))
+                    continue;
+
                 snd_pcm_sframes_t frames;
 
                 if ((frames = snd_pcm_avail_update(playbackHandle)) < 0)
                 {
                     if (frames == -EPIPE)
                     {
-                        logger.log(Log::Level::warning) << "Buffer underrun occurred";
-
-                        if (const auto result = snd_pcm_prepare(playbackHandle); result < 0)
-                            throw std::system_error(-result, std::system_category(), "Failed to prepare audio interface");
-
+                        recover();
                         continue;
                     }
                     else
-                        throw std::system_error(frames, std::system_category(), "Failed to get available frames");
+                        throw std::system_error(static_cast<int>(-frames), std::system_category(), "Failed to get available frames");
                 }
 
                 if (static_cast<snd_pcm_uframes_t>(frames) > periods * periodSize)
@@ -158,20 +200,16 @@ namespace ouzel::audio::alsa
                 if (static_cast<snd_pcm_uframes_t>(frames) < periodSize)
                     continue;
 
-                getData(frames, data);
+                // whole periods, so that the mixer always renders the same amount
+                const auto periodFrames = static_cast<snd_pcm_uframes_t>(frames) / periodSize * periodSize;
 
-                if (const auto result = snd_pcm_writei(playbackHandle, data.data(), frames); result < 0)
-                {
-                    if (result == -EPIPE)
-                    {
-                        logger.log(Log::Level::warning) << "Buffer underrun occurred";
+                if (mmapAccess)
+                    writeMmap(periodFrames);
+                else
+                    write(periodFrames);
 
-                        if (const auto prepareResult = snd_pcm_prepare(playbackHandle); prepareResult < 0)
-                            throw std::system_error(-prepareResult, std::system_category(), "Failed to prepare audio interface");
-                    }
-                    else
-                        throw std::system_error(-result, std::system_category(), "Failed to write data");
-                }
+                if (snd_pcm_sframes_t delay; snd_pcm_delay(playbackHandle, &delay) == 0 && delay >= 0)
+                    outputLatency = static_cast<std::uint32_t>(delay);
             }
             catch (const std::exception& e)
             {
@@ -179,5 +217,72 @@ namespace ouzel::audio::alsa
             }
         }
     }
+
+    void AudioDevice::write(snd_pcm_uframes_t frames)
+    {
+        getData(static_cast<std::uint32_t>(frames), data);
+
+        if (const auto result = snd_pcm_writei(playbackHandle, data.data(), frames); result < 0)
+        {
+            if (result == -EPIPE)
+                recover();
+            else
+                throw std::system_error(static_cast<int>(-result), std::system_category(), "Failed to write data");
+        }
+    }
+
+    void AudioDevice::writeMmap(snd_pcm_uframes_t frames)
+    {
+        // the ring buffer can wrap around, so it may take more than one area
+        while (frames > 0)
+        {
+            const snd_pcm_channel_area_t* areas;
+            snd_pcm_uframes_t offset;
+            snd_pcm_uframes_t size = frames;
+
+            if (const auto result = snd_pcm_mmap_begin(playbackHandle, &areas, &offset, &size); result < 0)
+            {
+                if (result == -EPIPE)
+                {
+                    recover();
+                    return;
+                }
+                else
+                    throw std::system_error(-result, std::system_category(), "Failed to map audio buffer");
+            }
+
+            // the channels of an interleaved buffer share the first area
+            auto destination = static_cast<std::uint8_t*>(areas[0].addr) + areas[0].first / 8 + offset * areas[0].step / 8;
+            getData(static_cast<std::uint32_t>(size), destination);
+
+            if (const auto result = snd_pcm_mmap_commit(playbackHandle, offset, size); result < 0)
+            {
+                if (result == -EPIPE)
+                {
+                    recover();
+                    return;
+                }
+                else
+                    throw std::system_error(static_cast<int>(-result), std::system_category(), "Failed to commit audio buffer");
+            }
+            else if (static_cast<snd_pcm_uframes_t>(result) != size)
+                throw std::runtime_error("Failed to commit audio buffer");
+
+            frames -= size;
+        }
+
+        if (snd_pcm_state(playbackHandle) == SND_PCM_STATE_PREPARED)
+            if (const auto result = snd_pcm_start(playbackHandle); result < 0)
+                throw std::system_error(-result, std::system_category(), "Failed to start audio interface");
+    }
+
+    void AudioDevice::recover()
+    {
+        ++xrunCount;
+        logger.log(Log::Level::warning) << "Buffer underrun occurred, output latency " << outputLatency.load() << " frames";
+
+        if (const auto result = snd_pcm_prepare(playbackHandle); result < 0)
+            throw std::system_error(-result, std::system_category(), "Failed to prepare audio interface");
+    }
 }
 #endif
@@ -9,6 +9,8 @@
 
 #include <atomic>
 #include <thread>
+#include <vector>
+#include <poll.h>
 #include <alsa/asoundlib.h>
 
 #include "../AudioDevice.hpp"
@@ -31,6 +33,9 @@ namespace ouzel::audio::alsa
 
     private:
         void run();
+        void write(snd_pcm_uframes_t frames);
+        void writeMmap(snd_pcm_uframes_t frames);
+        void recover();
 
         snd_pcm_t* playbackHandle = nullptr;
         snd_pcm_hw_params_t* hwParams = nullptr;
@@ -38,7 +43,9 @@ namespace ouzel::audio::alsa
 
         unsigned int periods = 4;
         snd_pcm_uframes_t periodSize = 1024;
+        bool mmapAccess = false;
 
+        std::vector<pollfd> pollDescriptors;
         std::vector<std::uint8_t> data;
 
         std::atomic_bool running{false};
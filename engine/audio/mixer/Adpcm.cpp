@@ -0,0 +1,111 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include "Adpcm.hpp"
+
+namespace ouzel::audio::mixer::adpcm
+{
+    namespace
+    {
+        constexpr std::int32_t indexTable[16] = {
+            -1, -1, -1, -1, 2, 4, 6, 8,
+            -1, -1, -1, -1, 2, 4, 6, 8
+        };
+
+        constexpr std::int32_t stepTable[89] = {
+            7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+            19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+            50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+            130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+            337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+            876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+            2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+            5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+            15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+        };
+
+        class State final
+        {
+        public:
+            std::int32_t predictor = 0;
+            std::int32_t index = 0;
+
+            std::int16_t decode(std::uint8_t nibble) noexcept
+            {
+                const auto step = stepTable[index];
+                auto difference = step >> 3;
+                if (nibble & 1) difference += step >> 2;
+                if (nibble & 2) difference += step >> 1;
+                if (nibble & 4) difference += step;
+
+                predictor = std::clamp((nibble & 8) ? predictor - difference : predictor + difference, -32768, 32767);
+                index = std::clamp(index + indexTable[nibble], 0, 88);
+
+                return static_cast<std::int16_t>(predictor);
+            }
+
+            std::uint8_t encode(std::int16_t sample) noexcept
+            {
+                auto difference = sample - predictor;
+                std::uint8_t nibble = 0;
+                if (difference < 0)
+                {
+                    nibble = 8;
+                    difference = -difference;
+                }
+
+                // the quantization matches the reconstruction in decode
+                auto step = stepTable[index];
+                if (difference >= step) { nibble |= 4; difference -= step; }
+                step >>= 1;
+                if (difference >= step) { nibble |= 2; difference -= step; }
+                step >>= 1;
+                if (difference >= step) nibble |= 1;
+
+                decode(nibble);
+                return nibble;
+            }
+        };
+    }
+
+    void encode(const std::int16_t* samples, std::size_t frames,
+                std::uint8_t* destination, std::size_t blockSize, std::size_t stride) noexcept
+    {
+        const auto blockFrames = getBlockFrames(blockSize);
+        State state;
+
+        for (std::size_t first = 0; first < frames; first += blockFrames, destination += stride)
+        {
+            // the step index carries over from the previous block, the predictor restarts from the exact sample
+            state.predictor = samples[first];
+            destination[0] = static_cast<std::uint8_t>(samples[first] & 0xFF);
+            destination[1] = static_cast<std::uint8_t>((samples[first] >> 8) & 0xFF);
+            destination[2] = static_cast<std::uint8_t>(state.index);
+            destination[3] = 0;
+
+            for (std::size_t i = 0; i < blockFrames - 1; ++i)
+            {
+                const auto sample = samples[std::min(first + i + 1, frames - 1)];
+                const auto nibble = state.encode(sample);
+
+                std::uint8_t& byte = destination[headerSize + i / 2];
+                byte = (i % 2) ? static_cast<std::uint8_t>(byte | (nibble << 4)) : nibble;
+            }
+        }
+    }
+
+    void decode(const std::uint8_t* block, std::size_t blockSize, std::int16_t* samples) noexcept
+    {
+        State state;
+        state.predictor = static_cast<std::int16_t>(block[0] | (block[1] << 8));
+        state.index = std::min(static_cast<std::int32_t>(block[2]), 88);
+
+        *samples++ = static_cast<std::int16_t>(state.predictor);
+
+        for (std::size_t i = headerSize; i < blockSize; ++i)
+        {
+            *samples++ = state.decode(block[i] & 0x0F);
+            *samples++ = state.decode(block[i] >> 4);
+        }
+    }
+}
@@ -0,0 +1,30 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_ADPCM_HPP
+#define OUZEL_AUDIO_MIXER_ADPCM_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// IMA ADPCM blocks of a single channel, every block starts with the first sample as a 16-bit predictor,
+// the step index and a reserved byte, followed by two samples per byte with the low nibble first
+namespace ouzel::audio::mixer::adpcm
+{
+    constexpr std::size_t headerSize = 4;
+    constexpr std::size_t defaultBlockSize = 256;
+
+    constexpr std::uint32_t getBlockFrames(std::size_t blockSize) noexcept
+    {
+        return static_cast<std::uint32_t>((blockSize - headerSize) * 2 + 1);
+    }
+
+    // encodes frames samples into blocks of blockSize bytes written stride bytes apart,
+    // the last block is padded with the last sample
+    void encode(const std::int16_t* samples, std::size_t frames,
+                std::uint8_t* destination, std::size_t blockSize, std::size_t stride) noexcept;
+
+    // decodes getBlockFrames(blockSize) samples of a single block
+    void decode(const std::uint8_t* block, std::size_t blockSize, std::int16_t* samples) noexcept;
+}
+
+#endif // OUZEL_AUDIO_MIXER_ADPCM_HPP
@@ -0,0 +1,32 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#include <cstdlib>
+#include <new>
+#include "Realtime.hpp"
+
+// replaces the global allocation functions with ones that count the allocations of the real-time threads,
+// only compiled into the engine when it is built with DEBUG_AUDIO=1 (the rest of the allocation functions
+// forward to these)
+void* operator new(std::size_t size)
+{
+    ouzel::audio::mixer::realtime::countAllocation();
+
+    if (void* result = std::malloc(size ? size : 1))
+        return result;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (pointer)
+    {
+        ouzel::audio::mixer::realtime::countAllocation();
+        std::free(pointer);
+    }
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
@@ -0,0 +1,261 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#if defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#elif defined(__SSE__)
+#  include <xmmintrin.h>
+#endif
+#include <algorithm>
+#include <cmath>
+#include "Biquad.hpp"
+#include "../../core/Engine.hpp"
+#include "../../math/Constants.hpp"
+
+namespace ouzel::audio::mixer
+{
+    namespace
+    {
+        struct Parameters final
+        {
+            float cosW;
+            float alpha;
+        };
+
+        Parameters getParameters(std::uint32_t sampleRate, float frequency, float q) noexcept
+        {
+            const auto nyquist = static_cast<float>(sampleRate) / 2.0F;
+            const auto w = tau<float> * std::clamp(frequency, 1.0F, nyquist * 0.99F) / static_cast<float>(sampleRate);
+            return Parameters{std::cos(w), std::sin(w) / (2.0F * std::max(q, 0.01F))};
+        }
+
+        Biquad::Coefficients normalize(float b0, float b1, float b2, float a0, float a1, float a2) noexcept
+        {
+            return Biquad::Coefficients{b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0};
+        }
+    }
+
+    Biquad::Coefficients Biquad::lowPass(std::uint32_t sampleRate, float frequency, float q) noexcept
+    {
+        const auto [cosW, alpha] = getParameters(sampleRate, frequency, q);
+        return normalize((1.0F - cosW) / 2.0F, 1.0F - cosW, (1.0F - cosW) / 2.0F,
+                         1.0F + alpha, -2.0F * cosW, 1.0F - alpha);
+    }
+
+    Biquad::Coefficients Biquad::highPass(std::uint32_t sampleRate, float frequency, float q) noexcept
+    {
+        const auto [cosW, alpha] = getParameters(sampleRate, frequency, q);
+        return normalize((1.0F + cosW) / 2.0F, -(1.0F + cosW), (1.0F + cosW) / 2.0F,
+                         1.0F + alpha, -2.0F * cosW, 1.0F - alpha);
+    }
+
+    Biquad::Coefficients Biquad::peak(std::uint32_t sampleRate, float frequency, float q, float gain) noexcept
+    {
+        const auto [cosW, alpha] = getParameters(sampleRate, frequency, q);
+        const auto a = std::pow(10.0F, gain / 40.0F);
+        return normalize(1.0F + alpha * a, -2.0F * cosW, 1.0F - alpha * a,
+                         1.0F + alpha / a, -2.0F * cosW, 1.0F - alpha / a);
+    }
+
+    Biquad::Coefficients Biquad::lowShelf(std::uint32_t sampleRate, float frequency, float q, float gain) noexcept
+    {
+        const auto [cosW, alpha] = getParameters(sampleRate, frequency, q);
+        const auto a = std::pow(10.0F, gain / 40.0F);
+        const auto beta = 2.0F * std::sqrt(a) * alpha;
+        return normalize(a * ((a + 1.0F) - (a - 1.0F) * cosW + beta),
+                         2.0F * a * ((a - 1.0F) - (a + 1.0F) * cosW),
+                         a * ((a + 1.0F) - (a - 1.0F) * cosW - beta),
+                         (a + 1.0F) + (a - 1.0F) * cosW + beta,
+                         -2.0F * ((a - 1.0F) + (a + 1.0F) * cosW),
+                         (a + 1.0F) + (a - 1.0F) * cosW - beta);
+    }
+
+    Biquad::Coefficients Biquad::highShelf(std::uint32_t sampleRate, float frequency, float q, float gain) noexcept
+    {
+        const auto [cosW, alpha] = getParameters(sampleRate, frequency, q);
+        const auto a = std::pow(10.0F, gain / 40.0F);
+        const auto beta = 2.0F * std::sqrt(a) * alpha;
+        return normalize(a * ((a + 1.0F) + (a - 1.0F) * cosW + beta),
+                         -2.0F * a * ((a - 1.0F) + (a + 1.0F) * cosW),
+                         a * ((a + 1.0F) + (a - 1.0F) * cosW - beta),
+                         (a + 1.0F) - (a - 1.0F) * cosW + beta,
+                         2.0F * ((a - 1.0F) - (a + 1.0F) * cosW),
+                         (a + 1.0F) - (a - 1.0F) * cosW - beta);
+    }
+
+    void Biquad::setCoefficients(const Coefficients& newCoefficients) noexcept
+    {
+        target = newCoefficients;
+
+        if (initialized)
+            smoothing = true;
+        else
+        {
+            current = newCoefficients;
+            initialized = true;
+        }
+    }
+
+    void Biquad::reset() noexcept
+    {
+        std::fill(std::begin(state1), std::end(state1), 0.0F);
+        std::fill(std::begin(state2), std::end(state2), 0.0F);
+    }
+
+    void Biquad::process(std::uint32_t frames, std::uint32_t channels, float* samples) noexcept
+    {
+        if (frames == 0) return;
+
+        channels = std::min(channels, maxChannels);
+
+        // the coefficients move linearly from current to target during the block
+        Coefficients delta{0.0F, 0.0F, 0.0F, 0.0F, 0.0F};
+        if (smoothing)
+        {
+            const auto step = 1.0F / static_cast<float>(frames);
+            delta.b0 = (target.b0 - current.b0) * step;
+            delta.b1 = (target.b1 - current.b1) * step;
+            delta.b2 = (target.b2 - current.b2) * step;
+            delta.a1 = (target.a1 - current.a1) * step;
+            delta.a2 = (target.a2 - current.a2) * step;
+        }
+
+        std::uint32_t channel = 0;
+
+        // the filter is recursive in time, so four channels are processed at once
+        if (core::isSimdAvailable)
+        {
+#if defined(__ARM_NEON__)
+            alignas(16) float input[4] = {0.0F, 0.0F, 0.0F, 0.0F};
+            alignas(16) float output[4];
+
+            for (; channel < channels; channel += 4)
+            {
+                const auto lanes = std::min(channels - channel, 4U);
+                std::fill(input + lanes, input + 4, 0.0F);
+
+                float32x4_t b0 = vdupq_n_f32(current.b0);
+                float32x4_t b1 = vdupq_n_f32(current.b1);
+                float32x4_t b2 = vdupq_n_f32(current.b2);
+                float32x4_t a1 = vdupq_n_f32(current.a1);
+                float32x4_t a2 = vdupq_n_f32(current.a2);
+                const float32x4_t db0 = vdupq_n_f32(delta.b0);
+                const float32x4_t db1 = vdupq_n_f32(delta.b1);
+                const float32x4_t db2 = vdupq_n_f32(delta.b2);
+                const float32x4_t da1 = vdupq_n_f32(delta.a1);
+                const float32x4_t da2 = vdupq_n_f32(delta.a2);
+                float32x4_t s1 = vld1q_f32(state1 + channel);
+                float32x4_t s2 = vld1q_f32(state2 + channel);
+
+                for (std::uint32_t frame = 0; frame < frames; ++frame)
+                {
+                    for (std::uint32_t lane = 0; lane < lanes; ++lane)
+                        input[lane] = samples[(channel + lane) * frames + frame];
+
+                    const float32x4_t x = vld1q_f32(input);
+                    const float32x4_t y = vmlaq_f32(s1, b0, x);
+                    s1 = vmlsq_f32(vmlaq_f32(s2, b1, x), a1, y);
+                    s2 = vmlsq_f32(vmulq_f32(b2, x), a2, y);
+                    vst1q_f32(output, y);
+
+                    for (std::uint32_t lane = 0; lane < lanes; ++lane)
+                        samples[(channel + lane) * frames + frame] = output[lane];
+
+                    b0 = vaddq_f32(b0, db0);
+                    b1 = vaddq_f32(b1, db1);
+                    b2 = vaddq_f32(b2, db2);
+                    a1 = vaddq_f32(a1, da1);
+                    a2 = vaddq_f32(a2, da2);
+                }
+
+                vst1q_f32(state1 + channel, s1);
+                vst1q_f32(state2 + channel, s2);
+            }
+#elif defined(__SSE__)
+            alignas(16) float input[4] = {0.0F, 0.0F, 0.0F, 0.0F};
+            alignas(16) float output[4];
+
+            for (; channel < channels; channel += 4)
+            {
+                const auto lanes = std::min(channels - channel, 4U);
+                std::fill(input + lanes, input + 4, 0.0F);
+
+                __m128 b0 = _mm_set1_ps(current.b0);
+                __m128 b1 = _mm_set1_ps(current.b1);
+                __m128 b2 = _mm_set1_ps(current.b2);
+                __m128 a1 = _mm_set1_ps(current.a1);
+                __m128 a2 = _mm_set1_ps(current.a2);
+                const __m128 db0 = _mm_set1_ps(delta.b0);
+                const __m128 db1 = _mm_set1_ps(delta.b1);
+                const __m128 db2 = _mm_set1_ps(delta.b2);
+                const __m128 da1 = _mm_set1_ps(delta.a1);
+                const __m128 da2 = _mm_set1_ps(delta.a2);
+                __m128 s1 = _mm_load_ps(state1 + channel);
+                __m128 s2 = _mm_load_ps(state2 + channel);
+
+                for (std::uint32_t frame = 0; frame < frames; ++frame)
+                {
+                    for (std::uint32_t lane = 0; lane < lanes; ++lane)
+                        input[lane] = samples[(channel + lane) * frames + frame];
+
+                    const __m128 x = _mm_load_ps(input);
+                    const __m128 y = _mm_add_ps(_mm_mul_ps(b0, x), s1);
+                    s1 = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(b1, x), s2), _mm_mul_ps(a1, y));
+                    s2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+                    _mm_store_ps(output, y);
+
+                    for (std::uint32_t lane = 0; lane < lanes; ++lane)
+                        samples[(channel + lane) * frames + frame] = output[lane];
+
+                    b0 = _mm_add_ps(b0, db0);
+                    b1 = _mm_add_ps(b1, db1);
+                    b2 = _mm_add_ps(b2, db2);
+                    a1 = _mm_add_ps(a1, da1);
+                    a2 = _mm_add_ps(a2, da2);
+                }
+
+                _mm_store_ps(state1 + channel, s1);
+                _mm_store_ps(state2 + channel, s2);
+            }
+#endif
+        }
+
+        for (; channel < channels; ++channel)
+        {
+            float* channelSamples = samples + channel * frames;
+            Coefficients c = current;
+            float s1 = state1[channel];
+            float s2 = state2[channel];
+
+            for (std::uint32_t frame = 0; frame < frames; ++frame)
+            {
+                const float x = channelSamples[frame];
+                const float y = c.b0 * x + s1;
+                s1 = c.b1 * x - c.a1 * y + s2;
+                s2 = c.b2 * x - c.a2 * y;
+                channelSamples[frame] = y;
+
+                c.b0 += delta.b0;
+                c.b1 += delta.b1;
+                c.b2 += delta.b2;
+                c.a1 += delta.a1;
+                c.a2 += delta.a2;
+            }
+
+            state1[channel] = s1;
+            state2[channel] = s2;
+        }
+
+        // flush the decayed state to avoid denormals
+        for (std::uint32_t i = 0; i < channels; ++i)
+        {
+            if (std::abs(state1[i]) < 1e-20F) state1[i] = 0.0F;
+            if (std::abs(state2[i]) < 1e-20F) state2[i] = 0.0F;
+        }
+
+        if (smoothing)
+        {
+            current = target;
+            smoothing = false;
+        }
+    }
+}
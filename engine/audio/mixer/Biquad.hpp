@@ -0,0 +1,51 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_BIQUAD_HPP
+#define OUZEL_AUDIO_MIXER_BIQUAD_HPP
+
+#include <cstdint>
+
+namespace ouzel::audio::mixer
+{
+    // transposed direct form II biquad filter that keeps a separate state for every channel
+    class Biquad final
+    {
+    public:
+        static constexpr std::uint32_t maxChannels = 8;
+
+        // normalized coefficients, a0 is 1
+        struct Coefficients final
+        {
+            float b0 = 1.0F;
+            float b1 = 0.0F;
+            float b2 = 0.0F;
+            float a1 = 0.0F;
+            float a2 = 0.0F;
+        };
+
+        // Audio EQ Cookbook filters, gain is in dB
+        static Coefficients lowPass(std::uint32_t sampleRate, float frequency, float q) noexcept;
+        static Coefficients highPass(std::uint32_t sampleRate, float frequency, float q) noexcept;
+        static Coefficients peak(std::uint32_t sampleRate, float frequency, float q, float gain) noexcept;
+        static Coefficients lowShelf(std::uint32_t sampleRate, float frequency, float q, float gain) noexcept;
+        static Coefficients highShelf(std::uint32_t sampleRate, float frequency, float q, float gain) noexcept;
+
+        // the coefficients are interpolated over the next processed block to avoid zipper noise
+        void setCoefficients(const Coefficients& newCoefficients) noexcept;
+        void reset() noexcept;
+
+        // filters planar samples in place
+        void process(std::uint32_t frames, std::uint32_t channels, float* samples) noexcept;
+
+    private:
+        Coefficients current;
+        Coefficients target;
+        bool initialized = false;
+        bool smoothing = false;
+
+        alignas(16) float state1[maxChannels]{};
+        alignas(16) float state2[maxChannels]{};
+    };
+}
+
+#endif // OUZEL_AUDIO_MIXER_BIQUAD_HPP
@@ -3,24 +3,44 @@
 #include <algorithm>
 #include "Bus.hpp"
 #include "Data.hpp"
+#include "Dsp.hpp"
 #include "Processor.hpp"
+#include "Spatializer.hpp"
 #include "Stream.hpp"
-#include "../../math/MathUtils.hpp"
 
 namespace ouzel::audio::mixer
 {
+    Bus::Bus(std::size_t maxSamples)
+    {
+        // the buses are generated on the mixer and the worker threads, so the buffers are allocated up front
+        buffer.reserve(maxSamples);
+        outputBuffer.reserve(maxSamples);
+    }
+
     Bus::~Bus()
+    {
+        Bus::detach();
+    }
+
+    void Bus::detach()
     {
         if (output) output->removeInput(this);
+        output = nullptr;
 
         for (Bus* inputBus : inputBuses)
             inputBus->output = nullptr;
+        inputBuses.clear();
 
         for (Stream* stream : inputStreams)
             stream->output = nullptr;
+        inputStreams.clear();
 
         for (Processor* processor : processors)
             processor->bus = nullptr;
+        processors.clear();
+        spatializer = nullptr;
+
+        Object::detach();
     }
 
     void Bus::setOutput(Bus* newOutput)
@@ -30,48 +50,6 @@ namespace ouzel::audio::mixer
         if (output) output->addInput(this);
     }
 
-    static void resample(std::uint32_t channels, std::uint32_t sourceFrames, const std::vector<float>& sourceSamples,
-                         std::uint32_t frames, std::vector<float>& samples)
-    {
-        if (sourceFrames != frames)
-        {
-            auto sourceIncrement = static_cast<float>(sourceFrames - 1) / static_cast<float>(frames - 1);
-            auto sourcePosition = 0.0F;
-
-            samples.resize(frames * channels);
-
-            for (std::uint32_t frame = 0; frame < frames - 1; ++frame)
-            {
-                auto sourceCurrentFrame = static_cast<std::uint32_t>(sourcePosition);
-                auto fraction = sourcePosition - sourceCurrentFrame;
-
-                std::uint32_t sourceNextFrame = sourceCurrentFrame + 1;
-
-                for (std::uint32_t channel = 0; channel < channels; ++channel)
-                {
-                    const auto sourceChannel = &sourceSamples[channel * sourceFrames];
-                    auto outputChannel = &samples[channel * frames];
-
-                    outputChannel[frame] = lerp(sourceChannel[sourceCurrentFrame],
-                                                sourceChannel[sourceNextFrame],
-                                                fraction);
-                }
-
-                sourcePosition += sourceIncrement;
-            }
-
-            // fill the last frame of the destination with the last frame of the source
-            for (std::uint32_t channel = 0; channel < channels; ++channel)
-            {
-                const auto sourceChannel = &sourceSamples[channel * sourceFrames];
-                auto outputChannel = &samples[channel * frames];
-                outputChannel[frames - 1] = sourceChannel[sourceFrames - 1];
-            }
-        }
-        else
-            samples = sourceSamples;
-    }
-
     static void convert(std::uint32_t frames, std::uint32_t sourceChannels, const std::vector<float>& sourceSamples,
                         std::uint32_t channels, std::vector<float>& samples)
     {
@@ -79,196 +57,103 @@ namespace ouzel::audio::mixer
 
         if (sourceChannels != channels)
         {
-            switch (sourceChannels)
-            {
-                case 1:
-                {
-                    switch (channels)
-                    {
-                        case 2: // upmix 1 to 2
-                            for (std::uint32_t frame = 0; frame < frames; ++frame)
-                            {
-                                samples[0 * frames + frame] = sourceSamples[frame]; // L = M
-                                samples[1 * frames + frame] = sourceSamples[frame]; // R = M
-                            }
-                            break;
-                        case 4: // upmix 1 to 4
-                            for (std::uint32_t frame = 0; frame < frames; ++frame)
-                            {
-                                samples[0 * frames + frame] = sourceSamples[frame]; // L = M
-                                samples[1 * frames + frame] = sourceSamples[frame]; // R = M
-                                samples[2 * frames + frame] = 0.0F; // SL = 0
-                                samples[3 * frames + frame] = 0.0F; // SR = 0
-                            }
-                            break;
-                        case 6: // upmix 1 to 6
-                            for (std::uint32_t frame = 0; frame < frames; ++frame)
-                            {
-                                samples[0 * frames + frame] = 0.0F; // L = 0
-                                samples[1 * frames + frame] = 0.0F; // R = 0
-                                samples[2 * frames + frame] = sourceSamples[frame]; // C = M
-                                samples[3 * frames + frame] = 0.0F; // LFE = 0
-                                samples[4 * frames + frame] = 0.0F; // SL = 0
-                                samples[5 * frames + frame] = 0.0F; // SR = 0
-                            }
-                            break;
-                    }
-                    break;
-                }
-                case 2:
-                {
-                    switch (channels)
-                    {
-                        case 1: // downmix 2 to 1
-                            for (std::uint32_t frame = 0; frame < frames; ++frame)
-                                samples[frame] = (sourceSamples[0 * frames + frame] +
-                                                  sourceSamples[1 * frames + frame]) * 0.5F; // M = (L + R) * 0.5
-                            break;
-                        case 4: // upmix 2 to 4
-                            for (std::uint32_t frame = 0; frame < frames; ++frame)
-                            {
-                                samples[0 * frames + frame] = sourceSamples[0 * frames + frame]; // L = L
-                                samples[1 * frames + frame] = sourceSamples[1 * frames + frame]; // R = R
-                                samples[2 * frames + frame] = 0.0F; // SL = 0
-                                samples[3 * frames + frame] = 0.0F; // SR = 0
-                            }
-                            break;
-                        case 6: // upmix 2 to 6
-                            for (std::uint32_t frame = 0; frame < frames; ++frame)
-                            {
-                                samples[0 * frames + frame] = sourceSamples[0 * frames + frame]; // L = L
-                                samples[1 * frames + frame] = sourceSamples[1 * frames + frame]; // R = R
-                                samples[2 * frames + frame] = 0.0F; // C = 0
-                                samples[3 * frames + frame] = 0.0F; // LFE = 0
-                                samples[4 * frames + frame] = 0.0F; // SL = 0
-                                samples[5 * frames + frame] = 0.0F; // SR = 0
-                            }
-                            break;
-                    }
-                    break;
-                }
-                case 4:
-                {
-                    switch (channels)
-                    {
-                        case 1: // downmix 4 to 1
-                            for (std::uint32_t frame = 0; frame < frames; ++frame)
-                                samples[frame] = (sourceSamples[0 * frames + frame] +
-                                                  sourceSamples[1 * frames + frame] +
-                                                  sourceSamples[2 * frames + frame] +
-                                                  sourceSamples[3 * frames + frame]) * 0.25F; // M = (L + R + SL + SR) * 0.25
-                            break;
-                        case 2: // downmix 4 to 2
-                            for (std::uint32_t frame = 0; frame < frames; ++frame)
-                            {
-                                samples[0 * frames + frame] = (sourceSamples[0 * frames + frame] +
-                                                               sourceSamples[2 * frames + frame]) * 0.5F; // L = (L + SL) * 0.5
-                                samples[1 * frames + frame] = (sourceSamples[1 * frames + frame] +
-                                                               sourceSamples[3 * frames + frame]) * 0.5F; // R = (R + RL) * 0.5
-                            }
-                            break;
-                        case 6: // upmix 4 to 6
-                            for (std::uint32_t frame = 0; frame < frames; ++frame)
-                            {
-                                samples[0 * frames + frame] = sourceSamples[0 * frames + frame]; // L = L
-                                samples[1 * frames + frame] = sourceSamples[1 * frames + frame]; // R = R
-                                samples[2 * frames + frame] = 0.0F; // C = 0
-                                samples[3 * frames + frame] = 0.0F; // LFE = 0
-                                samples[4 * frames + frame] = sourceSamples[2 * frames + frame]; // SL = SL
-                                samples[5 * frames + frame] = sourceSamples[3 * frames + frame]; // SR = SR
-                            }
-                            break;
-                    }
-                    break;
-                }
-                case 6:
-                {
-                    switch (channels)
-                    {
-                        case 1: // downmix 6 to 1
-                            for (std::uint32_t frame = 0; frame < frames; ++frame)
-                                samples[frame] = ((sourceSamples[0 * frames + frame] +
-                                                   sourceSamples[1 * frames + frame]) * 0.7071F +
-                                                  sourceSamples[2 * frames + frame] +
-                                                  (sourceSamples[4 * frames + frame] +
-                                                   sourceSamples[5 * frames + frame]) * 0.5F); // M = (L + R) * 0.7071 + C + (SL + SR) * 0.5
-                            break;
-                        case 2: // downmix 6 to 2
-                            for (std::uint32_t frame = 0; frame < frames; ++frame)
-                            {
-                                samples[frame * channels + 0] = (sourceSamples[0 * frames + frame] +
-                                                                 (sourceSamples[2 * frames + frame] +
-                                                                  sourceSamples[4 * frames + frame]) * 0.7071F); // L = L + (C + SL) * 0.7071
-                                samples[frame * channels + 1] = (sourceSamples[1 * frames + frame] +
-                                                                 (sourceSamples[2 * frames + frame] +
-                                                                  sourceSamples[5 * frames + frame]) * 0.7071F); // R = R + (C + SR) * 0.7071
-                            }
-                            break;
-                        case 4: // downmix 6 to 4
-                            for (std::uint32_t frame = 0; frame < frames; ++frame)
-                            {
-                                samples[frame * channels + 0] = (sourceSamples[0 * frames + frame] +
-                                                                 sourceSamples[2 * frames + frame] * 0.7071F); // L = L + C * 0.7071
-                                samples[frame * channels + 1] = (sourceSamples[1 * frames + frame] +
-                                                                 sourceSamples[2 * frames + frame] * 0.7071F); // R = R + C * 0.7071
-                                samples[frame * channels + 2] = sourceSamples[4 * frames + frame]; // SL = SL
-                                samples[frame * channels + 3] = sourceSamples[5 * frames + frame]; // SR = SR
-                            }
-                            break;
-                    }
-                    break;
-                }
-            }
+            if (const auto matrix = dsp::getConversionMatrix(sourceChannels, channels))
+                dsp::mix(frames, sourceChannels, sourceSamples.data(), channels, samples.data(), matrix);
+            else
+                std::fill(samples.begin(), samples.end(), 0.0F);
         }
         else
             samples = sourceSamples;
     }
 
     void Bus::generateSamples(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate,
-                              const Vector3F& listenerPosition, const QuaternionF& listenerRotation,
-                              std::vector<float>& samples)
+                              const Listener& listener)
     {
-        samples.resize(frames * channels);
-        std::fill(samples.begin(), samples.end(), 0.0F);
+        // the time of the input buses is measured when they are generated
+        Timing::Scope busScope(getTiming());
 
-        for (Bus* bus : inputBuses)
-        {
-            bus->generateSamples(frames, channels, sampleRate,
-                                 listenerPosition, listenerRotation, buffer);
+        outputBuffer.resize(frames * channels);
+        std::fill(outputBuffer.begin(), outputBuffer.end(), 0.0F);
 
-            for (std::size_t s = 0; s < samples.size(); ++s)
-                samples[s] += buffer[s];
-        }
+        // the inputs are always added in the same order, so the result does not depend on the order they were generated in
+        for (const Bus* bus : inputBuses)
+            dsp::add(outputBuffer.data(), bus->outputBuffer.data(), outputBuffer.size());
+
+        const bool spatialized = spatializer && spatializer->isEnabled();
+        const bool pitched = spatialized && spatializer->getDopplerFactor() > 0.0F;
+
+        if (spatialized)
+            spatializer->evaluate(inputStreams, listener, channels);
 
         for (Stream* stream : inputStreams)
         {
             if (stream->isPlaying())
             {
+                Timing::Scope streamScope(stream->getTiming());
+
+                // sized by Audio::initStream for the largest block at the highest pitch
+                auto& mixBuffer = stream->mixBuffer;
+
                 const std::uint32_t sourceSampleRate = stream->getData().getSampleRate();
                 const std::uint32_t sourceChannels = stream->getData().getChannels();
 
-                if (sourceSampleRate != sampleRate)
+                // the Doppler shift changes the pitch through the resampler
+                if (sourceSampleRate != sampleRate || pitched)
                 {
-                    std::uint32_t sourceFrames = (frames * sourceSampleRate + sampleRate - 1) / sampleRate; // round up
-                    stream->generateSamples(sourceFrames, resampleBuffer);
-                    resample(sourceChannels, sourceFrames, resampleBuffer, frames, mixBuffer);
+                    auto& resampler = stream->resampler;
+
+                    // the streams are prepared by Audio::createStream, preparing one here would lock and allocate,
+                    // so a stream that was prepared for a different rate is left silent
+                    if (!resampler.isPrepared(sourceSampleRate, sampleRate, sourceChannels))
+                        continue;
+
+                    resampler.setPitch(pitched ? stream->getSpatialState().pitch : 1.0F);
+
+                    if (stream->isVirtual())
+                    {
+                        stream->skip(resampler.skip(frames));
+                        continue;
+                    }
+
+                    const auto sourceFrames = resampler.getSourceFrames(frames);
+                    stream->generateSamples(sourceFrames, stream->resampleBuffer);
+                    mixBuffer.resize(frames * sourceChannels);
+                    resampler.process(sourceFrames, stream->resampleBuffer.data(), frames, mixBuffer.data());
+                }
+                else if (stream->isVirtual())
+                {
+                    stream->skip(frames);
+                    continue;
                 }
                 else
                     stream->generateSamples(frames, mixBuffer);
 
+                if (spatialized)
+                {
+                    // the stream gain is a part of the panning gains
+                    spatializer->pan(stream->getSpatialState(), frames, sourceChannels, mixBuffer.data(),
+                                     channels, outputBuffer.data());
+                    continue;
+                }
+
                 if (sourceChannels != channels)
                     convert(frames, sourceChannels, mixBuffer, channels, buffer);
                 else
                     buffer = mixBuffer;
 
-                for (std::size_t s = 0; s < samples.size(); ++s)
-                    samples[s] += buffer[s];
+                if (stream->getGain() != 1.0F)
+                    dsp::addScaled(outputBuffer.data(), buffer.data(), stream->getGain(), outputBuffer.size());
+                else
+                    dsp::add(outputBuffer.data(), buffer.data(), outputBuffer.size());
             }
         }
 
         for (Processor* processor : processors)
             if (processor->isEnabled())
-                processor->process(frames, channels, sampleRate, samples);
+            {
+                Timing::Scope processorScope(processor->getTiming());
+                processor->process(frames, channels, sampleRate, outputBuffer);
+            }
     }
 
     void Bus::addProcessor(Processor* processor)
@@ -279,6 +164,9 @@ namespace ouzel::audio::mixer
             if (processor->bus) processor->bus->removeProcessor(processor);
             processor->bus = this;
             processors.push_back(processor);
+
+            if (const auto newSpatializer = dynamic_cast<Spatializer*>(processor))
+                spatializer = newSpatializer;
         }
     }
 
@@ -289,9 +177,34 @@ namespace ouzel::audio::mixer
         {
             processor->bus = nullptr;
             processors.erase(i);
+
+            if (processor == spatializer) spatializer = nullptr;
         }
     }
 
+    namespace
+    {
+        template <class T>
+        void reserveList(std::vector<T*>& list, std::vector<T*>& newList) noexcept
+        {
+            // copied into the reserved capacity, so nothing is allocated
+            if (newList.capacity() > list.capacity())
+            {
+                newList.assign(list.begin(), list.end());
+                list.swap(newList);
+            }
+        }
+    }
+
+    void Bus::reserve(std::vector<Bus*>& newInputBuses,
+                      std::vector<Stream*>& newInputStreams,
+                      std::vector<Processor*>& newProcessors) noexcept
+    {
+        reserveList(inputBuses, newInputBuses);
+        reserveList(inputStreams, newInputStreams);
+        reserveList(processors, newProcessors);
+    }
+
     void Bus::addInput(Bus* bus)
     {
         const auto i = std::find(inputBuses.begin(), inputBuses.end(), bus);
@@ -4,11 +4,13 @@
 #define OUZEL_AUDIO_MIXER_BUS_HPP
 
 #include <vector>
+#include "Listener.hpp"
 #include "Object.hpp"
 
 namespace ouzel::audio::mixer
 {
     class Processor;
+    class Spatializer;
     class Stream;
 
     class Bus final: public Object
@@ -17,6 +19,7 @@ namespace ouzel::audio::mixer
         friend Stream;
     public:
         Bus() noexcept {}
+        explicit Bus(std::size_t maxSamples);
         ~Bus() override;
         Bus(const Bus&) = delete;
         Bus& operator=(const Bus&) = delete;
@@ -24,15 +27,27 @@ namespace ouzel::audio::mixer
         Bus(Bus&&) = delete;
         Bus& operator=(Bus&&) = delete;
 
+        void detach() final;
+
         void setOutput(Bus* newOutput);
 
+        auto getOutput() const noexcept { return output; }
+        auto& getInputBuses() const noexcept { return inputBuses; }
+
+        // mixes the samples of the input buses, so they have to be generated first
         void generateSamples(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate,
-                             const Vector3F& listenerPosition, const QuaternionF& listenerRotation,
-                             std::vector<float>& samples);
+                             const Listener& listener);
+        auto& getOutputBuffer() const noexcept { return outputBuffer; }
+        auto& getOutputBuffer() noexcept { return outputBuffer; }
 
         void addProcessor(Processor* processor);
         void removeProcessor(Processor* processor);
 
+        // swaps the lists with the larger ones allocated outside the mixer, the empty ones are kept
+        void reserve(std::vector<Bus*>& newInputBuses,
+                     std::vector<Stream*>& newInputStreams,
+                     std::vector<Processor*>& newProcessors) noexcept;
+
     private:
         void addInput(Bus* bus);
         void removeInput(Bus* bus);
@@ -43,10 +58,10 @@ namespace ouzel::audio::mixer
         std::vector<Bus*> inputBuses;
         std::vector<Stream*> inputStreams;
         std::vector<Processor*> processors;
+        Spatializer* spatializer = nullptr; // the input streams are panned by it instead of being converted
 
-        std::vector<float> resampleBuffer;
-        std::vector<float> mixBuffer;
         std::vector<float> buffer;
+        std::vector<float> outputBuffer;
     };
 }
 
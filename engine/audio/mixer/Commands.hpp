@@ -4,9 +4,13 @@
 #define OUZEL_AUDIO_MIXER_COMMANDS_HPP
 
 #include <cstdint>
-#include <functional>
 #include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "Graph.hpp"
+#include "Listener.hpp"
 #include "Processor.hpp"
 #include "Source.hpp"
 #include "Stream.hpp"
@@ -25,20 +29,28 @@ namespace ouzel::audio::mixer
             deleteObject,
             addChild,
             removeChild,
+            reserveChildren,
             play,
             stop,
             initBus,
             setBusOutput,
+            reserveBus,
             addProcessor,
             removeProcessor,
             setMasterBus,
             initStream,
             playStream,
             stopStream,
+            seekStream,
             setStreamOutput,
+            setStreamGain,
+            setStreamVirtual,
+            setStreamPosition,
             initData,
             initProcessor,
-            updateProcessor
+            updateProcessor,
+            setObjectStorage,
+            setListener
         };
 
         explicit constexpr Command(Type initType) noexcept: type(initType) {}
@@ -47,34 +59,37 @@ namespace ouzel::audio::mixer
         const Type type;
     };
 
+    // objects are constructed and destroyed outside the mixer, so that it never allocates
     class InitObjectCommand final: public Command
     {
     public:
-        explicit constexpr InitObjectCommand(ObjectId initObjectId) noexcept:
+        explicit InitObjectCommand(ObjectId initObjectId):
             Command(Command::Type::initObject),
-            objectId(initObjectId)
+            objectId(initObjectId),
+            object(std::make_unique<Object>())
         {}
 
         InitObjectCommand(ObjectId initObjectId,
-                          std::unique_ptr<Source> initSource) noexcept:
+                          std::unique_ptr<Source> initSource):
             Command(Command::Type::initObject),
             objectId(initObjectId),
-            source(std::move(initSource))
+            object(std::make_unique<Object>(std::move(initSource)))
         {}
 
         const ObjectId objectId;
-        std::unique_ptr<Source> source;
+        std::unique_ptr<Object> object;
     };
 
     class DeleteObjectCommand final: public Command
     {
     public:
-        explicit constexpr DeleteObjectCommand(ObjectId initObjectId) noexcept:
+        explicit DeleteObjectCommand(ObjectId initObjectId) noexcept:
             Command(Command::Type::deleteObject),
             objectId(initObjectId)
         {}
 
         const ObjectId objectId;
+        std::unique_ptr<Object> object; // detached object handed back by the mixer
     };
 
     class AddChildCommand final: public Command
@@ -105,6 +120,20 @@ namespace ouzel::audio::mixer
         const ObjectId childId;
     };
 
+    class ReserveChildrenCommand final: public Command
+    {
+    public:
+        ReserveChildrenCommand(ObjectId initObjectId, std::size_t capacity):
+            Command(Command::Type::reserveChildren),
+            objectId(initObjectId)
+        {
+            children.reserve(capacity);
+        }
+
+        const ObjectId objectId;
+        std::vector<Object*> children;
+    };
+
     class PlayCommand final: public Command
     {
     public:
@@ -133,12 +162,14 @@ namespace ouzel::audio::mixer
     class InitBusCommand final: public Command
     {
     public:
-        explicit constexpr InitBusCommand(ObjectId initBusId) noexcept:
+        InitBusCommand(ObjectId initBusId, std::size_t maxSamples):
             Command(Command::Type::initBus),
-            busId(initBusId)
+            busId(initBusId),
+            bus(std::make_unique<Bus>(maxSamples))
         {}
 
         const ObjectId busId;
+        std::unique_ptr<Bus> bus;
     };
 
     class SetBusOutputCommand final: public Command
@@ -155,6 +186,29 @@ namespace ouzel::audio::mixer
         const ObjectId outputBusId;
     };
 
+    // the lists of the inputs and the processors of a bus only grow here, so that adding them on the mixer thread
+    // never allocates, the lists that do not have to grow are left empty and the old ones are released with the command
+    class ReserveBusCommand final: public Command
+    {
+    public:
+        ReserveBusCommand(ObjectId initBusId,
+                          std::size_t inputBusCapacity,
+                          std::size_t inputStreamCapacity,
+                          std::size_t processorCapacity):
+            Command(Command::Type::reserveBus),
+            busId(initBusId)
+        {
+            inputBuses.reserve(inputBusCapacity);
+            inputStreams.reserve(inputStreamCapacity);
+            processors.reserve(processorCapacity);
+        }
+
+        const ObjectId busId;
+        std::vector<Bus*> inputBuses;
+        std::vector<Stream*> inputStreams;
+        std::vector<Processor*> processors;
+    };
+
     class AddProcessorCommand final: public Command
     {
     public:
@@ -197,26 +251,29 @@ namespace ouzel::audio::mixer
     class InitStreamCommand final: public Command
     {
     public:
-        constexpr InitStreamCommand(ObjectId initStreamId,
-                                    ObjectId initDataId) noexcept:
+        InitStreamCommand(ObjectId initStreamId,
+                          std::unique_ptr<Stream> initStream) noexcept:
             Command(Command::Type::initStream),
             streamId(initStreamId),
-            dataId(initDataId)
+            stream(std::move(initStream))
         {}
 
         const ObjectId streamId;
-        const ObjectId dataId;
+        std::unique_ptr<Stream> stream;
     };
 
     class PlayStreamCommand final: public Command
     {
     public:
-        explicit constexpr PlayStreamCommand(ObjectId initStreamId) noexcept:
+        constexpr PlayStreamCommand(ObjectId initStreamId,
+                                    std::size_t initPlayId = 0) noexcept:
             Command(Command::Type::playStream),
-            streamId(initStreamId)
+            streamId(initStreamId),
+            playId(initPlayId)
         {}
 
         const ObjectId streamId;
+        const std::size_t playId; // reported back when the stream stops by itself
     };
 
     class StopStreamCommand final: public Command
@@ -233,6 +290,20 @@ namespace ouzel::audio::mixer
         const bool reset;
     };
 
+    class SeekStreamCommand final: public Command
+    {
+    public:
+        constexpr SeekStreamCommand(ObjectId initStreamId,
+                                    std::uint64_t initFrame) noexcept:
+            Command(Command::Type::seekStream),
+            streamId(initStreamId),
+            frame(initFrame)
+        {}
+
+        const ObjectId streamId;
+        const std::uint64_t frame;
+    };
+
     class SetStreamOutputCommand final: public Command
     {
     public:
@@ -247,6 +318,51 @@ namespace ouzel::audio::mixer
         const ObjectId busId;
     };
 
+    class SetStreamGainCommand final: public Command
+    {
+    public:
+        constexpr SetStreamGainCommand(ObjectId initStreamId,
+                                       float initGain) noexcept:
+            Command(Command::Type::setStreamGain),
+            streamId(initStreamId),
+            gain(initGain)
+        {}
+
+        const ObjectId streamId;
+        const float gain;
+    };
+
+    class SetStreamVirtualCommand final: public Command
+    {
+    public:
+        constexpr SetStreamVirtualCommand(ObjectId initStreamId,
+                                          bool initVirtual) noexcept:
+            Command(Command::Type::setStreamVirtual),
+            streamId(initStreamId),
+            isVirtual(initVirtual)
+        {}
+
+        const ObjectId streamId;
+        const bool isVirtual;
+    };
+
+    class SetStreamPositionCommand final: public Command
+    {
+    public:
+        SetStreamPositionCommand(ObjectId initStreamId,
+                                 const Vector3F& initPosition,
+                                 const Vector3F& initVelocity) noexcept:
+            Command(Command::Type::setStreamPosition),
+            streamId(initStreamId),
+            position(initPosition),
+            velocity(initVelocity)
+        {}
+
+        const ObjectId streamId;
+        const Vector3F position;
+        const Vector3F velocity;
+    };
+
     class InitDataCommand final: public Command
     {
     public:
@@ -275,18 +391,72 @@ namespace ouzel::audio::mixer
         std::unique_ptr<Processor> processor;
     };
 
-    class UpdateProcessorCommand final: public Command
+    // the update is created on the game thread and applied on the mixer thread, where it must not throw,
+    // allocate or lock
+    class UpdateProcessorCommand: public Command
     {
     public:
-        UpdateProcessorCommand(ObjectId initProcessorId,
-                               const std::function<void(Processor*)>& initUpdateFunction) noexcept:
+        explicit UpdateProcessorCommand(ObjectId initProcessorId) noexcept:
             Command(Command::Type::updateProcessor),
-            processorId(initProcessorId),
-            updateFunction(initUpdateFunction)
+            processorId(initProcessorId)
         {}
 
+        virtual void update(Processor* processor) const noexcept = 0;
+
         const ObjectId processorId;
-        const std::function<void(Processor*)> updateFunction;
+    };
+
+    template <class Function>
+    class ProcessorUpdateCommand final: public UpdateProcessorCommand
+    {
+    public:
+        static_assert(std::is_nothrow_invocable_v<const Function&, Processor*>,
+                      "Processor updates must not throw");
+
+        ProcessorUpdateCommand(ObjectId initProcessorId, Function initFunction):
+            UpdateProcessorCommand(initProcessorId),
+            function(std::move(initFunction))
+        {}
+
+        void update(Processor* processor) const noexcept final
+        {
+            function(processor);
+        }
+
+    private:
+        const Function function;
+    };
+
+    // replaces the object table and the bus graph storage of the mixer with larger ones,
+    // the old ones are released with the command
+    class SetObjectStorageCommand final: public Command
+    {
+    public:
+        explicit SetObjectStorageCommand(std::size_t initCapacity):
+            Command(Command::Type::setObjectStorage),
+            objects(initCapacity),
+            graphStorage(initCapacity)
+        {
+            playingStreams.reserve(initCapacity);
+            stoppedStreams.reserve(initCapacity);
+        }
+
+        std::vector<std::unique_ptr<Object>> objects;
+        Graph::Storage graphStorage;
+        // stream ids with their play ids
+        std::vector<std::pair<ObjectId, std::size_t>> playingStreams;
+        std::vector<std::pair<ObjectId, std::size_t>> stoppedStreams;
+    };
+
+    class SetListenerCommand final: public Command
+    {
+    public:
+        explicit SetListenerCommand(const Listener& initListener) noexcept:
+            Command(Command::Type::setListener),
+            listener(initListener)
+        {}
+
+        const Listener listener;
     };
 
     class CommandBuffer final
@@ -304,14 +474,7 @@ namespace ouzel::audio::mixer
 
         void pushCommand(std::unique_ptr<Command> command)
         {
-            commands.push(std::move(command));
-        }
-
-        std::unique_ptr<Command> popCommand()
-        {
-            auto result = std::move(commands.front());
-            commands.pop();
-            return result;
+            commands.push_back(std::move(command));
         }
 
         auto& getCommands() const
@@ -321,7 +484,7 @@ namespace ouzel::audio::mixer
 
     private:
         std::string name;
-        std::queue<std::unique_ptr<Command>> commands;
+        std::vector<std::unique_ptr<Command>> commands;
     };
 }
 
@@ -0,0 +1,286 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <stdexcept>
+#include "Convolver.hpp"
+#include "Dsp.hpp"
+#include "Realtime.hpp"
+
+namespace ouzel::audio::mixer
+{
+    Convolver::Convolver(const std::vector<float>& impulseResponse, std::uint32_t impulseChannels,
+                         std::uint32_t initChannels, bool backgroundTail):
+        channelStates(initChannels),
+        headFrame(blockSize * 2),
+        background(backgroundTail)
+    {
+        const std::size_t length = impulseChannels ? impulseResponse.size() / impulseChannels : 0;
+        if (length == 0)
+            throw std::runtime_error("Empty impulse response");
+
+        headPartitions = static_cast<std::uint32_t>((std::min<std::size_t>(length, headSize) + blockSize - 1) / blockSize);
+        prepareFilters(impulseResponse, impulseChannels, 0, std::min<std::size_t>(length, headSize),
+                       blockSize, headPartitions, headFft, headFilters);
+
+        if (length > headSize)
+        {
+            tailPartitions = static_cast<std::uint32_t>((length - headSize + tailBlockSize - 1) / tailBlockSize);
+            tailFrame.resize(tailBlockSize * 2);
+            prepareFilters(impulseResponse, impulseChannels, headSize, length - headSize,
+                           tailBlockSize, tailPartitions, tailFft, tailFilters);
+        }
+
+        for (std::uint32_t channelIndex = 0; channelIndex < initChannels; ++channelIndex)
+        {
+            auto& channel = channelStates[channelIndex];
+            channel.filter = impulseChannels ? channelIndex % impulseChannels : 0;
+            channel.input.resize(blockSize);
+            channel.output.resize(blockSize);
+            prepareSegment(channel.head, blockSize, headPartitions);
+
+            if (tailPartitions)
+            {
+                prepareSegment(channel.tail, tailBlockSize, tailPartitions);
+                channel.tailInput.resize(tailBlockSize);
+                for (auto& tailOutput : channel.tailOutputs)
+                    tailOutput.resize(tailBlockSize);
+            }
+        }
+
+        if (background && tailPartitions)
+            tailThread = thread::Thread(&Convolver::tailMain, this);
+    }
+
+    Convolver::~Convolver()
+    {
+        std::unique_lock lock(tailMutex);
+        running = false;
+        lock.unlock();
+        tailCondition.notify_all();
+
+        if (tailThread.isJoinable()) tailThread.join();
+    }
+
+    void Convolver::prepareFilters(const std::vector<float>& impulseResponse, std::uint32_t impulseChannels,
+                                   std::size_t offset, std::size_t length, std::uint32_t partitionSize,
+                                   std::uint32_t partitionCount, Fft& fft, std::vector<Filter>& filters)
+    {
+        const std::size_t totalLength = impulseResponse.size() / impulseChannels;
+        const std::size_t binCount = partitionSize + 1;
+        std::vector<float> frame(partitionSize * 2);
+
+        filters.resize(impulseChannels);
+
+        for (std::uint32_t impulseChannel = 0; impulseChannel < impulseChannels; ++impulseChannel)
+        {
+            auto& filter = filters[impulseChannel];
+            filter.real.resize(binCount * partitionCount);
+            filter.imaginary.resize(binCount * partitionCount);
+
+            const float* source = impulseResponse.data() + impulseChannel * totalLength + offset;
+
+            for (std::uint32_t partition = 0; partition < partitionCount; ++partition)
+            {
+                // the second half stays zero, so that the circular convolution does not wrap around
+                const std::size_t start = static_cast<std::size_t>(partition) * partitionSize;
+                const auto count = std::min<std::size_t>(partitionSize, length - start);
+                std::fill(frame.begin(), frame.end(), 0.0F);
+                std::copy(source + start, source + start + count, frame.begin());
+
+                fft.forward(frame.data(), filter.real.data() + partition * binCount,
+                            filter.imaginary.data() + partition * binCount);
+            }
+        }
+    }
+
+    void Convolver::prepareSegment(Segment& segment, std::uint32_t partitionSize, std::uint32_t partitionCount)
+    {
+        const std::size_t binCount = partitionSize + 1;
+        segment.history.resize(partitionSize * 2);
+        segment.delayLineReal.resize(binCount * partitionCount);
+        segment.delayLineImaginary.resize(binCount * partitionCount);
+        segment.accumulatorReal.resize(binCount);
+        segment.accumulatorImaginary.resize(binCount);
+    }
+
+    void Convolver::process(std::uint32_t frames, float* samples, float gain)
+    {
+        for (std::uint32_t offset = 0; offset < frames;)
+        {
+            const auto count = std::min(frames - offset, blockSize - position);
+
+            for (std::size_t channelIndex = 0; channelIndex < channelStates.size(); ++channelIndex)
+            {
+                auto& channel = channelStates[channelIndex];
+                float* channelSamples = samples + channelIndex * frames + offset;
+
+                std::copy(channelSamples, channelSamples + count, channel.input.begin() + position);
+                dsp::addScaled(channelSamples, channel.output.data() + position, gain, count);
+            }
+
+            offset += count;
+            position += count;
+
+            if (position == blockSize)
+            {
+                processBlock();
+                position = 0;
+            }
+        }
+    }
+
+    void Convolver::processBlock()
+    {
+        constexpr std::size_t binCount = blockSize + 1;
+        const auto phase = static_cast<std::uint32_t>(blockIndex % blocksPerTailBlock);
+
+        for (auto& channel : channelStates)
+        {
+            auto& head = channel.head;
+            const auto& filter = headFilters[channel.filter];
+
+            std::copy(head.history.begin() + blockSize, head.history.end(), head.history.begin());
+            std::copy(channel.input.begin(), channel.input.end(), head.history.begin() + blockSize);
+
+            float* inputReal = head.delayLineReal.data() + head.delayLinePosition * binCount;
+            float* inputImaginary = head.delayLineImaginary.data() + head.delayLinePosition * binCount;
+            headFft.forward(head.history.data(), inputReal, inputImaginary);
+
+            std::fill(head.accumulatorReal.begin(), head.accumulatorReal.end(), 0.0F);
+            std::fill(head.accumulatorImaginary.begin(), head.accumulatorImaginary.end(), 0.0F);
+
+            // the newest input is multiplied by the first partition, the oldest by the last one
+            for (std::uint32_t partition = 0; partition < headPartitions; ++partition)
+            {
+                const auto slot = (head.delayLinePosition + headPartitions - partition) % headPartitions;
+                dsp::multiplyAddComplex(head.accumulatorReal.data(), head.accumulatorImaginary.data(),
+                                        head.delayLineReal.data() + slot * binCount,
+                                        head.delayLineImaginary.data() + slot * binCount,
+                                        filter.real.data() + partition * binCount,
+                                        filter.imaginary.data() + partition * binCount,
+                                        binCount);
+            }
+
+            head.delayLinePosition = (head.delayLinePosition + 1) % headPartitions;
+
+            headFft.inverse(head.accumulatorReal.data(), head.accumulatorImaginary.data(), headFrame.data());
+            std::copy(headFrame.begin() + blockSize, headFrame.end(), channel.output.begin());
+
+            if (tailPartitions)
+            {
+                // the tail block that started two tail blocks ago is played now
+                if (blockIndex >= blocksPerTailBlock * 2)
+                {
+                    const auto tailBlock = blockIndex / blocksPerTailBlock - 2;
+                    dsp::add(channel.output.data(), channel.tailOutputs[tailBlock % 2].data() + phase * blockSize, blockSize);
+                }
+
+                std::copy(channel.input.begin(), channel.input.end(), channel.tailInput.begin() + phase * blockSize);
+            }
+        }
+
+        if (tailPartitions)
+        {
+            if (!background && blockIndex >= blocksPerTailBlock)
+                processTailStep(blockIndex / blocksPerTailBlock - 1, phase);
+
+            if (phase == blocksPerTailBlock - 1)
+            {
+                const auto tailBlock = blockIndex / blocksPerTailBlock;
+
+                // the previous tail block had a whole tail block of time, so this normally does not wait
+                if (background)
+                {
+                    auto lock = realtime::lock(tailMutex);
+                    realtime::wait(tailCondition, lock, [this, tailBlock]() noexcept { return completedTailBlocks >= tailBlock; });
+                }
+
+                for (auto& channel : channelStates)
+                {
+                    auto& history = channel.tail.history;
+                    std::copy(history.begin() + tailBlockSize, history.end(), history.begin());
+                    std::copy(channel.tailInput.begin(), channel.tailInput.end(), history.begin() + tailBlockSize);
+                }
+
+                if (background)
+                {
+                    auto lock = realtime::lock(tailMutex);
+                    requestedTailBlocks = tailBlock + 1;
+                    lock.unlock();
+                    tailCondition.notify_all();
+                }
+            }
+        }
+
+        ++blockIndex;
+    }
+
+    // the first step transforms the input, the last one transforms the result back and the rest multiply the partitions
+    void Convolver::processTailStep(std::uint64_t tailBlock, std::uint32_t step) noexcept
+    {
+        constexpr std::size_t binCount = tailBlockSize + 1;
+        constexpr std::uint32_t multiplySteps = blocksPerTailBlock - 2;
+
+        for (auto& channel : channelStates)
+        {
+            auto& tail = channel.tail;
+
+            if (step == 0)
+            {
+                tailFft.forward(tail.history.data(),
+                                tail.delayLineReal.data() + tail.delayLinePosition * binCount,
+                                tail.delayLineImaginary.data() + tail.delayLinePosition * binCount);
+
+                std::fill(tail.accumulatorReal.begin(), tail.accumulatorReal.end(), 0.0F);
+                std::fill(tail.accumulatorImaginary.begin(), tail.accumulatorImaginary.end(), 0.0F);
+            }
+            else if (step <= multiplySteps)
+            {
+                const auto& filter = tailFilters[channel.filter];
+                const auto first = tailPartitions * (step - 1) / multiplySteps;
+                const auto last = tailPartitions * step / multiplySteps;
+
+                for (auto partition = first; partition < last; ++partition)
+                {
+                    const auto slot = (tail.delayLinePosition + tailPartitions - partition) % tailPartitions;
+                    dsp::multiplyAddComplex(tail.accumulatorReal.data(), tail.accumulatorImaginary.data(),
+                                            tail.delayLineReal.data() + slot * binCount,
+                                            tail.delayLineImaginary.data() + slot * binCount,
+                                            filter.real.data() + partition * binCount,
+                                            filter.imaginary.data() + partition * binCount,
+                                            binCount);
+                }
+            }
+            else
+            {
+                tail.delayLinePosition = (tail.delayLinePosition + 1) % tailPartitions;
+
+                tailFft.inverse(tail.accumulatorReal.data(), tail.accumulatorImaginary.data(), tailFrame.data());
+                std::copy(tailFrame.begin() + tailBlockSize, tailFrame.end(), channel.tailOutputs[tailBlock % 2].begin());
+            }
+        }
+    }
+
+    void Convolver::tailMain()
+    {
+        thread::setCurrentThreadName("Convolver");
+
+        std::unique_lock lock(tailMutex);
+        for (;;)
+        {
+            tailCondition.wait(lock, [this]() noexcept { return !running || completedTailBlocks < requestedTailBlocks; });
+            if (!running) break;
+
+            // the mixer does not touch the tail state until the block is completed
+            const auto tailBlock = completedTailBlocks;
+            lock.unlock();
+
+            for (std::uint32_t step = 0; step < blocksPerTailBlock; ++step)
+                processTailStep(tailBlock, step);
+
+            lock.lock();
+            completedTailBlocks = tailBlock + 1;
+            tailCondition.notify_all();
+        }
+    }
+}
@@ -0,0 +1,109 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_CONVOLVER_HPP
+#define OUZEL_AUDIO_MIXER_CONVOLVER_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "Fft.hpp"
+#include "../../thread/Thread.hpp"
+
+namespace ouzel::audio::mixer
+{
+    // non-uniformly partitioned overlap-save convolution with frequency domain delay lines,
+    // the head of the impulse response is split into short partitions that are convolved every block,
+    // the tail into long ones whose work is spread over the blocks or done on a background thread,
+    // so that the cost of every block is the same
+    class Convolver final
+    {
+    public:
+        static constexpr std::uint32_t blockSize = 256;
+        static constexpr std::uint32_t tailBlockSize = 4096;
+        static constexpr std::uint32_t blocksPerTailBlock = tailBlockSize / blockSize;
+        // the result of a tail block is needed two tail blocks after it starts
+        static constexpr std::uint32_t headSize = tailBlockSize * 2;
+
+        // the impulse response is planar, the output channels use its channels in turn
+        Convolver(const std::vector<float>& impulseResponse, std::uint32_t impulseChannels,
+                  std::uint32_t initChannels, bool backgroundTail);
+        ~Convolver();
+
+        Convolver(const Convolver&) = delete;
+        Convolver& operator=(const Convolver&) = delete;
+
+        Convolver(Convolver&&) = delete;
+        Convolver& operator=(Convolver&&) = delete;
+
+        auto getChannels() const noexcept { return static_cast<std::uint32_t>(channelStates.size()); }
+
+        // adds the convolved planar samples multiplied by gain, the output is delayed by blockSize frames
+        void process(std::uint32_t frames, float* samples, float gain);
+
+    private:
+        // spectra of the partitions of one impulse response channel one after another
+        struct Filter final
+        {
+            std::vector<float> real;
+            std::vector<float> imaginary;
+        };
+
+        // uniformly partitioned convolution of one channel
+        struct Segment final
+        {
+            std::vector<float> history; // the last two blocks of the input
+            std::vector<float> delayLineReal; // spectra of the last inputs, one for every partition
+            std::vector<float> delayLineImaginary;
+            std::uint32_t delayLinePosition = 0;
+            std::vector<float> accumulatorReal;
+            std::vector<float> accumulatorImaginary;
+        };
+
+        struct Channel final
+        {
+            std::size_t filter = 0;
+            std::vector<float> input;
+            std::vector<float> output;
+            Segment head;
+            Segment tail;
+            std::vector<float> tailInput;
+            std::vector<float> tailOutputs[2]; // double buffered, the tail blocks alternate
+        };
+
+        static void prepareFilters(const std::vector<float>& impulseResponse, std::uint32_t impulseChannels,
+                                   std::size_t offset, std::size_t length, std::uint32_t partitionSize,
+                                   std::uint32_t partitionCount, Fft& fft, std::vector<Filter>& filters);
+        static void prepareSegment(Segment& segment, std::uint32_t partitionSize, std::uint32_t partitionCount);
+
+        void processBlock();
+        void processTailStep(std::uint64_t tailBlock, std::uint32_t step) noexcept;
+        void tailMain();
+
+        std::vector<Channel> channelStates;
+        std::uint32_t position = 0;
+        std::uint64_t blockIndex = 0;
+
+        Fft headFft{blockSize * 2};
+        std::uint32_t headPartitions = 0;
+        std::vector<Filter> headFilters;
+        std::vector<float> headFrame;
+
+        Fft tailFft{tailBlockSize * 2};
+        std::uint32_t tailPartitions = 0;
+        std::vector<Filter> tailFilters;
+        std::vector<float> tailFrame;
+
+        bool background = false;
+        // guarded by the tail mutex, the tail thread sleeps on the condition until a tail block is requested
+        // and the mixer until the previous one is completed
+        std::uint64_t requestedTailBlocks = 0;
+        std::uint64_t completedTailBlocks = 0;
+        bool running = true;
+        std::mutex tailMutex;
+        std::condition_variable tailCondition;
+        thread::Thread tailThread;
+    };
+}
+
+#endif // OUZEL_AUDIO_MIXER_CONVOLVER_HPP
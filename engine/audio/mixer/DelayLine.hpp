@@ -0,0 +1,69 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_DELAYLINE_HPP
+#define OUZEL_AUDIO_MIXER_DELAYLINE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace ouzel::audio::mixer
+{
+    // circular buffer of planar samples that does not allocate after construction
+    class DelayLine final
+    {
+    public:
+        DelayLine() noexcept = default;
+        DelayLine(std::uint32_t initChannels, std::uint32_t maxDelay):
+            channels(initChannels),
+            size(getSize(maxDelay)),
+            buffer(size * channels)
+        {
+        }
+
+        auto getChannels() const noexcept { return channels; }
+        std::uint32_t getMaxDelay() const noexcept { return size - 1; }
+
+        void clear() noexcept
+        {
+            std::fill(buffer.begin(), buffer.end(), 0.0F);
+            position = 0;
+        }
+
+        // replaces the samples of the channel with the ones written delay frames earlier, call advance after every channel
+        void process(std::uint32_t channel, std::uint32_t delay, float* samples, std::uint32_t frames) noexcept
+        {
+            float* line = buffer.data() + channel * size;
+            const std::uint32_t mask = size - 1;
+            std::uint32_t current = position;
+
+            for (std::uint32_t frame = 0; frame < frames; ++frame)
+            {
+                line[current] = samples[frame];
+                samples[frame] = line[(current - delay) & mask];
+                current = (current + 1) & mask;
+            }
+        }
+
+        void advance(std::uint32_t frames) noexcept
+        {
+            position = (position + frames) & (size - 1);
+        }
+
+    private:
+        // the smallest power of two that can hold the delayed frames and the current one
+        static std::uint32_t getSize(std::uint32_t maxDelay) noexcept
+        {
+            std::uint32_t result = 1;
+            while (result <= maxDelay) result <<= 1;
+            return result;
+        }
+
+        std::uint32_t channels = 0;
+        std::uint32_t size = 1;
+        std::uint32_t position = 0;
+        std::vector<float> buffer;
+    };
+}
+
+#endif // OUZEL_AUDIO_MIXER_DELAYLINE_HPP
@@ -0,0 +1,568 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#if defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
+#elif defined(__SSE__)
+#  include <xmmintrin.h>
+#endif
+#include <algorithm>
+#include <cstring>
+#include "Dsp.hpp"
+#include "../../core/Engine.hpp"
+
+namespace ouzel::audio::mixer::dsp
+{
+    void add(float* destination, const float* source, std::size_t count) noexcept
+    {
+        std::size_t i = 0;
+
+        if (core::isSimdAvailable)
+        {
+#if defined(__ARM_NEON__)
+            for (; i + 4 <= count; i += 4)
+                vst1q_f32(destination + i, vaddq_f32(vld1q_f32(destination + i), vld1q_f32(source + i)));
+#elif defined(__SSE__)
+            for (; i + 4 <= count; i += 4)
+                _mm_storeu_ps(destination + i, _mm_add_ps(_mm_loadu_ps(destination + i), _mm_loadu_ps(source + i)));
+#endif
+        }
+
+        for (; i < count; ++i)
+            destination[i] += source[i];
+    }
+
+    void addScaled(float* destination, const float* source, float gain, std::size_t count) noexcept
+    {
+        std::size_t i = 0;
+
+        if (core::isSimdAvailable)
+        {
+#if defined(__ARM_NEON__)
+            const float32x4_t g = vdupq_n_f32(gain);
+            for (; i + 4 <= count; i += 4)
+                vst1q_f32(destination + i, vmlaq_f32(vld1q_f32(destination + i), vld1q_f32(source + i), g));
+#elif defined(__SSE__)
+            const __m128 g = _mm_set1_ps(gain);
+            for (; i + 4 <= count; i += 4)
+                _mm_storeu_ps(destination + i, _mm_add_ps(_mm_loadu_ps(destination + i),
+                                                          _mm_mul_ps(_mm_loadu_ps(source + i), g)));
+#endif
+        }
+
+        for (; i < count; ++i)
+            destination[i] += source[i] * gain;
+    }
+
+    void addRamped(float* destination, const float* source, float startGain, float endGain, std::size_t count) noexcept
+    {
+        const auto step = (endGain - startGain) / static_cast<float>(count);
+        std::size_t i = 0;
+
+        if (core::isSimdAvailable)
+        {
+#if defined(__ARM_NEON__)
+            const float offsets[4] = {0.0F, 1.0F, 2.0F, 3.0F};
+            float32x4_t g = vmlaq_n_f32(vdupq_n_f32(startGain), vld1q_f32(offsets), step);
+            const float32x4_t s = vdupq_n_f32(step * 4.0F);
+            for (; i + 4 <= count; i += 4)
+            {
+                vst1q_f32(destination + i, vmlaq_f32(vld1q_f32(destination + i), vld1q_f32(source + i), g));
+                g = vaddq_f32(g, s);
+            }
+#elif defined(__SSE__)
+            __m128 g = _mm_add_ps(_mm_set1_ps(startGain), _mm_mul_ps(_mm_set_ps(3.0F, 2.0F, 1.0F, 0.0F), _mm_set1_ps(step)));
+            const __m128 s = _mm_set1_ps(step * 4.0F);
+            for (; i + 4 <= count; i += 4)
+            {
+                _mm_storeu_ps(destination + i, _mm_add_ps(_mm_loadu_ps(destination + i),
+                                                          _mm_mul_ps(_mm_loadu_ps(source + i), g)));
+                g = _mm_add_ps(g, s);
+            }
+#endif
+        }
+
+        for (; i < count; ++i)
+            destination[i] += source[i] * (startGain + step * static_cast<float>(i));
+    }
+
+    void scale(float* destination, const float* source, float gain, std::size_t count) noexcept
+    {
+        std::size_t i = 0;
+
+        if (core::isSimdAvailable)
+        {
+#if defined(__ARM_NEON__)
+            for (; i + 4 <= count; i += 4)
+                vst1q_f32(destination + i, vmulq_n_f32(vld1q_f32(source + i), gain));
+#elif defined(__SSE__)
+            const __m128 g = _mm_set1_ps(gain);
+            for (; i + 4 <= count; i += 4)
+                _mm_storeu_ps(destination + i, _mm_mul_ps(_mm_loadu_ps(source + i), g));
+#endif
+        }
+
+        for (; i < count; ++i)
+            destination[i] = source[i] * gain;
+    }
+
+    void convert(const std::int16_t* source, float* destination, std::size_t count) noexcept
+    {
+        constexpr float factor = 1.0F / 32767.0F;
+        std::size_t i = 0;
+
+        if (core::isSimdAvailable)
+        {
+#if defined(__ARM_NEON__)
+            for (; i + 8 <= count; i += 8)
+            {
+                const int16x8_t value = vld1q_s16(source + i);
+                vst1q_f32(destination + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(value))), factor));
+                vst1q_f32(destination + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(value))), factor));
+            }
+#elif defined(__SSE2__)
+            const __m128 f = _mm_set1_ps(factor);
+            for (; i + 8 <= count; i += 8)
+            {
+                const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+                // the values are unpacked to the upper halves and shifted back to extend the sign
+                const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16);
+                const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(value, value), 16);
+                _mm_storeu_ps(destination + i, _mm_mul_ps(_mm_cvtepi32_ps(low), f));
+                _mm_storeu_ps(destination + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), f));
+            }
+#endif
+        }
+
+        for (; i < count; ++i)
+            destination[i] = static_cast<float>(source[i]) * factor;
+    }
+
+    void clamp(float* samples, std::size_t count, float min, float max) noexcept
+    {
+        std::size_t i = 0;
+
+        if (core::isSimdAvailable)
+        {
+#if defined(__ARM_NEON__)
+            const float32x4_t minimum = vdupq_n_f32(min);
+            const float32x4_t maximum = vdupq_n_f32(max);
+            for (; i + 4 <= count; i += 4)
+                vst1q_f32(samples + i, vminq_f32(vmaxq_f32(vld1q_f32(samples + i), minimum), maximum));
+#elif defined(__SSE__)
+            const __m128 minimum = _mm_set1_ps(min);
+            const __m128 maximum = _mm_set1_ps(max);
+            for (; i + 4 <= count; i += 4)
+                _mm_storeu_ps(samples + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(samples + i), minimum), maximum));
+#endif
+        }
+
+        for (; i < count; ++i)
+            samples[i] = std::clamp(samples[i], min, max);
+    }
+
+    float dot(const float* a, const float* b, std::size_t count) noexcept
+    {
+        std::size_t i = 0;
+        float result = 0.0F;
+
+        if (core::isSimdAvailable)
+        {
+#if defined(__ARM_NEON__)
+            float32x4_t sum = vdupq_n_f32(0.0F);
+            for (; i + 4 <= count; i += 4)
+                sum = vmlaq_f32(sum, vld1q_f32(a + i), vld1q_f32(b + i));
+
+            const float32x2_t pair = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+            result = vget_lane_f32(vpadd_f32(pair, pair), 0);
+#elif defined(__SSE__)
+            __m128 sum = _mm_setzero_ps();
+            for (; i + 4 <= count; i += 4)
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+
+            sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+            sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+            result = _mm_cvtss_f32(sum);
+#endif
+        }
+
+        for (; i < count; ++i)
+            result += a[i] * b[i];
+
+        return result;
+    }
+
+    void multiplyAddComplex(float* destinationReal, float* destinationImaginary,
+                            const float* aReal, const float* aImaginary,
+                            const float* bReal, const float* bImaginary, std::size_t count) noexcept
+    {
+        std::size_t i = 0;
+
+        if (core::isSimdAvailable)
+        {
+#if defined(__ARM_NEON__)
+            for (; i + 4 <= count; i += 4)
+            {
+                const float32x4_t ar = vld1q_f32(aReal + i);
+                const float32x4_t ai = vld1q_f32(aImaginary + i);
+                const float32x4_t br = vld1q_f32(bReal + i);
+                const float32x4_t bi = vld1q_f32(bImaginary + i);
+                vst1q_f32(destinationReal + i, vmlsq_f32(vmlaq_f32(vld1q_f32(destinationReal + i), ar, br), ai, bi));
+                vst1q_f32(destinationImaginary + i, vmlaq_f32(vmlaq_f32(vld1q_f32(destinationImaginary + i), ar, bi), ai, br));
+            }
+#elif defined(__SSE__)
+            for (; i + 4 <= count; i += 4)
+            {
+                const __m128 ar = _mm_loadu_ps(aReal + i);
+                const __m128 ai = _mm_loadu_ps(aImaginary + i);
+                const __m128 br = _mm_loadu_ps(bReal + i);
+                const __m128 bi = _mm_loadu_ps(bImaginary + i);
+                const __m128 real = _mm_sub_ps(_mm_mul_ps(ar, br), _mm_mul_ps(ai, bi));
+                const __m128 imaginary = _mm_add_ps(_mm_mul_ps(ar, bi), _mm_mul_ps(ai, br));
+                _mm_storeu_ps(destinationReal + i, _mm_add_ps(_mm_loadu_ps(destinationReal + i), real));
+                _mm_storeu_ps(destinationImaginary + i, _mm_add_ps(_mm_loadu_ps(destinationImaginary + i), imaginary));
+            }
+#endif
+        }
+
+        for (; i < count; ++i)
+        {
+            destinationReal[i] += aReal[i] * bReal[i] - aImaginary[i] * bImaginary[i];
+            destinationImaginary[i] += aReal[i] * bImaginary[i] + aImaginary[i] * bReal[i];
+        }
+    }
+
+    namespace
+    {
+        // channel conversion matrices, each row holds the source channel gains of one output channel
+        constexpr float upmix1To2[] = {
+            1.0F, // L = M
+            1.0F // R = M
+        };
+        constexpr float upmix1To4[] = {
+            1.0F, // L = M
+            1.0F, // R = M
+            0.0F, // SL = 0
+            0.0F // SR = 0
+        };
+        constexpr float upmix1To6[] = {
+            0.0F, // L = 0
+            0.0F, // R = 0
+            1.0F, // C = M
+            0.0F, // LFE = 0
+            0.0F, // SL = 0
+            0.0F // SR = 0
+        };
+        constexpr float downmix2To1[] = {
+            0.5F, 0.5F // M = (L + R) * 0.5
+        };
+        constexpr float upmix2To4[] = {
+            1.0F, 0.0F, // L = L
+            0.0F, 1.0F, // R = R
+            0.0F, 0.0F, // SL = 0
+            0.0F, 0.0F // SR = 0
+        };
+        constexpr float upmix2To6[] = {
+            1.0F, 0.0F, // L = L
+            0.0F, 1.0F, // R = R
+            0.0F, 0.0F, // C = 0
+            0.0F, 0.0F, // LFE = 0
+            0.0F, 0.0F, // SL = 0
+            0.0F, 0.0F // SR = 0
+        };
+        constexpr float downmix4To1[] = {
+            0.25F, 0.25F, 0.25F, 0.25F // M = (L + R + SL + SR) * 0.25
+        };
+        constexpr float downmix4To2[] = {
+            0.5F, 0.0F, 0.5F, 0.0F, // L = (L + SL) * 0.5
+            0.0F, 0.5F, 0.0F, 0.5F // R = (R + SR) * 0.5
+        };
+        constexpr float upmix4To6[] = {
+            1.0F, 0.0F, 0.0F, 0.0F, // L = L
+            0.0F, 1.0F, 0.0F, 0.0F, // R = R
+            0.0F, 0.0F, 0.0F, 0.0F, // C = 0
+            0.0F, 0.0F, 0.0F, 0.0F, // LFE = 0
+            0.0F, 0.0F, 1.0F, 0.0F, // SL = SL
+            0.0F, 0.0F, 0.0F, 1.0F // SR = SR
+        };
+        constexpr float downmix6To1[] = {
+            0.7071F, 0.7071F, 1.0F, 0.0F, 0.5F, 0.5F // M = (L + R) * 0.7071 + C + (SL + SR) * 0.5
+        };
+        constexpr float downmix6To2[] = {
+            1.0F, 0.0F, 0.7071F, 0.0F, 0.7071F, 0.0F, // L = L + (C + SL) * 0.7071
+            0.0F, 1.0F, 0.7071F, 0.0F, 0.0F, 0.7071F // R = R + (C + SR) * 0.7071
+        };
+        constexpr float downmix6To4[] = {
+            1.0F, 0.0F, 0.7071F, 0.0F, 0.0F, 0.0F, // L = L + C * 0.7071
+            0.0F, 1.0F, 0.7071F, 0.0F, 0.0F, 0.0F, // R = R + C * 0.7071
+            0.0F, 0.0F, 0.0F, 0.0F, 1.0F, 0.0F, // SL = SL
+            0.0F, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F // SR = SR
+        };
+    }
+
+    const float* getConversionMatrix(std::uint32_t sourceChannels, std::uint32_t channels) noexcept
+    {
+        switch (sourceChannels)
+        {
+            case 1:
+                switch (channels)
+                {
+                    case 2: return upmix1To2;
+                    case 4: return upmix1To4;
+                    case 6: return upmix1To6;
+                }
+                break;
+            case 2:
+                switch (channels)
+                {
+                    case 1: return downmix2To1;
+                    case 4: return upmix2To4;
+                    case 6: return upmix2To6;
+                }
+                break;
+            case 4:
+                switch (channels)
+                {
+                    case 1: return downmix4To1;
+                    case 2: return downmix4To2;
+                    case 6: return upmix4To6;
+                }
+                break;
+            case 6:
+                switch (channels)
+                {
+                    case 1: return downmix6To1;
+                    case 2: return downmix6To2;
+                    case 4: return downmix6To4;
+                }
+                break;
+        }
+
+        return nullptr;
+    }
+
+    void mix(std::uint32_t frames,
+             std::uint32_t sourceChannels, const float* source,
+             std::uint32_t channels, float* destination,
+             const float* matrix) noexcept
+    {
+        for (std::uint32_t channel = 0; channel < channels; ++channel)
+        {
+            const auto outputChannel = destination + channel * frames;
+            bool written = false;
+
+            for (std::uint32_t sourceChannel = 0; sourceChannel < sourceChannels; ++sourceChannel)
+            {
+                const auto gain = matrix[channel * sourceChannels + sourceChannel];
+                if (gain == 0.0F) continue;
+
+                if (written)
+                    addScaled(outputChannel, source + sourceChannel * frames, gain, frames);
+                else if (gain == 1.0F)
+                    std::memcpy(outputChannel, source + sourceChannel * frames, frames * sizeof(float));
+                else
+                    scale(outputChannel, source + sourceChannel * frames, gain, frames);
+
+                written = true;
+            }
+
+            if (!written)
+                std::fill(outputChannel, outputChannel + frames, 0.0F);
+        }
+    }
+
+    void interleave(const float* source, std::uint32_t frames, std::uint32_t channels, float* destination) noexcept
+    {
+        std::uint32_t frame = 0;
+
+        if (channels == 1)
+        {
+            std::memcpy(destination, source, frames * sizeof(float));
+            return;
+        }
+
+        if (channels == 2 && core::isSimdAvailable)
+        {
+            const auto left = source;
+            const auto right = source + frames;
+#if defined(__ARM_NEON__)
+            for (; frame + 4 <= frames; frame += 4)
+            {
+                float32x4x2_t value;
+                value.val[0] = vld1q_f32(left + frame);
+                value.val[1] = vld1q_f32(right + frame);
+                vst2q_f32(destination + frame * 2, value);
+            }
+#elif defined(__SSE__)
+            for (; frame + 4 <= frames; frame += 4)
+            {
+                const __m128 l = _mm_loadu_ps(left + frame);
+                const __m128 r = _mm_loadu_ps(right + frame);
+                _mm_storeu_ps(destination + frame * 2 + 0, _mm_unpacklo_ps(l, r));
+                _mm_storeu_ps(destination + frame * 2 + 4, _mm_unpackhi_ps(l, r));
+            }
+#endif
+        }
+
+        for (; frame < frames; ++frame)
+            for (std::uint32_t channel = 0; channel < channels; ++channel)
+                destination[frame * channels + channel] = source[channel * frames + frame];
+    }
+
+    void deinterleave(const float* source, std::uint32_t frames, std::uint32_t channels, float* destination) noexcept
+    {
+        std::uint32_t frame = 0;
+
+        if (channels == 1)
+        {
+            std::memcpy(destination, source, frames * sizeof(float));
+            return;
+        }
+
+        if (channels == 2 && core::isSimdAvailable)
+        {
+            const auto left = destination;
+            const auto right = destination + frames;
+#if defined(__ARM_NEON__)
+            for (; frame + 4 <= frames; frame += 4)
+            {
+                const float32x4x2_t value = vld2q_f32(source + frame * 2);
+                vst1q_f32(left + frame, value.val[0]);
+                vst1q_f32(right + frame, value.val[1]);
+            }
+#elif defined(__SSE__)
+            for (; frame + 4 <= frames; frame += 4)
+            {
+                const __m128 a = _mm_loadu_ps(source + frame * 2 + 0); // l0 r0 l1 r1
+                const __m128 b = _mm_loadu_ps(source + frame * 2 + 4); // l2 r2 l3 r3
+                _mm_storeu_ps(left + frame, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+                _mm_storeu_ps(right + frame, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+            }
+#endif
+        }
+
+        for (; frame < frames; ++frame)
+            for (std::uint32_t channel = 0; channel < channels; ++channel)
+                destination[channel * frames + frame] = source[frame * channels + channel];
+    }
+
+    namespace
+    {
+        // xorshift32 mapped to [0, 1)
+        inline float random(std::uint32_t& state) noexcept
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+
+            const std::uint32_t bits = (state >> 9) | 0x3F800000U;
+            float result;
+            std::memcpy(&result, &bits, sizeof(result));
+            return result - 1.0F;
+        }
+
+        inline std::int16_t quantize(float sample, Dither& dither, std::uint32_t lane) noexcept
+        {
+            auto& state = dither.state[lane];
+            const auto noise = random(state) - random(state);
+            const auto value = std::clamp(sample * 32767.0F + noise, -32768.0F, 32767.0F);
+            return static_cast<std::int16_t>(value);
+        }
+
+#if defined(__ARM_NEON__)
+        inline float32x4_t random(uint32x4_t& state) noexcept
+        {
+            state = veorq_u32(state, vshlq_n_u32(state, 13));
+            state = veorq_u32(state, vshrq_n_u32(state, 17));
+            state = veorq_u32(state, vshlq_n_u32(state, 5));
+
+            const uint32x4_t bits = vorrq_u32(vshrq_n_u32(state, 9), vdupq_n_u32(0x3F800000U));
+            return vsubq_f32(vreinterpretq_f32_u32(bits), vdupq_n_f32(1.0F));
+        }
+
+        inline int16x4_t quantize(float32x4_t samples, uint32x4_t& state) noexcept
+        {
+            const float32x4_t noise = vsubq_f32(random(state), random(state));
+            const float32x4_t value = vmlaq_n_f32(noise, samples, 32767.0F);
+            return vqmovn_s32(vcvtq_s32_f32(value)); // saturates
+        }
+#elif defined(__SSE2__)
+        inline __m128 random(__m128i& state) noexcept
+        {
+            state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+            state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+            state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+
+            const __m128i bits = _mm_or_si128(_mm_srli_epi32(state, 9), _mm_set1_epi32(0x3F800000));
+            return _mm_sub_ps(_mm_castsi128_ps(bits), _mm_set1_ps(1.0F));
+        }
+
+        inline __m128i quantize(__m128 samples, __m128i& state) noexcept
+        {
+            const __m128 noise = _mm_sub_ps(random(state), random(state));
+            const __m128 value = _mm_add_ps(_mm_mul_ps(samples, _mm_set1_ps(32767.0F)), noise);
+            return _mm_cvttps_epi32(value); // saturated when packed
+        }
+#endif
+    }
+
+    void interleave(const float* source, std::uint32_t frames, std::uint32_t channels,
+                    std::int16_t* destination, Dither& dither) noexcept
+    {
+        std::uint32_t frame = 0;
+
+        if ((channels == 1 || channels == 2) && core::isSimdAvailable)
+        {
+#if defined(__ARM_NEON__)
+            uint32x4_t state = vld1q_u32(dither.state.data());
+
+            if (channels == 1)
+            {
+                for (; frame + 4 <= frames; frame += 4)
+                    vst1_s16(destination + frame, quantize(vld1q_f32(source + frame), state));
+            }
+            else
+            {
+                for (; frame + 4 <= frames; frame += 4)
+                {
+                    int16x4x2_t value;
+                    value.val[0] = quantize(vld1q_f32(source + frame), state);
+                    value.val[1] = quantize(vld1q_f32(source + frames + frame), state);
+                    vst2_s16(destination + frame * 2, value);
+                }
+            }
+
+            vst1q_u32(dither.state.data(), state);
+#elif defined(__SSE2__)
+            __m128i state = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither.state.data()));
+
+            if (channels == 1)
+            {
+                for (; frame + 4 <= frames; frame += 4)
+                {
+                    const __m128i value = quantize(_mm_loadu_ps(source + frame), state);
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(destination + frame), _mm_packs_epi32(value, value));
+                }
+            }
+            else
+            {
+                for (; frame + 4 <= frames; frame += 4)
+                {
+                    const __m128i left = quantize(_mm_loadu_ps(source + frame), state);
+                    const __m128i right = quantize(_mm_loadu_ps(source + frames + frame), state);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + frame * 2),
+                                     _mm_unpacklo_epi16(_mm_packs_epi32(left, left),
+                                                        _mm_packs_epi32(right, right)));
+                }
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dither.state.data()), state);
+#endif
+        }
+
+        for (; frame < frames; ++frame)
+            for (std::uint32_t channel = 0; channel < channels; ++channel)
+                destination[frame * channels + channel] = quantize(source[channel * frames + frame], dither, channel % 4);
+    }
+}
@@ -0,0 +1,63 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_DSP_HPP
+#define OUZEL_AUDIO_MIXER_DSP_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// vectorized sample kernels, all of the sample pointers may be unaligned
+namespace ouzel::audio::mixer::dsp
+{
+    // destination += source
+    void add(float* destination, const float* source, std::size_t count) noexcept;
+
+    // destination += source * gain
+    void addScaled(float* destination, const float* source, float gain, std::size_t count) noexcept;
+
+    // destination += source * gain, the gain moves linearly from startGain towards endGain
+    void addRamped(float* destination, const float* source, float startGain, float endGain, std::size_t count) noexcept;
+
+    // destination = source * gain
+    void scale(float* destination, const float* source, float gain, std::size_t count) noexcept;
+
+    // 16-bit samples to floats in the [-1, 1] range
+    void convert(const std::int16_t* source, float* destination, std::size_t count) noexcept;
+
+    void clamp(float* samples, std::size_t count, float min, float max) noexcept;
+
+    // sum of a[i] * b[i]
+    float dot(const float* a, const float* b, std::size_t count) noexcept;
+
+    // complex destination += a * b, the real and the imaginary parts are in separate arrays
+    void multiplyAddComplex(float* destinationReal, float* destinationImaginary,
+                            const float* aReal, const float* aImaginary,
+                            const float* bReal, const float* bImaginary, std::size_t count) noexcept;
+
+    // the standard up and down mix matrix for mix, null if there is none for the channel counts
+    const float* getConversionMatrix(std::uint32_t sourceChannels, std::uint32_t channels) noexcept;
+
+    // converts planar source channels to planar destination channels with a channels x sourceChannels gain matrix
+    void mix(std::uint32_t frames,
+             std::uint32_t sourceChannels, const float* source,
+             std::uint32_t channels, float* destination,
+             const float* matrix) noexcept;
+
+    // planar to interleaved samples and back
+    void interleave(const float* source, std::uint32_t frames, std::uint32_t channels, float* destination) noexcept;
+    void deinterleave(const float* source, std::uint32_t frames, std::uint32_t channels, float* destination) noexcept;
+
+    // state of the triangular (TPDF) dither noise added before the quantization to 16 bits
+    class Dither final
+    {
+    public:
+        std::array<std::uint32_t, 4> state{{0x6C078965U, 0x1B873593U, 0xCC9E2D51U, 0x85EBCA6BU}};
+    };
+
+    // planar float samples to interleaved 16-bit samples with dither
+    void interleave(const float* source, std::uint32_t frames, std::uint32_t channels,
+                    std::int16_t* destination, Dither& dither) noexcept;
+}
+
+#endif // OUZEL_AUDIO_MIXER_DSP_HPP
@@ -0,0 +1,184 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#if defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#elif defined(__SSE__)
+#  include <xmmintrin.h>
+#endif
+#include <cmath>
+#include <stdexcept>
+#include "Fft.hpp"
+#include "../../core/Engine.hpp"
+#include "../../math/Constants.hpp"
+
+namespace ouzel::audio::mixer
+{
+    Fft::Fft(std::uint32_t initSize):
+        size(initSize),
+        halfSize(initSize / 2)
+    {
+        if (size < 4 || (size & (size - 1)) != 0)
+            throw std::runtime_error("FFT size must be a power of two");
+
+        std::uint32_t bits = 0;
+        while ((1U << bits) < halfSize) ++bits;
+
+        reversed.resize(halfSize);
+        for (std::uint32_t i = 0; i < halfSize; ++i)
+        {
+            std::uint32_t result = 0;
+            for (std::uint32_t bit = 0; bit < bits; ++bit)
+                if (i & (1U << bit)) result |= 1U << (bits - 1 - bit);
+            reversed[i] = result;
+        }
+
+        twiddleReal.resize(halfSize);
+        twiddleImaginary.resize(halfSize);
+        for (std::uint32_t butterflies = 1; butterflies < halfSize; butterflies *= 2)
+            for (std::uint32_t i = 0; i < butterflies; ++i)
+            {
+                const auto angle = -pi<double> * i / butterflies;
+                twiddleReal[butterflies - 1 + i] = static_cast<float>(std::cos(angle));
+                twiddleImaginary[butterflies - 1 + i] = static_cast<float>(std::sin(angle));
+            }
+
+        splitReal.resize(halfSize);
+        splitImaginary.resize(halfSize);
+        for (std::uint32_t i = 0; i < halfSize; ++i)
+        {
+            const auto angle = -tau<double> * i / size;
+            splitReal[i] = static_cast<float>(std::cos(angle));
+            splitImaginary[i] = static_cast<float>(std::sin(angle));
+        }
+
+        workReal.resize(halfSize);
+        workImaginary.resize(halfSize);
+    }
+
+    void Fft::forward(const float* input, float* real, float* imaginary) noexcept
+    {
+        // the even samples are the real and the odd ones are the imaginary part of the half size signal
+        for (std::uint32_t i = 0; i < halfSize; ++i)
+        {
+            workReal[reversed[i]] = input[i * 2];
+            workImaginary[reversed[i]] = input[i * 2 + 1];
+        }
+
+        transform(workReal.data(), workImaginary.data());
+
+        real[0] = workReal[0] + workImaginary[0];
+        imaginary[0] = 0.0F;
+        real[halfSize] = workReal[0] - workImaginary[0];
+        imaginary[halfSize] = 0.0F;
+
+        for (std::uint32_t i = 1; i < halfSize; ++i)
+        {
+            const auto j = halfSize - i;
+
+            // spectra of the even and the odd samples
+            const auto evenReal = (workReal[i] + workReal[j]) * 0.5F;
+            const auto evenImaginary = (workImaginary[i] - workImaginary[j]) * 0.5F;
+            const auto oddReal = (workImaginary[i] + workImaginary[j]) * 0.5F;
+            const auto oddImaginary = (workReal[j] - workReal[i]) * 0.5F;
+
+            real[i] = evenReal + oddReal * splitReal[i] - oddImaginary * splitImaginary[i];
+            imaginary[i] = evenImaginary + oddReal * splitImaginary[i] + oddImaginary * splitReal[i];
+        }
+    }
+
+    void Fft::inverse(const float* real, const float* imaginary, float* output) noexcept
+    {
+        for (std::uint32_t i = 0; i < halfSize; ++i)
+        {
+            const auto j = halfSize - i;
+
+            const auto evenReal = (real[i] + real[j]) * 0.5F;
+            const auto evenImaginary = (imaginary[i] - imaginary[j]) * 0.5F;
+            const auto differenceReal = (real[i] - real[j]) * 0.5F;
+            const auto differenceImaginary = (imaginary[i] + imaginary[j]) * 0.5F;
+
+            // rotate the difference back by the conjugate twiddle
+            const auto oddReal = differenceReal * splitReal[i] + differenceImaginary * splitImaginary[i];
+            const auto oddImaginary = differenceImaginary * splitReal[i] - differenceReal * splitImaginary[i];
+
+            // the inverse transform is the forward one with the real and the imaginary parts swapped
+            workImaginary[reversed[i]] = evenReal - oddImaginary;
+            workReal[reversed[i]] = evenImaginary + oddReal;
+        }
+
+        transform(workReal.data(), workImaginary.data());
+
+        const auto scale = 1.0F / static_cast<float>(halfSize);
+        for (std::uint32_t i = 0; i < halfSize; ++i)
+        {
+            output[i * 2] = workImaginary[i] * scale;
+            output[i * 2 + 1] = workReal[i] * scale;
+        }
+    }
+
+    void Fft::transform(float* real, float* imaginary) noexcept
+    {
+        for (std::uint32_t butterflies = 1; butterflies < halfSize; butterflies *= 2)
+        {
+            const float* stageReal = twiddleReal.data() + butterflies - 1;
+            const float* stageImaginary = twiddleImaginary.data() + butterflies - 1;
+
+            for (std::uint32_t group = 0; group < halfSize; group += butterflies * 2)
+            {
+                float* topReal = real + group;
+                float* topImaginary = imaginary + group;
+                float* bottomReal = topReal + butterflies;
+                float* bottomImaginary = topImaginary + butterflies;
+                std::uint32_t i = 0;
+
+                // the butterflies of a group are independent, so four of them are computed at once
+                if (core::isSimdAvailable)
+                {
+#if defined(__ARM_NEON__)
+                    for (; i + 4 <= butterflies; i += 4)
+                    {
+                        const float32x4_t wr = vld1q_f32(stageReal + i);
+                        const float32x4_t wi = vld1q_f32(stageImaginary + i);
+                        const float32x4_t br = vld1q_f32(bottomReal + i);
+                        const float32x4_t bi = vld1q_f32(bottomImaginary + i);
+                        const float32x4_t tr = vmlsq_f32(vmulq_f32(br, wr), bi, wi);
+                        const float32x4_t ti = vmlaq_f32(vmulq_f32(br, wi), bi, wr);
+                        const float32x4_t ar = vld1q_f32(topReal + i);
+                        const float32x4_t ai = vld1q_f32(topImaginary + i);
+                        vst1q_f32(topReal + i, vaddq_f32(ar, tr));
+                        vst1q_f32(topImaginary + i, vaddq_f32(ai, ti));
+                        vst1q_f32(bottomReal + i, vsubq_f32(ar, tr));
+                        vst1q_f32(bottomImaginary + i, vsubq_f32(ai, ti));
+                    }
+#elif defined(__SSE__)
+                    for (; i + 4 <= butterflies; i += 4)
+                    {
+                        const __m128 wr = _mm_loadu_ps(stageReal + i);
+                        const __m128 wi = _mm_loadu_ps(stageImaginary + i);
+                        const __m128 br = _mm_loadu_ps(bottomReal + i);
+                        const __m128 bi = _mm_loadu_ps(bottomImaginary + i);
+                        const __m128 tr = _mm_sub_ps(_mm_mul_ps(br, wr), _mm_mul_ps(bi, wi));
+                        const __m128 ti = _mm_add_ps(_mm_mul_ps(br, wi), _mm_mul_ps(bi, wr));
+                        const __m128 ar = _mm_loadu_ps(topReal + i);
+                        const __m128 ai = _mm_loadu_ps(topImaginary + i);
+                        _mm_storeu_ps(topReal + i, _mm_add_ps(ar, tr));
+                        _mm_storeu_ps(topImaginary + i, _mm_add_ps(ai, ti));
+                        _mm_storeu_ps(bottomReal + i, _mm_sub_ps(ar, tr));
+                        _mm_storeu_ps(bottomImaginary + i, _mm_sub_ps(ai, ti));
+                    }
+#endif
+                }
+
+                for (; i < butterflies; ++i)
+                {
+                    const auto tr = bottomReal[i] * stageReal[i] - bottomImaginary[i] * stageImaginary[i];
+                    const auto ti = bottomReal[i] * stageImaginary[i] + bottomImaginary[i] * stageReal[i];
+                    bottomReal[i] = topReal[i] - tr;
+                    bottomImaginary[i] = topImaginary[i] - ti;
+                    topReal[i] += tr;
+                    topImaginary[i] += ti;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,42 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_FFT_HPP
+#define OUZEL_AUDIO_MIXER_FFT_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace ouzel::audio::mixer
+{
+    // real FFT of a power of two size computed with a complex FFT of half the size,
+    // the spectra are stored as separate real and imaginary arrays of size / 2 + 1 bins
+    class Fft final
+    {
+    public:
+        explicit Fft(std::uint32_t initSize);
+
+        auto getSize() const noexcept { return size; }
+
+        void forward(const float* input, float* real, float* imaginary) noexcept;
+        // the output is normalized, so that it matches the input of forward
+        void inverse(const float* real, const float* imaginary, float* output) noexcept;
+
+    private:
+        // in place, the input has to be in the bit reversed order
+        void transform(float* real, float* imaginary) noexcept;
+
+        std::uint32_t size = 0;
+        std::uint32_t halfSize = 0;
+        std::vector<std::uint32_t> reversed;
+        // twiddles of all stages one after another, the stage with n butterflies per group starts at n - 1
+        std::vector<float> twiddleReal;
+        std::vector<float> twiddleImaginary;
+        // twiddles that split the half size transform into the real one
+        std::vector<float> splitReal;
+        std::vector<float> splitImaginary;
+        std::vector<float> workReal;
+        std::vector<float> workImaginary;
+    };
+}
+
+#endif // OUZEL_AUDIO_MIXER_FFT_HPP
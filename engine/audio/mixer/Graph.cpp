@@ -0,0 +1,201 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <thread>
+#include "Graph.hpp"
+#include "Bus.hpp"
+#include "Realtime.hpp"
+
+namespace ouzel::audio::mixer
+{
+    Graph::Graph(std::uint32_t workerCount)
+    {
+        workers.reserve(workerCount);
+
+        // the workers keep the default priority, because the thread that renders the graph waits for them
+        // and must never be preempted by them
+        for (std::uint32_t i = 0; i < workerCount; ++i)
+            workers.emplace_back(&Graph::workerMain, this);
+    }
+
+    Graph::~Graph()
+    {
+        std::unique_lock lock(workerMutex);
+        running = false;
+        lock.unlock();
+        workerCondition.notify_all();
+
+        for (auto& worker : workers)
+            if (worker.isJoinable()) worker.join();
+    }
+
+    void Graph::setStorage(Storage& newStorage) noexcept
+    {
+        std::swap(storage, newStorage);
+        dirty = true;
+    }
+
+    // every bus has a single output, so the buses reachable from the master bus form a tree and
+    // the reversed breadth-first order puts every bus after its inputs
+    void Graph::compile(Bus* masterBus) noexcept
+    {
+        root = masterBus;
+        dirty = false;
+        nodeCount = 0;
+
+        if (!masterBus || storage.capacity == 0) return;
+
+        storage.nodes[0] = masterBus;
+        storage.parents[0] = none;
+        nodeCount = 1;
+
+        for (std::size_t node = 0; node < nodeCount; ++node)
+        {
+            std::uint32_t dependencyCount = 0;
+
+            for (Bus* input : storage.nodes[node]->getInputBuses())
+                if (input != masterBus && nodeCount < storage.capacity) // the master bus can be in a loop
+                {
+                    storage.nodes[nodeCount] = input;
+                    storage.parents[nodeCount] = static_cast<std::uint32_t>(node);
+                    ++nodeCount;
+                    ++dependencyCount;
+                }
+
+            storage.dependencies[node] = dependencyCount;
+        }
+    }
+
+    void Graph::generateSamples(Bus* masterBus, std::uint32_t frames, std::uint32_t channels,
+                                std::uint32_t sampleRate, const Listener& listener)
+    {
+        if (dirty || masterBus != root) compile(masterBus);
+
+        if (workers.empty() || nodeCount < 2)
+        {
+            for (auto node = nodeCount; node-- > 0;)
+                storage.nodes[node]->generateSamples(frames, channels, sampleRate, listener);
+            return;
+        }
+
+        jobFrames = frames;
+        jobChannels = channels;
+        jobSampleRate = sampleRate;
+        jobListener = &listener;
+        readIndex = 0;
+        writeIndex = 0;
+        completed = 0;
+
+        for (std::size_t node = 0; node < nodeCount; ++node)
+        {
+            storage.pending[node].store(storage.dependencies[node], std::memory_order_relaxed);
+            storage.ready[node].store(0, std::memory_order_relaxed);
+        }
+
+        for (auto node = nodeCount; node-- > 0;)
+            if (storage.dependencies[node] == 0) push(static_cast<std::uint32_t>(node));
+
+        auto lock = realtime::lock(workerMutex);
+        active = true;
+        ++generation;
+        lock.unlock();
+        workerCondition.notify_all();
+
+        work();
+
+        // the workers may still be looking for work, so the job must not change until they leave
+        lock = realtime::lock(workerMutex);
+        active = false;
+        realtime::wait(workerCondition, lock, [this]() noexcept { return busyWorkers == 0; });
+    }
+
+    void Graph::push(std::uint32_t node) noexcept
+    {
+        // every bus is pushed once per job, so the slots never run out
+        const auto slot = writeIndex.fetch_add(1, std::memory_order_acq_rel);
+        storage.ready[slot].store(node + 1, std::memory_order_release);
+    }
+
+    std::uint32_t Graph::pop() noexcept
+    {
+        auto slot = readIndex.load(std::memory_order_acquire);
+
+        for (;;)
+        {
+            if (slot >= writeIndex.load(std::memory_order_acquire)) return none;
+            if (readIndex.compare_exchange_weak(slot, slot + 1, std::memory_order_acq_rel)) break;
+        }
+
+        // the slot is reserved before the node is stored in it
+        std::uint32_t value;
+        while ((value = storage.ready[slot].load(std::memory_order_acquire)) == 0)
+            std::this_thread::yield();
+
+        return value - 1;
+    }
+
+    void Graph::work()
+    {
+        while (completed.load(std::memory_order_acquire) < nodeCount)
+        {
+            const auto node = pop();
+
+            if (node == none)
+            {
+                // the buses that are left wait for the inputs that the other threads are generating
+                auto lock = realtime::lock(workerMutex);
+                realtime::wait(workerCondition, lock, [this]() noexcept {
+                    return readIndex.load(std::memory_order_acquire) < writeIndex.load(std::memory_order_acquire) ||
+                        completed.load(std::memory_order_acquire) >= nodeCount;
+                });
+                continue;
+            }
+
+            storage.nodes[node]->generateSamples(jobFrames, jobChannels, jobSampleRate, *jobListener);
+
+            const auto parent = storage.parents[node];
+            const bool parentReady = parent != none &&
+                storage.pending[parent].fetch_sub(1, std::memory_order_acq_rel) == 1;
+            if (parentReady) push(parent);
+
+            const bool finished = completed.fetch_add(1, std::memory_order_acq_rel) + 1 == nodeCount;
+
+            // the waiting threads check the job state under the lock, so the notification can not be missed
+            if (parentReady || finished)
+            {
+                const auto lock = realtime::lock(workerMutex);
+                workerCondition.notify_all();
+            }
+        }
+    }
+
+    void Graph::workerMain()
+    {
+        thread::setCurrentThreadName("Mixer worker");
+
+        std::uint64_t lastGeneration = 0;
+        std::unique_lock lock(workerMutex);
+
+        for (;;)
+        {
+            workerCondition.wait(lock, [this, lastGeneration]() noexcept {
+                return !running || generation != lastGeneration;
+            });
+
+            if (!running) break;
+            lastGeneration = generation;
+            if (!active) continue;
+
+            ++busyWorkers;
+            lock.unlock();
+
+            {
+                realtime::Scope realtimeScope;
+                work();
+            }
+
+            lock.lock();
+            if (--busyWorkers == 0) workerCondition.notify_all();
+        }
+    }
+}
@@ -0,0 +1,105 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_GRAPH_HPP
+#define OUZEL_AUDIO_MIXER_GRAPH_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Listener.hpp"
+#include "../../thread/Thread.hpp"
+
+namespace ouzel::audio::mixer
+{
+    class Bus;
+
+    // the buses that are reachable from the master bus ordered so that every bus comes after its inputs,
+    // the buses that do not depend on each other are generated in parallel by a pool of worker threads,
+    // every bus mixes its inputs in a fixed order, so the output does not depend on the scheduling
+    class Graph final
+    {
+    public:
+        // allocated outside the mixer thread, so that compiling the graph never allocates
+        class Storage final
+        {
+            friend Graph;
+        public:
+            Storage() = default;
+            explicit Storage(std::size_t initCapacity):
+                capacity(initCapacity),
+                nodes(initCapacity),
+                parents(initCapacity),
+                dependencies(initCapacity),
+                pending(std::make_unique<std::atomic<std::uint32_t>[]>(initCapacity)),
+                ready(std::make_unique<std::atomic<std::uint32_t>[]>(initCapacity))
+            {
+            }
+
+        private:
+            std::size_t capacity = 0;
+            std::vector<Bus*> nodes;
+            std::vector<std::uint32_t> parents;
+            std::vector<std::uint32_t> dependencies;
+            std::unique_ptr<std::atomic<std::uint32_t>[]> pending; // inputs that are not generated yet
+            std::unique_ptr<std::atomic<std::uint32_t>[]> ready; // buses whose inputs are all generated
+        };
+
+        explicit Graph(std::uint32_t workerCount);
+        ~Graph();
+
+        Graph(const Graph&) = delete;
+        Graph& operator=(const Graph&) = delete;
+
+        Graph(Graph&&) = delete;
+        Graph& operator=(Graph&&) = delete;
+
+        // the previous storage is moved to the argument, so that it can be freed outside the mixer
+        void setStorage(Storage& newStorage) noexcept;
+
+        // should be called every time the buses are connected differently
+        void invalidate() noexcept { dirty = true; }
+
+        // generates the samples of the master bus and all of its inputs
+        void generateSamples(Bus* masterBus, std::uint32_t frames, std::uint32_t channels,
+                             std::uint32_t sampleRate, const Listener& listener);
+
+    private:
+        static constexpr std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+
+        void compile(Bus* masterBus) noexcept;
+        void push(std::uint32_t node) noexcept;
+        std::uint32_t pop() noexcept;
+        void work();
+        void workerMain();
+
+        Storage storage;
+        std::size_t nodeCount = 0;
+        Bus* root = nullptr;
+        bool dirty = true;
+
+        // the current job
+        std::uint32_t jobFrames = 0;
+        std::uint32_t jobChannels = 0;
+        std::uint32_t jobSampleRate = 0;
+        const Listener* jobListener = nullptr;
+        std::atomic<std::uint32_t> readIndex{0};
+        std::atomic<std::uint32_t> writeIndex{0};
+        std::atomic<std::size_t> completed{0};
+
+        // guarded by the worker mutex, the workers sleep on the condition until a job starts or the buses
+        // they wait for are ready
+        bool active = false;
+        std::uint64_t generation = 0;
+        std::uint32_t busyWorkers = 0;
+        bool running = true;
+        std::mutex workerMutex;
+        std::condition_variable workerCondition;
+        std::vector<thread::Thread> workers;
+    };
+}
+
+#endif // OUZEL_AUDIO_MIXER_GRAPH_HPP
@@ -0,0 +1,20 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_LISTENER_HPP
+#define OUZEL_AUDIO_MIXER_LISTENER_HPP
+
+#include "../../math/Quaternion.hpp"
+#include "../../math/Vector.hpp"
+
+namespace ouzel::audio::mixer
+{
+    // the point of view that the positional streams are rendered for
+    struct Listener final
+    {
+        Vector3F position;
+        QuaternionF rotation = QuaternionF::identity();
+        Vector3F velocity;
+    };
+}
+
+#endif // OUZEL_AUDIO_MIXER_LISTENER_HPP
@@ -1,9 +1,11 @@
 // Copyright 2015-2020 Elviss Strazdins. All rights reserved.
 
 #include <algorithm>
+#include <cassert>
 #include "Mixer.hpp"
 #include "Bus.hpp"
 #include "Data.hpp"
+#include "Realtime.hpp"
 #include "Stream.hpp"
 #include "../../math/MathUtils.hpp"
 
@@ -11,64 +13,104 @@ namespace ouzel::audio::mixer
 {
     Mixer::Mixer(std::uint32_t initBufferSize,
                  std::uint32_t initChannels,
-                 const std::function<void(const Event&)>& initCallback):
+                 std::uint32_t initSampleRate,
+                 std::uint32_t initLatency,
+                 const std::function<void(const Event&)>& initCallback,
+                 bool initOffline,
+                 std::uint32_t workerCount):
         bufferSize(initBufferSize),
         channels(initChannels),
+        sampleRate(initSampleRate),
+        latency(initLatency ? initLatency : initBufferSize * 2),
         callback(initCallback),
-        mixerThread(&Mixer::mixerMain, this),
-        buffer(initBufferSize * 3, initChannels)
+        offline(initOffline),
+        graph(workerCount),
+        buffer(latency + initBufferSize, initChannels),
+        renderBuffer(initBufferSize * initChannels)
     {
-        //mixerThread.setPriority(20.0F, true);
-
         rootObjectId = getObjectId();
         objects.resize(rootObjectId);
+        playingStreams.reserve(rootObjectId);
+        stoppedStreams.reserve(rootObjectId);
         auto object = std::make_unique<RootObject>();
         rootObject = object.get();
         objects[rootObjectId - 1] = std::move(object);
+
+        if (!offline) mixerThread = thread::Thread(&Mixer::mixerMain, this);
+        //mixerThread.setPriority(20.0F, true);
     }
 
     Mixer::~Mixer()
     {
+        running = false;
+        bufferCondition.notify_all();
+
         if (mixerThread.isJoinable())
             mixerThread.join();
+
+        CommandBuffer* commandBuffer;
+        while (commandQueue.pop(commandBuffer)) delete commandBuffer;
+        while (executedCommandQueue.pop(commandBuffer)) delete commandBuffer;
     }
 
-    void Mixer::process()
+    void Mixer::submitCommandBuffer(CommandBuffer&& commandBuffer)
     {
-        CommandBuffer commandBuffer;
-        std::unique_ptr<Command> command;
+        assert(!realtime::isRealtimeThread());
 
-        for (;;)
+        CommandBuffer* executedCommandBuffer;
+        while (executedCommandQueue.pop(executedCommandBuffer))
         {
-            std::unique_lock lock(commandQueueMutex);
-            if (commandQueue.empty()) break;
-            commandBuffer = std::move(commandQueue.front());
-            commandQueue.pop();
-            lock.unlock();
+            delete executedCommandBuffer;
+            --submittedCommandBuffers;
+        }
 
-            while (!commandBuffer.isEmpty())
-            {
-                command = commandBuffer.popCommand();
+        if (!commandBuffer.isEmpty())
+            pendingCommandBuffers.push(std::make_unique<CommandBuffer>(std::move(commandBuffer)));
 
+        while (!pendingCommandBuffers.empty() && submittedCommandBuffers < commandQueueSize)
+        {
+            commandQueue.push(pendingCommandBuffers.front().release());
+            pendingCommandBuffers.pop();
+            ++submittedCommandBuffers;
+        }
+    }
+
+    void Mixer::process()
+    {
+        CommandBuffer* commandBuffer;
+
+        while (commandQueue.pop(commandBuffer))
+        {
+            for (const auto& command : commandBuffer->getCommands())
+            {
                 switch (command->type)
                 {
                     case Command::Type::initObject:
                     {
                         auto initObjectCommand = static_cast<InitObjectCommand*>(command.get());
-                        objects[initObjectCommand->objectId - 1] = std::make_unique<Object>(std::move(initObjectCommand->source));
+                        objects[initObjectCommand->objectId - 1] = std::move(initObjectCommand->object);
                         break;
                     }
                     case Command::Type::deleteObject:
                     {
-                        auto deleteObjectCommand = static_cast<const DeleteObjectCommand*>(command.get());
-                        objects[deleteObjectCommand->objectId - 1].reset();
+                        auto deleteObjectCommand = static_cast<DeleteObjectCommand*>(command.get());
+                        auto& object = objects[deleteObjectCommand->objectId - 1];
+
+                        if (object)
+                        {
+                            removePlayingStream(deleteObjectCommand->objectId);
+                            if (object.get() == masterBus) masterBus = nullptr;
+                            object->detach();
+                            graph.invalidate();
+                            deleteObjectCommand->object = std::move(object);
+                        }
                         break;
                     }
                     case Command::Type::addChild:
                     {
                         auto addChildCommand = static_cast<const AddChildCommand*>(command.get());
                         Object* object = objects[addChildCommand->objectId - 1].get();
-                        Object* child = objects[addChildCommand->objectId - 1].get();
+                        Object* child = objects[addChildCommand->childId - 1].get();
                         object->addChild(*child);
                         break;
                     }
@@ -76,10 +118,17 @@ namespace ouzel::audio::mixer
                     {
                         auto removeChildCommand = static_cast<const RemoveChildCommand*>(command.get());
                         Object* object = objects[removeChildCommand->objectId - 1].get();
-                        Object* child = objects[removeChildCommand->objectId - 1].get();
+                        Object* child = objects[removeChildCommand->childId - 1].get();
                         object->removeChild(*child);
                         break;
                     }
+                    case Command::Type::reserveChildren:
+                    {
+                        auto reserveChildrenCommand = static_cast<ReserveChildrenCommand*>(command.get());
+                        Object* object = objects[reserveChildrenCommand->objectId - 1].get();
+                        object->reserveChildren(reserveChildrenCommand->children);
+                        break;
+                    }
                     case Command::Type::play:
                     {
                         auto playCommand = static_cast<const PlayCommand*>(command.get());
@@ -96,12 +145,8 @@ namespace ouzel::audio::mixer
                     }
                     case Command::Type::initBus:
                     {
-                        auto initBusCommand = static_cast<const InitBusCommand*>(command.get());
-
-                        if (initBusCommand->busId > objects.size())
-                            objects.resize(initBusCommand->busId);
-
-                        objects[initBusCommand->busId - 1] = std::make_unique<Bus>();
+                        auto initBusCommand = static_cast<InitBusCommand*>(command.get());
+                        objects[initBusCommand->busId - 1] = std::move(initBusCommand->bus);
                         break;
                     }
                     case Command::Type::setBusOutput:
@@ -110,6 +155,17 @@ namespace ouzel::audio::mixer
 
                         auto bus = static_cast<Bus*>(objects[setBusOutputCommand->busId - 1].get());
                         bus->setOutput(setBusOutputCommand->outputBusId ? static_cast<Bus*>(objects[setBusOutputCommand->outputBusId - 1].get()) : nullptr);
+                        graph.invalidate();
+                        break;
+                    }
+                    case Command::Type::reserveBus:
+                    {
+                        auto reserveBusCommand = static_cast<ReserveBusCommand*>(command.get());
+
+                        auto bus = static_cast<Bus*>(objects[reserveBusCommand->busId - 1].get());
+                        bus->reserve(reserveBusCommand->inputBuses,
+                                     reserveBusCommand->inputStreams,
+                                     reserveBusCommand->processors);
                         break;
                     }
                     case Command::Type::addProcessor:
@@ -135,17 +191,13 @@ namespace ouzel::audio::mixer
                         auto setMasterBusCommand = static_cast<const SetMasterBusCommand*>(command.get());
 
                         masterBus = setMasterBusCommand->busId ? static_cast<Bus*>(objects[setMasterBusCommand->busId - 1].get()) : nullptr;
+                        graph.invalidate();
                         break;
                     }
                     case Command::Type::initStream:
                     {
-                        auto initStreamCommand = static_cast<const InitStreamCommand*>(command.get());
-
-                        if (initStreamCommand->streamId > objects.size())
-                            objects.resize(initStreamCommand->streamId);
-
-                        auto data = static_cast<Data*>(objects[initStreamCommand->dataId - 1].get());
-                        objects[initStreamCommand->streamId - 1] = data->createStream();
+                        auto initStreamCommand = static_cast<InitStreamCommand*>(command.get());
+                        objects[initStreamCommand->streamId - 1] = std::move(initStreamCommand->stream);
                         break;
                     }
                     case Command::Type::playStream:
@@ -154,6 +206,9 @@ namespace ouzel::audio::mixer
 
                         auto stream = static_cast<Stream*>(objects[playStreamCommand->streamId - 1].get());
                         stream->play();
+
+                        removePlayingStream(playStreamCommand->streamId);
+                        playingStreams.emplace_back(playStreamCommand->streamId, playStreamCommand->playId);
                         break;
                     }
                     case Command::Type::stopStream:
@@ -162,6 +217,18 @@ namespace ouzel::audio::mixer
 
                         auto stream = static_cast<Stream*>(objects[stopStreamCommand->streamId - 1].get());
                         stream->stop(stopStreamCommand->reset);
+
+                        // streams stopped by the game are not reported
+                        removePlayingStream(stopStreamCommand->streamId);
+                        break;
+                    }
+                    case Command::Type::seekStream:
+                    {
+                        auto seekStreamCommand = static_cast<const SeekStreamCommand*>(command.get());
+
+                        auto stream = static_cast<Stream*>(objects[seekStreamCommand->streamId - 1].get());
+                        stream->seek(seekStreamCommand->frame);
+                        stream->getResampler().reset();
                         break;
                     }
                     case Command::Type::setStreamOutput:
@@ -172,23 +239,40 @@ namespace ouzel::audio::mixer
                         stream->setOutput(setStreamOutputCommand->busId ? static_cast<Bus*>(objects[setStreamOutputCommand->busId - 1].get()) : nullptr);
                         break;
                     }
-                    case Command::Type::initData:
+                    case Command::Type::setStreamGain:
                     {
-                        auto initDataCommand = static_cast<InitDataCommand*>(command.get());
+                        auto setStreamGainCommand = static_cast<const SetStreamGainCommand*>(command.get());
 
-                        if (initDataCommand->dataId > objects.size())
-                            objects.resize(initDataCommand->dataId);
+                        auto stream = static_cast<Stream*>(objects[setStreamGainCommand->streamId - 1].get());
+                        stream->setGain(setStreamGainCommand->gain);
+                        break;
+                    }
+                    case Command::Type::setStreamVirtual:
+                    {
+                        auto setStreamVirtualCommand = static_cast<const SetStreamVirtualCommand*>(command.get());
 
+                        auto stream = static_cast<Stream*>(objects[setStreamVirtualCommand->streamId - 1].get());
+                        stream->setVirtual(setStreamVirtualCommand->isVirtual);
+                        break;
+                    }
+                    case Command::Type::setStreamPosition:
+                    {
+                        auto setStreamPositionCommand = static_cast<const SetStreamPositionCommand*>(command.get());
+
+                        auto stream = static_cast<Stream*>(objects[setStreamPositionCommand->streamId - 1].get());
+                        stream->setPosition(setStreamPositionCommand->position);
+                        stream->setVelocity(setStreamPositionCommand->velocity);
+                        break;
+                    }
+                    case Command::Type::initData:
+                    {
+                        auto initDataCommand = static_cast<InitDataCommand*>(command.get());
                         objects[initDataCommand->dataId - 1] = std::move(initDataCommand->data);
                         break;
                     }
                     case Command::Type::initProcessor:
                     {
                         auto initProcessorCommand = static_cast<InitProcessorCommand*>(command.get());
-
-                        if (initProcessorCommand->processorId > objects.size())
-                            objects.resize(initProcessorCommand->processorId);
-
                         objects[initProcessorCommand->processorId - 1] = std::move(initProcessorCommand->processor);
                         break;
                     }
@@ -197,58 +281,234 @@ namespace ouzel::audio::mixer
                         auto updateProcessorCommand = static_cast<const UpdateProcessorCommand*>(command.get());
 
                         auto processor = static_cast<Processor*>(objects[updateProcessorCommand->processorId - 1].get());
-                        updateProcessorCommand->updateFunction(processor);
+                        updateProcessorCommand->update(processor);
+                        break;
+                    }
+                    case Command::Type::setObjectStorage:
+                    {
+                        auto setObjectStorageCommand = static_cast<SetObjectStorageCommand*>(command.get());
+
+                        std::move(objects.begin(), objects.end(), setObjectStorageCommand->objects.begin());
+                        objects.swap(setObjectStorageCommand->objects);
+                        graph.setStorage(setObjectStorageCommand->graphStorage);
+
+                        // copied into the reserved capacity
+                        setObjectStorageCommand->playingStreams.assign(playingStreams.begin(), playingStreams.end());
+                        playingStreams.swap(setObjectStorageCommand->playingStreams);
+                        setObjectStorageCommand->stoppedStreams.assign(stoppedStreams.begin(), stoppedStreams.end());
+                        stoppedStreams.swap(setObjectStorageCommand->stoppedStreams);
+                        break;
+                    }
+                    case Command::Type::setListener:
+                    {
+                        auto setListenerCommand = static_cast<const SetListenerCommand*>(command.get());
+                        listener = setListenerCommand->listener;
                         break;
                     }
                     default:
-                        throw std::runtime_error("Invalid command");
+                        invalidCommandCount.fetch_add(1, std::memory_order_relaxed);
+                        break;
                 }
             }
+
+            // can not overflow, because no more than commandQueueSize buffers are submitted at a time
+            executedCommandQueue.push(commandBuffer);
         }
     }
 
-    void Mixer::getSamples(std::uint32_t frames, std::uint32_t channelCount, std::uint32_t sampleRate, std::vector<float>& samples)
+    void Mixer::getSamples(std::uint32_t frames, std::uint32_t channelCount, std::uint32_t, std::vector<float>& samples)
     {
-        process();
+        assert(channelCount == channels);
+
+        if (offline)
+        {
+            {
+                realtime::Scope realtimeScope;
+
+                process();
+
+                Timing::Scope renderScope(&renderTiming);
+
+                if (masterBus)
+                {
+                    graph.generateSamples(masterBus, frames, channels, sampleRate, listener);
+                    samples = masterBus->getOutputBuffer();
+                    dsp::clamp(samples.data(), samples.size(), -1.0F, 1.0F);
+                }
+                else
+                {
+                    samples.resize(frames * channelCount);
+                    std::fill(samples.begin(), samples.end(), 0.0F);
+                }
+
+                findStoppedStreams();
+            }
+
+            reportStoppedStreams();
+            return;
+        }
+
+        realtime::Scope realtimeScope;
+
+        const auto now = Timing::Clock::now();
+
+        if (lastCallbackFrames > 0)
+        {
+            const auto interval = now - lastCallbackTime;
+            const auto expected = std::chrono::nanoseconds(std::uint64_t{1000000000} * lastCallbackFrames / sampleRate);
+            const auto deviation = std::chrono::duration_cast<std::chrono::microseconds>(interval > expected ?
+                                                                                          interval - expected :
+                                                                                          expected - interval).count();
+            std::size_t bin = 0;
+            while (bin < jitterBinBounds.size() && deviation >= jitterBinBounds[bin]) ++bin;
+            jitterHistogram[bin].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        lastCallbackTime = now;
+        lastCallbackFrames = frames;
 
         samples.resize(frames * channelCount);
+        const auto readFrames = filled ? buffer.read(samples.data(), frames, frames) : 0;
+
+        if (readFrames < frames)
+        {
+            for (std::uint32_t channel = 0; channel < channelCount; ++channel)
+                std::fill(samples.begin() + channel * frames + readFrames,
+                          samples.begin() + (channel + 1) * frames, 0.0F);
+
+            // silence before the ring is filled for the first time is expected
+            if (filled)
+            {
+                missingFrames.fetch_add(frames - readFrames, std::memory_order_relaxed);
+                starvationTime.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+                starvationCount.fetch_add(1, std::memory_order_release);
+            }
+        }
+
+        // wake up the mixer thread without taking the lock
+        bufferCondition.notify_one();
+    }
+
+    Mixer::Statistics Mixer::takeStatistics() noexcept
+    {
+        Statistics statistics;
+        statistics.renderTiming = renderTiming.take();
+
+        for (std::size_t bin = 0; bin < jitterBinCount; ++bin)
+            statistics.jitterHistogram[bin] = jitterHistogram[bin].exchange(0, std::memory_order_relaxed);
+
+        return statistics;
+    }
+
+    void Mixer::render()
+    {
+        Timing::Scope renderScope(&renderTiming);
 
         if (masterBus)
         {
-            Vector3F listenerPosition;
-            QuaternionF listenerRotation;
+            graph.generateSamples(masterBus, bufferSize, channels, sampleRate, listener);
+
+            auto& samples = masterBus->getOutputBuffer();
+            dsp::clamp(samples.data(), samples.size(), -1.0F, 1.0F);
+            buffer.write(samples.data(), bufferSize, bufferSize);
+
+            findStoppedStreams();
+        }
+        else
+        {
+            std::fill(renderBuffer.begin(), renderBuffer.end(), 0.0F);
+            buffer.write(renderBuffer.data(), bufferSize, bufferSize);
+        }
+    }
+
+    void Mixer::reportStarvation()
+    {
+        const auto currentStarvationCount = starvationCount.load(std::memory_order_acquire);
 
-            masterBus->generateSamples(frames, channelCount, sampleRate,
-                                       listenerPosition, listenerRotation, samples);
+        if (currentStarvationCount != reportedStarvationCount)
+        {
+            Event event(Event::Type::starvation);
+            event.starvationCount = currentStarvationCount - reportedStarvationCount;
+            event.missingFrames = missingFrames.exchange(0, std::memory_order_relaxed);
+            event.time = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(starvationTime.load(std::memory_order_relaxed)));
+            reportedStarvationCount = currentStarvationCount;
+
+            if (callback) callback(event);
         }
+    }
 
-        for (float& sample : samples)
-            sample = std::clamp(sample, -1.0F, 1.0F);
+    void Mixer::findStoppedStreams() noexcept
+    {
+        for (std::size_t i = 0; i < playingStreams.size();)
+        {
+            const auto stream = static_cast<const Stream*>(objects[playingStreams[i].first - 1].get());
+
+            if (!stream->isPlaying())
+            {
+                stoppedStreams.push_back(playingStreams[i]);
+                playingStreams[i] = playingStreams.back();
+                playingStreams.pop_back();
+            }
+            else
+                ++i;
+        }
+    }
+
+    void Mixer::reportStoppedStreams()
+    {
+        for (const auto& [streamId, playId] : stoppedStreams)
+        {
+            Event event(Event::Type::streamStopped);
+            event.objectId = streamId;
+            event.playId = playId;
+
+            if (callback) callback(event);
+        }
+
+        stoppedStreams.clear();
+    }
+
+    void Mixer::removePlayingStream(ObjectId streamId) noexcept
+    {
+        const auto i = std::find_if(playingStreams.begin(), playingStreams.end(),
+                                    [streamId](const auto& playingStream) noexcept {
+                                        return playingStream.first == streamId;
+                                    });
+
+        if (i != playingStreams.end())
+        {
+            *i = playingStreams.back();
+            playingStreams.pop_back();
+        }
     }
 
     void Mixer::mixerMain()
     {
         thread::setCurrentThreadName("Mixer");
 
-        for (;;)
+        // wake up at least once per device buffer in case a notification was missed
+        const auto period = std::chrono::microseconds(std::uint64_t{1000000} * bufferSize / sampleRate);
+
+        while (running)
         {
-            break; // TODO: remove
+            {
+                realtime::Scope realtimeScope;
 
-            /*process();
+                process();
 
-            std::unique_lock lock(bufferMutex);
-            bufferCondition.wait(lock);
+                while (buffer.getFrames() < latency)
+                    render();
 
-            if (masterBus)
-            {
-                //Vector3F listenerPosition;
-                //QuaternionF listenerRotation;
+                filled = true;
+            }
 
-                //masterBus->getData(frames, channels, sampleRate, listenerPosition, listenerRotation, samples);
-            }*/
+            reportStarvation();
+            reportStoppedStreams();
 
-            //for (float& f : samples)
-            //    f = std::clamp(f, -1.0F, 1.0F);
+            std::unique_lock lock(bufferMutex);
+            bufferCondition.wait_for(lock, period, [this]() {
+                return !running || buffer.getFrames() < latency;
+            });
         }
     }
 }
@@ -3,6 +3,9 @@
 #ifndef OUZEL_AUDIO_MIXER_MIXER_HPP
 #define OUZEL_AUDIO_MIXER_MIXER_HPP
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstdint>
 #include <functional>
@@ -12,8 +15,14 @@
 #include <thread>
 #include <vector>
 #include "Commands.hpp"
+#include "Dsp.hpp"
+#include "Graph.hpp"
+#include "Listener.hpp"
 #include "Object.hpp"
 #include "Processor.hpp"
+#include "Queue.hpp"
+#include "RingBuffer.hpp"
+#include "Timing.hpp"
 #include "../../thread/Thread.hpp"
 
 namespace ouzel::audio::mixer
@@ -29,10 +38,7 @@ namespace ouzel::audio::mixer
             for (Object* child : children)
             {
                 child->getSamples(frames, channels, sampleRate, buffer);
-
-                for (std::uint32_t channel = 0; channel < channels; ++channel)
-                    for (std::uint32_t frame = 0; frame < frames; ++frame)
-                        samples[channel * frames + frame] += buffer[channel * frames + frame];
+                dsp::add(samples.data(), buffer.data(), frames * channels);
             }
         }
 
@@ -57,13 +63,27 @@ namespace ouzel::audio::mixer
             Event() noexcept = default;
             explicit Event(Type initType) noexcept: type(initType) {}
 
-            Type type;
-            std::size_t objectId;
+            Type type = Type::streamStarted;
+            std::size_t objectId = 0;
+            std::size_t playId = 0; // of the play command of the stream that stopped by itself
+
+            // starvation events are aggregated, they report the callbacks that were not fully served
+            // since the previous event, the frames that were replaced by silence and when the last one happened
+            std::size_t starvationCount = 0;
+            std::size_t missingFrames = 0;
+            std::chrono::steady_clock::time_point time;
         };
 
+        // the mixer thread renders latency frames ahead of the device (twice the buffer size if zero),
+        // an offline mixer has no thread and renders in getSamples, so that the output does not depend on timing,
+        // the independent buses are generated in parallel by workerCount threads besides the rendering one
         Mixer(std::uint32_t initBufferSize,
               std::uint32_t initChannels,
-              const std::function<void(const Event&)>& initCallback);
+              std::uint32_t initSampleRate,
+              std::uint32_t initLatency,
+              const std::function<void(const Event&)>& initCallback,
+              bool initOffline = false,
+              std::uint32_t workerCount = 0);
 
         ~Mixer();
 
@@ -73,7 +93,21 @@ namespace ouzel::audio::mixer
         Mixer(Mixer&&) = delete;
         Mixer& operator=(Mixer&&) = delete;
 
-        void process();
+        static constexpr std::size_t jitterBinCount = 8;
+        // upper bounds of the jitter histogram bins in microseconds, the last bin has the rest
+        static constexpr std::array<std::int64_t, jitterBinCount - 1> jitterBinBounds{250, 500, 1000, 2000, 4000, 8000, 16000};
+
+        struct Statistics final
+        {
+            Timing::Statistics renderTiming; // of the blocks of the buffer size
+            // deviations of the intervals between the device callbacks from the duration of their frames
+            std::array<std::uint64_t, jitterBinCount> jitterHistogram{};
+        };
+
+        // the statistics since the previous call, can be called from any thread
+        Statistics takeStatistics() noexcept;
+
+        // called by the audio device, only copies the samples rendered by the mixer thread unless offline
         void getSamples(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate, std::vector<float>& samples);
 
         using ObjectId = std::size_t;
@@ -96,24 +130,35 @@ namespace ouzel::audio::mixer
             deletedObjectIds.insert(objectId);
         }
 
-        void submitCommandBuffer(CommandBuffer&& commandBuffer)
-        {
-            std::unique_lock lock(commandQueueMutex);
-            commandQueue.push(std::move(commandBuffer));
-            lock.unlock();
-        }
+        // hands the command buffer over to the mixer and releases the ones it has already executed
+        void submitCommandBuffer(CommandBuffer&& commandBuffer);
 
         auto getRootObjectId() const noexcept
         {
             return rootObjectId;
         }
 
+        // commands of an unknown type are skipped by the mixer and counted here
+        auto getInvalidCommandCount() const noexcept
+        {
+            return invalidCommandCount.load();
+        }
+
     private:
+        void process();
+        void render();
+        void reportStarvation();
+        void findStoppedStreams() noexcept;
+        void reportStoppedStreams();
+        void removePlayingStream(ObjectId streamId) noexcept;
         void mixerMain();
 
         std::uint32_t bufferSize;
         std::uint32_t channels;
+        std::uint32_t sampleRate;
+        std::uint32_t latency;
         std::function<void(const Event&)> callback;
+        bool offline = false;
 
         ObjectId lastObjectId = 0;
         std::set<ObjectId> deletedObjectIds;
@@ -122,37 +167,43 @@ namespace ouzel::audio::mixer
         std::size_t rootObjectId = 0;
         RootObject* rootObject = nullptr;
 
-        Bus* masterBus = nullptr;
-
-        class Buffer final
-        {
-        public:
-            Buffer(std::size_t size, std::uint32_t initChannels):
-                maxFrames(size),
-                channels(initChannels),
-                buffer(size * channels)
-            {
-            }
-
-            bool canRead() const { return frames > 0; }
-            bool canWrite() const { return frames < maxFrames; }
+        // the streams that were started by a command, so that the ones that reach their end can be reported,
+        // both have the capacity of the object table, so they never grow on the mixer thread
+        std::vector<std::pair<ObjectId, std::size_t>> playingStreams;
+        std::vector<std::pair<ObjectId, std::size_t>> stoppedStreams;
 
-        private:
-            std::size_t frames = 0;
-            std::size_t maxFrames;
-            std::uint32_t channels;
-            std::size_t readPosition = 0;
-            std::size_t writePosition = 0;
-            std::vector<float> buffer;
-        };
+        Bus* masterBus = nullptr;
+        Listener listener;
+        Graph graph;
 
-        thread::Thread mixerThread;
         std::mutex bufferMutex;
         std::condition_variable bufferCondition;
-        Buffer buffer;
+        RingBuffer buffer; // written by the mixer thread and read by the audio device
+        std::vector<float> renderBuffer;
+        std::atomic<bool> running{true};
+        std::atomic<bool> filled{false}; // the ring has reached the latency at least once
+
+        std::atomic<std::size_t> starvationCount{0};
+        std::atomic<std::size_t> missingFrames{0};
+        std::atomic<std::chrono::steady_clock::rep> starvationTime{0};
+        std::size_t reportedStarvationCount = 0;
+
+        Timing renderTiming;
+        std::array<std::atomic<std::uint64_t>, jitterBinCount> jitterHistogram{};
+        // only used by the thread of the audio device
+        Timing::Clock::time_point lastCallbackTime;
+        std::uint32_t lastCallbackFrames = 0;
+
+        // command buffers travel to the mixer and back over wait-free queues, so that the mixer
+        // never locks and the buffers (with the objects deleted by them) are freed outside of it
+        static constexpr std::size_t commandQueueSize = 64;
+        Queue<CommandBuffer*> commandQueue{commandQueueSize};
+        Queue<CommandBuffer*> executedCommandQueue{commandQueueSize};
+        std::queue<std::unique_ptr<CommandBuffer>> pendingCommandBuffers;
+        std::size_t submittedCommandBuffers = 0;
+        std::atomic<std::size_t> invalidCommandCount{0};
 
-        std::queue<CommandBuffer> commandQueue;
-        std::mutex commandQueueMutex;
+        thread::Thread mixerThread;
     };
 }
 
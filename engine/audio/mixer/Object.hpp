@@ -3,10 +3,12 @@
 #ifndef OUZEL_AUDIO_MIXER_OBJECT_HPP
 #define OUZEL_AUDIO_MIXER_OBJECT_HPP
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <vector>
 #include "Source.hpp"
+#include "Timing.hpp"
 #include "../../math/Quaternion.hpp"
 #include "../../math/Vector.hpp"
 
@@ -56,12 +58,38 @@ namespace ouzel::audio::mixer
                 const auto i = std::find(children.begin(), children.end(), &child);
                 if (i != children.end())
                 {
-                    child.parent = this;
+                    child.parent = nullptr;
                     children.erase(i);
                 }
             }
         }
 
+        // swaps the list of the children with a larger one allocated outside the mixer
+        void reserveChildren(std::vector<Object*>& newChildren) noexcept
+        {
+            if (newChildren.capacity() > children.capacity())
+            {
+                newChildren.assign(children.begin(), children.end());
+                children.swap(newChildren);
+            }
+        }
+
+        // unlinks the object from the rest of the graph, so that it can be destroyed outside the mixer
+        virtual void detach()
+        {
+            if (parent)
+                parent->removeChild(*this);
+
+            for (auto child : children)
+                child->parent = nullptr;
+
+            children.clear();
+        }
+
+        // shared with the game thread, which reads it while the object is rendered
+        Timing* getTiming() const noexcept { return timing.get(); }
+        void setTiming(std::shared_ptr<Timing> newTiming) noexcept { timing = std::move(newTiming); }
+
         void play()
         {
             if (source)
@@ -88,6 +116,7 @@ namespace ouzel::audio::mixer
         Object* parent = nullptr;
         std::vector<Object*> children;
         std::unique_ptr<Source> source;
+        std::shared_ptr<Timing> timing;
     };
 }
 
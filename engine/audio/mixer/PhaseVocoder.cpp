@@ -0,0 +1,176 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <cmath>
+#include "PhaseVocoder.hpp"
+#include "../../math/Constants.hpp"
+
+namespace ouzel::audio::mixer
+{
+    namespace
+    {
+        // the squared Hann windows of the overlapping frames add up to 1.5
+        constexpr float outputGain = 2.0F / 3.0F;
+        constexpr float peakThreshold = 1e-12F;
+
+        float wrapPhase(float phase) noexcept
+        {
+            return phase - tau<float> * std::round(phase / tau<float>);
+        }
+    }
+
+    PhaseVocoder::PhaseVocoder():
+        fft(frameSize),
+        window(frameSize),
+        frame(frameSize),
+        real(binCount),
+        imaginary(binCount),
+        magnitudes(binCount),
+        shiftedReal(binCount),
+        shiftedImaginary(binCount),
+        rotations(binCount)
+    {
+        for (std::uint32_t i = 0; i < frameSize; ++i)
+            window[i] = 0.5F - 0.5F * std::cos(tau<float> * static_cast<float>(i) / static_cast<float>(frameSize));
+
+        peaks.reserve(binCount);
+    }
+
+    void PhaseVocoder::prepare(std::uint32_t channels)
+    {
+        channelStates.resize(channels);
+        reset();
+    }
+
+    void PhaseVocoder::reset() noexcept
+    {
+        for (auto& channel : channelStates)
+        {
+            std::fill(channel.input.begin(), channel.input.end(), 0.0F);
+            std::fill(channel.output.begin(), channel.output.end(), 0.0F);
+            std::fill(channel.accumulator.begin(), channel.accumulator.end(), 0.0F);
+            std::fill(channel.previousReal.begin(), channel.previousReal.end(), 0.0F);
+            std::fill(channel.previousImaginary.begin(), channel.previousImaginary.end(), 0.0F);
+            std::fill(channel.rotations.begin(), channel.rotations.end(), 0.0F);
+        }
+
+        position = latency;
+    }
+
+    void PhaseVocoder::process(float scale, std::uint32_t frames, float* samples) noexcept
+    {
+        std::uint32_t endPosition = position;
+
+        for (std::size_t channelIndex = 0; channelIndex < channelStates.size(); ++channelIndex)
+        {
+            auto& channel = channelStates[channelIndex];
+            float* channelSamples = samples + channelIndex * frames;
+            std::uint32_t current = position;
+
+            for (std::uint32_t offset = 0; offset < frames;)
+            {
+                const auto count = std::min(frames - offset, frameSize - current);
+
+                std::copy(channelSamples + offset, channelSamples + offset + count, channel.input.begin() + current);
+                std::copy(channel.output.begin() + (current - latency), channel.output.begin() + (current - latency + count),
+                          channelSamples + offset);
+
+                offset += count;
+                current += count;
+
+                if (current == frameSize)
+                {
+                    processFrame(channel, scale);
+                    current = latency;
+                }
+            }
+
+            endPosition = current;
+        }
+
+        position = endPosition;
+    }
+
+    void PhaseVocoder::processFrame(Channel& channel, float scale) noexcept
+    {
+        for (std::uint32_t i = 0; i < frameSize; ++i)
+            frame[i] = channel.input[i] * window[i];
+
+        fft.forward(frame.data(), real.data(), imaginary.data());
+
+        for (std::uint32_t bin = 0; bin < binCount; ++bin)
+            magnitudes[bin] = real[bin] * real[bin] + imaginary[bin] * imaginary[bin];
+
+        peaks.clear();
+        for (std::uint32_t bin = 1; bin + 1 < binCount; ++bin)
+            if (magnitudes[bin] > peakThreshold &&
+                magnitudes[bin] > magnitudes[bin - 1] &&
+                magnitudes[bin] >= magnitudes[bin + 1])
+                peaks.push_back(bin);
+
+        std::fill(shiftedReal.begin(), shiftedReal.end(), 0.0F);
+        std::fill(shiftedImaginary.begin(), shiftedImaginary.end(), 0.0F);
+        std::fill(rotations.begin(), rotations.end(), 0.0F);
+
+        std::uint32_t regionStart = 0;
+
+        for (std::size_t peakIndex = 0; peakIndex < peaks.size(); ++peakIndex)
+        {
+            const auto peak = peaks[peakIndex];
+
+            // the region of a peak ends at the lowest bin before the next peak
+            std::uint32_t regionEnd = binCount;
+            if (peakIndex + 1 < peaks.size())
+            {
+                const auto begin = magnitudes.begin() + peak;
+                const auto end = magnitudes.begin() + peaks[peakIndex + 1];
+                regionEnd = static_cast<std::uint32_t>(std::min_element(begin, end) - magnitudes.begin()) + 1;
+            }
+
+            // the deviation of the phase advance since the previous frame gives the exact frequency of the peak
+            const auto advance = std::atan2(imaginary[peak] * channel.previousReal[peak] - real[peak] * channel.previousImaginary[peak],
+                                            real[peak] * channel.previousReal[peak] + imaginary[peak] * channel.previousImaginary[peak]);
+            const auto expected = tau<float> * static_cast<float>(peak * hopSize) / static_cast<float>(frameSize);
+            const auto frequency = static_cast<float>(peak) + wrapPhase(advance - expected) * static_cast<float>(frameSize) / (tau<float> * static_cast<float>(hopSize));
+
+            // the region is moved by whole bins and the rest of the shift is made by rotating its phase
+            const auto shift = frequency * (scale - 1.0F);
+            const auto rotation = wrapPhase(channel.rotations[peak] +
+                                            tau<float> * shift * static_cast<float>(hopSize) / static_cast<float>(frameSize));
+            const auto binShift = static_cast<std::int32_t>(std::lround(shift));
+            const auto rotationCos = std::cos(rotation);
+            const auto rotationSin = std::sin(rotation);
+
+            for (std::uint32_t bin = regionStart; bin < regionEnd; ++bin)
+            {
+                rotations[bin] = rotation;
+
+                const auto target = static_cast<std::int32_t>(bin) + binShift;
+                if (target < 0 || target >= static_cast<std::int32_t>(binCount)) continue;
+
+                shiftedReal[static_cast<std::size_t>(target)] += real[bin] * rotationCos - imaginary[bin] * rotationSin;
+                shiftedImaginary[static_cast<std::size_t>(target)] += real[bin] * rotationSin + imaginary[bin] * rotationCos;
+            }
+
+            regionStart = regionEnd;
+        }
+
+        shiftedImaginary[0] = 0.0F;
+        shiftedImaginary[binCount - 1] = 0.0F;
+
+        channel.previousReal.swap(real);
+        channel.previousImaginary.swap(imaginary);
+        channel.rotations.swap(rotations);
+
+        fft.inverse(shiftedReal.data(), shiftedImaginary.data(), frame.data());
+
+        for (std::uint32_t i = 0; i < frameSize; ++i)
+            channel.accumulator[i] += frame[i] * window[i] * outputGain;
+
+        std::copy(channel.accumulator.begin(), channel.accumulator.begin() + hopSize, channel.output.begin());
+        std::copy(channel.accumulator.begin() + hopSize, channel.accumulator.end(), channel.accumulator.begin());
+        std::fill(channel.accumulator.end() - hopSize, channel.accumulator.end(), 0.0F);
+
+        std::copy(channel.input.begin() + hopSize, channel.input.end(), channel.input.begin());
+    }
+}
@@ -0,0 +1,67 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_PHASEVOCODER_HPP
+#define OUZEL_AUDIO_MIXER_PHASEVOCODER_HPP
+
+#include <cstdint>
+#include <vector>
+#include "Fft.hpp"
+
+namespace ouzel::audio::mixer
+{
+    // pitch scaler that moves the regions around the spectral peaks to the scaled frequencies,
+    // every bin of a region is rotated by the phase of its peak (identity phase locking),
+    // so that the partials keep their shape and do not smear
+    class PhaseVocoder final
+    {
+    public:
+        static constexpr std::uint32_t frameSize = 1024;
+        static constexpr std::uint32_t overlap = 4;
+        static constexpr std::uint32_t hopSize = frameSize / overlap;
+        static constexpr std::uint32_t binCount = frameSize / 2 + 1;
+        static constexpr std::uint32_t latency = frameSize - hopSize;
+
+        PhaseVocoder();
+
+        bool isPrepared(std::uint32_t channels) const noexcept
+        {
+            return channels == channelStates.size();
+        }
+
+        void prepare(std::uint32_t channels);
+        void reset() noexcept;
+
+        // scales the pitch of the planar samples in place, the output is delayed by latency frames
+        void process(float scale, std::uint32_t frames, float* samples) noexcept;
+
+    private:
+        struct Channel final
+        {
+            std::vector<float> input = std::vector<float>(frameSize);
+            std::vector<float> output = std::vector<float>(hopSize);
+            std::vector<float> accumulator = std::vector<float>(frameSize);
+            std::vector<float> previousReal = std::vector<float>(binCount);
+            std::vector<float> previousImaginary = std::vector<float>(binCount);
+            std::vector<float> rotations = std::vector<float>(binCount);
+        };
+
+        void processFrame(Channel& channel, float scale) noexcept;
+
+        Fft fft;
+        std::vector<float> window;
+        std::vector<Channel> channelStates;
+        std::uint32_t position = latency;
+
+        // scratch buffers shared by the channels
+        std::vector<float> frame;
+        std::vector<float> real;
+        std::vector<float> imaginary;
+        std::vector<float> magnitudes;
+        std::vector<float> shiftedReal;
+        std::vector<float> shiftedImaginary;
+        std::vector<float> rotations;
+        std::vector<std::uint32_t> peaks;
+    };
+}
+
+#endif // OUZEL_AUDIO_MIXER_PHASEVOCODER_HPP
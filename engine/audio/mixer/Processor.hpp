@@ -24,11 +24,18 @@ namespace ouzel::audio::mixer
         Processor(Processor&&) = delete;
         Processor& operator=(Processor&&) = delete;
 
+        void detach() override
+        {
+            if (bus) bus->removeProcessor(this);
+
+            Object::detach();
+        }
+
         virtual void process(std::uint32_t frames, std::uint32_t channels, std::uint32_t sampleRate,
                              std::vector<float>& samples) = 0;
 
         auto isEnabled() const noexcept { return enabled; }
-        void setEnabled(bool newEnabled) { enabled = newEnabled; }
+        void setEnabled(bool newEnabled) noexcept { enabled = newEnabled; }
 
     private:
         Bus* bus = nullptr;
@@ -0,0 +1,67 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_QUEUE_HPP
+#define OUZEL_AUDIO_MIXER_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace ouzel::audio::mixer
+{
+    // wait-free queue with a fixed capacity for exactly one producer and one consumer thread
+    template <class T>
+    class Queue final
+    {
+    public:
+        explicit Queue(std::size_t capacity):
+            buffer(capacity + 1)
+        {
+        }
+
+        Queue(const Queue&) = delete;
+        Queue& operator=(const Queue&) = delete;
+
+        Queue(Queue&&) = delete;
+        Queue& operator=(Queue&&) = delete;
+
+        // returns false if the queue is full, may be called only by the producer
+        bool push(T value) noexcept
+        {
+            const auto currentWritePosition = writePosition.load(std::memory_order_relaxed);
+            const auto nextWritePosition = next(currentWritePosition);
+
+            if (nextWritePosition == readPosition.load(std::memory_order_acquire))
+                return false;
+
+            buffer[currentWritePosition] = std::move(value);
+            writePosition.store(nextWritePosition, std::memory_order_release);
+            return true;
+        }
+
+        // returns false if the queue is empty, may be called only by the consumer
+        bool pop(T& value) noexcept
+        {
+            const auto currentReadPosition = readPosition.load(std::memory_order_relaxed);
+
+            if (currentReadPosition == writePosition.load(std::memory_order_acquire))
+                return false;
+
+            value = std::move(buffer[currentReadPosition]);
+            readPosition.store(next(currentReadPosition), std::memory_order_release);
+            return true;
+        }
+
+    private:
+        std::size_t next(std::size_t position) const noexcept
+        {
+            return (position + 1 == buffer.size()) ? 0 : position + 1;
+        }
+
+        std::vector<T> buffer;
+        alignas(64) std::atomic<std::size_t> readPosition{0};
+        alignas(64) std::atomic<std::size_t> writePosition{0};
+    };
+}
+
+#endif // OUZEL_AUDIO_MIXER_QUEUE_HPP
@@ -0,0 +1,58 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#include <atomic>
+#include "Realtime.hpp"
+
+namespace ouzel::audio::mixer::realtime
+{
+    namespace
+    {
+        thread_local bool realtimeThread = false;
+        std::atomic<bool> checksEnabled{false};
+        std::atomic<std::size_t> allocationCount{0};
+        std::atomic<std::size_t> blockCount{0};
+    }
+
+    void setChecksEnabled(bool enabled) noexcept
+    {
+        checksEnabled = enabled;
+    }
+
+    std::size_t getAllocationCount() noexcept
+    {
+        return allocationCount;
+    }
+
+    std::size_t getBlockCount() noexcept
+    {
+        return blockCount;
+    }
+
+    bool isRealtimeThread() noexcept
+    {
+        return realtimeThread;
+    }
+
+    Scope::Scope() noexcept:
+        previous(realtimeThread)
+    {
+        realtimeThread = true;
+    }
+
+    Scope::~Scope()
+    {
+        realtimeThread = previous;
+    }
+
+    void countAllocation() noexcept
+    {
+        if (realtimeThread && checksEnabled.load(std::memory_order_relaxed))
+            allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void countBlock() noexcept
+    {
+        if (realtimeThread && checksEnabled.load(std::memory_order_relaxed))
+            blockCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,66 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_REALTIME_HPP
+#define OUZEL_AUDIO_MIXER_REALTIME_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace ouzel::audio::mixer::realtime
+{
+    // when enabled, heap allocations and blocking waits performed inside a real-time scope are counted,
+    // allocations are only seen if the engine is built with DEBUG_AUDIO=1, which links AllocationHook.cpp
+    // that replaces the global allocation functions
+    void setChecksEnabled(bool enabled) noexcept;
+    std::size_t getAllocationCount() noexcept;
+    std::size_t getBlockCount() noexcept;
+    void countAllocation() noexcept;
+    void countBlock() noexcept;
+
+    bool isRealtimeThread() noexcept;
+
+    // locks the mutex, the lock is counted if the mutex is held by another thread
+    inline std::unique_lock<std::mutex> lock(std::mutex& mutex)
+    {
+        std::unique_lock<std::mutex> result(mutex, std::try_to_lock);
+
+        if (!result.owns_lock())
+        {
+            countBlock();
+            result.lock();
+        }
+
+        return result;
+    }
+
+    // waits on the condition until the predicate is satisfied, the wait is counted if the thread has to sleep
+    template <class Predicate>
+    void wait(std::condition_variable& condition, std::unique_lock<std::mutex>& lock, Predicate predicate)
+    {
+        if (!predicate())
+        {
+            countBlock();
+            condition.wait(lock, predicate);
+        }
+    }
+
+    // marks the current thread as real-time for the lifetime of the scope
+    class Scope final
+    {
+    public:
+        Scope() noexcept;
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        Scope(Scope&&) = delete;
+        Scope& operator=(Scope&&) = delete;
+
+    private:
+        bool previous;
+    };
+}
+
+#endif // OUZEL_AUDIO_MIXER_REALTIME_HPP
@@ -0,0 +1,212 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <utility>
+#include "Resampler.hpp"
+#include "Dsp.hpp"
+#include "../../math/Constants.hpp"
+
+namespace ouzel::audio::mixer
+{
+    namespace
+    {
+        struct Design final
+        {
+            std::uint32_t taps;
+            std::uint32_t phases;
+            double passband; // fraction of the Nyquist frequency
+            double beta; // Kaiser window shape
+        };
+
+        Design getDesign(ResamplerQuality quality) noexcept
+        {
+            switch (quality)
+            {
+                case ResamplerQuality::low: return Design{8, 32, 0.85, 5.0};
+                case ResamplerQuality::high: return Design{32, 256, 0.95, 9.0};
+                case ResamplerQuality::medium:
+                default: return Design{16, 128, 0.91, 7.0};
+            }
+        }
+
+        // the ratio is kept with this many steps per frame, so that the pitch can be changed smoothly
+        constexpr std::uint64_t pitchPrecision = 4096;
+
+        // zeroth-order modified Bessel function of the first kind
+        double besselI0(double x) noexcept
+        {
+            double result = 1.0;
+            double term = 1.0;
+
+            for (std::uint32_t k = 1; k < 32; ++k)
+            {
+                term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                result += term;
+                if (term < result * 1e-12) break;
+            }
+
+            return result;
+        }
+
+        std::shared_ptr<const Resampler::Filter> createFilter(const Design& design, double cutoff)
+        {
+            auto filter = std::make_shared<Resampler::Filter>();
+            filter->taps = design.taps;
+            filter->phases = design.phases;
+            filter->coefficients.resize((design.phases + 1) * design.taps);
+
+            const double halfTaps = design.taps / 2.0;
+            const double windowNormalization = besselI0(design.beta);
+            std::vector<double> values(design.taps);
+
+            for (std::uint32_t phase = 0; phase <= design.phases; ++phase)
+            {
+                const auto row = &filter->coefficients[phase * design.taps];
+                const double offset = static_cast<double>(phase) / design.phases;
+                double sum = 0.0;
+
+                for (std::uint32_t tap = 0; tap < design.taps; ++tap)
+                {
+                    // distance of the tap from the interpolated position
+                    const double x = tap - (halfTaps - 1.0) - offset;
+                    const double sinc = (x == 0.0) ? 1.0 : std::sin(pi<double> * cutoff * x) / (pi<double> * cutoff * x);
+                    const double r = x / halfTaps;
+                    const double window = (r * r < 1.0) ? besselI0(design.beta * std::sqrt(1.0 - r * r)) / windowNormalization : 0.0;
+                    values[tap] = sinc * window;
+                    sum += values[tap];
+                }
+
+                // unity gain at DC for every phase
+                for (std::uint32_t tap = 0; tap < design.taps; ++tap)
+                    row[tap] = static_cast<float>(values[tap] / sum);
+            }
+
+            return filter;
+        }
+
+        std::shared_ptr<const Resampler::Filter> getFilter(std::uint32_t sourceSampleRate,
+                                                           std::uint32_t sampleRate,
+                                                           ResamplerQuality quality,
+                                                           float pitch)
+        {
+            static std::mutex filterMutex;
+            static std::map<std::pair<ResamplerQuality, double>, std::shared_ptr<const Resampler::Filter>> filters;
+
+            const auto design = getDesign(quality);
+
+            // every upsampling ratio shares the same filter, downsampling (also by raising the pitch) lowers the cutoff
+            const double cutoff = design.passband * std::min(1.0, static_cast<double>(sampleRate) /
+                                                             (static_cast<double>(sourceSampleRate) * static_cast<double>(pitch)));
+
+            std::lock_guard lock(filterMutex);
+
+            auto& filter = filters[std::make_pair(quality, cutoff)];
+            if (!filter) filter = createFilter(design, cutoff);
+            return filter;
+        }
+    }
+
+    void Resampler::precomputeFilters(std::uint32_t sampleRate, ResamplerQuality quality)
+    {
+        // the matching rates are resampled too when the pitch is raised
+        for (const std::uint32_t sourceSampleRate : {22050U, 32000U, 44100U, 48000U, 88200U, 96000U})
+            for (const float bandPitch : bandPitches)
+                getFilter(sourceSampleRate, sampleRate, quality, bandPitch);
+    }
+
+    void Resampler::prepare(std::uint32_t sourceSampleRate, std::uint32_t sampleRate, std::uint32_t channels,
+                            std::uint32_t maxFrames)
+    {
+        for (std::size_t band = 0; band < bandPitches.size(); ++band)
+            filters[band] = getFilter(sourceSampleRate, sampleRate, quality, bandPitches[band]);
+        filter = filters.front().get();
+
+        currentSourceSampleRate = sourceSampleRate;
+        currentSampleRate = sampleRate;
+        currentChannels = channels;
+
+        const auto divisor = std::gcd(sourceSampleRate, sampleRate);
+        baseStep = sourceSampleRate / divisor * pitchPrecision;
+        step = baseStep;
+        denominator = sampleRate / divisor * pitchPrecision;
+
+        history.resize(filter->taps * channels);
+        buffer.reserve(filter->taps + getMaxSourceFrames(maxFrames) + 1);
+        reset();
+    }
+
+    void Resampler::reset() noexcept
+    {
+        fraction = 0;
+        std::fill(history.begin(), history.end(), 0.0F);
+    }
+
+    void Resampler::setPitch(float pitch) noexcept
+    {
+        step = std::max(std::uint64_t{1}, static_cast<std::uint64_t>(std::llround(static_cast<double>(baseStep) * static_cast<double>(pitch))));
+
+        // the first band whose highest pitch is not below the pitch
+        std::size_t band = 0;
+        while (band + 1 < bandPitches.size() && pitch > bandPitches[band]) ++band;
+        if (filters[band]) filter = filters[band].get();
+    }
+
+    std::uint32_t Resampler::skip(std::uint32_t frames) noexcept
+    {
+        const auto sourceFrames = getSourceFrames(frames);
+        fraction = (fraction + std::uint64_t{frames} * step) % denominator;
+
+        // the skipped source frames are never seen, so the history would be stale anyway
+        std::fill(history.begin(), history.end(), 0.0F);
+
+        return sourceFrames;
+    }
+
+    void Resampler::process(std::uint32_t sourceFrames, const float* source,
+                            std::uint32_t frames, float* output)
+    {
+        const auto taps = filter->taps;
+        const auto phases = filter->phases;
+        const auto coefficients = filter->coefficients.data();
+
+        // the history followed by the new source frames
+        buffer.resize(taps + sourceFrames);
+
+        std::uint64_t endFraction = fraction;
+
+        for (std::uint32_t channel = 0; channel < currentChannels; ++channel)
+        {
+            const auto channelHistory = &history[channel * taps];
+            std::copy(channelHistory, channelHistory + taps, buffer.begin());
+            std::copy(source + channel * sourceFrames, source + (channel + 1) * sourceFrames, buffer.begin() + taps);
+
+            const auto outputChannel = output + channel * frames;
+            std::uint64_t position = fraction;
+
+            for (std::uint32_t frame = 0; frame < frames; ++frame)
+            {
+                const auto index = position / denominator;
+                const auto phasePosition = static_cast<double>(position % denominator) * phases / denominator;
+                const auto phase = static_cast<std::uint32_t>(phasePosition);
+                const auto weight = static_cast<float>(phasePosition - phase);
+
+                const auto window = buffer.data() + index;
+                const auto current = dsp::dot(window, coefficients + phase * taps, taps);
+                const auto next = dsp::dot(window, coefficients + (phase + 1) * taps, taps);
+                outputChannel[frame] = current + (next - current) * weight;
+
+                position += step;
+            }
+
+            std::copy(buffer.end() - taps, buffer.end(), channelHistory);
+            endFraction = position;
+        }
+
+        // keep only the fractional part, the consumed frames are in the history now
+        fraction = endFraction - std::uint64_t{sourceFrames} * denominator;
+    }
+}
@@ -0,0 +1,104 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_RESAMPLER_HPP
+#define OUZEL_AUDIO_MIXER_RESAMPLER_HPP
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "../ResamplerQuality.hpp"
+
+namespace ouzel::audio::mixer
+{
+    // polyphase windowed-sinc sample rate converter that keeps its phase and history between blocks
+    class Resampler final
+    {
+    public:
+        struct Filter final
+        {
+            std::uint32_t taps = 0;
+            std::uint32_t phases = 0;
+            std::vector<float> coefficients; // (phases + 1) rows of taps coefficients
+        };
+
+        // builds the filters for the usual source sample rates and all the pitch bands, so that the streams share them
+        static void precomputeFilters(std::uint32_t sampleRate, ResamplerQuality quality);
+
+        auto getQuality() const noexcept { return quality; }
+        void setQuality(ResamplerQuality newQuality) noexcept { quality = newQuality; }
+
+        bool isPrepared(std::uint32_t sourceSampleRate, std::uint32_t sampleRate,
+                        std::uint32_t channels) const noexcept
+        {
+            return filter &&
+                sourceSampleRate == currentSourceSampleRate &&
+                sampleRate == currentSampleRate &&
+                channels == currentChannels;
+        }
+
+        // the output lags behind the source by this many source frames
+        std::uint32_t getDelay() const noexcept { return filter ? filter->taps / 2 + 1 : 0; }
+
+        // locks and allocates, so it must never be called on the mixer thread, the streams are prepared before
+        // they are handed over to the mixer, maxFrames is the largest block that will be processed without allocating
+        void prepare(std::uint32_t sourceSampleRate, std::uint32_t sampleRate, std::uint32_t channels,
+                     std::uint32_t maxFrames = 0);
+        void reset() noexcept;
+
+        // scales the conversion ratio, e.g. for the Doppler shift, takes effect from the next block,
+        // switches to the filter of the pitch band, so that the raised pitch does not alias
+        void setPitch(float pitch) noexcept;
+
+        // advances the phase as if frames were processed, returns the number of source frames to skip
+        std::uint32_t skip(std::uint32_t frames) noexcept;
+
+        // the number of source frames process will consume to produce the given number of frames
+        std::uint32_t getSourceFrames(std::uint32_t frames) const noexcept
+        {
+            return static_cast<std::uint32_t>((fraction + std::uint64_t{frames} * step) / denominator);
+        }
+
+        // the most source frames process can consume to produce the given number of frames at the highest pitch
+        std::uint32_t getMaxSourceFrames(std::uint32_t frames) const noexcept
+        {
+            const auto maxStep = static_cast<std::uint64_t>(std::llround(static_cast<double>(baseStep) *
+                                                                         static_cast<double>(bandPitches.back())));
+            return static_cast<std::uint32_t>((denominator - 1 + std::uint64_t{frames} * maxStep) / denominator);
+        }
+
+        // the largest number of frames process can produce from the given number of source frames
+        std::uint32_t getFrames(std::uint32_t sourceFrames) const noexcept
+        {
+            return static_cast<std::uint32_t>(((std::uint64_t{sourceFrames} + 1) * denominator - fraction - 1) / step);
+        }
+
+        // source and output are planar, source must hold getSourceFrames(frames) frames
+        void process(std::uint32_t sourceFrames, const float* source,
+                     std::uint32_t frames, float* output);
+
+    private:
+        // the upper bounds of the pitch bands, every band uses the cutoff of its highest pitch
+        static constexpr std::array<float, 5> bandPitches{1.0F, 1.25F, 1.5F, 1.75F, 2.0F};
+
+        ResamplerQuality quality = ResamplerQuality::medium;
+        std::array<std::shared_ptr<const Filter>, bandPitches.size()> filters;
+        const Filter* filter = nullptr; // the filter of the current pitch band
+
+        std::uint32_t currentSourceSampleRate = 0;
+        std::uint32_t currentSampleRate = 0;
+        std::uint32_t currentChannels = 0;
+
+        // the read position advances by step / denominator source frames per output frame
+        std::uint64_t baseStep = 1; // step without the pitch
+        std::uint64_t step = 1;
+        std::uint64_t denominator = 1;
+        std::uint64_t fraction = 0;
+
+        std::vector<float> history; // last taps source frames of every channel
+        std::vector<float> buffer;
+    };
+}
+
+#endif // OUZEL_AUDIO_MIXER_RESAMPLER_HPP
@@ -0,0 +1,241 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#if defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#elif defined(__SSE__)
+#  include <xmmintrin.h>
+#endif
+#include <algorithm>
+#include <cmath>
+#include "Reverberator.hpp"
+#include "Dsp.hpp"
+#include "../../core/Engine.hpp"
+
+namespace ouzel::audio::mixer
+{
+    namespace
+    {
+        // mutually prime ratios of the comb lengths to the longest one
+        constexpr float combRatios[Reverberator::combCount] = {1.0F, 0.8733F, 0.7617F, 0.6597F};
+        constexpr float allpassDelays[Reverberator::allpassCount] = {0.0126F, 0.0051F}; // seconds
+        constexpr float allpassGain = 0.5F;
+        constexpr float damping = 0.2F;
+        constexpr float stereoSpread = 0.00052F; // seconds added to the delays of every other channel
+        constexpr float wetGain = 1.0F / Reverberator::combCount;
+        constexpr std::uint32_t blockSize = 256;
+    }
+
+    void Reverberator::prepare(std::uint32_t sampleRate, std::uint32_t channels, float delay, float decay)
+    {
+        currentSampleRate = sampleRate;
+        channelStates.resize(channels);
+
+        const auto feedback = std::clamp(decay, 0.0F, 0.99F);
+
+        for (std::uint32_t channelIndex = 0; channelIndex < channels; ++channelIndex)
+        {
+            auto& channel = channelStates[channelIndex];
+            const auto spread = (channelIndex % 2) ? stereoSpread : 0.0F;
+
+            for (std::size_t comb = 0; comb < combCount; ++comb)
+            {
+                const auto length = static_cast<std::uint32_t>((delay * combRatios[comb] + spread) * static_cast<float>(sampleRate));
+                channel.combLines[comb].assign(std::max(length, 1U), 0.0F);
+                channel.combPositions[comb] = 0;
+                channel.combFilters[comb] = 0.0F;
+
+                // the shorter combs recirculate more often, so they get less feedback to decay at the same rate
+                channel.combFeedbacks[comb] = std::pow(feedback, combRatios[comb]);
+            }
+
+            for (std::size_t allpass = 0; allpass < allpassCount; ++allpass)
+            {
+                const auto length = static_cast<std::uint32_t>((allpassDelays[allpass] + spread) * static_cast<float>(sampleRate));
+                channel.allpassLines[allpass].assign(std::max(length, 1U), 0.0F);
+                channel.allpassPositions[allpass] = 0;
+            }
+        }
+    }
+
+    void Reverberator::reset() noexcept
+    {
+        for (auto& channel : channelStates)
+        {
+            for (auto& line : channel.combLines)
+                std::fill(line.begin(), line.end(), 0.0F);
+            channel.combPositions.fill(0);
+            channel.combFilters.fill(0.0F);
+
+            for (auto& line : channel.allpassLines)
+                std::fill(line.begin(), line.end(), 0.0F);
+            channel.allpassPositions.fill(0);
+        }
+    }
+
+    void Reverberator::process(std::uint32_t frames, float* samples) noexcept
+    {
+        float wet[blockSize];
+
+        for (std::size_t channelIndex = 0; channelIndex < channelStates.size(); ++channelIndex)
+        {
+            auto& channel = channelStates[channelIndex];
+            float* channelSamples = samples + channelIndex * frames;
+
+            for (std::uint32_t offset = 0; offset < frames; offset += blockSize)
+            {
+                const auto count = std::min(frames - offset, blockSize);
+
+                processCombs(channel, channelSamples + offset, wet, count);
+
+                for (std::size_t allpass = 0; allpass < allpassCount; ++allpass)
+                    processAllpass(channel.allpassLines[allpass], channel.allpassPositions[allpass], wet, count);
+
+                dsp::addScaled(channelSamples + offset, wet, wetGain, count);
+            }
+        }
+    }
+
+    // the combs are recursive in time, so they are vectorized across the bank
+    void Reverberator::processCombs(Channel& channel, const float* input, float* output, std::uint32_t frames) noexcept
+    {
+        float* lines[combCount];
+        std::uint32_t sizes[combCount];
+        for (std::size_t comb = 0; comb < combCount; ++comb)
+        {
+            lines[comb] = channel.combLines[comb].data();
+            sizes[comb] = static_cast<std::uint32_t>(channel.combLines[comb].size());
+        }
+
+        auto& positions = channel.combPositions;
+        std::uint32_t frame = 0;
+
+        if (core::isSimdAvailable)
+        {
+#if defined(__ARM_NEON__)
+            alignas(16) float delayed[combCount];
+            alignas(16) float written[combCount];
+
+            const float32x4_t feedbacks = vld1q_f32(channel.combFeedbacks.data());
+            const float32x4_t damp = vdupq_n_f32(damping);
+            const float32x4_t undamp = vdupq_n_f32(1.0F - damping);
+            float32x4_t filters = vld1q_f32(channel.combFilters.data());
+
+            for (; frame < frames; ++frame)
+            {
+                for (std::size_t comb = 0; comb < combCount; ++comb)
+                    delayed[comb] = lines[comb][positions[comb]];
+
+                const float32x4_t d = vld1q_f32(delayed);
+                filters = vmlaq_f32(vmulq_f32(d, undamp), filters, damp);
+                vst1q_f32(written, vmlaq_f32(vdupq_n_f32(input[frame]), filters, feedbacks));
+
+                for (std::size_t comb = 0; comb < combCount; ++comb)
+                {
+                    lines[comb][positions[comb]] = written[comb];
+                    if (++positions[comb] == sizes[comb]) positions[comb] = 0;
+                }
+
+                output[frame] = delayed[0] + delayed[1] + delayed[2] + delayed[3];
+            }
+
+            vst1q_f32(channel.combFilters.data(), filters);
+#elif defined(__SSE__)
+            alignas(16) float delayed[combCount];
+            alignas(16) float written[combCount];
+
+            const __m128 feedbacks = _mm_loadu_ps(channel.combFeedbacks.data());
+            const __m128 damp = _mm_set1_ps(damping);
+            const __m128 undamp = _mm_set1_ps(1.0F - damping);
+            __m128 filters = _mm_loadu_ps(channel.combFilters.data());
+
+            for (; frame < frames; ++frame)
+            {
+                for (std::size_t comb = 0; comb < combCount; ++comb)
+                    delayed[comb] = lines[comb][positions[comb]];
+
+                const __m128 d = _mm_load_ps(delayed);
+                filters = _mm_add_ps(_mm_mul_ps(d, undamp), _mm_mul_ps(filters, damp));
+                _mm_store_ps(written, _mm_add_ps(_mm_set1_ps(input[frame]), _mm_mul_ps(filters, feedbacks)));
+
+                for (std::size_t comb = 0; comb < combCount; ++comb)
+                {
+                    lines[comb][positions[comb]] = written[comb];
+                    if (++positions[comb] == sizes[comb]) positions[comb] = 0;
+                }
+
+                output[frame] = delayed[0] + delayed[1] + delayed[2] + delayed[3];
+            }
+
+            _mm_storeu_ps(channel.combFilters.data(), filters);
+#endif
+        }
+
+        for (; frame < frames; ++frame)
+        {
+            float sum = 0.0F;
+
+            for (std::size_t comb = 0; comb < combCount; ++comb)
+            {
+                const float delayed = lines[comb][positions[comb]];
+                channel.combFilters[comb] = delayed * (1.0F - damping) + channel.combFilters[comb] * damping;
+                lines[comb][positions[comb]] = input[frame] + channel.combFilters[comb] * channel.combFeedbacks[comb];
+                if (++positions[comb] == sizes[comb]) positions[comb] = 0;
+
+                sum += delayed;
+            }
+
+            output[frame] = sum;
+        }
+    }
+
+    // a sample written to the line is read back only after a full loop, so the frames of a chunk
+    // that does not wrap around are independent and vectorized in time
+    void Reverberator::processAllpass(std::vector<float>& line, std::uint32_t& position,
+                                      float* samples, std::uint32_t frames) noexcept
+    {
+        const auto size = static_cast<std::uint32_t>(line.size());
+
+        for (std::uint32_t frame = 0; frame < frames;)
+        {
+            const auto count = std::min(frames - frame, size - position);
+            float* delayed = line.data() + position;
+            float* current = samples + frame;
+            std::uint32_t i = 0;
+
+            if (core::isSimdAvailable)
+            {
+#if defined(__ARM_NEON__)
+                const float32x4_t gain = vdupq_n_f32(allpassGain);
+                for (; i + 4 <= count; i += 4)
+                {
+                    const float32x4_t d = vld1q_f32(delayed + i);
+                    const float32x4_t v = vmlaq_f32(vld1q_f32(current + i), d, gain);
+                    vst1q_f32(delayed + i, v);
+                    vst1q_f32(current + i, vmlsq_f32(d, v, gain));
+                }
+#elif defined(__SSE__)
+                const __m128 gain = _mm_set1_ps(allpassGain);
+                for (; i + 4 <= count; i += 4)
+                {
+                    const __m128 d = _mm_loadu_ps(delayed + i);
+                    const __m128 v = _mm_add_ps(_mm_loadu_ps(current + i), _mm_mul_ps(d, gain));
+                    _mm_storeu_ps(delayed + i, v);
+                    _mm_storeu_ps(current + i, _mm_sub_ps(d, _mm_mul_ps(v, gain)));
+                }
+#endif
+            }
+
+            for (; i < count; ++i)
+            {
+                const float d = delayed[i];
+                const float v = current[i] + d * allpassGain;
+                delayed[i] = v;
+                current[i] = d - v * allpassGain;
+            }
+
+            frame += count;
+            position += count;
+            if (position == size) position = 0;
+        }
+    }
+}
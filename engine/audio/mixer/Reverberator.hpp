@@ -0,0 +1,53 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_REVERBERATOR_HPP
+#define OUZEL_AUDIO_MIXER_REVERBERATOR_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace ouzel::audio::mixer
+{
+    // Schroeder reverberator: parallel low-pass feedback combs followed by series all-pass filters
+    class Reverberator final
+    {
+    public:
+        static constexpr std::size_t combCount = 4;
+        static constexpr std::size_t allpassCount = 2;
+
+        bool isPrepared(std::uint32_t sampleRate, std::uint32_t channels) const noexcept
+        {
+            return sampleRate == currentSampleRate && channels == channelStates.size();
+        }
+
+        // allocates the delay lines, delay is the length of the longest comb in seconds and
+        // decay is the gain of its feedback
+        void prepare(std::uint32_t sampleRate, std::uint32_t channels, float delay, float decay);
+        void reset() noexcept;
+
+        // adds the reverberated signal to the planar samples
+        void process(std::uint32_t frames, float* samples) noexcept;
+
+    private:
+        struct Channel final
+        {
+            std::array<std::vector<float>, combCount> combLines;
+            std::array<std::uint32_t, combCount> combPositions{};
+            alignas(16) std::array<float, combCount> combFilters{};
+            alignas(16) std::array<float, combCount> combFeedbacks{};
+
+            std::array<std::vector<float>, allpassCount> allpassLines;
+            std::array<std::uint32_t, allpassCount> allpassPositions{};
+        };
+
+        void processCombs(Channel& channel, const float* input, float* output, std::uint32_t frames) noexcept;
+        static void processAllpass(std::vector<float>& line, std::uint32_t& position,
+                                   float* samples, std::uint32_t frames) noexcept;
+
+        std::uint32_t currentSampleRate = 0;
+        std::vector<Channel> channelStates;
+    };
+}
+
+#endif // OUZEL_AUDIO_MIXER_REVERBERATOR_HPP
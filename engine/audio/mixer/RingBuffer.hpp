@@ -0,0 +1,83 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_RINGBUFFER_HPP
+#define OUZEL_AUDIO_MIXER_RINGBUFFER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace ouzel::audio::mixer
+{
+    // wait-free ring of interleaved frames for one producer and one consumer thread
+    class RingBuffer final
+    {
+    public:
+        RingBuffer(std::size_t size, std::uint32_t initChannels):
+            maxFrames(size),
+            channels(initChannels),
+            buffer(size * channels)
+        {
+        }
+
+        RingBuffer(const RingBuffer&) = delete;
+        RingBuffer& operator=(const RingBuffer&) = delete;
+
+        RingBuffer(RingBuffer&&) = delete;
+        RingBuffer& operator=(RingBuffer&&) = delete;
+
+        auto getMaxFrames() const noexcept { return maxFrames; }
+        std::size_t getFrames() const noexcept { return frames.load(std::memory_order_acquire); }
+        std::size_t getFreeFrames() const noexcept { return maxFrames - getFrames(); }
+
+        // writes count frames from planar samples (stride samples apart), there must be enough free frames
+        void write(const float* samples, std::size_t count, std::size_t stride) noexcept
+        {
+            for (std::size_t frame = 0; frame < count; ++frame)
+            {
+                for (std::uint32_t channel = 0; channel < channels; ++channel)
+                    buffer[writePosition * channels + channel] = samples[channel * stride + frame];
+
+                writePosition = (writePosition + 1 == maxFrames) ? 0 : writePosition + 1;
+            }
+
+            frames.fetch_add(count, std::memory_order_release);
+        }
+
+        // reads up to count frames into planar samples (stride samples apart), returns the number of frames read
+        std::size_t read(float* samples, std::size_t count, std::size_t stride) noexcept
+        {
+            const auto readFrames = std::min(count, getFrames());
+
+            for (std::size_t frame = 0; frame < readFrames; ++frame)
+            {
+                for (std::uint32_t channel = 0; channel < channels; ++channel)
+                    samples[channel * stride + frame] = buffer[readPosition * channels + channel];
+
+                readPosition = (readPosition + 1 == maxFrames) ? 0 : readPosition + 1;
+            }
+
+            frames.fetch_sub(readFrames, std::memory_order_release);
+            return readFrames;
+        }
+
+        // must not overlap with read or write calls
+        void clear() noexcept
+        {
+            readPosition = 0;
+            writePosition = 0;
+            frames.store(0, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<std::size_t> frames{0};
+        std::size_t maxFrames;
+        std::uint32_t channels;
+        std::size_t readPosition = 0;
+        std::size_t writePosition = 0;
+        std::vector<float> buffer;
+    };
+}
+
+#endif // OUZEL_AUDIO_MIXER_RINGBUFFER_HPP
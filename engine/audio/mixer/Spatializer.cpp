@@ -0,0 +1,226 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <cmath>
+#include "Spatializer.hpp"
+#include "Dsp.hpp"
+#include "Stream.hpp"
+#include "../../math/Constants.hpp"
+
+namespace ouzel::audio::mixer
+{
+    namespace
+    {
+        constexpr float minPitch = 0.5F;
+        constexpr float maxPitch = 2.0F;
+        constexpr float pitchSmoothing = 0.5F; // part of the remaining pitch change applied every block
+        constexpr float minDistanceToListener = 0.0001F;
+
+        // azimuth is in degrees clockwise from the front
+        struct Speaker final
+        {
+            std::uint32_t channel;
+            float azimuth;
+        };
+
+        // neighbouring speakers and the inverse of the matrix made of their direction vectors
+        struct SpeakerPair final
+        {
+            std::uint32_t first;
+            std::uint32_t second;
+            float inverse[4];
+        };
+
+        struct Layout final
+        {
+            std::uint32_t speakerCount;
+            SpeakerPair pairs[Spatializer::maxChannels];
+        };
+
+        // the speakers must be ordered by azimuth
+        template <std::size_t N>
+        Layout createLayout(const Speaker (&speakers)[N]) noexcept
+        {
+            Layout layout{};
+            layout.speakerCount = N;
+
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                const auto& first = speakers[i];
+                const auto& second = speakers[(i + 1) % N];
+                const auto firstX = std::sin(first.azimuth * pi<float> / 180.0F);
+                const auto firstZ = std::cos(first.azimuth * pi<float> / 180.0F);
+                const auto secondX = std::sin(second.azimuth * pi<float> / 180.0F);
+                const auto secondZ = std::cos(second.azimuth * pi<float> / 180.0F);
+                const auto determinant = firstX * secondZ - secondX * firstZ;
+
+                layout.pairs[i] = SpeakerPair{
+                    first.channel, second.channel,
+                    {secondZ / determinant, -secondX / determinant, -firstZ / determinant, firstX / determinant}
+                };
+            }
+
+            return layout;
+        }
+
+        // L, R, SL, SR
+        constexpr Speaker quadSpeakers[] = {{2, -135.0F}, {0, -45.0F}, {1, 45.0F}, {3, 135.0F}};
+        // L, R, C, LFE, SL, SR, the LFE channel is not panned to
+        constexpr Speaker surroundSpeakers[] = {{4, -110.0F}, {0, -30.0F}, {2, 0.0F}, {1, 30.0F}, {5, 110.0F}};
+
+        const Layout quadLayout = createLayout(quadSpeakers);
+        const Layout surroundLayout = createLayout(surroundSpeakers);
+
+        // vector base amplitude panning in the horizontal plane, the elevated part of the direction is spread
+        // over all the speakers, so that the power stays constant
+        void panVector(const Layout& layout, const Vector3F& direction, float gain, float* gains) noexcept
+        {
+            float powers[Spatializer::maxChannels]{};
+
+            const auto horizontal = direction.v[0] * direction.v[0] + direction.v[2] * direction.v[2];
+            const auto spread = std::max(0.0F, 1.0F - horizontal) / static_cast<float>(layout.speakerCount);
+
+            if (horizontal > minDistanceToListener)
+            {
+                const auto length = std::sqrt(horizontal);
+                const auto x = direction.v[0] / length;
+                const auto z = direction.v[2] / length;
+
+                for (std::uint32_t i = 0; i < layout.speakerCount; ++i)
+                {
+                    const auto& pair = layout.pairs[i];
+                    const auto firstGain = pair.inverse[0] * x + pair.inverse[1] * z;
+                    const auto secondGain = pair.inverse[2] * x + pair.inverse[3] * z;
+
+                    if (firstGain >= -minDistanceToListener && secondGain >= -minDistanceToListener)
+                    {
+                        const auto norm = firstGain * firstGain + secondGain * secondGain;
+                        powers[pair.first] = horizontal * std::max(firstGain, 0.0F) * std::max(firstGain, 0.0F) / norm;
+                        powers[pair.second] = horizontal * std::max(secondGain, 0.0F) * std::max(secondGain, 0.0F) / norm;
+                        break;
+                    }
+                }
+            }
+
+            for (std::uint32_t i = 0; i < layout.speakerCount; ++i)
+            {
+                const auto channel = layout.pairs[i].first;
+                gains[channel] = gain * std::sqrt(powers[channel] + spread);
+            }
+        }
+
+        // equal power panning by the lateral part of the direction
+        void panStereo(const Vector3F& direction, float gain, float* gains) noexcept
+        {
+            const auto pan = std::clamp(direction.v[0], -1.0F, 1.0F);
+            gains[0] = gain * std::sqrt((1.0F - pan) / 2.0F);
+            gains[1] = gain * std::sqrt((1.0F + pan) / 2.0F);
+        }
+    }
+
+    float Spatializer::getAttenuation(DistanceModel distanceModel, float distance,
+                                      float minDistance, float maxDistance, float rolloffFactor) noexcept
+    {
+        if (minDistance <= 0.0F) return 1.0F;
+
+        const auto clampedDistance = std::clamp(distance, minDistance, std::max(minDistance, maxDistance));
+
+        switch (distanceModel)
+        {
+            case DistanceModel::inverse:
+                return minDistance / (minDistance + rolloffFactor * (clampedDistance - minDistance));
+            case DistanceModel::linear:
+                if (maxDistance <= minDistance) return 1.0F;
+                return std::max(0.0F, 1.0F - rolloffFactor * (clampedDistance - minDistance) / (maxDistance - minDistance));
+            case DistanceModel::exponential:
+                return std::pow(clampedDistance / minDistance, -rolloffFactor);
+        }
+
+        return 1.0F;
+    }
+
+    void Spatializer::evaluate(const std::vector<Stream*>& streams, const Listener& listener, std::uint32_t channels) noexcept
+    {
+        // the directions are rotated to the space of the listener
+        QuaternionF inverseRotation = listener.rotation;
+        inverseRotation.invert();
+
+        // velocities at or above the speed of sound would flip the sign of the Doppler shift
+        const auto maxSpeed = (dopplerFactor > 0.0F) ? 0.9F * speedOfSound / dopplerFactor : 0.0F;
+
+        for (Stream* stream : streams)
+        {
+            if (!stream->isPlaying() || stream->isVirtual()) continue;
+
+            auto& state = stream->getSpatialState();
+
+            const Vector3F offset = position + stream->getPosition() - listener.position;
+            const auto distance = offset.length();
+            const auto gain = stream->getGain() * getAttenuation(distanceModel, distance, minDistance, maxDistance, rolloffFactor);
+            const auto direction = (distance > minDistanceToListener) ? offset / distance : Vector3F{};
+            const auto localDirection = inverseRotation.rotateVector(direction);
+
+            state.targetGains.fill(0.0F);
+
+            switch (channels)
+            {
+                case 1: state.targetGains[0] = gain; break;
+                case 4: panVector(quadLayout, localDirection, gain, state.targetGains.data()); break;
+                case 6: panVector(surroundLayout, localDirection, gain, state.targetGains.data()); break;
+                default: panStereo(localDirection, gain, state.targetGains.data()); break;
+            }
+
+            auto targetPitch = 1.0F;
+            if (dopplerFactor > 0.0F)
+            {
+                // speeds along the line between the listener and the source, positive when approaching
+                const auto listenerSpeed = std::clamp(listener.velocity.dot(direction), -maxSpeed, maxSpeed);
+                const auto sourceSpeed = std::clamp(-(velocity + stream->getVelocity()).dot(direction), -maxSpeed, maxSpeed);
+
+                targetPitch = std::clamp((speedOfSound + dopplerFactor * listenerSpeed) /
+                                         (speedOfSound - dopplerFactor * sourceSpeed), minPitch, maxPitch);
+            }
+
+            if (state.initialized)
+            {
+                state.pitch += (targetPitch - state.pitch) * pitchSmoothing;
+                if (std::abs(targetPitch - state.pitch) < 0.0001F) state.pitch = targetPitch;
+            }
+            else
+            {
+                state.gains = state.targetGains;
+                state.pitch = targetPitch;
+                state.initialized = true;
+            }
+        }
+    }
+
+    void Spatializer::pan(State& state, std::uint32_t frames, std::uint32_t inputChannels, const float* input,
+                          std::uint32_t channels, float* samples)
+    {
+        const float* mono = input;
+
+        if (inputChannels > 1)
+        {
+            const auto channelGain = 1.0F / static_cast<float>(inputChannels);
+            monoBuffer.resize(frames);
+            dsp::scale(monoBuffer.data(), input, channelGain, frames);
+            for (std::uint32_t channel = 1; channel < inputChannels; ++channel)
+                dsp::addScaled(monoBuffer.data(), input + channel * frames, channelGain, frames);
+            mono = monoBuffer.data();
+        }
+
+        for (std::uint32_t channel = 0; channel < std::min(channels, maxChannels); ++channel)
+        {
+            const auto gain = state.gains[channel];
+            const auto targetGain = state.targetGains[channel];
+
+            if (gain != targetGain)
+                dsp::addRamped(samples + channel * frames, mono, gain, targetGain, frames);
+            else if (gain != 0.0F)
+                dsp::addScaled(samples + channel * frames, mono, gain, frames);
+
+            state.gains[channel] = targetGain;
+        }
+    }
+}
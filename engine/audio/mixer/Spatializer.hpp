@@ -0,0 +1,78 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_SPATIALIZER_HPP
+#define OUZEL_AUDIO_MIXER_SPATIALIZER_HPP
+
+#include <array>
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+#include "Listener.hpp"
+#include "Processor.hpp"
+#include "../DistanceModel.hpp"
+#include "../../math/Vector.hpp"
+
+namespace ouzel::audio::mixer
+{
+    class Stream;
+
+    // positions the streams that are mixed directly into its bus, the bus pans them while mixing
+    class Spatializer final: public Processor
+    {
+    public:
+        static constexpr std::uint32_t maxChannels = 8;
+        static constexpr float speedOfSound = 343.3F; // meters per second
+
+        // the panning gains and the Doppler pitch of a stream
+        struct State final
+        {
+            std::array<float, maxChannels> gains{};
+            std::array<float, maxChannels> targetGains{};
+            float pitch = 1.0F;
+            bool initialized = false;
+        };
+
+        // the mono downmix of the largest block is allocated up front, so that panning never allocates
+        explicit Spatializer(std::uint32_t maxFrames)
+        {
+            monoBuffer.reserve(maxFrames);
+        }
+
+        static float getAttenuation(DistanceModel distanceModel, float distance,
+                                    float minDistance, float maxDistance, float rolloffFactor) noexcept;
+
+        void process(std::uint32_t, std::uint32_t, std::uint32_t, std::vector<float>&) final {}
+
+        void setPosition(const Vector3F& newPosition) noexcept { position = newPosition; }
+        void setVelocity(const Vector3F& newVelocity) noexcept { velocity = newVelocity; }
+        void setDistanceModel(DistanceModel newDistanceModel) noexcept { distanceModel = newDistanceModel; }
+        void setRolloffFactor(float newRolloffFactor) noexcept { rolloffFactor = newRolloffFactor; }
+        void setMinDistance(float newMinDistance) noexcept { minDistance = newMinDistance; }
+        void setMaxDistance(float newMaxDistance) noexcept { maxDistance = newMaxDistance; }
+
+        // zero disables the Doppler effect, so that the streams are not resampled because of it
+        auto getDopplerFactor() const noexcept { return dopplerFactor; }
+        void setDopplerFactor(float newDopplerFactor) noexcept { dopplerFactor = newDopplerFactor; }
+
+        // calculates the target gains and pitches of all the streams in a single pass once per block
+        void evaluate(const std::vector<Stream*>& streams, const Listener& listener, std::uint32_t channels) noexcept;
+
+        // adds the mono downmix of the planar input to the planar samples,
+        // the gains move linearly to the targets during the block
+        void pan(State& state, std::uint32_t frames, std::uint32_t inputChannels, const float* input,
+                 std::uint32_t channels, float* samples);
+
+    private:
+        Vector3F position;
+        Vector3F velocity;
+        DistanceModel distanceModel = DistanceModel::inverse;
+        float rolloffFactor = 1.0F;
+        float minDistance = 1.0F;
+        float maxDistance = FLT_MAX;
+        float dopplerFactor = 1.0F;
+
+        std::vector<float> monoBuffer;
+    };
+}
+
+#endif // OUZEL_AUDIO_MIXER_SPATIALIZER_HPP
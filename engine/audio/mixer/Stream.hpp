@@ -3,9 +3,13 @@
 #ifndef OUZEL_AUDIO_MIXER_STREAM_HPP
 #define OUZEL_AUDIO_MIXER_STREAM_HPP
 
+#include <limits>
 #include "Object.hpp"
 #include "Bus.hpp"
 #include "Data.hpp"
+#include "Resampler.hpp"
+#include "Spatializer.hpp"
+#include "../../math/Vector.hpp"
 
 namespace ouzel::audio::mixer
 {
@@ -32,7 +36,16 @@ namespace ouzel::audio::mixer
         Stream(Stream&&) = delete;
         Stream& operator=(Stream&&) = delete;
 
+        void detach() override
+        {
+            if (output) output->removeInput(this);
+            output = nullptr;
+
+            Object::detach();
+        }
+
         auto& getData() const noexcept { return data; }
+        auto& getResampler() noexcept { return resampler; }
 
         void setOutput(Bus* newOutput)
         {
@@ -41,23 +54,73 @@ namespace ouzel::audio::mixer
             if (output) output->addInput(this);
         }
 
+        // sizes the buffers the output bus mixes the stream with, so that mixing it never allocates,
+        // must be called on the game thread after the resampler is prepared
+        void reserveBuffers(std::uint32_t maxFrames)
+        {
+            const auto channels = data.getChannels();
+            resampleBuffer.reserve(resampler.getMaxSourceFrames(maxFrames) * channels);
+            mixBuffer.reserve(maxFrames * channels);
+        }
+
         auto isPlaying() const noexcept { return playing; }
         void play() { playing = true; }
 
         void stop(bool shouldReset)
         {
             playing = false;
-            if (shouldReset) reset();
+            if (shouldReset)
+            {
+                reset();
+                resampler.reset();
+                spatialState.initialized = false;
+            }
         }
 
+        auto getGain() const noexcept { return gain; }
+        void setGain(float newGain) noexcept { gain = newGain; }
+
+        // relative to the spatializer of the output bus
+        auto& getPosition() const noexcept { return position; }
+        void setPosition(const Vector3F& newPosition) noexcept { position = newPosition; }
+
+        auto& getVelocity() const noexcept { return velocity; }
+        void setVelocity(const Vector3F& newVelocity) noexcept { velocity = newVelocity; }
+
+        auto& getSpatialState() noexcept { return spatialState; }
+
+        // virtual streams are not decoded or mixed, they only keep advancing their play position
+        auto isVirtual() const noexcept { return virtualized; }
+        void setVirtual(bool newVirtual) noexcept { virtualized = newVirtual; }
+
         virtual void reset() = 0;
 
+        // moves the play position to the given source frame, streams without a position ignore it
+        virtual void seek(std::uint64_t) {}
+
+        // advances the play position by the given number of source frames without producing samples
+        virtual void skip(std::uint32_t) {}
+
+        // source frames left until the stream stops, the maximum for the streams without an end
+        virtual std::uint64_t getRemainingFrames() const noexcept
+        {
+            return std::numeric_limits<std::uint64_t>::max();
+        }
+
         virtual void generateSamples(std::uint32_t frames, std::vector<float>& samples) = 0;
 
     protected:
         Data& data;
         Bus* output = nullptr;
         bool playing = false;
+        bool virtualized = false;
+        float gain = 1.0F;
+        Vector3F position;
+        Vector3F velocity;
+        Spatializer::State spatialState;
+        Resampler resampler;
+        std::vector<float> resampleBuffer;
+        std::vector<float> mixBuffer;
     };
 }
 
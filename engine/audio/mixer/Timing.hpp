@@ -0,0 +1,77 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_TIMING_HPP
+#define OUZEL_AUDIO_MIXER_TIMING_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace ouzel::audio::mixer
+{
+    // time spent in a node of the mixer, added by the thread that generates the node
+    // and taken by any other thread without locking
+    class Timing final
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        struct Statistics final
+        {
+            std::chrono::nanoseconds totalTime{0};
+            std::chrono::nanoseconds maximumTime{0}; // of a single block
+            std::uint64_t blockCount = 0;
+        };
+
+        // measures the time until it goes out of scope, does nothing without a timing
+        class Scope final
+        {
+        public:
+            explicit Scope(Timing* initTiming) noexcept:
+                timing(initTiming),
+                start(initTiming ? Clock::now() : Clock::time_point())
+            {
+            }
+
+            ~Scope()
+            {
+                if (timing) timing->add(Clock::now() - start);
+            }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            Timing* timing;
+            Clock::time_point start;
+        };
+
+        void add(Clock::duration duration) noexcept
+        {
+            const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+
+            totalTime.fetch_add(nanoseconds, std::memory_order_relaxed);
+            // there is only one writer, so the maximum can not be lowered by another block
+            if (nanoseconds > maximumTime.load(std::memory_order_relaxed))
+                maximumTime.store(nanoseconds, std::memory_order_relaxed);
+            blockCount.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // the time since the previous call
+        Statistics take() noexcept
+        {
+            Statistics result;
+            result.blockCount = blockCount.exchange(0, std::memory_order_relaxed);
+            result.totalTime = std::chrono::nanoseconds(totalTime.exchange(0, std::memory_order_relaxed));
+            result.maximumTime = std::chrono::nanoseconds(maximumTime.exchange(0, std::memory_order_relaxed));
+            return result;
+        }
+
+    private:
+        std::atomic<std::chrono::nanoseconds::rep> totalTime{0};
+        std::atomic<std::chrono::nanoseconds::rep> maximumTime{0};
+        std::atomic<std::uint64_t> blockCount{0};
+    };
+}
+
+#endif // OUZEL_AUDIO_MIXER_TIMING_HPP
@@ -0,0 +1,127 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#if defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+#include <algorithm>
+#include <cmath>
+#include "Wavetable.hpp"
+#include "Fft.hpp"
+#include "../../core/Engine.hpp"
+
+namespace ouzel::audio::mixer
+{
+    namespace
+    {
+        constexpr std::uint32_t fractionBits = 32 - Wavetable::sizeBits;
+        constexpr std::uint32_t fractionMask = (1U << fractionBits) - 1U;
+        constexpr float fractionScale = 1.0F / static_cast<float>(1U << fractionBits);
+    }
+
+    Wavetable::Wavetable(const std::vector<float>& harmonics)
+    {
+        const auto harmonicCount = std::min(static_cast<std::uint32_t>(harmonics.size()), maxHarmonics);
+
+        // every level has half of the harmonics of the previous one, the last one has only the fundamental
+        for (auto count = std::max(harmonicCount, 1U); count > 0; count /= 2)
+            levelHarmonics.push_back(count);
+
+        levels.resize(levelHarmonics.size() * (size + 1));
+
+        Fft fft(size);
+        std::vector<float> real(size / 2 + 1);
+        std::vector<float> imaginary(size / 2 + 1);
+
+        for (std::size_t level = 0; level < levelHarmonics.size(); ++level)
+        {
+            std::fill(imaginary.begin(), imaginary.end(), 0.0F);
+
+            // a sine of amplitude a is the bin -a * size / 2 of the imaginary part
+            for (std::uint32_t harmonic = 1; harmonic <= std::min(levelHarmonics[level], harmonicCount); ++harmonic)
+                imaginary[harmonic] = -harmonics[harmonic - 1] * static_cast<float>(size / 2);
+
+            const auto table = &levels[level * (size + 1)];
+            fft.inverse(real.data(), imaginary.data(), table);
+            table[size] = table[0];
+        }
+    }
+
+    std::uint32_t Wavetable::getIncrement(float frequency, std::uint32_t sampleRate) noexcept
+    {
+        const auto cycles = std::fabs(static_cast<double>(frequency)) / static_cast<double>(sampleRate);
+        return static_cast<std::uint32_t>(std::fmod(cycles, 1.0) * 4294967296.0);
+    }
+
+    const float* Wavetable::getTable(std::uint32_t increment) const noexcept
+    {
+        // the first level whose highest harmonic stays below half of a cycle per frame
+        std::size_t level = 0;
+        while (level + 1 < levelHarmonics.size() &&
+               static_cast<std::uint64_t>(levelHarmonics[level]) * increment >= 0x80000000U)
+            ++level;
+
+        return &levels[level * (size + 1)];
+    }
+
+    void Wavetable::generate(std::uint32_t frames, std::uint32_t& phase, std::uint32_t increment,
+                             float amplitude, float* samples) const noexcept
+    {
+        const auto table = getTable(increment);
+        std::uint32_t i = 0;
+
+        if (core::isSimdAvailable)
+        {
+#if defined(__ARM_NEON__)
+            const std::uint32_t startPhases[4] = {phase, phase + increment, phase + increment * 2, phase + increment * 3};
+            uint32x4_t phases = vld1q_u32(startPhases);
+            const uint32x4_t step = vdupq_n_u32(increment * 4);
+            const uint32x4_t mask = vdupq_n_u32(fractionMask);
+            std::uint32_t indices[4];
+
+            for (; i + 4 <= frames; i += 4)
+            {
+                vst1q_u32(indices, vshrq_n_u32(phases, fractionBits));
+                const float a[4] = {table[indices[0]], table[indices[1]], table[indices[2]], table[indices[3]]};
+                const float b[4] = {table[indices[0] + 1], table[indices[1] + 1], table[indices[2] + 1], table[indices[3] + 1]};
+                const float32x4_t fraction = vmulq_n_f32(vcvtq_f32_u32(vandq_u32(phases, mask)), fractionScale);
+                const float32x4_t first = vld1q_f32(a);
+                const float32x4_t value = vmlaq_f32(first, vsubq_f32(vld1q_f32(b), first), fraction);
+                vst1q_f32(samples + i, vmulq_n_f32(value, amplitude));
+                phases = vaddq_u32(phases, step);
+            }
+#elif defined(__SSE2__)
+            __m128i phases = _mm_setr_epi32(static_cast<int>(phase), static_cast<int>(phase + increment),
+                                            static_cast<int>(phase + increment * 2), static_cast<int>(phase + increment * 3));
+            const __m128i step = _mm_set1_epi32(static_cast<int>(increment * 4));
+            const __m128i mask = _mm_set1_epi32(static_cast<int>(fractionMask));
+            const __m128 scale = _mm_set1_ps(fractionScale);
+            const __m128 gain = _mm_set1_ps(amplitude);
+            alignas(16) std::uint32_t indices[4];
+
+            for (; i + 4 <= frames; i += 4)
+            {
+                _mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_srli_epi32(phases, fractionBits));
+                const __m128 first = _mm_setr_ps(table[indices[0]], table[indices[1]], table[indices[2]], table[indices[3]]);
+                const __m128 second = _mm_setr_ps(table[indices[0] + 1], table[indices[1] + 1],
+                                                  table[indices[2] + 1], table[indices[3] + 1]);
+                // the fraction fits in the positive range of the signed conversion
+                const __m128 fraction = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(phases, mask)), scale);
+                const __m128 value = _mm_add_ps(first, _mm_mul_ps(_mm_sub_ps(second, first), fraction));
+                _mm_storeu_ps(samples + i, _mm_mul_ps(value, gain));
+                phases = _mm_add_epi32(phases, step);
+            }
+#endif
+            phase += increment * i;
+        }
+
+        for (; i < frames; ++i)
+        {
+            const auto index = phase >> fractionBits;
+            const auto fraction = static_cast<float>(phase & fractionMask) * fractionScale;
+            samples[i] = (table[index] + (table[index + 1] - table[index]) * fraction) * amplitude;
+            phase += increment;
+        }
+    }
+}
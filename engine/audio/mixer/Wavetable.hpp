@@ -0,0 +1,41 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_WAVETABLE_HPP
+#define OUZEL_AUDIO_MIXER_WAVETABLE_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace ouzel::audio::mixer
+{
+    // a single cycle of a waveform with a table per octave, every table only has the harmonics
+    // that stay below the Nyquist frequency for the fundamentals it is played at,
+    // the phase is a 32-bit fixed point fraction of the cycle that wraps around on overflow
+    class Wavetable final
+    {
+    public:
+        static constexpr std::uint32_t sizeBits = 12;
+        static constexpr std::uint32_t size = 1U << sizeBits;
+        // a quarter of the table size, so that the highest harmonic has four samples per cycle
+        static constexpr std::uint32_t maxHarmonics = size / 4;
+
+        // amplitudes of the sine harmonics, starting from the fundamental
+        explicit Wavetable(const std::vector<float>& harmonics);
+
+        // the phase increment of a frame for the frequency at the sample rate
+        static std::uint32_t getIncrement(float frequency, std::uint32_t sampleRate) noexcept;
+
+        // writes frames samples with linear interpolation and advances the phase
+        void generate(std::uint32_t frames, std::uint32_t& phase, std::uint32_t increment,
+                      float amplitude, float* samples) const noexcept;
+
+    private:
+        const float* getTable(std::uint32_t increment) const noexcept;
+
+        std::vector<std::uint32_t> levelHarmonics;
+        // every level has size + 1 samples, the last one repeats the first for the interpolation
+        std::vector<float> levels;
+    };
+}
+
+#endif // OUZEL_AUDIO_MIXER_WAVETABLE_HPP
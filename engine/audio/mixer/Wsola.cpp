@@ -0,0 +1,168 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <cmath>
+#include "Wsola.hpp"
+#include "Dsp.hpp"
+
+namespace ouzel::audio::mixer
+{
+    namespace
+    {
+        constexpr float segmentLength = 0.015F; // seconds
+        constexpr double margin = 2.0; // frames needed by the interpolation
+    }
+
+    void Wsola::prepare(std::uint32_t sampleRate, std::uint32_t channels)
+    {
+        currentSampleRate = sampleRate;
+        segmentSize = std::max(static_cast<std::uint32_t>(segmentLength * static_cast<float>(sampleRate)), 16U);
+        fadeSize = segmentSize / 2;
+        searchSize = segmentSize / 4;
+
+        // the delay never exceeds three segments, the rest is left for the written block
+        std::uint32_t size = 1;
+        while (size < segmentSize * 4) size <<= 1;
+        mask = size - 1;
+
+        buffers.resize(channels);
+        for (auto& buffer : buffers)
+            buffer.assign(size, 0.0F);
+
+        reference.resize(fadeSize);
+        candidates.resize(fadeSize + searchSize * 2);
+
+        reset();
+    }
+
+    void Wsola::reset() noexcept
+    {
+        for (auto& buffer : buffers)
+            std::fill(buffer.begin(), buffer.end(), 0.0F);
+
+        // start with enough delay to jump back without the read position passing the write position,
+        // the positions start after two segments, so that a jump back never goes below zero
+        readPosition = segmentSize * 2.0;
+        writePosition = segmentSize * 3 + static_cast<std::uint64_t>(margin);
+        fadeRemaining = 0;
+    }
+
+    void Wsola::process(float shift, std::uint32_t frames, float* samples) noexcept
+    {
+        if (buffers.empty()) return;
+
+        const double rate = static_cast<double>(shift);
+        const std::uint32_t maxChunk = mask + 1 - segmentSize * 3;
+
+        for (std::uint32_t offset = 0; offset < frames;)
+        {
+            const auto count = std::min(frames - offset, maxChunk);
+
+            for (std::size_t channel = 0; channel < buffers.size(); ++channel)
+            {
+                const float* input = samples + channel * frames + offset;
+                auto& buffer = buffers[channel];
+                for (std::uint32_t frame = 0; frame < count; ++frame)
+                    buffer[(writePosition + frame) & mask] = input[frame];
+            }
+
+            for (std::uint32_t frame = 0; frame < count; ++frame)
+            {
+                // frames up to the current one are written
+                const auto written = static_cast<double>(writePosition + frame + 1);
+                const auto delay = written - readPosition;
+
+                if (fadeRemaining == 0)
+                {
+                    if (rate > 1.0 && delay < fadeSize * rate + margin)
+                    {
+                        // the read position catches up, so a segment is repeated
+                        fadePosition = findSplice(readPosition, readPosition - segmentSize);
+                        fadeRemaining = fadeSize;
+                    }
+                    else if (rate < 1.0 && delay > segmentSize + searchSize + fadeSize + margin)
+                    {
+                        // the read position falls behind, so a segment is skipped
+                        fadePosition = findSplice(readPosition, readPosition + segmentSize);
+                        fadeRemaining = fadeSize;
+                    }
+                }
+
+                if (fadeRemaining)
+                {
+                    const auto gain = static_cast<float>(fadeSize - fadeRemaining + 1) / static_cast<float>(fadeSize + 1);
+
+                    for (std::size_t channel = 0; channel < buffers.size(); ++channel)
+                        samples[channel * frames + offset + frame] = read(buffers[channel], readPosition) * (1.0F - gain) +
+                            read(buffers[channel], fadePosition) * gain;
+
+                    readPosition += rate;
+                    fadePosition += rate;
+
+                    if (--fadeRemaining == 0) readPosition = fadePosition;
+                }
+                else
+                {
+                    for (std::size_t channel = 0; channel < buffers.size(); ++channel)
+                        samples[channel * frames + offset + frame] = read(buffers[channel], readPosition);
+
+                    readPosition += rate;
+                }
+            }
+
+            writePosition += count;
+            offset += count;
+        }
+    }
+
+    float Wsola::read(const std::vector<float>& buffer, double position) const noexcept
+    {
+        const auto index = static_cast<std::uint64_t>(position);
+        const auto fraction = static_cast<float>(position - static_cast<double>(index));
+        const auto current = buffer[index & mask];
+        const auto next = buffer[(index + 1) & mask];
+        return current + (next - current) * fraction;
+    }
+
+    // returns the position around to whose signal the signal at from continues most smoothly
+    double Wsola::findSplice(double from, double to) noexcept
+    {
+        const auto fromIndex = static_cast<std::uint64_t>(from);
+        const auto toIndex = static_cast<std::uint64_t>(to) - searchSize;
+
+        // the channels are mixed, so that all of them jump together
+        std::fill(reference.begin(), reference.end(), 0.0F);
+        std::fill(candidates.begin(), candidates.end(), 0.0F);
+        for (const auto& buffer : buffers)
+        {
+            for (std::uint32_t i = 0; i < fadeSize; ++i)
+                reference[i] += buffer[(fromIndex + i) & mask];
+            for (std::size_t i = 0; i < candidates.size(); ++i)
+                candidates[i] += buffer[(toIndex + i) & mask];
+        }
+
+        float energy = dsp::dot(candidates.data(), candidates.data(), fadeSize);
+        float bestScore = -1.0F;
+        std::uint32_t bestOffset = searchSize;
+
+        for (std::uint32_t offset = 0; offset <= searchSize * 2; ++offset)
+        {
+            if (offset)
+            {
+                const auto removed = candidates[offset - 1];
+                const auto added = candidates[offset + fadeSize - 1];
+                energy = std::max(energy - removed * removed + added * added, 0.0F);
+            }
+
+            const auto score = dsp::dot(reference.data(), candidates.data() + offset, fadeSize) / std::sqrt(energy + 1e-9F);
+            if (score > bestScore)
+            {
+                bestScore = score;
+                bestOffset = offset;
+            }
+        }
+
+        // keep the fraction of the read position, so that the interpolation does not change
+        return static_cast<double>(toIndex + bestOffset) + (from - static_cast<double>(fromIndex));
+    }
+}
@@ -0,0 +1,49 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_MIXER_WSOLA_HPP
+#define OUZEL_AUDIO_MIXER_WSOLA_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace ouzel::audio::mixer
+{
+    // low latency time domain pitch shifter (waveform similarity overlap-add), the input is read at
+    // the shifted rate and when the read position gets too close to or too far from the write position
+    // it jumps by a segment, the splice point is the offset that resembles the replaced signal the most
+    class Wsola final
+    {
+    public:
+        bool isPrepared(std::uint32_t sampleRate, std::uint32_t channels) const noexcept
+        {
+            return sampleRate == currentSampleRate && channels == buffers.size();
+        }
+
+        void prepare(std::uint32_t sampleRate, std::uint32_t channels);
+        void reset() noexcept;
+
+        // shifts the pitch of the planar samples in place
+        void process(float shift, std::uint32_t frames, float* samples) noexcept;
+
+    private:
+        float read(const std::vector<float>& buffer, double position) const noexcept;
+        double findSplice(double from, double to) noexcept;
+
+        std::uint32_t currentSampleRate = 0;
+        std::uint32_t segmentSize = 0; // frames skipped or repeated by a jump
+        std::uint32_t fadeSize = 0; // frames cross-faded after a jump
+        std::uint32_t searchSize = 0; // maximum offset of the splice point
+        std::uint32_t mask = 0;
+        std::vector<std::vector<float>> buffers;
+
+        std::uint64_t writePosition = 0;
+        double readPosition = 0.0;
+        double fadePosition = 0.0; // the read position after the jump
+        std::uint32_t fadeRemaining = 0;
+
+        std::vector<float> reference;
+        std::vector<float> candidates;
+    };
+}
+
+#endif // OUZEL_AUDIO_MIXER_WSOLA_HPP
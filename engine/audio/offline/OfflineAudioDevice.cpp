@@ -0,0 +1,185 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+#include "OfflineAudioDevice.hpp"
+#include "../../utils/Log.hpp"
+
+namespace ouzel::audio::offline
+{
+    namespace
+    {
+        constexpr std::size_t headerSize = 44;
+        constexpr std::uint16_t formatPcm = 1;
+        constexpr std::uint16_t formatIeeeFloat = 3;
+
+        void encode(std::uint8_t* destination, std::uint32_t value, std::size_t size) noexcept
+        {
+            for (std::size_t i = 0; i < size; ++i)
+                destination[i] = static_cast<std::uint8_t>(value >> (i * 8));
+        }
+    }
+
+    AudioDevice::AudioDevice(const Settings& settings,
+                             const std::function<void(std::uint32_t frames,
+                                                      std::uint32_t channels,
+                                                      std::uint32_t sampleRate,
+                                                      std::vector<float>& samples)>& initDataGetter):
+        audio::AudioDevice(Driver::offline, settings, initDataGetter),
+        renderLength(settings.renderLength)
+    {
+        sampleFormat = settings.sampleFormat;
+
+        if (!settings.renderFile.empty())
+        {
+            file.open(settings.renderFile, std::ios::binary | std::ios::trunc);
+            if (!file)
+                throw std::runtime_error("Failed to open " + settings.renderFile);
+
+            writeHeader();
+        }
+    }
+
+    AudioDevice::~AudioDevice()
+    {
+        running = false;
+        if (renderThread.isJoinable()) renderThread.join();
+
+        if (file.is_open()) writeHeader();
+    }
+
+    void AudioDevice::start()
+    {
+        running = true;
+        renderThread = thread::Thread(&AudioDevice::run, this);
+    }
+
+    void AudioDevice::stop()
+    {
+        running = false;
+        if (renderThread.isJoinable()) renderThread.join();
+
+        if (file.is_open()) writeHeader();
+    }
+
+    void AudioDevice::render(std::uint64_t frames)
+    {
+        if (renderThread.isJoinable())
+            throw std::runtime_error("Audio device must be stopped before rendering");
+
+        auto frame = getRenderedFrames();
+        const auto endFrame = frame + frames;
+
+        while (frame < endFrame)
+        {
+            while (nextEvent < timeline.size() && timeline[nextEvent].frame <= frame)
+                timeline[nextEvent++].action();
+
+            // the blocks are split at the events, so that they are sample accurate
+            auto blockEnd = std::min(endFrame, frame + bufferSize);
+            if (nextEvent < timeline.size())
+                blockEnd = std::min(blockEnd, timeline[nextEvent].frame);
+
+            renderBlock(static_cast<std::uint32_t>(blockEnd - frame));
+            frame = blockEnd;
+        }
+
+        if (file.is_open()) writeHeader();
+        reportThroughput();
+    }
+
+    void AudioDevice::setTimeline(const std::vector<Event>& newTimeline)
+    {
+        timeline = newTimeline;
+        nextEvent = 0;
+
+        // skip the events that are already in the past
+        while (nextEvent < timeline.size() && timeline[nextEvent].frame < getRenderedFrames())
+            ++nextEvent;
+    }
+
+    double AudioDevice::getRealtimeFactor() const noexcept
+    {
+        const std::chrono::duration<double> duration = std::chrono::steady_clock::duration(mixingTime.load(std::memory_order_relaxed));
+        const auto renderedDuration = static_cast<double>(getRenderedFrames()) / sampleRate;
+
+        return (duration.count() > 0.0) ? renderedDuration / duration.count() : 0.0;
+    }
+
+    void AudioDevice::run()
+    {
+        thread::setCurrentThreadName("Audio");
+
+        while (running && (renderLength == 0 || getRenderedFrames() < renderLength))
+        {
+            try
+            {
+                const auto frames = renderLength ?
+                    static_cast<std::uint32_t>(std::min<std::uint64_t>(bufferSize, renderLength - getRenderedFrames())) :
+                    bufferSize;
+
+                renderBlock(frames);
+            }
+            catch (const std::exception& e)
+            {
+                logger.log(Log::Level::error) << e.what();
+                break;
+            }
+        }
+
+        reportThroughput();
+    }
+
+    void AudioDevice::renderBlock(std::uint32_t frames)
+    {
+        // only the mixing is measured, the file output is not a part of the throughput
+        const auto begin = std::chrono::steady_clock::now();
+        getData(frames, data);
+        const auto end = std::chrono::steady_clock::now();
+
+        mixingTime.fetch_add((end - begin).count(), std::memory_order_relaxed);
+        renderedFrames.fetch_add(frames, std::memory_order_relaxed);
+
+        if (file.is_open())
+        {
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!file)
+                throw std::runtime_error("Failed to write audio data");
+
+            dataSize += data.size();
+        }
+    }
+
+    void AudioDevice::writeHeader()
+    {
+        const std::uint32_t sampleSize = (sampleFormat == SampleFormat::float32) ? sizeof(float) : sizeof(std::int16_t);
+        const auto size = static_cast<std::uint32_t>(std::min<std::uint64_t>(dataSize, std::numeric_limits<std::uint32_t>::max() - headerSize));
+
+        std::array<std::uint8_t, headerSize> header{{
+            'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+            'f', 'm', 't', ' ', 16, 0, 0, 0
+        }};
+        encode(&header[4], static_cast<std::uint32_t>(headerSize - 8) + size, 4);
+        encode(&header[20], (sampleFormat == SampleFormat::float32) ? formatIeeeFloat : formatPcm, 2);
+        encode(&header[22], channels, 2);
+        encode(&header[24], sampleRate, 4);
+        encode(&header[28], sampleRate * channels * sampleSize, 4);
+        encode(&header[32], channels * sampleSize, 2);
+        encode(&header[34], sampleSize * 8, 2);
+        header[36] = 'd'; header[37] = 'a'; header[38] = 't'; header[39] = 'a';
+        encode(&header[40], size, 4);
+
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+        file.seekp(0, std::ios::end);
+        file.flush();
+    }
+
+    void AudioDevice::reportThroughput() const
+    {
+        logger.log(Log::Level::info) << "Rendered " << static_cast<double>(getRenderedFrames()) / sampleRate <<
+            " seconds of audio " << getRealtimeFactor() << " times faster than realtime";
+    }
+}
@@ -0,0 +1,74 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_AUDIO_OFFLINEAUDIODEVICE_HPP
+#define OUZEL_AUDIO_OFFLINEAUDIODEVICE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <vector>
+#include "../AudioDevice.hpp"
+#include "../../thread/Thread.hpp"
+
+namespace ouzel::audio::offline
+{
+    // renders faster than realtime without audio hardware and writes the output to a WAV file,
+    // the output is discarded if the render file is empty
+    class AudioDevice final: public audio::AudioDevice
+    {
+    public:
+        // the action is called before its frame is rendered, the commands that it submits
+        // with Audio::update take effect exactly at that frame
+        struct Event final
+        {
+            std::uint64_t frame;
+            std::function<void()> action;
+        };
+
+        AudioDevice(const Settings& settings,
+                    const std::function<void(std::uint32_t frames,
+                                             std::uint32_t channels,
+                                             std::uint32_t sampleRate,
+                                             std::vector<float>& samples)>& initDataGetter);
+        ~AudioDevice() override;
+
+        // renders on a separate thread until stopped or until the render length is reached
+        void start() final;
+        void stop() final;
+
+        // renders the frames on the calling thread following the timeline, the device must be stopped
+        void render(std::uint64_t frames);
+
+        // the events must be ordered by frame
+        void setTimeline(const std::vector<Event>& newTimeline);
+
+        auto getRenderedFrames() const noexcept { return renderedFrames.load(std::memory_order_relaxed); }
+
+        // the duration of the rendered audio divided by the time it took to mix it
+        double getRealtimeFactor() const noexcept;
+
+    private:
+        void run();
+        void renderBlock(std::uint32_t frames);
+        void writeHeader();
+        void reportThroughput() const;
+
+        std::uint64_t renderLength = 0;
+        std::ofstream file;
+        std::uint64_t dataSize = 0;
+        std::vector<std::uint8_t> data;
+
+        std::vector<Event> timeline;
+        std::size_t nextEvent = 0;
+
+        std::atomic<std::uint64_t> renderedFrames{0};
+        std::atomic<std::chrono::steady_clock::rep> mixingTime{0};
+
+        std::atomic_bool running{false};
+        thread::Thread renderThread;
+    };
+}
+
+#endif // OUZEL_AUDIO_OFFLINEAUDIODEVICE_HPP
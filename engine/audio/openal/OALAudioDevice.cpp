@@ -362,6 +362,9 @@ namespace ouzel::audio::openal
             alGetSourcei(sourceId, AL_SOURCE_STATE, &state);
             if (state != AL_PLAYING)
             {
+                // the source stopped, because it played all of the queued buffers
+                ++xrunCount;
+
                 alSourcePlay(sourceId);
 
                 if (const auto error = alGetError(); error != AL_NO_ERROR)
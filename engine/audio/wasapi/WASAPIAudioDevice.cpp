@@ -289,6 +289,8 @@ namespace ouzel::audio::wasapi
     {
         thread::setCurrentThreadName("Audio");
 
+        bool filled = false;
+
         while (running)
         {
             try
@@ -303,6 +305,9 @@ namespace ouzel::audio::wasapi
                     if (const auto hr = audioClient->GetCurrentPadding(&bufferPadding); FAILED(hr))
                         throw std::system_error(hr, errorCategory, "Failed to get buffer padding");
 
+                    // the device played everything that was written to it before the event was handled
+                    if (filled && bufferPadding == 0) ++xrunCount;
+
                     const UINT32 frameCount = bufferFrameCount - bufferPadding;
                     if (frameCount != 0)
                     {
@@ -316,6 +321,8 @@ namespace ouzel::audio::wasapi
 
                         if (const auto hr = renderClient->ReleaseBuffer(frameCount, 0); FAILED(hr))
                             throw std::system_error(hr, errorCategory, "Failed to release buffer");
+
+                        filled = true;
                     }
                 }
             }
@@ -163,8 +163,10 @@ namespace ouzel::audio::xaudio2
             throw std::system_error(hr, errorCategory, "Failed to flush sound data");
     }
 
-    void AudioDevice::OnVoiceProcessingPassStart(UINT32)
+    void AudioDevice::OnVoiceProcessingPassStart(UINT32 bytesRequired)
     {
+        // the voice ran out of the submitted buffers
+        if (bytesRequired > 0) ++xrunCount;
     }
 
     void AudioDevice::OnVoiceProcessingPassEnd()
@@ -172,8 +172,36 @@ namespace ouzel::core
             const auto& debugAudioValue = userEngineSection.getValue("debugAudio", defaultEngineSection.getValue("debugAudio"));
             if (!debugAudioValue.empty()) settings.audioSettings.debugAudio = (debugAudioValue == "true" || debugAudioValue == "1" || debugAudioValue == "yes");
 
+            const auto& resamplerQualityValue = userEngineSection.getValue("resamplerQuality", defaultEngineSection.getValue("resamplerQuality"));
+            if (resamplerQualityValue == "low") settings.audioSettings.resamplerQuality = audio::ResamplerQuality::low;
+            else if (resamplerQualityValue == "medium") settings.audioSettings.resamplerQuality = audio::ResamplerQuality::medium;
+            else if (resamplerQualityValue == "high") settings.audioSettings.resamplerQuality = audio::ResamplerQuality::high;
+
+            const auto& audioBufferSizeValue = userEngineSection.getValue("audioBufferSize", defaultEngineSection.getValue("audioBufferSize"));
+            if (!audioBufferSizeValue.empty()) settings.audioSettings.bufferSize = static_cast<std::uint32_t>(std::stoul(audioBufferSizeValue));
+
+            const auto& audioPeriodsValue = userEngineSection.getValue("audioPeriods", defaultEngineSection.getValue("audioPeriods"));
+            if (!audioPeriodsValue.empty()) settings.audioSettings.periods = static_cast<std::uint32_t>(std::stoul(audioPeriodsValue));
+
+            const auto& audioMmapValue = userEngineSection.getValue("audioMmap", defaultEngineSection.getValue("audioMmap"));
+            if (!audioMmapValue.empty()) settings.audioSettings.mmapAccess = (audioMmapValue == "true" || audioMmapValue == "1" || audioMmapValue == "yes");
+
+            const auto& audioLatencyValue = userEngineSection.getValue("audioLatency", defaultEngineSection.getValue("audioLatency"));
+            if (!audioLatencyValue.empty()) settings.audioSettings.latency = static_cast<std::uint32_t>(std::stoul(audioLatencyValue));
+
+            const auto& audioMaxVoicesValue = userEngineSection.getValue("audioMaxVoices", defaultEngineSection.getValue("audioMaxVoices"));
+            if (!audioMaxVoicesValue.empty()) settings.audioSettings.maxVoices = static_cast<std::uint32_t>(std::stoul(audioMaxVoicesValue));
+
+            const auto& audioMixerWorkersValue = userEngineSection.getValue("audioMixerWorkers", defaultEngineSection.getValue("audioMixerWorkers"));
+            if (!audioMixerWorkersValue.empty()) settings.audioSettings.mixerWorkers = static_cast<std::uint32_t>(std::stoul(audioMixerWorkersValue));
+
             settings.audioSettings.audioDevice = userEngineSection.getValue("audioDevice", defaultEngineSection.getValue("audioDevice"));
 
+            settings.audioSettings.renderFile = userEngineSection.getValue("audioRenderFile", defaultEngineSection.getValue("audioRenderFile"));
+
+            const auto& audioRenderLengthValue = userEngineSection.getValue("audioRenderLength", defaultEngineSection.getValue("audioRenderLength"));
+            if (!audioRenderLengthValue.empty()) settings.audioSettings.renderLength = std::stoull(audioRenderLengthValue);
+
             return settings;
         }
     }
@@ -725,6 +753,8 @@ namespace ouzel::core
             updateEvent->type = Event::Type::update;
             updateEvent->delta = delta;
             eventDispatcher.dispatchEvent(std::move(updateEvent));
+
+            sceneManager.update(delta);
         }
 
         inputManager->update();
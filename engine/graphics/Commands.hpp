@@ -434,7 +434,7 @@ namespace ouzel::graphics
     {
     public:
         InitTextureCommand(ResourceId initTexture,
-                           const std::vector<std::pair<Size2U, std::vector<std::uint8_t>>>& initLevels,
+                           std::vector<std::pair<Size2U, std::vector<std::uint8_t>>> initLevels,
                            TextureType initTextureType,
                            Flags initFlags,
                            std::uint32_t initSampleCount,
@@ -443,7 +443,7 @@ namespace ouzel::graphics
                            std::uint32_t initMaxAnisotropy) noexcept(false):
             Command(Command::Type::initTexture),
             texture(initTexture),
-            levels(initLevels),
+            levels(std::move(initLevels)),
             textureType(initTextureType),
             flags(initFlags),
             sampleCount(initSampleCount),
@@ -467,20 +467,20 @@ namespace ouzel::graphics
     {
     public:
         SetTextureDataCommand(ResourceId initTexture,
-                              const std::vector<std::pair<Size2U, std::vector<std::uint8_t>>>& initLevels) noexcept(false):
+                              std::vector<std::pair<Size2U, std::vector<std::uint8_t>>> initLevels) noexcept(false):
             Command(Command::Type::setTextureData),
             texture(initTexture),
-            levels(initLevels),
+            levels(std::move(initLevels)),
             face(CubeFace::positiveX)
         {
         }
 
         SetTextureDataCommand(ResourceId initTexture,
-                              const std::vector<std::pair<Size2U, std::vector<std::uint8_t>>>& initLevels,
+                              std::vector<std::pair<Size2U, std::vector<std::uint8_t>>> initLevels,
                               CubeFace initFace) noexcept(false):
             Command(Command::Type::setTextureData),
             texture(initTexture),
-            levels(initLevels),
+            levels(std::move(initLevels)),
             face(initFace)
         {
         }
@@ -0,0 +1,384 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include "MeshOptimizer.hpp"
+#include "../math/Box.hpp"
+
+namespace ouzel::graphics
+{
+    namespace
+    {
+        constexpr std::size_t cacheSize = 32;
+        constexpr std::uint32_t fifoCacheSize = 16;
+        constexpr std::uint32_t maxGridSize = 1024;
+        constexpr auto noIndex = std::numeric_limits<std::uint32_t>::max();
+
+        // vertex score from "Linear-Speed Vertex Cache Optimisation" by Tom Forsyth
+        float getVertexScore(std::int32_t cachePosition, std::uint32_t remainingTriangles) noexcept
+        {
+            if (remainingTriangles == 0) return -1.0F;
+
+            float score = 0.0F;
+
+            if (cachePosition >= 0)
+            {
+                if (cachePosition < 3) // the last triangle's vertices
+                    score = 0.75F;
+                else
+                    score = std::pow(1.0F - static_cast<float>(cachePosition - 3) / static_cast<float>(cacheSize - 3), 1.5F);
+            }
+
+            // favor vertices with few remaining triangles to avoid leaving lone triangles behind
+            return score + 2.0F / std::sqrt(static_cast<float>(remainingTriangles));
+        }
+
+        std::vector<std::uint32_t> clusterVertices(const std::vector<std::uint32_t>& indices,
+                                                   const std::vector<Vertex>& vertices,
+                                                   const Box3F& bounds,
+                                                   std::uint32_t gridSize)
+        {
+            const auto extent = bounds.max - bounds.min;
+            const auto size = std::max({extent.v[0], extent.v[1], extent.v[2]});
+            const auto scale = (size > 0.0F) ? static_cast<float>(gridSize) / size : 0.0F;
+
+            const auto getCell = [&bounds, scale, gridSize](float value, std::size_t axis) noexcept {
+                return std::min(static_cast<std::uint32_t>((value - bounds.min.v[axis]) * scale), gridSize - 1);
+            };
+
+            std::unordered_map<std::uint64_t, std::uint32_t> cellClusters;
+            std::vector<std::uint32_t> vertexClusters(vertices.size(), noIndex);
+            std::vector<Vector3F> clusterCenters;
+            std::vector<std::uint32_t> clusterSizes;
+
+            for (const auto index : indices)
+                if (vertexClusters[index] == noIndex)
+                {
+                    const auto& position = vertices[index].position;
+                    const auto key = (static_cast<std::uint64_t>(getCell(position.v[0], 0)) * gridSize +
+                                      getCell(position.v[1], 1)) * gridSize + getCell(position.v[2], 2);
+
+                    const auto result = cellClusters.insert(std::pair(key, static_cast<std::uint32_t>(clusterCenters.size())));
+                    if (result.second)
+                    {
+                        clusterCenters.emplace_back();
+                        clusterSizes.push_back(0);
+                    }
+
+                    const auto cluster = result.first->second;
+                    vertexClusters[index] = cluster;
+                    clusterCenters[cluster] += position;
+                    ++clusterSizes[cluster];
+                }
+
+            for (std::size_t i = 0; i < clusterCenters.size(); ++i)
+                clusterCenters[i] /= static_cast<float>(clusterSizes[i]);
+
+            // every cluster is represented by its vertex that is the closest to the cluster's center
+            std::vector<std::uint32_t> representatives(clusterCenters.size(), noIndex);
+            std::vector<float> distances(clusterCenters.size(), std::numeric_limits<float>::max());
+
+            for (std::size_t i = 0; i < vertices.size(); ++i)
+                if (const auto cluster = vertexClusters[i]; cluster != noIndex)
+                {
+                    const auto distance = vertices[i].position.distanceSquared(clusterCenters[cluster]);
+                    if (distance < distances[cluster])
+                    {
+                        distances[cluster] = distance;
+                        representatives[cluster] = static_cast<std::uint32_t>(i);
+                    }
+                }
+
+            std::vector<std::uint32_t> result;
+
+            for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+            {
+                const auto a = representatives[vertexClusters[indices[i + 0]]];
+                const auto b = representatives[vertexClusters[indices[i + 1]]];
+                const auto c = representatives[vertexClusters[indices[i + 2]]];
+
+                // skip the collapsed triangles
+                if (a != b && b != c && c != a)
+                {
+                    result.push_back(a);
+                    result.push_back(b);
+                    result.push_back(c);
+                }
+            }
+
+            return result;
+        }
+    }
+
+    void optimizeVertexCache(std::vector<std::uint32_t>& indices,
+                             std::size_t vertexCount)
+    {
+        const auto triangleCount = indices.size() / 3;
+        if (triangleCount < 2) return;
+
+        std::vector<std::uint32_t> remainingTriangles(vertexCount, 0);
+        for (std::size_t i = 0; i < triangleCount * 3; ++i)
+        {
+            if (indices[i] >= vertexCount)
+                throw std::out_of_range("Invalid vertex index");
+
+            ++remainingTriangles[indices[i]];
+        }
+
+        // triangles that use each vertex
+        std::vector<std::uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+        for (std::size_t v = 0; v < vertexCount; ++v)
+            adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remainingTriangles[v];
+
+        std::vector<std::uint32_t> adjacency(triangleCount * 3);
+        std::vector<std::uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (std::size_t t = 0; t < triangleCount; ++t)
+            for (std::size_t c = 0; c < 3; ++c)
+                adjacency[adjacencyFill[indices[t * 3 + c]]++] = static_cast<std::uint32_t>(t);
+
+        std::vector<std::int32_t> cachePositions(vertexCount, -1);
+        std::vector<float> vertexScores(vertexCount);
+        for (std::size_t v = 0; v < vertexCount; ++v)
+            vertexScores[v] = getVertexScore(-1, remainingTriangles[v]);
+
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<std::uint32_t> result;
+        result.reserve(indices.size());
+
+        std::vector<std::uint32_t> cache;
+        std::vector<std::uint32_t> newCache;
+        cache.reserve(cacheSize + 3);
+        newCache.reserve(cacheSize + 3);
+
+        std::size_t scanPosition = 0;
+        std::size_t bestTriangle = 0;
+
+        for (std::size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+        {
+            if (bestTriangle == noIndex)
+            {
+                // no triangles touch the cache, continue with the next unemitted triangle
+                while (emitted[scanPosition]) ++scanPosition;
+                bestTriangle = scanPosition;
+            }
+
+            emitted[bestTriangle] = true;
+
+            const std::uint32_t triangle[] = {
+                indices[bestTriangle * 3 + 0],
+                indices[bestTriangle * 3 + 1],
+                indices[bestTriangle * 3 + 2]
+            };
+
+            newCache.clear();
+
+            for (const auto v : triangle)
+            {
+                result.push_back(v);
+                newCache.push_back(v);
+
+                // remove the triangle from the vertex's list of remaining triangles
+                const auto begin = adjacency.begin() + adjacencyOffsets[v];
+                const auto end = begin + remainingTriangles[v];
+                const auto i = std::find(begin, end, static_cast<std::uint32_t>(bestTriangle));
+                std::iter_swap(i, end - 1);
+                --remainingTriangles[v];
+            }
+
+            for (const auto v : cache)
+                if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                    newCache.push_back(v);
+
+            for (std::size_t i = 0; i < newCache.size(); ++i)
+            {
+                const auto v = newCache[i];
+                cachePositions[v] = (i < cacheSize) ? static_cast<std::int32_t>(i) : -1;
+                vertexScores[v] = getVertexScore(cachePositions[v], remainingTriangles[v]);
+            }
+
+            bestTriangle = noIndex;
+            float bestScore = std::numeric_limits<float>::lowest();
+
+            for (const auto v : newCache)
+                for (std::uint32_t i = 0; i < remainingTriangles[v]; ++i)
+                {
+                    const auto t = adjacency[adjacencyOffsets[v] + i];
+                    const auto score = vertexScores[indices[t * 3 + 0]] +
+                        vertexScores[indices[t * 3 + 1]] +
+                        vertexScores[indices[t * 3 + 2]];
+
+                    if (score > bestScore)
+                    {
+                        bestScore = score;
+                        bestTriangle = t;
+                    }
+                }
+
+            if (newCache.size() > cacheSize) newCache.resize(cacheSize);
+            cache.swap(newCache);
+        }
+
+        std::copy(indices.begin() + static_cast<std::ptrdiff_t>(triangleCount * 3),
+                  indices.end(), std::back_inserter(result));
+        indices.swap(result);
+    }
+
+    void optimizeOverdraw(std::vector<std::uint32_t>& indices,
+                          const std::vector<Vertex>& vertices)
+    {
+        const auto triangleCount = indices.size() / 3;
+        if (triangleCount < 2) return;
+
+        // split the triangles into clusters at the points where all vertices miss the cache,
+        // reordering these clusters keeps the cache efficiency of the original order
+        std::vector<std::size_t> clusterStarts;
+        std::vector<std::uint32_t> timestamps(vertices.size(), 0);
+        std::uint32_t time = fifoCacheSize + 1;
+
+        for (std::size_t t = 0; t < triangleCount; ++t)
+        {
+            std::uint32_t misses = 0;
+
+            for (std::size_t c = 0; c < 3; ++c)
+            {
+                const auto v = indices[t * 3 + c];
+                if (v >= vertices.size())
+                    throw std::out_of_range("Invalid vertex index");
+
+                if (time - timestamps[v] > fifoCacheSize)
+                {
+                    timestamps[v] = time++;
+                    ++misses;
+                }
+            }
+
+            if (misses == 3 || clusterStarts.empty())
+                clusterStarts.push_back(t);
+        }
+
+        if (clusterStarts.size() < 2) return;
+
+        clusterStarts.push_back(triangleCount);
+
+        const auto clusterCount = clusterStarts.size() - 1;
+        std::vector<Vector3F> clusterCentroids(clusterCount);
+        std::vector<Vector3F> clusterNormals(clusterCount);
+        std::vector<float> clusterAreas(clusterCount, 0.0F);
+        Vector3F meshCentroid;
+        float meshArea = 0.0F;
+
+        for (std::size_t cluster = 0; cluster < clusterCount; ++cluster)
+        {
+            for (std::size_t t = clusterStarts[cluster]; t < clusterStarts[cluster + 1]; ++t)
+            {
+                const auto& p0 = vertices[indices[t * 3 + 0]].position;
+                const auto& p1 = vertices[indices[t * 3 + 1]].position;
+                const auto& p2 = vertices[indices[t * 3 + 2]].position;
+
+                const auto normal = (p1 - p0).cross(p2 - p0);
+                const auto area = normal.length();
+
+                clusterCentroids[cluster] += (p0 + p1 + p2) * (area / 3.0F);
+                clusterNormals[cluster] += normal;
+                clusterAreas[cluster] += area;
+            }
+
+            meshCentroid += clusterCentroids[cluster];
+            meshArea += clusterAreas[cluster];
+        }
+
+        if (meshArea > 0.0F) meshCentroid /= meshArea;
+
+        // clusters that face away from the center of the mesh occlude the others, so they are drawn first
+        std::vector<float> sortKeys(clusterCount, 0.0F);
+        for (std::size_t cluster = 0; cluster < clusterCount; ++cluster)
+            if (clusterAreas[cluster] > 0.0F)
+            {
+                const auto centroid = clusterCentroids[cluster] / clusterAreas[cluster];
+                sortKeys[cluster] = (centroid - meshCentroid).dot(clusterNormals[cluster].normalized());
+            }
+
+        std::vector<std::size_t> order(clusterCount);
+        for (std::size_t i = 0; i < clusterCount; ++i) order[i] = i;
+
+        std::stable_sort(order.begin(), order.end(), [&sortKeys](std::size_t a, std::size_t b) noexcept {
+            return sortKeys[a] > sortKeys[b];
+        });
+
+        std::vector<std::uint32_t> result;
+        result.reserve(indices.size());
+
+        for (const auto cluster : order)
+            result.insert(result.end(),
+                          indices.begin() + static_cast<std::ptrdiff_t>(clusterStarts[cluster] * 3),
+                          indices.begin() + static_cast<std::ptrdiff_t>(clusterStarts[cluster + 1] * 3));
+
+        std::copy(indices.begin() + static_cast<std::ptrdiff_t>(triangleCount * 3),
+                  indices.end(), std::back_inserter(result));
+        indices.swap(result);
+    }
+
+    void optimizeVertexFetch(std::vector<std::uint32_t>& indices,
+                             std::vector<Vertex>& vertices)
+    {
+        std::vector<std::uint32_t> remap(vertices.size(), noIndex);
+        std::vector<Vertex> result;
+        result.reserve(vertices.size());
+
+        for (auto& index : indices)
+        {
+            if (index >= vertices.size())
+                throw std::out_of_range("Invalid vertex index");
+
+            if (remap[index] == noIndex)
+            {
+                remap[index] = static_cast<std::uint32_t>(result.size());
+                result.push_back(vertices[index]);
+            }
+
+            index = remap[index];
+        }
+
+        vertices.swap(result);
+    }
+
+    std::vector<std::uint32_t> simplify(const std::vector<std::uint32_t>& indices,
+                                        const std::vector<Vertex>& vertices,
+                                        std::size_t targetIndexCount)
+    {
+        if (indices.size() <= targetIndexCount) return indices;
+
+        Box3F bounds;
+        for (const auto index : indices)
+        {
+            if (index >= vertices.size())
+                throw std::out_of_range("Invalid vertex index");
+
+            bounds.insertPoint(vertices[index].position);
+        }
+
+        // find the finest grid that produces no more than the requested amount of indices
+        std::vector<std::uint32_t> result;
+        std::uint32_t low = 1;
+        std::uint32_t high = maxGridSize;
+
+        while (low <= high)
+        {
+            const auto gridSize = low + (high - low) / 2;
+            auto clustered = clusterVertices(indices, vertices, bounds, gridSize);
+
+            if (clustered.size() <= targetIndexCount)
+            {
+                result = std::move(clustered);
+                low = gridSize + 1;
+            }
+            else
+                high = gridSize - 1;
+        }
+
+        return result;
+    }
+}
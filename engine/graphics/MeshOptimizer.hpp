@@ -0,0 +1,30 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_GRAPHICS_MESHOPTIMIZER_HPP
+#define OUZEL_GRAPHICS_MESHOPTIMIZER_HPP
+
+#include <cstdint>
+#include <vector>
+#include "Vertex.hpp"
+
+namespace ouzel::graphics
+{
+    // reorders the triangles to maximize the post-transform vertex cache hits
+    void optimizeVertexCache(std::vector<std::uint32_t>& indices,
+                             std::size_t vertexCount);
+
+    // reorders the cache-optimized triangle clusters so that the outer ones are drawn first
+    void optimizeOverdraw(std::vector<std::uint32_t>& indices,
+                          const std::vector<Vertex>& vertices);
+
+    // reorders the vertices in the order of their first use and removes unused ones
+    void optimizeVertexFetch(std::vector<std::uint32_t>& indices,
+                             std::vector<Vertex>& vertices);
+
+    // returns a simplified index list (referencing the same vertices) with at most targetIndexCount indices
+    std::vector<std::uint32_t> simplify(const std::vector<std::uint32_t>& indices,
+                                        const std::vector<Vertex>& vertices,
+                                        std::size_t targetIndexCount);
+}
+
+#endif // OUZEL_GRAPHICS_MESHOPTIMIZER_HPP
@@ -686,7 +686,7 @@ namespace ouzel::graphics
         std::vector<std::pair<Size2U, std::vector<std::uint8_t>>> levels = calculateSizes(size, mipmaps, pixelFormat);
 
         initGraphics.addCommand(std::make_unique<InitTextureCommand>(resource,
-                                                                    levels,
+                                                                    std::move(levels),
                                                                     TextureType::twoDimensional,
                                                                     flags,
                                                                     sampleCount,
@@ -721,7 +721,7 @@ namespace ouzel::graphics
         std::vector<std::pair<Size2U, std::vector<std::uint8_t>>> levels = calculateSizes(size, initData, mipmaps, pixelFormat);
 
         initGraphics.addCommand(std::make_unique<InitTextureCommand>(resource,
-                                                                     levels,
+                                                                     std::move(levels),
                                                                      TextureType::twoDimensional,
                                                                      flags,
                                                                      sampleCount,
@@ -731,7 +731,7 @@ namespace ouzel::graphics
     }
 
     Texture::Texture(Graphics& initGraphics,
-                     const std::vector<std::pair<Size2U, std::vector<std::uint8_t>>>& initLevels,
+                     std::vector<std::pair<Size2U, std::vector<std::uint8_t>>> initLevels,
                      const Size2U& initSize,
                      Flags initFlags,
                      PixelFormat initPixelFormat):
@@ -749,7 +749,7 @@ namespace ouzel::graphics
             (mipmaps == 0 || mipmaps > 1))
             throw std::runtime_error("Invalid mip map count");
 
-        std::vector<std::pair<Size2U, std::vector<std::uint8_t>>> levels = initLevels;
+        std::vector<std::pair<Size2U, std::vector<std::uint8_t>>> levels = std::move(initLevels);
 
         if (!initGraphics.getDevice()->isNPOTTexturesSupported() && !isPowerOfTwo(size))
         {
@@ -758,7 +758,7 @@ namespace ouzel::graphics
         }
 
         initGraphics.addCommand(std::make_unique<InitTextureCommand>(resource,
-                                                                     levels,
+                                                                     std::move(levels),
                                                                      TextureType::twoDimensional,
                                                                      flags,
                                                                      sampleCount,
@@ -767,17 +767,25 @@ namespace ouzel::graphics
                                                                      maxAnisotropy));
     }
 
+    std::vector<std::pair<Size2U, std::vector<std::uint8_t>>> Texture::createLevels(const std::vector<std::uint8_t>& data,
+                                                                                    const Size2U& size,
+                                                                                    std::uint32_t mipmaps,
+                                                                                    PixelFormat pixelFormat)
+    {
+        return calculateSizes(size, data, mipmaps, pixelFormat);
+    }
+
     void Texture::setData(const std::vector<std::uint8_t>& newData, CubeFace face)
     {
         if ((flags & Flags::dynamic) != Flags::dynamic ||
             (flags & Flags::bindRenderTarget) == Flags::bindRenderTarget)
             throw std::runtime_error("Texture is not dynamic");
 
-        const std::vector<std::pair<Size2U, std::vector<std::uint8_t>>> levels = calculateSizes(size, newData, mipmaps, pixelFormat);
+        std::vector<std::pair<Size2U, std::vector<std::uint8_t>>> levels = calculateSizes(size, newData, mipmaps, pixelFormat);
 
         if (resource)
             graphics->addCommand(std::make_unique<SetTextureDataCommand>(resource,
-                                                                         levels,
+                                                                         std::move(levels),
                                                                          face));
     }
 
@@ -38,11 +38,17 @@ namespace ouzel::graphics
                 std::uint32_t initMipmaps = 0,
                 PixelFormat initPixelFormat = PixelFormat::rgba8UnsignedNorm);
         Texture(Graphics& initGraphics,
-                const std::vector<std::pair<Size2U, std::vector<std::uint8_t>>>& initLevels,
+                std::vector<std::pair<Size2U, std::vector<std::uint8_t>>> initLevels,
                 const Size2U& initSize,
                 Flags initFlags = Flags::none,
                 PixelFormat initPixelFormat = PixelFormat::rgba8UnsignedNorm);
 
+        // the mip levels of the data, they can be calculated on any thread and passed to the constructor
+        static std::vector<std::pair<Size2U, std::vector<std::uint8_t>>> createLevels(const std::vector<std::uint8_t>& data,
+                                                                                      const Size2U& size,
+                                                                                      std::uint32_t mipmaps,
+                                                                                      PixelFormat pixelFormat);
+
         auto& getResource() const noexcept { return resource; }
 
         auto& getSize() const noexcept { return size; }
@@ -37,6 +37,10 @@ namespace ouzel::gui
                                          Color color,
                                          float fontSize,
                                          const Vector2F& anchor) const = 0;
+
+        // uploads the glyphs rasterized by getRenderData since the last call, called before drawing,
+        // so that the glyph textures are uploaded once per frame
+        virtual void uploadGlyphs() const {}
     };
 }
 
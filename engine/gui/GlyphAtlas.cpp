@@ -0,0 +1,102 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include "GlyphAtlas.hpp"
+#include "../core/Engine.hpp"
+
+namespace ouzel::gui
+{
+    GlyphAtlas::Page::Page(std::uint32_t initSize):
+        size(initSize),
+        coverage(size * size, 0),
+        textureData(size * size * 4, 255)
+    {
+        for (std::size_t i = 0; i < coverage.size(); ++i)
+            textureData[i * 4 + 3] = 0;
+    }
+
+    const GlyphAtlas::Region* GlyphAtlas::Page::findRegion(std::uint64_t key) const
+    {
+        const auto i = regions.find(key);
+        return (i != regions.end()) ? &i->second : nullptr;
+    }
+
+    const GlyphAtlas::Region* GlyphAtlas::Page::allocateRegion(std::uint64_t key,
+                                                               std::uint16_t width,
+                                                               std::uint16_t height)
+    {
+        if (width + padding * 2 > size || height + padding * 2 > size)
+            return nullptr;
+
+        // start a new row
+        if (rowX + width + padding > size)
+        {
+            rowX = padding;
+            rowY += rowHeight + padding;
+            rowHeight = 0;
+        }
+
+        if (rowY + height + padding > size)
+            return nullptr;
+
+        Region region;
+        region.x = static_cast<std::uint16_t>(rowX);
+        region.y = static_cast<std::uint16_t>(rowY);
+        region.width = width;
+        region.height = height;
+
+        rowX += width + padding;
+        if (height > rowHeight) rowHeight = height;
+
+        dirtyTop = std::min(dirtyTop, rowY);
+        dirtyBottom = std::max(dirtyBottom, rowY + height);
+
+        return &(regions[key] = region);
+    }
+
+    const std::shared_ptr<graphics::Texture>& GlyphAtlas::Page::getTexture()
+    {
+        if (!texture)
+        {
+            updateTextureData();
+            texture = std::make_shared<graphics::Texture>(*engine->getGraphics(),
+                                                          textureData,
+                                                          Size2U(size, size),
+                                                          graphics::Flags::dynamic,
+                                                          1);
+        }
+
+        return texture;
+    }
+
+    void GlyphAtlas::Page::upload()
+    {
+        if (texture && dirtyTop < dirtyBottom)
+        {
+            updateTextureData();
+            texture->setData(textureData);
+        }
+    }
+
+    void GlyphAtlas::Page::updateTextureData() noexcept
+    {
+        // only the rows of the new glyphs are converted
+        for (std::size_t i = dirtyTop * size; i < dirtyBottom * size; ++i)
+            textureData[i * 4 + 3] = coverage[i];
+
+        dirtyTop = size;
+        dirtyBottom = 0;
+    }
+
+    GlyphAtlas::Page& GlyphAtlas::addPage()
+    {
+        pages.push_back(std::make_unique<Page>());
+        return *pages.back();
+    }
+
+    void GlyphAtlas::upload()
+    {
+        for (const auto& page : pages)
+            page->upload();
+    }
+}
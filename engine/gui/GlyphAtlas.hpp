@@ -0,0 +1,82 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_GUI_GLYPHATLAS_HPP
+#define OUZEL_GUI_GLYPHATLAS_HPP
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "../graphics/Texture.hpp"
+
+namespace ouzel::gui
+{
+    class GlyphAtlas final
+    {
+    public:
+        static constexpr std::uint32_t pageSize = 512;
+        static constexpr std::uint32_t padding = 1;
+
+        struct Region final
+        {
+            std::uint16_t x = 0;
+            std::uint16_t y = 0;
+            std::uint16_t width = 0;
+            std::uint16_t height = 0;
+        };
+
+        // glyphs are packed in rows into a single channel coverage bitmap, the page texture has no mipmaps,
+        // because the padding between the glyphs is too narrow for the smaller levels
+        class Page final
+        {
+        public:
+            explicit Page(std::uint32_t initSize = pageSize);
+
+            auto getSize() const noexcept { return size; }
+
+            const Region* findRegion(std::uint64_t key) const;
+
+            // returns nullptr if the page is full, the glyph has to be rasterized at getData(region)
+            const Region* allocateRegion(std::uint64_t key, std::uint16_t width, std::uint16_t height);
+
+            std::uint8_t* getData(const Region& region) noexcept
+            {
+                return coverage.data() + region.y * size + region.x;
+            }
+
+            // creates the texture on the first call, the glyphs added later are uploaded by upload
+            const std::shared_ptr<graphics::Texture>& getTexture();
+
+            // uploads the page if glyphs were added since the last upload
+            void upload();
+
+        private:
+            void updateTextureData() noexcept;
+
+            std::uint32_t size = pageSize;
+            std::vector<std::uint8_t> coverage;
+            std::vector<std::uint8_t> textureData; // white with the coverage in alpha, as the texture shader expects
+            std::unordered_map<std::uint64_t, Region> regions;
+            std::uint32_t rowX = padding;
+            std::uint32_t rowY = padding;
+            std::uint32_t rowHeight = 0;
+            std::shared_ptr<graphics::Texture> texture;
+            // the rows that were rasterized since the last upload
+            std::uint32_t dirtyTop = size;
+            std::uint32_t dirtyBottom = 0;
+        };
+
+        auto getPageCount() const noexcept { return pages.size(); }
+        Page& getPage(std::size_t index) const { return *pages[index]; }
+        Page& addPage();
+
+        // uploads the glyphs of all the pages at once, so that a page is uploaded at most once per frame
+        // no matter how many texts added glyphs to it
+        void upload();
+
+    private:
+        std::vector<std::unique_ptr<Page>> pages;
+    };
+}
+
+#endif // OUZEL_GUI_GLYPHATLAS_HPP
@@ -27,9 +27,13 @@
 
 namespace ouzel::gui
 {
-    TTFont::TTFont(const std::vector<std::byte>& initData, bool initMipmaps):
-        data(initData),
-        mipmaps(initMipmaps)
+    namespace
+    {
+        constexpr std::uint32_t maxPageSize = 16384;
+    }
+
+    TTFont::TTFont(const std::vector<std::byte>& initData):
+        data(initData)
     {
         const auto offset = stbtt_GetFontOffsetForIndex(reinterpret_cast<const unsigned char*>(data.data()), 0);
 
@@ -42,120 +46,115 @@ namespace ouzel::gui
             throw std::runtime_error("Failed to load font");
     }
 
-    Font::RenderData TTFont::getRenderData(const std::string& text,
-                                           Color color,
-                                           float fontSize,
-                                           const Vector2F& anchor) const
+    const TTFont::Glyph* TTFont::getGlyph(char32_t c, float fontSize, float scale) const
     {
-        if (!font)
-            throw std::runtime_error("Font not loaded");
-
-        constexpr std::uint32_t spacing = 2U;
-
-        const float s = stbtt_ScaleForPixelHeight(font.get(), fontSize);
-
-        const std::u32string utf32Text = utf8::toUtf32(text);
-
-        std::set<char32_t> glyphs;
-        for (const char32_t i : utf32Text)
-            glyphs.insert(i);
-
-        std::uint16_t width = 0;
-        std::uint16_t height = 0;
+        const auto key = getGlyphKey(c, fontSize);
 
-        int ascent;
-        int descent;
-        int lineGap;
-        stbtt_GetFontVMetrics(font.get(), &ascent, &descent, &lineGap);
-
-        struct CharDescriptor final
-        {
-            std::uint16_t x = 0;
-            std::uint16_t y = 0;
-            std::uint16_t width = 0;
-            std::uint16_t height = 0;
-            Vector2F offset;
-            float advance = 0;
-            std::vector<std::uint8_t> bitmap;
-        };
-
-        std::unordered_map<std::uint32_t, CharDescriptor> chars;
-
-        for (const char32_t c : glyphs)
+        auto i = glyphs.find(key);
+        if (i == glyphs.end())
         {
-            int w;
-            int h;
-            int xoff;
-            int yoff;
+            Glyph glyph;
 
-            if (const auto index = stbtt_FindGlyphIndex(font.get(), static_cast<int>(c)))
+            if ((glyph.index = stbtt_FindGlyphIndex(font.get(), static_cast<int>(c))))
             {
+                int ascent;
+                int descent;
+                int lineGap;
+                stbtt_GetFontVMetrics(font.get(), &ascent, &descent, &lineGap);
+
                 int advance;
                 int leftBearing;
-                stbtt_GetGlyphHMetrics(font.get(), index, &advance, &leftBearing);
+                stbtt_GetGlyphHMetrics(font.get(), glyph.index, &advance, &leftBearing);
 
-                CharDescriptor charDesc;
+                int x0;
+                int y0;
+                int x1;
+                int y1;
+                stbtt_GetGlyphBitmapBoxSubpixel(font.get(), glyph.index, scale, scale, 0.0F, 0.0F, &x0, &y0, &x1, &y1);
 
-                if (const auto bitmap = stbtt_GetGlyphBitmapSubpixel(font.get(), s, s, 0.0F, 0.0F, index, &w, &h, &xoff, &yoff))
+                if (x1 > x0 && y1 > y0)
                 {
-                    charDesc.width = static_cast<std::uint16_t>(w);
-                    charDesc.height = static_cast<std::uint16_t>(h);
-                    charDesc.offset.v[0] = static_cast<float>(leftBearing * s);
-                    charDesc.offset.v[1] = static_cast<float>(yoff + (ascent - descent) * s);
-                    charDesc.bitmap = std::vector<std::uint8_t>(bitmap, bitmap + h * w);
-                    charDesc.x = width;
-
-                    width += static_cast<std::uint16_t>(w);
-                    height = std::max(height, static_cast<std::uint16_t>(h));
-
-                    stbtt_FreeBitmap(bitmap, nullptr);
+                    glyph.width = static_cast<std::uint16_t>(x1 - x0);
+                    glyph.height = static_cast<std::uint16_t>(y1 - y0);
+                    glyph.offset.v[0] = static_cast<float>(leftBearing * scale);
+                    glyph.offset.v[1] = static_cast<float>(y0 + (ascent - descent) * scale);
                 }
 
-                charDesc.advance = static_cast<float>(advance * s);
-
-                if (!chars.empty())
-                    width += spacing;
-
-                chars[c] = charDesc;
+                glyph.advance = static_cast<float>(advance * scale);
             }
+
+            i = glyphs.insert(std::pair(key, glyph)).first;
         }
 
-        std::vector<std::uint8_t> textureData(width * height * 4);
+        return i->second.index ? &i->second : nullptr;
+    }
 
-        for (std::uint16_t posX = 0; posX < width; ++posX)
-        {
-            for (std::uint16_t posY = 0; posY < height; ++posY)
+    bool TTFont::placeGlyphs(GlyphAtlas::Page& page,
+                             const std::u32string& text,
+                             float fontSize,
+                             float scale) const
+    {
+        for (const char32_t c : text)
+            if (const auto glyph = getGlyph(c, fontSize, scale); glyph && glyph->width && glyph->height)
             {
-                textureData[(posY * width + posX) * 4 + 0] = 255;
-                textureData[(posY * width + posX) * 4 + 1] = 255;
-                textureData[(posY * width + posX) * 4 + 2] = 255;
-                textureData[(posY * width + posX) * 4 + 3] = 0;
+                const auto key = getGlyphKey(c, fontSize);
+
+                if (!page.findRegion(key))
+                {
+                    const auto region = page.allocateRegion(key, glyph->width, glyph->height);
+                    if (!region) return false;
+
+                    stbtt_MakeGlyphBitmapSubpixel(font.get(),
+                                                  page.getData(*region),
+                                                  region->width, region->height,
+                                                  static_cast<int>(page.getSize()),
+                                                  scale, scale, 0.0F, 0.0F,
+                                                  glyph->index);
+                }
             }
-        }
 
-        for (const auto& c : chars)
+        return true;
+    }
+
+    Font::RenderData TTFont::getRenderData(const std::string& text,
+                                           Color color,
+                                           float fontSize,
+                                           const Vector2F& anchor) const
+    {
+        if (!font)
+            throw std::runtime_error("Font not loaded");
+
+        const float s = stbtt_ScaleForPixelHeight(font.get(), fontSize);
+
+        const std::u32string utf32Text = utf8::toUtf32(text);
+
+        int ascent;
+        int descent;
+        int lineGap;
+        stbtt_GetFontVMetrics(font.get(), &ascent, &descent, &lineGap);
+
+        // all glyphs of the text have to be on the same page, start a new one if the last page is full
+        auto page = atlas.getPageCount() ? &atlas.getPage(atlas.getPageCount() - 1) : &atlas.addPage();
+        std::unique_ptr<GlyphAtlas::Page> dedicatedPage;
+
+        if (!placeGlyphs(*page, utf32Text, fontSize, s))
         {
-            const auto& charDesc = c.second;
+            page = &atlas.addPage();
 
-            for (std::uint16_t posX = 0; posX < charDesc.width; ++posX)
+            // text that does not fit on an empty page gets a page of its own that is not shared with other texts
+            for (auto size = GlyphAtlas::pageSize * 2; !placeGlyphs(*page, utf32Text, fontSize, s); size *= 2)
             {
-                for (std::uint16_t posY = 0; posY < charDesc.height; ++posY)
-                {
-                    textureData[(posY * width + posX + charDesc.x) * 4 + 0] = 255;
-                    textureData[(posY * width + posX + charDesc.x) * 4 + 1] = 255;
-                    textureData[(posY * width + posX + charDesc.x) * 4 + 2] = 255;
-                    textureData[(posY * width + posX + charDesc.x) * 4 + 3] = charDesc.bitmap[posY * charDesc.width + posX];
-                }
+                if (size > maxPageSize)
+                    throw std::runtime_error("Text is too large");
+
+                dedicatedPage = std::make_unique<GlyphAtlas::Page>(size);
+                page = dedicatedPage.get();
             }
         }
 
-        RenderData result;
-
-        auto texture = std::make_shared<graphics::Texture>(*engine->getGraphics(),
-                                                           textureData,
-                                                           Size2U(width, height),
-                                                           graphics::Flags::none,
-                                                           mipmaps ? 0 : 1);
+        // the dedicated page is released after this call, so its texture is created with all the glyphs
+        auto texture = page->getTexture();
+        const auto textureSize = static_cast<float>(page->getSize());
 
         Vector2F position;
 
@@ -170,11 +169,9 @@ namespace ouzel::gui
 
         for (auto i = utf32Text.begin(); i != utf32Text.end(); ++i)
         {
-            auto iter = chars.find(*i);
-
-            if (iter != chars.end())
+            if (const auto glyph = getGlyph(*i, fontSize, s))
             {
-                const auto& f = iter->second;
+                const auto& f = *glyph;
 
                 const auto startIndex = static_cast<std::uint16_t>(vertices.size());
                 indices.push_back(startIndex + 0);
@@ -185,11 +182,17 @@ namespace ouzel::gui
                 indices.push_back(startIndex + 3);
                 indices.push_back(startIndex + 2);
 
-                Vector2F leftTop(f.x / static_cast<float>(width),
-                                 f.y / static_cast<float>(height));
+                Vector2F leftTop;
+                Vector2F rightBottom;
 
-                Vector2F rightBottom((f.x + f.width) / static_cast<float>(width),
-                                     (f.y + f.height) / static_cast<float>(height));
+                if (const auto region = page->findRegion(getGlyphKey(*i, fontSize)))
+                {
+                    leftTop = Vector2F(region->x / textureSize,
+                                       region->y / textureSize);
+
+                    rightBottom = Vector2F((region->x + region->width) / textureSize,
+                                           (region->y + region->height) / textureSize);
+                }
 
                 textCoords[0] = Vector2F(leftTop.v[0], rightBottom.v[1]);
                 textCoords[1] = Vector2F(rightBottom.v[0], rightBottom.v[1]);
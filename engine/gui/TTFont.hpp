@@ -4,6 +4,8 @@
 #define OUZEL_GUI_TTFONT_HPP
 
 #include "../gui/Font.hpp"
+#include "../gui/GlyphAtlas.hpp"
+#include "../utils/Utils.hpp"
 
 struct stbtt_fontinfo;
 
@@ -13,19 +15,44 @@ namespace ouzel::gui
     {
     public:
         TTFont() = default;
-        TTFont(const std::vector<std::byte>& newData, bool newMipmaps = true);
+        explicit TTFont(const std::vector<std::byte>& newData);
 
         RenderData getRenderData(const std::string& text,
                                  Color color,
                                  float fontSize,
                                  const Vector2F& anchor) const final;
 
+        void uploadGlyphs() const final { atlas.upload(); }
+
         float getStringWidth(const std::string& text);
 
     private:
+        struct Glyph final
+        {
+            int index = 0;
+            std::uint16_t width = 0;
+            std::uint16_t height = 0;
+            Vector2F offset;
+            float advance = 0.0F;
+        };
+
+        static std::uint64_t getGlyphKey(char32_t c, float fontSize) noexcept
+        {
+            return (static_cast<std::uint64_t>(bitCast<std::uint32_t>(fontSize)) << 32) | c;
+        }
+
+        const Glyph* getGlyph(char32_t c, float fontSize, float scale) const;
+        bool placeGlyphs(GlyphAtlas::Page& page,
+                         const std::u32string& text,
+                         float fontSize,
+                         float scale) const;
+
         std::unique_ptr<stbtt_fontinfo> font;
         std::vector<std::byte> data;
-        bool mipmaps = true;
+
+        // glyph metrics and rasterized glyphs are cached for every font size
+        mutable std::unordered_map<std::uint64_t, Glyph> glyphs;
+        mutable GlyphAtlas atlas;
     };
 }
 
@@ -63,7 +63,7 @@ namespace ouzel::input
                                                   STBI_default);
 
         if (!tempData)
-            throw std::runtime_error("Failed to load texture, reason: " + std::string(stbi_failure_reason()));
+            throw std::runtime_error("Failed to load texture");
 
         std::size_t pixelSize;
         graphics::PixelFormat pixelFormat;
@@ -25,6 +25,7 @@ LOCAL_SRC_FILES := ../assets/BmfLoader.cpp \
     ../assets/CueLoader.cpp \
     ../assets/GltfLoader.cpp \
     ../assets/ImageLoader.cpp \
+    ../assets/Loading.cpp \
     ../assets/MtlLoader.cpp \
     ../assets/ObjLoader.cpp \
     ../assets/ParticleSystemLoader.cpp \
@@ -32,9 +33,23 @@ LOCAL_SRC_FILES := ../assets/BmfLoader.cpp \
     ../assets/TtfLoader.cpp \
     ../assets/VorbisLoader.cpp \
     ../assets/WaveLoader.cpp \
+    ../audio/mixer/Biquad.cpp \
     ../audio/mixer/Bus.cpp \
+    ../audio/mixer/Spatializer.cpp \
+    ../audio/mixer/Fft.cpp \
+    ../audio/mixer/PhaseVocoder.cpp \
+    ../audio/mixer/Wavetable.cpp \
+    ../audio/mixer/Wsola.cpp \
+    ../audio/mixer/Convolver.cpp \
+    ../audio/mixer/Adpcm.cpp \
+    ../audio/mixer/Graph.cpp \
+    ../audio/mixer/Reverberator.cpp \
+    ../audio/mixer/Resampler.cpp \
+    ../audio/mixer/Realtime.cpp \
+    ../audio/mixer/Dsp.cpp \
     ../audio/mixer/Mixer.cpp \
     ../audio/opensl/OSLAudioDevice.cpp \
+    ../audio/offline/OfflineAudioDevice.cpp \
     ../audio/Audio.cpp \
     ../audio/AudioDevice.cpp \
     ../audio/Containers.cpp \
@@ -49,6 +64,8 @@ LOCAL_SRC_FILES := ../assets/BmfLoader.cpp \
     ../audio/SilenceSound.cpp \
     ../audio/Sound.cpp \
     ../audio/Submix.cpp \
+    ../audio/Streamer.cpp \
+    ../audio/WavePlayer.cpp \
     ../audio/Voice.cpp \
     ../audio/VorbisClip.cpp \
     ../core/android/EngineAndroid.cpp \
@@ -72,11 +89,13 @@ LOCAL_SRC_FILES := ../assets/BmfLoader.cpp \
     ../graphics/Buffer.cpp \
     ../graphics/DepthStencilState.cpp \
     ../graphics/Graphics.cpp \
+    ../graphics/MeshOptimizer.cpp \
     ../graphics/RenderDevice.cpp \
     ../graphics/RenderTarget.cpp \
     ../graphics/Shader.cpp \
     ../graphics/Texture.cpp \
     ../gui/BMFont.cpp \
+    ../gui/GlyphAtlas.cpp \
     ../gui/TTFont.cpp \
     ../gui/Widget.cpp \
     ../gui/Widgets.cpp \
@@ -100,6 +119,7 @@ LOCAL_SRC_FILES := ../assets/BmfLoader.cpp \
     ../network/Network.cpp \
     ../network/Server.cpp \
     ../scene/Actor.cpp \
+    ../scene/AnimationSystem.cpp \
     ../scene/Animator.cpp \
     ../scene/Animators.cpp \
     ../scene/Camera.cpp \
@@ -175,7 +175,7 @@ namespace ouzel
 
         constexpr void invert() noexcept
         {
-            constexpr T squared = v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3]; // norm squared
+            const T squared = v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3]; // norm squared
             if (squared <= std::numeric_limits<T>::min())
                 return;
 
@@ -189,7 +189,7 @@ namespace ouzel
 
         auto getNorm() const noexcept
         {
-            constexpr T n = v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3];
+            const T n = v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3];
             if (n == T(1)) // already normalized
                 return T(1);
 
@@ -198,7 +198,7 @@ namespace ouzel
 
         void normalize() noexcept
         {
-            constexpr T squared = v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3];
+            const T squared = v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3];
             if (squared == T(1)) // already normalized
                 return;
 
@@ -215,7 +215,7 @@ namespace ouzel
 
         Quaternion normalized() const noexcept
         {
-            constexpr T squared = v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3];
+            const T squared = v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3];
             if (squared == T(1)) // already normalized
                 return *this;
 
@@ -317,7 +317,7 @@ namespace ouzel
 
         Vector<T, 3> rotateVector(const Vector<T, 3>& vector) const noexcept
         {
-            constexpr Vector<T, 3> q(v[0], v[1], v[2]);
+            const Vector<T, 3> q(v[0], v[1], v[2]);
             const Vector<T, 3> t = T(2) * q.cross(vector);
             return vector + (v[3] * t) + q.cross(t);
         }
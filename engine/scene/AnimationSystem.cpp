@@ -0,0 +1,87 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#include <algorithm>
+#include "AnimationSystem.hpp"
+#include "Animator.hpp"
+#include "../core/Engine.hpp"
+
+namespace ouzel::scene
+{
+    AnimationSystem::~AnimationSystem()
+    {
+        for (Animator* animator : animators)
+            if (animator) animator->animationSystem = nullptr;
+    }
+
+    void AnimationSystem::update(float delta)
+    {
+        // animators started during the update are appended and advanced in the same pass
+        for (std::size_t i = 0; i < animators.size(); ++i)
+        {
+            Animator* animator = animators[i];
+            if (!animator) continue;
+
+            if (!animator->running)
+            {
+                removeAnimator(*animator);
+                continue;
+            }
+
+            if (animator->advance(delta))
+                finishedAnimators.push_back(animator);
+        }
+
+        compact();
+
+        // finish events are dispatched after all the animators have been advanced
+        for (std::size_t i = 0; i < finishedAnimators.size(); ++i)
+            if (Animator* animator = finishedAnimators[i])
+            {
+                auto finishEvent = std::make_unique<AnimationEvent>();
+                finishEvent->type = Event::Type::animationFinish;
+                finishEvent->component = animator;
+                engine->getEventDispatcher().dispatchEvent(std::move(finishEvent));
+            }
+
+        finishedAnimators.clear();
+    }
+
+    void AnimationSystem::addAnimator(Animator& animator)
+    {
+        if (animator.animationSystem == this) return;
+
+        if (animator.animationSystem)
+            animator.animationSystem->removeAnimator(animator);
+
+        animator.animationSystem = this;
+        animator.animationSystemIndex = animators.size();
+        animators.push_back(&animator);
+        ++animatorCount;
+    }
+
+    void AnimationSystem::removeAnimator(Animator& animator)
+    {
+        if (animator.animationSystem != this) return;
+
+        animators[animator.animationSystemIndex] = nullptr;
+        animator.animationSystem = nullptr;
+        --animatorCount;
+
+        // the animator can be deleted by a handler of another animator's finish event
+        std::replace(finishedAnimators.begin(), finishedAnimators.end(), &animator, static_cast<Animator*>(nullptr));
+    }
+
+    void AnimationSystem::compact()
+    {
+        std::size_t count = 0;
+
+        for (Animator* animator : animators)
+            if (animator)
+            {
+                animator->animationSystemIndex = count;
+                animators[count++] = animator;
+            }
+
+        animators.resize(count);
+    }
+}
@@ -0,0 +1,44 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_SCENE_ANIMATIONSYSTEM_HPP
+#define OUZEL_SCENE_ANIMATIONSYSTEM_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace ouzel::scene
+{
+    class Animator;
+
+    // Advances all started animators in a single pass per frame
+    class AnimationSystem final
+    {
+    public:
+        AnimationSystem() = default;
+        ~AnimationSystem();
+
+        AnimationSystem(const AnimationSystem&) = delete;
+        AnimationSystem& operator=(const AnimationSystem&) = delete;
+
+        AnimationSystem(AnimationSystem&&) = delete;
+        AnimationSystem& operator=(AnimationSystem&&) = delete;
+
+        void update(float delta);
+
+        void addAnimator(Animator& animator);
+        void removeAnimator(Animator& animator);
+
+        auto getAnimatorCount() const noexcept { return animatorCount; }
+
+    private:
+        void compact();
+
+        // removed animators leave empty slots that are compacted after each update
+        std::vector<Animator*> animators;
+        std::size_t animatorCount = 0;
+
+        std::vector<Animator*> finishedAnimators;
+    };
+}
+
+#endif // OUZEL_SCENE_ANIMATIONSYSTEM_HPP
@@ -4,6 +4,7 @@
 #include <cassert>
 #include "Animator.hpp"
 #include "Actor.hpp"
+#include "AnimationSystem.hpp"
 #include "../core/Engine.hpp"
 
 namespace ouzel::scene
@@ -11,14 +12,11 @@ namespace ouzel::scene
     Animator::Animator(float initLength):
         length(initLength)
     {
-        updateHandler.updateHandler = [this](const UpdateEvent& event) {
-            update(event.delta);
-            return false;
-        };
     }
 
     Animator::~Animator()
     {
+        if (animationSystem) animationSystem->removeAnimator(*this);
         if (parent) parent->removeAnimator(*this);
 
         for (const auto& animator : animators)
@@ -27,40 +25,48 @@ namespace ouzel::scene
 
     void Animator::update(float delta)
     {
-        if (running)
+        if (advance(delta))
         {
-            if (length == 0.0F) // never-ending animation
-            {
-                currentTime += delta;
-                progress = 0.0F;
-            }
-            else if (currentTime + delta >= length)
-            {
-                done = true;
-                running = false;
-                progress = 1.0F;
-                currentTime = length;
-
-                auto finishEvent = std::make_unique<AnimationEvent>();
-                finishEvent->type = Event::Type::animationFinish;
-                finishEvent->component = this;
-                engine->getEventDispatcher().dispatchEvent(std::move(finishEvent));
-            }
-            else
-            {
-                currentTime += delta;
-                progress = currentTime / length;
-            }
-
-            updateProgress();
+            auto finishEvent = std::make_unique<AnimationEvent>();
+            finishEvent->type = Event::Type::animationFinish;
+            finishEvent->component = this;
+            engine->getEventDispatcher().dispatchEvent(std::move(finishEvent));
+        }
+    }
+
+    bool Animator::advance(float delta)
+    {
+        if (!running) return false;
+
+        bool finished = false;
+
+        if (length == 0.0F) // never-ending animation
+        {
+            currentTime += delta;
+            progress = 0.0F;
+        }
+        else if (currentTime + delta >= length)
+        {
+            done = true;
+            running = false;
+            progress = 1.0F;
+            currentTime = length;
+            finished = true;
         }
         else
-            updateHandler.remove();
+        {
+            currentTime += delta;
+            progress = currentTime / length;
+        }
+
+        updateProgress();
+
+        return finished;
     }
 
     void Animator::start()
     {
-        engine->getEventDispatcher().addEventHandler(updateHandler);
+        engine->getSceneManager().getAnimationSystem().addAnimator(*this);
         play();
 
         auto startEvent = std::make_unique<AnimationEvent>();
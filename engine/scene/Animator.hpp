@@ -3,16 +3,19 @@
 #ifndef OUZEL_SCENE_ANIMATOR_HPP
 #define OUZEL_SCENE_ANIMATOR_HPP
 
+#include <cstddef>
 #include <memory>
 #include <vector>
 #include "Component.hpp"
-#include "../events/EventHandler.hpp"
 
 namespace ouzel::scene
 {
+    class AnimationSystem;
+
     class Animator: public Component
     {
         friend Actor;
+        friend AnimationSystem;
     public:
         explicit Animator(float initLength);
         ~Animator() override;
@@ -48,6 +51,9 @@ namespace ouzel::scene
     protected:
         virtual void updateProgress() {}
 
+        // returns true if the animation has finished
+        bool advance(float delta);
+
         float length = 0.0F;
         float currentTime = 0.0F;
         float progress = 0.0F;
@@ -57,7 +63,8 @@ namespace ouzel::scene
         Animator* parent = nullptr;
         Actor* targetActor = nullptr;
 
-        EventHandler updateHandler;
+        AnimationSystem* animationSystem = nullptr;
+        std::size_t animationSystemIndex = 0;
 
         std::vector<Animator*> animators;
         std::vector<std::unique_ptr<Animator>> ownedAnimators;
@@ -1,7 +1,12 @@
 // Copyright 2015-2020 Elviss Strazdins. All rights reserved.
 
+#if defined(__SSE__)
+#  include <xmmintrin.h>
+#endif
 #include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <limits>
 #include <stdexcept>
 #include "ParticleSystem.hpp"
 #include "SceneManager.hpp"
@@ -19,6 +24,60 @@ namespace ouzel::scene
     namespace
     {
         constexpr float updateStep = 1.0F / 60.0F;
+
+        // values[i] += deltas[i] * step
+        void integrate(float* values, const float* deltas, std::uint32_t count, float step) noexcept
+        {
+            std::uint32_t i = 0;
+
+#if defined(__SSE__)
+            const __m128 s = _mm_set1_ps(step);
+            for (; i + 4 <= count; i += 4)
+                _mm_storeu_ps(&values[i], _mm_add_ps(_mm_loadu_ps(&values[i]),
+                                                     _mm_mul_ps(_mm_loadu_ps(&deltas[i]), s)));
+#endif
+
+            for (; i < count; ++i)
+                values[i] += deltas[i] * step;
+        }
+    }
+
+    void ParticleSystem::Particles::resize(std::size_t newSize)
+    {
+        for (auto attribute : {
+            &life,
+            &positionX, &positionY,
+            &colorRed, &colorGreen, &colorBlue, &colorAlpha,
+            &deltaColorRed, &deltaColorGreen, &deltaColorBlue, &deltaColorAlpha,
+            &angle,
+            &this->size, &deltaSize,
+            &rotation, &deltaRotation,
+            &radialAcceleration, &tangentialAcceleration,
+            &directionX, &directionY,
+            &radius, &degreesPerSecond, &deltaRadius
+        })
+            attribute->resize(newSize);
+    }
+
+    void ParticleSystem::Particles::compact(const std::vector<std::pair<std::uint32_t, std::uint32_t>>& moves)
+    {
+        // life is compacted while the moves are collected
+        for (auto attribute : {
+            &positionX, &positionY,
+            &colorRed, &colorGreen, &colorBlue, &colorAlpha,
+            &deltaColorRed, &deltaColorGreen, &deltaColorBlue, &deltaColorAlpha,
+            &angle,
+            &size, &deltaSize,
+            &rotation, &deltaRotation,
+            &radialAcceleration, &tangentialAcceleration,
+            &directionX, &directionY,
+            &radius, &degreesPerSecond, &deltaRadius
+        })
+        {
+            float* data = attribute->data();
+            for (const auto& [from, to] : moves)
+                data[to] = data[from];
+        }
     }
 
     ParticleSystem::ParticleSystem():
@@ -138,71 +197,14 @@ namespace ouzel::scene
 
             if (active)
             {
-                for (std::uint32_t counter = particleCount; counter > 0; --counter)
-                {
-                    const std::size_t i = counter - 1;
+                updateLife();
 
-                    particles[i].life -= updateStep;
+                if (particleSystemData.emitterType == ParticleSystemData::EmitterType::gravity)
+                    updateGravityParticles();
+                else
+                    updateRadiusParticles();
 
-                    if (particles[i].life >= 0.0F)
-                    {
-                        if (particleSystemData.emitterType == ParticleSystemData::EmitterType::gravity)
-                        {
-                            Vector2F tmp;
-                            Vector2F radial;
-                            Vector2F tangential;
-
-                            // radial acceleration
-                            if (particles[i].position.v[0] == 0.0F || particles[i].position.v[1] == 0.0F)
-                                radial = particles[i].position.normalized();
-
-                            tangential = radial;
-                            radial *= particles[i].radialAcceleration;
-
-                            // tangential acceleration
-                            std::swap(tangential.v[0], tangential.v[1]);
-                            tangential.v[0] *= - particles[i].tangentialAcceleration;
-                            tangential.v[1] *= particles[i].tangentialAcceleration;
-
-                            // (gravity + radial + tangential) * updateStep
-                            tmp.v[0] = radial.v[0] + tangential.v[0] + particleSystemData.gravity.v[0];
-                            tmp.v[1] = radial.v[1] + tangential.v[1] + particleSystemData.gravity.v[1];
-                            tmp *= updateStep;
-
-                            particles[i].direction.v[0] += tmp.v[0];
-                            particles[i].direction.v[1] += tmp.v[1];
-                            tmp.v[0] = particles[i].direction.v[0] * updateStep * (particleSystemData.yCoordFlipped ? 1.0F : 0.0F);
-                            tmp.v[1] = particles[i].direction.v[1] * updateStep * (particleSystemData.yCoordFlipped ? 1.0F : 0.0F);
-                            particles[i].position.v[0] += tmp.v[0];
-                            particles[i].position.v[1] += tmp.v[1];
-                        }
-                        else
-                        {
-                            particles[i].angle += particles[i].degreesPerSecond * updateStep;
-                            particles[i].radius += particles[i].deltaRadius * updateStep;
-                            particles[i].position.v[0] = -std::cos(particles[i].angle) * particles[i].radius;
-                            particles[i].position.v[1] = -std::sin(particles[i].angle) * particles[i].radius * (particleSystemData.yCoordFlipped ? 1.0F : 0.0F);
-                        }
-
-                        // color r,g,b,a
-                        particles[i].colorRed += particles[i].deltaColorRed * updateStep;
-                        particles[i].colorGreen += particles[i].deltaColorGreen * updateStep;
-                        particles[i].colorBlue += particles[i].deltaColorBlue * updateStep;
-                        particles[i].colorAlpha += particles[i].deltaColorAlpha * updateStep;
-
-                        // size
-                        particles[i].size += (particles[i].deltaSize * updateStep);
-                        particles[i].size = std::max(0.0F, particles[i].size);
-
-                        // angle
-                        particles[i].rotation += particles[i].deltaRotation * updateStep;
-                    }
-                    else
-                    {
-                        particles[i] = particles[particleCount - 1];
-                        --particleCount;
-                    }
-                }
+                updateParticleAttributes();
 
                 needsMeshUpdate = true;
                 needsBoundingBoxUpdate = true;
@@ -223,7 +225,7 @@ namespace ouzel::scene
 
                     for (std::uint32_t i = 0; i < particleCount; ++i)
                     {
-                        auto position = Vector3F(particles[i].position);
+                        Vector3F position(particles.positionX[i], particles.positionY[i], 0.0F);
                         inverseTransform.transformPoint(position);
                         boundingBox.insertPoint(position);
                     }
@@ -232,9 +234,156 @@ namespace ouzel::scene
             else if (particleSystemData.positionType == ParticleSystemData::PositionType::grouped)
             {
                 for (std::uint32_t i = 0; i < particleCount; ++i)
-                    boundingBox.insertPoint(Vector3F(particles[i].position));
+                    boundingBox.insertPoint(Vector3F(particles.positionX[i], particles.positionY[i], 0.0F));
+            }
+        }
+    }
+
+    void ParticleSystem::updateLife()
+    {
+        float* life = particles.life.data();
+
+        for (std::uint32_t i = 0; i < particleCount; ++i)
+            life[i] -= updateStep;
+
+        // move the alive particles from the end of the arrays into the slots of the dead ones
+        particleMoves.clear();
+        std::uint32_t alive = 0;
+        std::uint32_t end = particleCount;
+
+        while (alive < end)
+        {
+            if (life[alive] >= 0.0F)
+            {
+                ++alive;
+                continue;
+            }
+
+            do --end; while (end > alive && life[end] < 0.0F);
+            if (end == alive) break;
+
+            particleMoves.emplace_back(end, alive);
+            life[alive] = life[end];
+            ++alive;
+        }
+
+        particleCount = alive;
+
+        if (!particleMoves.empty())
+            particles.compact(particleMoves);
+    }
+
+    void ParticleSystem::updateGravityParticles()
+    {
+        const float gravityX = particleSystemData.gravity.v[0];
+        const float gravityY = particleSystemData.gravity.v[1];
+        const float positionStep = updateStep * (particleSystemData.yCoordFlipped ? 1.0F : 0.0F);
+
+        float* positionX = particles.positionX.data();
+        float* positionY = particles.positionY.data();
+        float* directionX = particles.directionX.data();
+        float* directionY = particles.directionY.data();
+        const float* radialAcceleration = particles.radialAcceleration.data();
+        const float* tangentialAcceleration = particles.tangentialAcceleration.data();
+
+        std::uint32_t i = 0;
+
+#if defined(__SSE__)
+        if (core::isSimdAvailable)
+        {
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 minLength = _mm_set1_ps(std::numeric_limits<float>::min());
+            const __m128 gx = _mm_set1_ps(gravityX);
+            const __m128 gy = _mm_set1_ps(gravityY);
+            const __m128 step = _mm_set1_ps(updateStep);
+            const __m128 pstep = _mm_set1_ps(positionStep);
+
+            for (; i + 4 <= particleCount; i += 4)
+            {
+                __m128 px = _mm_loadu_ps(&positionX[i]);
+                __m128 py = _mm_loadu_ps(&positionY[i]);
+
+                // radial acceleration
+                const __m128 squared = _mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py));
+                const __m128 length = _mm_sqrt_ps(squared);
+                const __m128 normalize = _mm_cmpgt_ps(length, minLength);
+                const __m128 useRadial = _mm_or_ps(_mm_cmpeq_ps(px, zero), _mm_cmpeq_ps(py, zero));
+                const __m128 divisor = _mm_or_ps(_mm_and_ps(normalize, length), _mm_andnot_ps(normalize, _mm_set1_ps(1.0F)));
+                const __m128 rx = _mm_and_ps(useRadial, _mm_div_ps(px, divisor));
+                const __m128 ry = _mm_and_ps(useRadial, _mm_div_ps(py, divisor));
+
+                const __m128 ra = _mm_loadu_ps(&radialAcceleration[i]);
+                const __m128 ta = _mm_loadu_ps(&tangentialAcceleration[i]);
+
+                // (gravity + radial + tangential) * updateStep
+                const __m128 ax = _mm_mul_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(rx, ra), _mm_mul_ps(ry, ta)), gx), step);
+                const __m128 ay = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ry, ra), _mm_mul_ps(rx, ta)), gy), step);
+
+                const __m128 dx = _mm_add_ps(_mm_loadu_ps(&directionX[i]), ax);
+                const __m128 dy = _mm_add_ps(_mm_loadu_ps(&directionY[i]), ay);
+                _mm_storeu_ps(&directionX[i], dx);
+                _mm_storeu_ps(&directionY[i], dy);
+
+                px = _mm_add_ps(px, _mm_mul_ps(dx, pstep));
+                py = _mm_add_ps(py, _mm_mul_ps(dy, pstep));
+                _mm_storeu_ps(&positionX[i], px);
+                _mm_storeu_ps(&positionY[i], py);
             }
         }
+#endif
+
+        for (; i < particleCount; ++i)
+        {
+            Vector2F radial;
+
+            // radial acceleration
+            if (positionX[i] == 0.0F || positionY[i] == 0.0F)
+                radial = Vector2F(positionX[i], positionY[i]).normalized();
+
+            // (gravity + radial + tangential) * updateStep
+            directionX[i] += (radial.v[0] * radialAcceleration[i] - radial.v[1] * tangentialAcceleration[i] + gravityX) * updateStep;
+            directionY[i] += (radial.v[1] * radialAcceleration[i] + radial.v[0] * tangentialAcceleration[i] + gravityY) * updateStep;
+
+            positionX[i] += directionX[i] * positionStep;
+            positionY[i] += directionY[i] * positionStep;
+        }
+    }
+
+    void ParticleSystem::updateRadiusParticles()
+    {
+        const float flip = particleSystemData.yCoordFlipped ? 1.0F : 0.0F;
+
+        float* positionX = particles.positionX.data();
+        float* positionY = particles.positionY.data();
+        float* angle = particles.angle.data();
+        float* radius = particles.radius.data();
+
+        integrate(angle, particles.degreesPerSecond.data(), particleCount, updateStep);
+        integrate(radius, particles.deltaRadius.data(), particleCount, updateStep);
+
+        for (std::uint32_t i = 0; i < particleCount; ++i)
+        {
+            positionX[i] = -std::cos(angle[i]) * radius[i];
+            positionY[i] = -std::sin(angle[i]) * radius[i] * flip;
+        }
+    }
+
+    void ParticleSystem::updateParticleAttributes()
+    {
+        // color r,g,b,a
+        integrate(particles.colorRed.data(), particles.deltaColorRed.data(), particleCount, updateStep);
+        integrate(particles.colorGreen.data(), particles.deltaColorGreen.data(), particleCount, updateStep);
+        integrate(particles.colorBlue.data(), particles.deltaColorBlue.data(), particleCount, updateStep);
+        integrate(particles.colorAlpha.data(), particles.deltaColorAlpha.data(), particleCount, updateStep);
+
+        // size
+        float* size = particles.size.data();
+        integrate(size, particles.deltaSize.data(), particleCount, updateStep);
+        for (std::uint32_t i = 0; i < particleCount; ++i)
+            size[i] = std::max(0.0F, size[i]);
+
+        // angle
+        integrate(particles.rotation.data(), particles.deltaRotation.data(), particleCount, updateStep);
     }
 
     void ParticleSystem::init(const ParticleSystemData& newParticleSystemData)
@@ -324,56 +473,63 @@ namespace ouzel::scene
                                                           static_cast<std::uint32_t>(getVectorSize(vertices)));
 
         particles.resize(particleSystemData.maxParticles);
+        particleMoves.reserve(particleSystemData.maxParticles);
     }
 
     void ParticleSystem::updateParticleMesh()
     {
         if (actor)
         {
-            for (std::uint32_t counter = particleCount; counter > 0; --counter)
-            {
-                const std::size_t i = counter - 1;
+            const Vector2F offset = (particleSystemData.positionType == ParticleSystemData::PositionType::free) ?
+                Vector2F() :
+                (particleSystemData.positionType == ParticleSystemData::PositionType::parent) ?
+                Vector2F(actor->getPosition()) :
+                (particleSystemData.positionType == ParticleSystemData::PositionType::grouped) ?
+                Vector2F() :
+                throw std::runtime_error("Invalid position type");
+
+            // grouped particles are positioned by the transform matrix
+            const float positionScale = (particleSystemData.positionType == ParticleSystemData::PositionType::grouped) ? 0.0F : 1.0F;
 
-                const Vector2F position = (particleSystemData.positionType == ParticleSystemData::PositionType::free) ?
-                    particles[i].position :
-                    (particleSystemData.positionType == ParticleSystemData::PositionType::parent) ?
-                    Vector2F(actor->getPosition()) + particles[i].position :
-                    (particleSystemData.positionType == ParticleSystemData::PositionType::grouped) ?
-                    Vector2F() :
-                    throw std::runtime_error("Invalid position type");
+            const float* positionX = particles.positionX.data();
+            const float* positionY = particles.positionY.data();
+            const float* size = particles.size.data();
+            const float* rotation = particles.rotation.data();
+            const float* colorRed = particles.colorRed.data();
+            const float* colorGreen = particles.colorGreen.data();
+            const float* colorBlue = particles.colorBlue.data();
+            const float* colorAlpha = particles.colorAlpha.data();
 
-                const float halfSize = particles[i].size / 2.0F;
-                Vector2F v1(-halfSize, -halfSize);
-                Vector2F v2(halfSize, halfSize);
+            graphics::Vertex* vertex = vertices.data();
+
+            for (std::uint32_t i = 0; i < particleCount; ++i, vertex += 4)
+            {
+                const float x = positionX[i] * positionScale + offset.v[0];
+                const float y = positionY[i] * positionScale + offset.v[1];
 
-                const float r = -degToRad(particles[i].rotation);
-                const float cr = std::cos(r);
-                const float sr = std::sin(r);
+                const float halfSize = size[i] / 2.0F;
 
-                const Vector2F a(v1.v[0] * cr - v1.v[1] * sr, v1.v[0] * sr + v1.v[1] * cr);
-                const Vector2F b(v2.v[0] * cr - v1.v[1] * sr, v2.v[0] * sr + v1.v[1] * cr);
-                const Vector2F c(v2.v[0] * cr - v2.v[1] * sr, v2.v[0] * sr + v2.v[1] * cr);
-                const Vector2F d(v1.v[0] * cr - v2.v[1] * sr, v1.v[0] * sr + v2.v[1] * cr);
+                const float r = -degToRad(rotation[i]);
+                const float cr = std::cos(r) * halfSize;
+                const float sr = std::sin(r) * halfSize;
 
-                const Color color(particles[i].colorRed,
-                                  particles[i].colorGreen,
-                                  particles[i].colorBlue,
-                                  particles[i].colorAlpha);
+                const Color color(colorRed[i], colorGreen[i], colorBlue[i], colorAlpha[i]);
 
-                vertices[i * 4 + 0].position = Vector3F(a + position);
-                vertices[i * 4 + 0].color = color;
+                vertex[0].position = Vector3F(-cr + sr + x, -sr - cr + y, 0.0F);
+                vertex[0].color = color;
 
-                vertices[i * 4 + 1].position = Vector3F(b + position);
-                vertices[i * 4 + 1].color = color;
+                vertex[1].position = Vector3F(cr + sr + x, sr - cr + y, 0.0F);
+                vertex[1].color = color;
 
-                vertices[i * 4 + 2].position = Vector3F(d + position);
-                vertices[i * 4 + 2].color = color;
+                vertex[2].position = Vector3F(-cr - sr + x, -sr + cr + y, 0.0F);
+                vertex[2].color = color;
 
-                vertices[i * 4 + 3].position = Vector3F(c + position);
-                vertices[i * 4 + 3].color = color;
+                vertex[3].position = Vector3F(cr - sr + x, sr + cr + y, 0.0F);
+                vertex[3].color = color;
             }
 
-            vertexBuffer->setData(vertices.data(), static_cast<std::uint32_t>(getVectorSize(vertices)));
+            // only the vertices of the alive particles are uploaded
+            vertexBuffer->setData(vertices.data(), particleCount * 4 * static_cast<std::uint32_t>(sizeof(graphics::Vertex)));
         }
     }
 
@@ -396,38 +552,38 @@ namespace ouzel::scene
             {
                 if (particleSystemData.emitterType == ParticleSystemData::EmitterType::gravity)
                 {
-                    particles[i].life = std::max(particleSystemData.particleLifespan + particleSystemData.particleLifespanVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine), 0.0F);
+                    particles.life[i] = std::max(particleSystemData.particleLifespan + particleSystemData.particleLifespanVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine), 0.0F);
 
-                    particles[i].position = particleSystemData.sourcePosition + position + Vector2F(particleSystemData.sourcePositionVariance.v[0] * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine),
-                                                                                                    particleSystemData.sourcePositionVariance.v[1] * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine));
+                    particles.positionX[i] = particleSystemData.sourcePosition.v[0] + position.v[0] + particleSystemData.sourcePositionVariance.v[0] * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine);
+                    particles.positionY[i] = particleSystemData.sourcePosition.v[1] + position.v[1] + particleSystemData.sourcePositionVariance.v[1] * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine);
 
-                    particles[i].size = std::max(particleSystemData.startParticleSize + particleSystemData.startParticleSizeVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine), 0.0F);
+                    particles.size[i] = std::max(particleSystemData.startParticleSize + particleSystemData.startParticleSizeVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine), 0.0F);
 
                     const float finishSize = std::max(particleSystemData.finishParticleSize + particleSystemData.finishParticleSizeVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine), 0.0F);
-                    particles[i].deltaSize = (finishSize - particles[i].size) / particles[i].life;
+                    particles.deltaSize[i] = (finishSize - particles.size[i]) / particles.life[i];
 
-                    particles[i].colorRed = std::clamp(particleSystemData.startColorRed + particleSystemData.startColorRedVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine), 0.0F, 1.0F);
-                    particles[i].colorGreen = std::clamp(particleSystemData.startColorGreen + particleSystemData.startColorGreenVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine), 0.0F, 1.0F);
-                    particles[i].colorBlue = std::clamp(particleSystemData.startColorBlue + particleSystemData.startColorBlueVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine), 0.0F, 1.0F);
-                    particles[i].colorAlpha = std::clamp(particleSystemData.startColorAlpha + particleSystemData.startColorAlphaVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine), 0.0F, 1.0F);
+                    particles.colorRed[i] = std::clamp(particleSystemData.startColorRed + particleSystemData.startColorRedVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine), 0.0F, 1.0F);
+                    particles.colorGreen[i] = std::clamp(particleSystemData.startColorGreen + particleSystemData.startColorGreenVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine), 0.0F, 1.0F);
+                    particles.colorBlue[i] = std::clamp(particleSystemData.startColorBlue + particleSystemData.startColorBlueVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine), 0.0F, 1.0F);
+                    particles.colorAlpha[i] = std::clamp(particleSystemData.startColorAlpha + particleSystemData.startColorAlphaVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine), 0.0F, 1.0F);
 
                     const float finishColorRed = std::clamp(particleSystemData.finishColorRed + particleSystemData.finishColorRedVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine), 0.0F, 1.0F);
                     const float finishColorGreen = std::clamp(particleSystemData.finishColorGreen + particleSystemData.finishColorGreenVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine), 0.0F, 1.0F);
                     const float finishColorBlue = std::clamp(particleSystemData.finishColorBlue + particleSystemData.finishColorBlueVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine), 0.0F, 1.0F);
                     const float finishColorAlpha = std::clamp(particleSystemData.finishColorAlpha + particleSystemData.finishColorAlphaVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine), 0.0F, 1.0F);
 
-                    particles[i].deltaColorRed = (finishColorRed - particles[i].colorRed) / particles[i].life;
-                    particles[i].deltaColorGreen = (finishColorGreen - particles[i].colorGreen) / particles[i].life;
-                    particles[i].deltaColorBlue = (finishColorBlue - particles[i].colorBlue) / particles[i].life;
-                    particles[i].deltaColorAlpha = (finishColorAlpha - particles[i].colorAlpha) / particles[i].life;
+                    particles.deltaColorRed[i] = (finishColorRed - particles.colorRed[i]) / particles.life[i];
+                    particles.deltaColorGreen[i] = (finishColorGreen - particles.colorGreen[i]) / particles.life[i];
+                    particles.deltaColorBlue[i] = (finishColorBlue - particles.colorBlue[i]) / particles.life[i];
+                    particles.deltaColorAlpha[i] = (finishColorAlpha - particles.colorAlpha[i]) / particles.life[i];
 
-                    particles[i].rotation = particleSystemData.startRotation + particleSystemData.startRotationVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine);
+                    particles.rotation[i] = particleSystemData.startRotation + particleSystemData.startRotationVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine);
 
                     const float finishRotation = particleSystemData.finishRotation + particleSystemData.finishRotationVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine);
-                    particles[i].deltaRotation = (finishRotation - particles[i].rotation) / particles[i].life;
+                    particles.deltaRotation[i] = (finishRotation - particles.rotation[i]) / particles.life[i];
 
-                    particles[i].radialAcceleration = particleSystemData.radialAcceleration + particleSystemData.radialAcceleration * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine);
-                    particles[i].tangentialAcceleration = particleSystemData.tangentialAcceleration + particleSystemData.tangentialAcceleration * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine);
+                    particles.radialAcceleration[i] = particleSystemData.radialAcceleration + particleSystemData.radialAcceleration * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine);
+                    particles.tangentialAcceleration[i] = particleSystemData.tangentialAcceleration + particleSystemData.tangentialAcceleration * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine);
 
                     if (particleSystemData.rotationIsDir)
                     {
@@ -435,8 +591,9 @@ namespace ouzel::scene
                         const Vector2F v(std::cos(a), std::sin(a));
                         const float s = particleSystemData.speed + particleSystemData.speedVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine);
                         const auto dir = v * s;
-                        particles[i].direction = dir;
-                        particles[i].rotation = -radToDeg(dir.getAngle());
+                        particles.directionX[i] = dir.v[0];
+                        particles.directionY[i] = dir.v[1];
+                        particles.rotation[i] = -radToDeg(dir.getAngle());
                     }
                     else
                     {
@@ -444,17 +601,18 @@ namespace ouzel::scene
                         const Vector2F v(std::cos(a), std::sin(a));
                         const float s = particleSystemData.speed + particleSystemData.speedVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine);
                         const auto dir = v * s;
-                        particles[i].direction = dir;
+                        particles.directionX[i] = dir.v[0];
+                        particles.directionY[i] = dir.v[1];
                     }
                 }
                 else
                 {
-                    particles[i].radius = particleSystemData.maxRadius + particleSystemData.maxRadiusVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine);
-                    particles[i].angle = degToRad(particleSystemData.angle + particleSystemData.angleVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine));
-                    particles[i].degreesPerSecond = degToRad(particleSystemData.rotatePerSecond + particleSystemData.rotatePerSecondVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine));
+                    particles.radius[i] = particleSystemData.maxRadius + particleSystemData.maxRadiusVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine);
+                    particles.angle[i] = degToRad(particleSystemData.angle + particleSystemData.angleVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine));
+                    particles.degreesPerSecond[i] = degToRad(particleSystemData.rotatePerSecond + particleSystemData.rotatePerSecondVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine));
 
                     const float endRadius = particleSystemData.minRadius + particleSystemData.minRadiusVariance * std::uniform_real_distribution<float>{-1.0F, 1.0F}(core::randomEngine);
-                    particles[i].deltaRadius = (endRadius - particles[i].radius) / particles[i].life;
+                    particles.deltaRadius[i] = (endRadius - particles.radius[i]) / particles.life[i];
                 }
             }
 
@@ -4,6 +4,7 @@
 #define OUZEL_SCENE_PARTICLESYSTEM_HPP
 
 #include <string>
+#include <utility>
 #include <vector>
 #include <functional>
 #include "Component.hpp"
@@ -145,6 +146,10 @@ namespace ouzel::scene
 
     private:
         void update(float delta);
+        void updateLife();
+        void updateGravityParticles();
+        void updateRadiusParticles();
+        void updateParticleAttributes();
 
         void createParticleMesh();
         void updateParticleMesh();
@@ -158,41 +163,47 @@ namespace ouzel::scene
         std::shared_ptr<graphics::Texture> texture;
         std::shared_ptr<graphics::Texture> whitePixelTexture;
 
-        struct Particle final
+        // particle attributes are kept in separate arrays so that they can be updated in batches
+        struct Particles final
         {
-            float life = 0.0F;
+            void resize(std::size_t newSize);
+            void compact(const std::vector<std::pair<std::uint32_t, std::uint32_t>>& moves);
 
-            Vector2F position;
+            std::vector<float> life;
 
-            float colorRed = 0.0F;
-            float colorGreen = 0.0F;
-            float colorBlue = 0.0F;
-            float colorAlpha = 0.0F;
+            std::vector<float> positionX;
+            std::vector<float> positionY;
 
-            float deltaColorRed = 0.0F;
-            float deltaColorGreen = 0.0F;
-            float deltaColorBlue = 0.0F;
-            float deltaColorAlpha = 0.0F;
+            std::vector<float> colorRed;
+            std::vector<float> colorGreen;
+            std::vector<float> colorBlue;
+            std::vector<float> colorAlpha;
 
-            float angle = 0.0F;
-            float speed = 0.0F;
+            std::vector<float> deltaColorRed;
+            std::vector<float> deltaColorGreen;
+            std::vector<float> deltaColorBlue;
+            std::vector<float> deltaColorAlpha;
 
-            float size = 0.0F;
-            float deltaSize = 0.0F;
+            std::vector<float> angle;
 
-            float rotation = 0.0F;
-            float deltaRotation = 0.0F;
+            std::vector<float> size;
+            std::vector<float> deltaSize;
 
-            float radialAcceleration = 0.0F;
-            float tangentialAcceleration = 0.0F;
+            std::vector<float> rotation;
+            std::vector<float> deltaRotation;
 
-            Vector2F direction;
-            float radius = 0.0F;
-            float degreesPerSecond = 0.0F;
-            float deltaRadius = 0.0F;
+            std::vector<float> radialAcceleration;
+            std::vector<float> tangentialAcceleration;
+
+            std::vector<float> directionX;
+            std::vector<float> directionY;
+            std::vector<float> radius;
+            std::vector<float> degreesPerSecond;
+            std::vector<float> deltaRadius;
         };
 
-        std::vector<Particle> particles;
+        Particles particles;
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> particleMoves;
 
         std::unique_ptr<graphics::Buffer> indexBuffer;
         std::unique_ptr<graphics::Buffer> vertexBuffer;
@@ -53,6 +53,11 @@ namespace ouzel::scene
         return result;
     }
 
+    void SceneManager::update(float delta)
+    {
+        animationSystem.update(delta);
+    }
+
     void SceneManager::draw()
     {
         while (scenes.size() > 1)
@@ -9,6 +9,7 @@
 #include <queue>
 #include <set>
 #include <vector>
+#include "AnimationSystem.hpp"
 
 namespace ouzel::scene
 {
@@ -26,6 +27,7 @@ namespace ouzel::scene
         SceneManager(SceneManager&&) = delete;
         SceneManager& operator=(SceneManager&&) = delete;
 
+        void update(float delta);
         void draw();
 
         void setScene(Scene& scene);
@@ -40,7 +42,12 @@ namespace ouzel::scene
 
         auto getScene() const noexcept { return scenes.empty() ? nullptr : scenes.back(); }
 
+        auto& getAnimationSystem() noexcept { return animationSystem; }
+        auto& getAnimationSystem() const noexcept { return animationSystem; }
+
     private:
+        AnimationSystem animationSystem;
+
         std::vector<Scene*> scenes;
         std::vector<std::unique_ptr<Scene>> ownedScenes;
     };
@@ -1,24 +1,109 @@
 // Copyright 2015-2020 Elviss Strazdins. All rights reserved.
 
+#if defined(__SSE__)
+#  include <xmmintrin.h>
+#endif
+#include <cmath>
+#include <stdexcept>
 #include "SkinnedMeshRenderer.hpp"
 #include "../core/Engine.hpp"
+#include "../utils/Utils.hpp"
 
 namespace ouzel::scene
 {
+    SkinnedMeshData::SkinnedMeshData(const Box3F& initBoundingBox,
+                                     const std::shared_ptr<graphics::Material>& initMaterial,
+                                     const void* indices,
+                                     std::uint32_t initIndexCount,
+                                     std::uint32_t initIndexSize,
+                                     std::vector<graphics::Vertex>&& initVertices,
+                                     std::vector<Influence>&& initInfluences,
+                                     std::vector<Bone>&& initBones,
+                                     std::vector<Animation>&& initAnimations):
+        boundingBox(initBoundingBox),
+        material(initMaterial),
+        indexCount(initIndexCount),
+        indexSize(initIndexSize),
+        indexBuffer(*engine->getGraphics(),
+                    graphics::BufferType::index,
+                    graphics::Flags::none,
+                    indices,
+                    initIndexCount * initIndexSize),
+        vertices(std::move(initVertices)),
+        influences(std::move(initInfluences)),
+        bones(std::move(initBones)),
+        animations(std::move(initAnimations))
+    {
+        if (influences.size() != vertices.size())
+            throw std::runtime_error("Invalid bone influence count");
+
+        for (const auto& influence : influences)
+            for (const auto bone : influence.bones)
+                if (bone >= bones.size() && !bones.empty())
+                    throw std::runtime_error("Invalid bone index");
+
+        for (std::size_t i = 0; i < bones.size(); ++i)
+            if (bones[i].parent != noParent && bones[i].parent >= i)
+                throw std::runtime_error("Bones are not sorted");
+    }
+
     SkinnedMeshRenderer::SkinnedMeshRenderer()
     {
         whitePixelTexture = engine->getCache().getTexture(textureWhitePixel);
+
+        updateHandler.updateHandler = [this](const UpdateEvent& event) {
+            update(event.delta);
+            return false;
+        };
     }
 
-    SkinnedMeshRenderer::SkinnedMeshRenderer(const SkinnedMeshData& meshData)
+    SkinnedMeshRenderer::SkinnedMeshRenderer(const SkinnedMeshData& initMeshData):
+        SkinnedMeshRenderer()
     {
-        init(meshData);
+        init(initMeshData);
     }
 
-    void SkinnedMeshRenderer::init(const SkinnedMeshData& meshData)
+    void SkinnedMeshRenderer::init(const SkinnedMeshData& newMeshData)
     {
-        boundingBox = meshData.boundingBox;
-        material = meshData.material;
+        meshData = &newMeshData;
+        boundingBox = meshData->boundingBox;
+        material = meshData->material;
+
+        animation = nullptr;
+        channelKeys.clear();
+        pose = meshData->bones;
+        globalTransforms.resize(meshData->bones.size());
+        palette.resize(meshData->bones.size());
+
+        vertices = meshData->vertices;
+        vertexBuffer = std::make_unique<graphics::Buffer>(*engine->getGraphics(),
+                                                          graphics::BufferType::vertex,
+                                                          graphics::Flags::dynamic,
+                                                          vertices.data(),
+                                                          static_cast<std::uint32_t>(getVectorSize(vertices)));
+
+        currentTime = 0.0F;
+        poseDirty = true;
+    }
+
+    void SkinnedMeshRenderer::update(float delta)
+    {
+        if (!animation) return;
+
+        currentTime += delta;
+
+        if (currentTime >= animation->length)
+        {
+            if (repeat && animation->length > 0.0F)
+                currentTime = std::fmod(currentTime, animation->length);
+            else
+            {
+                currentTime = animation->length;
+                stop(false);
+            }
+        }
+
+        poseDirty = true;
     }
 
     void SkinnedMeshRenderer::draw(const Matrix4F& transformMatrix,
@@ -30,5 +115,263 @@ namespace ouzel::scene
                         opacity,
                         renderViewProjection,
                         wireframe);
+
+        if (!meshData || !material || vertices.empty()) return;
+
+        if (poseDirty)
+        {
+            samplePose();
+            calculatePalette();
+            skinVertices();
+
+            vertexBuffer->setData(vertices.data(), static_cast<std::uint32_t>(getVectorSize(vertices)));
+            poseDirty = false;
+        }
+
+        const auto modelViewProj = renderViewProjection * transformMatrix;
+        const float colorVector[] = {
+            material->diffuseColor.normR(),
+            material->diffuseColor.normG(),
+            material->diffuseColor.normB(),
+            material->diffuseColor.normA() * opacity * material->opacity
+        };
+
+        std::vector<std::vector<float>> fragmentShaderConstants(1);
+        fragmentShaderConstants[0] = {std::begin(colorVector), std::end(colorVector)};
+
+        std::vector<std::vector<float>> vertexShaderConstants(1);
+        vertexShaderConstants[0] = {std::begin(modelViewProj.m), std::end(modelViewProj.m)};
+
+        std::vector<std::size_t> textures;
+        for (const std::shared_ptr<graphics::Texture>& texture : material->textures)
+            textures.push_back(wireframe ? whitePixelTexture->getResource() : texture ? texture->getResource() : 0);
+
+        engine->getGraphics()->setPipelineState(material->blendState->getResource(),
+                                                material->shader->getResource(),
+                                                material->cullMode,
+                                                wireframe ? graphics::FillMode::wireframe : graphics::FillMode::solid);
+        engine->getGraphics()->setShaderConstants(fragmentShaderConstants,
+                                                  vertexShaderConstants);
+        engine->getGraphics()->setTextures(textures);
+        engine->getGraphics()->draw(meshData->indexBuffer.getResource(),
+                                    meshData->indexCount,
+                                    meshData->indexSize,
+                                    vertexBuffer->getResource(),
+                                    graphics::DrawMode::triangleList,
+                                    0);
+    }
+
+    void SkinnedMeshRenderer::play()
+    {
+        if (!playing)
+        {
+            engine->getEventDispatcher().addEventHandler(updateHandler);
+            playing = true;
+        }
+    }
+
+    void SkinnedMeshRenderer::stop(bool resetAnimation)
+    {
+        if (playing)
+        {
+            playing = false;
+            updateHandler.remove();
+        }
+
+        if (resetAnimation) reset();
+    }
+
+    void SkinnedMeshRenderer::reset()
+    {
+        setAnimationTime(0.0F);
+    }
+
+    bool SkinnedMeshRenderer::hasAnimation(const std::string& name) const
+    {
+        if (!meshData) return false;
+
+        for (const auto& meshAnimation : meshData->animations)
+            if (meshAnimation.name == name) return true;
+
+        return false;
+    }
+
+    void SkinnedMeshRenderer::setAnimation(const std::string& newAnimation, bool newRepeat)
+    {
+        if (!meshData) throw std::runtime_error("Skinned mesh renderer is not initialized");
+
+        animation = nullptr;
+
+        for (const auto& meshAnimation : meshData->animations)
+            if (meshAnimation.name == newAnimation)
+            {
+                animation = &meshAnimation;
+                break;
+            }
+
+        if (!animation) throw std::runtime_error("Invalid animation " + newAnimation);
+
+        repeat = newRepeat;
+        channelKeys.assign(animation->channels.size(), 0);
+        setAnimationTime(0.0F);
+    }
+
+    void SkinnedMeshRenderer::setAnimationTime(float time)
+    {
+        currentTime = time;
+        poseDirty = true;
+    }
+
+    void SkinnedMeshRenderer::samplePose()
+    {
+        pose = meshData->bones;
+
+        if (!animation) return;
+
+        for (std::size_t c = 0; c < animation->channels.size(); ++c)
+        {
+            const auto& channel = animation->channels[c];
+            if (channel.times.empty()) continue;
+
+            // start the search from the previously sampled key, so that forward playback does not have to search
+            std::size_t key = channelKeys[c];
+            if (key >= channel.times.size() || channel.times[key] > currentTime) key = 0;
+            while (key + 1 < channel.times.size() && channel.times[key + 1] <= currentTime) ++key;
+            channelKeys[c] = key;
+
+            const std::size_t next = (key + 1 < channel.times.size()) ? key + 1 : key;
+            float t = 0.0F;
+            if (channel.interpolation == SkinnedMeshData::Channel::Interpolation::linear &&
+                next != key && currentTime > channel.times[key])
+                t = (currentTime - channel.times[key]) / (channel.times[next] - channel.times[key]);
+
+            auto& bone = pose[channel.bone];
+
+            if (channel.path == SkinnedMeshData::Channel::Path::rotation)
+            {
+                const float* v0 = &channel.values[key * 4];
+                const float* v1 = &channel.values[next * 4];
+                const QuaternionF q0(v0[0], v0[1], v0[2], v0[3]);
+                QuaternionF q1(v1[0], v1[1], v1[2], v1[3]);
+
+                // interpolate along the shortest path
+                if (q0.v[0] * q1.v[0] + q0.v[1] * q1.v[1] + q0.v[2] * q1.v[2] + q0.v[3] * q1.v[3] < 0.0F)
+                    q1.negate();
+
+                bone.rotation.lerp(q0, q1, t);
+                bone.rotation.normalize();
+            }
+            else
+            {
+                const float* v0 = &channel.values[key * 3];
+                const float* v1 = &channel.values[next * 3];
+                const Vector3F value(v0[0] + (v1[0] - v0[0]) * t,
+                                     v0[1] + (v1[1] - v0[1]) * t,
+                                     v0[2] + (v1[2] - v0[2]) * t);
+
+                if (channel.path == SkinnedMeshData::Channel::Path::translation)
+                    bone.position = value;
+                else
+                    bone.scale = value;
+            }
+        }
+    }
+
+    void SkinnedMeshRenderer::calculatePalette()
+    {
+        for (std::size_t i = 0; i < pose.size(); ++i)
+        {
+            const auto& bone = pose[i];
+
+            Matrix4F localTransform;
+            localTransform.setTranslation(bone.position);
+
+            Matrix4F rotationMatrix;
+            rotationMatrix.setRotation(bone.rotation);
+            localTransform *= rotationMatrix;
+
+            Matrix4F scaleMatrix;
+            scaleMatrix.setScale(bone.scale);
+            localTransform *= scaleMatrix;
+
+            // parents are always calculated before their children
+            if (bone.parent == SkinnedMeshData::noParent)
+                bone.parentTransform.multiply(localTransform, globalTransforms[i]);
+            else
+                globalTransforms[bone.parent].multiply(localTransform, globalTransforms[i]);
+
+            globalTransforms[i].multiply(bone.inverseBindMatrix, palette[i]);
+        }
+    }
+
+    void SkinnedMeshRenderer::skinVertices()
+    {
+        if (palette.empty()) return;
+
+        const auto& bindVertices = meshData->vertices;
+        const auto& influences = meshData->influences;
+
+        for (std::size_t v = 0; v < vertices.size(); ++v)
+        {
+            const auto& bindVertex = bindVertices[v];
+            const auto& influence = influences[v];
+            auto& vertex = vertices[v];
+
+#if defined(__SSE__)
+            if (core::isSimdAvailable)
+            {
+                // blend the columns of the bone matrices
+                __m128 c0 = _mm_setzero_ps();
+                __m128 c1 = _mm_setzero_ps();
+                __m128 c2 = _mm_setzero_ps();
+                __m128 c3 = _mm_setzero_ps();
+
+                for (std::size_t i = 0; i < SkinnedMeshData::maxInfluences; ++i)
+                {
+                    if (influence.weights[i] == 0.0F) continue;
+
+                    const float* m = palette[influence.bones[i]].m.data();
+                    const __m128 w = _mm_set1_ps(influence.weights[i]);
+                    c0 = _mm_add_ps(c0, _mm_mul_ps(_mm_load_ps(&m[0]), w));
+                    c1 = _mm_add_ps(c1, _mm_mul_ps(_mm_load_ps(&m[4]), w));
+                    c2 = _mm_add_ps(c2, _mm_mul_ps(_mm_load_ps(&m[8]), w));
+                    c3 = _mm_add_ps(c3, _mm_mul_ps(_mm_load_ps(&m[12]), w));
+                }
+
+                const auto& p = bindVertex.position;
+                const auto& n = bindVertex.normal;
+
+                alignas(16) float position[4];
+                _mm_store_ps(position, _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p.v[0])),
+                                                             _mm_mul_ps(c1, _mm_set1_ps(p.v[1]))),
+                                                  _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(p.v[2])), c3)));
+
+                alignas(16) float normal[4];
+                _mm_store_ps(normal, _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(n.v[0])),
+                                                           _mm_mul_ps(c1, _mm_set1_ps(n.v[1]))),
+                                                _mm_mul_ps(c2, _mm_set1_ps(n.v[2]))));
+
+                vertex.position = Vector3F(position[0], position[1], position[2]);
+                vertex.normal = Vector3F(normal[0], normal[1], normal[2]).normalized();
+                continue;
+            }
+#endif
+
+            Matrix4F skinMatrix;
+            skinMatrix.setZero();
+
+            for (std::size_t i = 0; i < SkinnedMeshData::maxInfluences; ++i)
+            {
+                if (influence.weights[i] == 0.0F) continue;
+
+                const auto& m = palette[influence.bones[i]].m;
+                for (std::size_t j = 0; j < 16; ++j)
+                    skinMatrix.m[j] += m[j] * influence.weights[i];
+            }
+
+            skinMatrix.transformPoint(bindVertex.position, vertex.position);
+            skinMatrix.transformVector(bindVertex.normal, vertex.normal);
+            vertex.normal.normalize();
+        }
     }
 }
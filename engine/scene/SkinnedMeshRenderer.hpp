@@ -3,20 +3,71 @@
 #ifndef OUZEL_SCENE_SKINNEDMESHRENDERER_HPP
 #define OUZEL_SCENE_SKINNEDMESHRENDERER_HPP
 
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <string>
 #include <vector>
 #include "../scene/Component.hpp"
+#include "../events/EventHandler.hpp"
+#include "../graphics/Buffer.hpp"
 #include "../graphics/Material.hpp"
+#include "../graphics/Vertex.hpp"
+#include "../math/Matrix.hpp"
+#include "../math/Quaternion.hpp"
 
 namespace ouzel::scene
 {
     class SkinnedMeshData final
     {
     public:
+        static constexpr std::size_t noParent = std::numeric_limits<std::size_t>::max();
+        static constexpr std::size_t maxInfluences = 4;
+
+        // bones are sorted so that every parent comes before its children
         struct Bone final
         {
-            Bone* parent = nullptr;
+            std::size_t parent = noParent;
             Vector3F position;
-            QuaternionF rotation;
+            QuaternionF rotation = QuaternionF::identity();
+            Vector3F scale{1.0F, 1.0F, 1.0F};
+            Matrix4F inverseBindMatrix = Matrix4F::identity();
+            Matrix4F parentTransform = Matrix4F::identity(); // transformation of the non-bone ancestors of a root bone
+        };
+
+        struct Influence final
+        {
+            std::array<std::uint16_t, maxInfluences> bones{};
+            std::array<float, maxInfluences> weights{};
+        };
+
+        struct Channel final
+        {
+            enum class Path
+            {
+                translation,
+                rotation,
+                scale
+            };
+
+            enum class Interpolation
+            {
+                step,
+                linear
+            };
+
+            std::size_t bone = 0;
+            Path path = Path::translation;
+            Interpolation interpolation = Interpolation::linear;
+            std::vector<float> times;
+            std::vector<float> values; // 3 components for translation and scale, 4 for rotation
+        };
+
+        struct Animation final
+        {
+            std::string name;
+            float length = 0.0F;
+            std::vector<Channel> channels;
         };
 
         SkinnedMeshData() = default;
@@ -26,9 +77,27 @@ namespace ouzel::scene
             material(initMaterial)
         {
         }
+        SkinnedMeshData(const Box3F& initBoundingBox,
+                        const std::shared_ptr<graphics::Material>& initMaterial,
+                        const void* indices,
+                        std::uint32_t initIndexCount,
+                        std::uint32_t initIndexSize,
+                        std::vector<graphics::Vertex>&& initVertices,
+                        std::vector<Influence>&& initInfluences,
+                        std::vector<Bone>&& initBones,
+                        std::vector<Animation>&& initAnimations);
 
         Box3F boundingBox;
         std::shared_ptr<graphics::Material> material;
+
+        std::uint32_t indexCount = 0;
+        std::uint32_t indexSize = 0;
+        graphics::Buffer indexBuffer;
+
+        std::vector<graphics::Vertex> vertices; // bind pose
+        std::vector<Influence> influences;
+        std::vector<Bone> bones;
+        std::vector<Animation> animations;
     };
 
     class SkinnedMeshRenderer: public Component
@@ -39,6 +108,8 @@ namespace ouzel::scene
 
         void init(const SkinnedMeshData& meshData);
 
+        void update(float delta);
+
         void draw(const Matrix4F& transformMatrix,
                   float opacity,
                   const Matrix4F& renderViewProjection,
@@ -47,9 +118,40 @@ namespace ouzel::scene
         auto& getMaterial() const noexcept { return material; }
         void setMaterial(const std::shared_ptr<graphics::Material>& newMaterial) { material = newMaterial; }
 
+        void play();
+        void stop(bool resetAnimation = true);
+        void reset();
+        auto isPlaying() const noexcept { return playing; }
+
+        bool hasAnimation(const std::string& animation) const;
+        void setAnimation(const std::string& newAnimation, bool repeat = true);
+        auto getAnimationTime() const noexcept { return currentTime; }
+        void setAnimationTime(float time);
+
     private:
+        void samplePose();
+        void calculatePalette();
+        void skinVertices();
+
+        const SkinnedMeshData* meshData = nullptr;
         std::shared_ptr<graphics::Material> material;
         std::shared_ptr<graphics::Texture> whitePixelTexture;
+
+        const SkinnedMeshData::Animation* animation = nullptr;
+        std::vector<std::size_t> channelKeys; // last sampled key of each channel
+        std::vector<SkinnedMeshData::Bone> pose;
+        std::vector<Matrix4F> globalTransforms;
+        std::vector<Matrix4F> palette;
+
+        std::vector<graphics::Vertex> vertices;
+        std::unique_ptr<graphics::Buffer> vertexBuffer;
+
+        bool playing = false;
+        bool repeat = true;
+        bool poseDirty = true;
+        float currentTime = 0.0F;
+
+        EventHandler updateHandler;
     };
 }
 
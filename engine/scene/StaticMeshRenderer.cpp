@@ -1,6 +1,8 @@
 // Copyright 2015-2020 Elviss Strazdins. All rights reserved.
 
+#include <algorithm>
 #include <limits>
+#include <stdexcept>
 #include "StaticMeshRenderer.hpp"
 #include "../core/Engine.hpp"
 #include "../utils/Utils.hpp"
@@ -8,14 +10,23 @@
 namespace ouzel::scene
 {
     StaticMeshData::StaticMeshData(const Box3F& initBoundingBox,
-                                   const std::vector<std::uint32_t> indices,
+                                   const std::vector<std::uint32_t>& indices,
                                    const std::vector<graphics::Vertex>& vertices,
-                                   const graphics::Material* initMaterial):
+                                   const graphics::Material* initMaterial,
+                                   const std::vector<Lod>& initLods):
         boundingBox(initBoundingBox),
-        material(initMaterial)
+        material(initMaterial),
+        lods(initLods)
     {
         indexCount = static_cast<std::uint32_t>(indices.size());
 
+        if (lods.empty())
+            lods.push_back(Lod{0, indexCount, 0.0F});
+
+        for (const auto& lod : lods)
+            if (lod.startIndex + lod.indexCount > indexCount)
+                throw std::out_of_range("Invalid level of detail");
+
         indexSize = sizeof(std::uint16_t);
 
         for (const auto index : indices)
@@ -62,8 +73,8 @@ namespace ouzel::scene
     {
         boundingBox = meshData.boundingBox;
         material = meshData.material;
-        indexCount = meshData.indexCount;
         indexSize = meshData.indexSize;
+        lods = meshData.lods;
         indexBuffer = &meshData.indexBuffer;
         vertexBuffer = &meshData.vertexBuffer;
     }
@@ -103,11 +114,53 @@ namespace ouzel::scene
         engine->getGraphics()->setShaderConstants(fragmentShaderConstants,
                                                   vertexShaderConstants);
         engine->getGraphics()->setTextures(textures);
+
+        const auto& lod = selectLod(modelViewProj);
+
         engine->getGraphics()->draw(indexBuffer->getResource(),
-                                    indexCount,
+                                    lod.indexCount,
                                     indexSize,
                                     vertexBuffer->getResource(),
                                     graphics::DrawMode::triangleList,
-                                    0);
+                                    lod.startIndex);
+    }
+
+    const StaticMeshData::Lod& StaticMeshRenderer::selectLod(const Matrix4F& modelViewProjection) const noexcept
+    {
+        if (lods.size() == 1) return lods.front();
+
+        // projected size of the bounding box in the normalized device coordinates
+        Vector2F min(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+        Vector2F max(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+
+        for (std::size_t i = 0; i < 8; ++i)
+        {
+            const Vector4F corner((i & 1) ? boundingBox.max.v[0] : boundingBox.min.v[0],
+                              (i & 2) ? boundingBox.max.v[1] : boundingBox.min.v[1],
+                              (i & 4) ? boundingBox.max.v[2] : boundingBox.min.v[2],
+                              1.0F);
+            Vector4F position;
+            modelViewProjection.transformVector(corner, position);
+
+            // the camera is inside or behind the bounding box
+            if (position.v[3] <= std::numeric_limits<float>::epsilon())
+                return lods.front();
+
+            for (std::size_t axis = 0; axis < 2; ++axis)
+            {
+                const auto value = position.v[axis] / position.v[3];
+                min.v[axis] = std::min(min.v[axis], value);
+                max.v[axis] = std::max(max.v[axis], value);
+            }
+        }
+
+        // normalized device coordinates span two units
+        const auto screenSize = std::max(max.v[0] - min.v[0], max.v[1] - min.v[1]) * 0.5F * lodBias;
+
+        for (const auto& lod : lods)
+            if (screenSize >= lod.screenSize)
+                return lod;
+
+        return lods.back();
     }
 }
@@ -14,16 +14,27 @@ namespace ouzel::scene
     class StaticMeshData final
     {
     public:
+        // a range of the index buffer drawn while the projected bounding box covers at least screenSize of the viewport
+        // width or height, whichever fraction is larger
+        struct Lod final
+        {
+            std::uint32_t startIndex = 0;
+            std::uint32_t indexCount = 0;
+            float screenSize = 0.0F;
+        };
+
         StaticMeshData() = default;
         StaticMeshData(const Box3F& initBoundingBox,
-                       const std::vector<std::uint32_t> indices,
+                       const std::vector<std::uint32_t>& indices,
                        const std::vector<graphics::Vertex>& vertices,
-                       const graphics::Material* initMaterial);
+                       const graphics::Material* initMaterial,
+                       const std::vector<Lod>& initLods = {});
 
         Box3F boundingBox;
         const graphics::Material* material = nullptr;
         std::uint32_t indexCount = 0;
         std::uint32_t indexSize = 0;
+        std::vector<Lod> lods; // ordered from the most detailed
         graphics::Buffer indexBuffer;
         graphics::Buffer vertexBuffer;
     };
@@ -47,10 +58,16 @@ namespace ouzel::scene
             material = newMaterial;
         }
 
+        auto getLodBias() const noexcept { return lodBias; }
+        void setLodBias(float newLodBias) noexcept { lodBias = newLodBias; }
+
     private:
+        const StaticMeshData::Lod& selectLod(const Matrix4F& modelViewProjection) const noexcept;
+
         const graphics::Material* material = nullptr;
-        std::uint32_t indexCount = 0;
         std::uint32_t indexSize = 0;
+        std::vector<StaticMeshData::Lod> lods;
+        float lodBias = 1.0F;
         const graphics::Buffer* indexBuffer = nullptr;
         const graphics::Buffer* vertexBuffer = nullptr;
     };
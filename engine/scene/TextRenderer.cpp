@@ -65,6 +65,8 @@ namespace ouzel::scene
                         renderViewProjection,
                         wireframe);
 
+        if (font) font->uploadGlyphs();
+
         if (needsMeshUpdate)
         {
             indexBuffer.setData(indices.data(), static_cast<std::uint32_t>(getVectorSize(indices)));
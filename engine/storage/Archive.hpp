@@ -14,12 +14,21 @@
 
 namespace ouzel::storage
 {
+    // a part of a file on disk that can be read directly (files inside archives are stored uncompressed)
+    struct FileRange final
+    {
+        Path path;
+        std::uint64_t offset = 0;
+        std::uint64_t size = 0;
+    };
+
     class Archive final
     {
     public:
         Archive() = default;
 
-        explicit Archive(const Path& path):
+        explicit Archive(const Path& initPath):
+            path{initPath},
             file{path, std::ios::binary}
         {
             constexpr std::uint32_t centralDirectory = 0x02014B50U;
@@ -98,7 +107,18 @@ namespace ouzel::storage
             return entries.find(filename) != entries.end();
         }
 
+        FileRange getFileRange(const std::string& filename) const
+        {
+            const auto i = entries.find(filename);
+
+            if (i == entries.end())
+                throw std::runtime_error("File " + filename + " does not exist");
+
+            return FileRange{path, static_cast<std::uint64_t>(i->second.offset), i->second.size};
+        }
+
     private:
+        Path path;
         std::ifstream file;
 
         struct Entry final
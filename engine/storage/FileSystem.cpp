@@ -307,7 +307,10 @@ namespace ouzel::storage
         if (searchResources)
             for (auto& archive : archives)
                 if (archive.second.fileExists(filename))
+                {
+                    std::lock_guard lock(archiveMutex);
                     return archive.second.readFile(filename);
+                }
 
 #if defined(__ANDROID__)
         if (!filename.isAbsolute())
@@ -319,23 +322,27 @@ namespace ouzel::storage
             if (!asset)
                 throw std::runtime_error("Failed to open file " + std::string(filename));
 
-            std::vector<std::byte> data;
-            std::byte buffer[1024];
+            std::vector<std::byte> data(static_cast<std::size_t>(AAsset_getLength64(asset)));
+            std::size_t offset = 0;
 
-            for (;;)
+            while (offset < data.size())
             {
-                const auto bytesRead = AAsset_read(asset, buffer, sizeof(buffer));
+                const auto bytesRead = AAsset_read(asset, data.data() + offset, data.size() - offset);
 
                 if (bytesRead < 0)
+                {
+                    AAsset_close(asset);
                     throw std::runtime_error("Failed to read from file");
+                }
                 else if (bytesRead == 0)
                     break;
 
-                data.insert(data.end(), buffer, buffer + bytesRead);
+                offset += static_cast<std::size_t>(bytesRead);
             }
 
             AAsset_close(asset);
 
+            data.resize(offset);
             return data;
         }
 #endif
@@ -346,22 +353,86 @@ namespace ouzel::storage
         if (path.isEmpty())
             throw std::runtime_error("Failed to find file " + std::string(filename));
 
-        std::ifstream file(path, std::ios::binary);
-        if (!file)
+#if defined(__unix__) || defined(__APPLE__)
+        auto fileDescriptor = open(path.getNative().c_str(), O_RDONLY | O_CLOEXEC);
+        while (fileDescriptor == -1 && errno == EINTR)
+            fileDescriptor = open(path.getNative().c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (fileDescriptor == -1)
             throw std::runtime_error("Failed to open file " + std::string(filename));
 
-        std::vector<std::byte> data;
-        std::byte buffer[1024];
+        const FileDescriptor file = fileDescriptor;
+
+        struct stat s;
+        if (fstat(file, &s) == -1)
+            throw std::system_error(errno, std::system_category(), "Failed to get file status");
+
+        // the whole file is read with as few calls as possible into a buffer of its size
+        std::vector<std::byte> data(static_cast<std::size_t>(s.st_size));
+        std::size_t offset = 0;
 
-        while (!file.eof())
+        while (offset < data.size())
         {
-            file.read(reinterpret_cast<char*>(buffer), sizeof(buffer));
-            data.insert(data.end(), buffer, buffer + file.gcount());
+            const auto bytesRead = pread(file, data.data() + offset, data.size() - offset, static_cast<off_t>(offset));
+
+            if (bytesRead == -1)
+            {
+                if (errno == EINTR) continue;
+                throw std::system_error(errno, std::system_category(), "Failed to read from file");
+            }
+            else if (bytesRead == 0) // the file was truncated while reading it
+                break;
+
+            offset += static_cast<std::size_t>(bytesRead);
         }
 
+        data.resize(offset);
+#else
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+            throw std::runtime_error("Failed to open file " + std::string(filename));
+
+        std::vector<std::byte> data(static_cast<std::size_t>(file.tellg()));
+        file.seekg(0, std::ios::beg);
+
+        file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        data.resize(static_cast<std::size_t>(file.gcount()));
+#endif
+
         return data;
     }
 
+    FileRange FileSystem::getFileRange(const Path& filename, const bool searchResources) const
+    {
+        if (searchResources)
+            for (auto& archive : archives)
+                if (archive.second.fileExists(filename))
+                    return archive.second.getFileRange(filename);
+
+#if defined(__ANDROID__)
+        if (!filename.isAbsolute())
+            throw std::runtime_error("Android assets can not be read in parts");
+#endif
+
+        const auto path = getPath(filename, searchResources);
+        return FileRange{path, 0, getFileSize(path)};
+    }
+
+    MappedFile FileSystem::mapFile(const Path& filename, const bool searchResources, MappedFile::Access access)
+    {
+#if defined(__ANDROID__)
+        // the assets are compressed inside the package, so they are read into memory instead
+        if (!filename.isAbsolute() &&
+            (!searchResources ||
+             std::none_of(archives.begin(), archives.end(),
+                          [&filename](const auto& archive) { return archive.second.fileExists(filename); })))
+            return MappedFile{readFile(filename, searchResources)};
+#endif
+
+        // the files inside the archives are stored uncompressed, so they can be mapped directly
+        return MappedFile{getFileRange(filename, searchResources), access};
+    }
+
     bool FileSystem::resourceFileExists(const Path& filename) const
     {
         if (filename.isAbsolute())
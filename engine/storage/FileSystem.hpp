@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <system_error>
@@ -31,6 +32,7 @@
 #  include <unistd.h>
 #endif
 #include "Archive.hpp"
+#include "MappedFile.hpp"
 #include "Path.hpp"
 
 namespace ouzel::core
@@ -235,6 +237,13 @@ namespace ouzel::storage
 
         std::vector<std::byte> readFile(const Path& filename, const bool searchResources = true);
 
+        // locates the file for reading it in parts instead of loading it whole
+        FileRange getFileRange(const Path& filename, const bool searchResources = true) const;
+
+        // maps the file into memory, so that it can be parsed without copying it
+        MappedFile mapFile(const Path& filename, const bool searchResources = true,
+                           MappedFile::Access access = MappedFile::Access::sequential);
+
         bool resourceFileExists(const Path& filename) const;
 
         Path getPath(const Path& filename, const bool searchResources = true) const
@@ -349,28 +358,6 @@ namespace ouzel::storage
             if (!CopyFileW(from.getNative().c_str(), to.getNative().c_str(), !overwrite))
                 throw std::system_error(GetLastError(), std::system_category(), "Failed to copy file");
 #elif defined(__unix__) || defined(__APPLE__)
-            class FileDescriptor final
-            {
-            public:
-                FileDescriptor(int f) noexcept: fd{f} {}
-                ~FileDescriptor() { if (fd != -1) close(fd); }
-                FileDescriptor(FileDescriptor&& other) noexcept: fd{other.fd}
-                {
-                    other.fd = -1;
-                }
-                FileDescriptor& operator=(FileDescriptor&& other) noexcept
-                {
-                    if (this == &other) return *this;
-                    if (fd != -1) close(fd);
-                    fd = other.fd;
-                    other.fd = -1;
-                    return *this;
-                }
-                operator int() const noexcept { return fd; }
-            private:
-                int fd = -1;
-            };
-
             auto inFileDescriptor = open(from.getNative().c_str(), O_RDONLY);
             while (inFileDescriptor == -1 && errno == EINTR)
                 inFileDescriptor = open(from.getNative().c_str(), O_RDONLY);
@@ -598,10 +585,35 @@ namespace ouzel::storage
         }
 
     private:
+#if defined(__unix__) || defined(__APPLE__)
+        class FileDescriptor final
+        {
+        public:
+            FileDescriptor(int f) noexcept: fd{f} {}
+            ~FileDescriptor() { if (fd != -1) close(fd); }
+            FileDescriptor(FileDescriptor&& other) noexcept: fd{other.fd}
+            {
+                other.fd = -1;
+            }
+            FileDescriptor& operator=(FileDescriptor&& other) noexcept
+            {
+                if (this == &other) return *this;
+                if (fd != -1) close(fd);
+                fd = other.fd;
+                other.fd = -1;
+                return *this;
+            }
+            operator int() const noexcept { return fd; }
+        private:
+            int fd = -1;
+        };
+#endif
+
         core::Engine& engine;
         Path appPath;
         std::vector<Path> resourcePaths;
         std::vector<std::pair<std::string, Archive>> archives;
+        std::mutex archiveMutex; // the archives share a stream, so only one file can be read from them at a time
     };
 }
 
@@ -0,0 +1,209 @@
+// Copyright 2015-2020 Elviss Strazdins. All rights reserved.
+
+#ifndef OUZEL_STORAGE_MAPPEDFILE_HPP
+#define OUZEL_STORAGE_MAPPEDFILE_HPP
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+#if defined(_WIN32)
+#  pragma push_macro("WIN32_LEAN_AND_MEAN")
+#  pragma push_macro("NOMINMAX")
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <Windows.h>
+#  pragma pop_macro("WIN32_LEAN_AND_MEAN")
+#  pragma pop_macro("NOMINMAX")
+#elif defined(__unix__) || defined(__APPLE__)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+#include "Archive.hpp"
+
+namespace ouzel::storage
+{
+    // a read-only view of the contents of a file, the file is mapped into memory where the platform allows it,
+    // otherwise it is read into a buffer owned by the view
+    class MappedFile final
+    {
+    public:
+        enum class Access
+        {
+            sequential,
+            random
+        };
+
+        MappedFile() = default;
+
+        explicit MappedFile(std::vector<std::byte> initBuffer) noexcept:
+            buffer(std::move(initBuffer)), data(buffer.data()), size(buffer.size())
+        {
+        }
+
+        explicit MappedFile(const FileRange& range, Access access = Access::sequential):
+            size(static_cast<std::size_t>(range.size))
+        {
+            if (!size) return;
+
+#if defined(_WIN32)
+            SYSTEM_INFO systemInfo;
+            GetSystemInfo(&systemInfo);
+
+            // the view has to start at the allocation granularity
+            const auto delta = static_cast<std::size_t>(range.offset % systemInfo.dwAllocationGranularity);
+            const auto offset = range.offset - delta;
+
+            const HANDLE file = CreateFileW(range.path.getNative().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                            OPEN_EXISTING,
+                                            access == Access::sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS,
+                                            nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+                throw std::system_error(GetLastError(), std::system_category(), "Failed to open file");
+
+            const HANDLE fileMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            const auto mappingError = GetLastError();
+            CloseHandle(file);
+
+            if (!fileMapping)
+                throw std::system_error(mappingError, std::system_category(), "Failed to create file mapping");
+
+            mapping = MapViewOfFile(fileMapping, FILE_MAP_READ,
+                                    static_cast<DWORD>(offset >> 32),
+                                    static_cast<DWORD>(offset & 0xFFFFFFFFU),
+                                    size + delta);
+            const auto viewError = GetLastError();
+            CloseHandle(fileMapping);
+
+            if (!mapping)
+                throw std::system_error(viewError, std::system_category(), "Failed to map view of file");
+
+            data = static_cast<const std::byte*>(mapping) + delta;
+#elif defined(__unix__) || defined(__APPLE__)
+            // the mapping has to start at a page boundary
+            const auto pageSize = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+            const auto delta = static_cast<std::size_t>(range.offset % pageSize);
+            const auto offset = range.offset - delta;
+
+            auto fileDescriptor = open(range.path.getNative().c_str(), O_RDONLY | O_CLOEXEC);
+            while (fileDescriptor == -1 && errno == EINTR)
+                fileDescriptor = open(range.path.getNative().c_str(), O_RDONLY | O_CLOEXEC);
+
+            if (fileDescriptor == -1)
+                throw std::system_error(errno, std::system_category(), "Failed to open file");
+
+            // the mapping keeps a reference to the file, so the descriptor is not needed after it is created
+            void* result = mmap(nullptr, size + delta, PROT_READ, MAP_PRIVATE, fileDescriptor, static_cast<off_t>(offset));
+            const auto mapError = errno;
+            close(fileDescriptor);
+
+            if (result == MAP_FAILED)
+                throw std::system_error(mapError, std::system_category(), "Failed to map file");
+
+            mapping = result;
+            mappingSize = size + delta;
+            data = static_cast<const std::byte*>(mapping) + delta;
+
+            // the advice is only a hint, so the failures are ignored
+            if (access == Access::sequential)
+            {
+                madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+                madvise(mapping, mappingSize, MADV_WILLNEED);
+            }
+            else
+                madvise(mapping, mappingSize, MADV_RANDOM);
+#else
+            static_cast<void>(access);
+
+            std::ifstream file(range.path, std::ios::binary);
+            if (!file)
+                throw std::runtime_error("Failed to open file " + std::string(range.path));
+
+            file.seekg(static_cast<std::streamoff>(range.offset), std::ios::beg);
+
+            buffer.resize(size);
+            file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(size));
+            if (!file)
+                throw std::runtime_error("Failed to read from file " + std::string(range.path));
+
+            data = buffer.data();
+#endif
+        }
+
+        ~MappedFile()
+        {
+            unmap();
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept:
+            buffer(std::move(other.buffer)),
+            mapping(other.mapping),
+            mappingSize(other.mappingSize),
+            data(other.data),
+            size(other.size)
+        {
+            other.mapping = nullptr;
+            other.mappingSize = 0;
+            other.data = nullptr;
+            other.size = 0;
+        }
+
+        MappedFile& operator=(MappedFile&& other) noexcept
+        {
+            if (this == &other) return *this;
+
+            unmap();
+
+            buffer = std::move(other.buffer);
+            mapping = other.mapping;
+            mappingSize = other.mappingSize;
+            data = other.data;
+            size = other.size;
+
+            other.mapping = nullptr;
+            other.mappingSize = 0;
+            other.data = nullptr;
+            other.size = 0;
+
+            return *this;
+        }
+
+        auto getData() const noexcept { return data; }
+        auto getSize() const noexcept { return size; }
+        auto isEmpty() const noexcept { return size == 0; }
+
+        auto begin() const noexcept { return data; }
+        auto end() const noexcept { return data + size; }
+
+    private:
+        void unmap() noexcept
+        {
+#if defined(_WIN32)
+            if (mapping) UnmapViewOfFile(mapping);
+#elif defined(__unix__) || defined(__APPLE__)
+            if (mapping) munmap(mapping, mappingSize);
+#endif
+            mapping = nullptr;
+            mappingSize = 0;
+        }
+
+        std::vector<std::byte> buffer; // the contents of the files that can not be mapped
+        void* mapping = nullptr;
+        std::size_t mappingSize = 0;
+        const std::byte* data = nullptr;
+        std::size_t size = 0;
+    };
+}
+
+#endif // OUZEL_STORAGE_MAPPEDFILE_HPP